@@ -2,20 +2,27 @@
 #define LESPMV_H
 
 #include"general_config.h"
-#include"plat_config.h"
+#include"plat_runtime.h"
 #include"memopt.h"
+#include"arena.h"
+#include"perf_counter.h"
 #include"mmio.h"
 #include"thread.h"
 #include"csr5_utils.h"
 
 #include"sparse_io.h"
 #include"sparse_format.h"
+#include"sparse_matrix.h"
 #include"sparse_operation.h"
 #include"sparse_partition.h"
 #include"sparse_conversion.h"
+#include"sparse_update.h"
 #include"spmv_benchmark.h"
 #include"spmv_testroutine.h"
 #include"sparse_features.h"
+#include"sparse_generator.h"
+#include"sparse_solver.h"
+#include"sparse_reorder.h"
 
 #include"spmv_csr.h"
 #include"spmv_bsr.h"
@@ -26,5 +33,10 @@
 #include"spmv_s_ell.h"
 #include"spmv_sell_c_sigma.h"
 #include"spmv_sell_c_R.h"
+#include"spmv_fused.h"
+#include"spmv_cbcsr.h"
+#include"spmv_csb.h"
+#include"spmv_transpose.h"
+#include"sparse_dynamic.h"
 
 #endif /* LESPMV_H */
@@ -0,0 +1,96 @@
+#ifndef ARENA_H
+#define ARENA_H
+/*
+ * @brief Reusable bump arena for conversion scratch and SpMV temporaries.
+ *        It has one sub-arena per OpenMP thread, so threads allocate without
+ *        locks and first touch their own blocks. A sub-arena only asks the
+ *        allocator for memory when it has to grow; after the first (warm-up)
+ *        call of a kernel the blocks are large enough and no heap call is made.
+ *
+ *        Usage: every allocate() happens inside a Le_arena_scope of the same
+ *        sub-arena, the memory is released when that scope ends (LIFO):
+ *
+ *            Le_arena &arena = Le_get_arena(mat.arena);
+ *            arena.reserve_threads(thread_num);   // outside parallel regions
+ *            #pragma omp parallel
+ *            {
+ *                const int tid = Le_get_thread_id();
+ *                Le_arena_scope scope(arena, tid);
+ *                ValueType *tmp = arena.alloc_array<ValueType>(n, tid);
+ *            }
+ *
+ *        An arena serves one SpMV / conversion at a time.
+ */
+#include<stddef.h>
+#include"memopt.h"
+
+class Le_arena
+{
+    public:
+    // bytes_per_thread: initial block of each sub-arena, allocated on first use
+    // alloc: allocator of the blocks, nullptr for the current Le_get_allocator()
+    explicit Le_arena(size_t bytes_per_thread = 0, const Le_allocator *alloc = nullptr);
+    ~Le_arena();
+
+    Le_arena(const Le_arena &) = delete;
+    Le_arena & operator=(const Le_arena &) = delete;
+
+    // make sure there are num_threads sub-arenas, call it outside parallel regions
+    void reserve_threads(int num_threads);
+
+    int num_threads() const { return num_subs; }
+
+    // cache line aligned memory of sub-arena tid, valid until the enclosing scope ends
+    void * allocate(size_t bytes, int tid = 0);
+
+    template <typename T>
+    T * alloc_array(size_t N, int tid = 0) { return (T *) allocate(N * sizeof(T), tid); }
+
+    // bytes held by all sub-arenas
+    size_t capacity() const;
+
+    // free all blocks, no scope may be active
+    void release();
+
+    private:
+    friend class Le_arena_scope;
+    struct Sub;
+
+    void grow(Sub &s, size_t need);
+    void free_retired(Sub &s);
+
+    Sub *subs;
+    int num_subs;
+    size_t first_block;
+    const Le_allocator *alloc;
+};
+
+/**
+ * @brief Allocations of sub-arena tid made during the scope are released at its end
+ */
+class Le_arena_scope
+{
+    public:
+    Le_arena_scope(Le_arena &arena, int tid = 0);
+    ~Le_arena_scope();
+
+    Le_arena_scope(const Le_arena_scope &) = delete;
+    Le_arena_scope & operator=(const Le_arena_scope &) = delete;
+
+    private:
+    Le_arena &arena;
+    int tid;
+    char *block;
+    size_t top;
+};
+
+// arena of the calling thread, used by kernels and conversions of handles without one
+Le_arena & Le_thread_arena();
+
+// the handle's arena if set, else Le_thread_arena()
+inline Le_arena & Le_get_arena(Le_arena *arena)
+{
+    return arena != nullptr ? *arena : Le_thread_arena();
+}
+
+#endif /* ARENA_H */
@@ -2,7 +2,8 @@
 #define CSR5_UTILS_H
 #include"thread.h"
 #include"memopt.h"
-#include"plat_config.h"
+#include"arena.h"
+#include"plat_runtime.h"
 #include"general_config.h"
 
 #include<math.h>
@@ -18,9 +19,13 @@ void aosoa_transpose_kernel_smem(T         *d_data,
     int num_p = ceil((double)nnz / (double)(omega * sigma)) - 1;
     int num_thread = Le_get_thread_num();
 
-    T *s_data_all = (T *)memalign(CACHE_LINE, (uint64_t) sigma * omega * sizeof(T) * num_thread);
+    // 每线程一个 sigma * omega 的转置缓冲, 线程数须与缓冲个数一致
+    Le_arena &arena = Le_thread_arena();
+    arena.reserve_threads(1);
+    Le_arena_scope scope(arena);
+    T *s_data_all = arena.alloc_array<T>((size_t) sigma * omega * num_thread);
 
-    #pragma omp parallel for
+    #pragma omp parallel for num_threads(num_thread)
     for (int par_id = 0; par_id < num_p; par_id++)
     {
         int tid = Le_get_thread_id();
@@ -68,8 +73,6 @@ void aosoa_transpose_kernel_smem(T         *d_data,
             d_data[par_id * omega * sigma + idx] = s_data[idx_y * omega + idx_x];
         }
     }
-
-    free(s_data_all);
 }
 
 template<typename IndexType, typename UIndexType, typename ValueType>
@@ -82,7 +85,8 @@ int aosoa_transpose(const int           sigma,
                     bool                R2C)
 {
     aosoa_transpose_kernel_smem<IndexType, UIndexType>(column_index, partition_pointer, nnz, sigma, omega, R2C);
-    aosoa_transpose_kernel_smem<ValueType, UIndexType>(value,        partition_pointer, nnz, sigma, omega, R2C);
+    if (value != nullptr)   // pattern-only 矩阵没有 values
+        aosoa_transpose_kernel_smem<ValueType, UIndexType>(value,        partition_pointer, nnz, sigma, omega, R2C);
     return 0;
 }
 
@@ -24,6 +24,58 @@
 // Foa a column: [log(CSR5_SIGMA x CSR5_OMEGA) + log(CSR5_OMEGA) + CSR5_SIGMA] (bits)
 #define CSR5_SIGMA   16     // can change to 12 or 16
 #define BSR_BlockDimRow 16
+#define DIA_ROW_BLOCK   512    // rows of y accumulated in a local buffer by the DIA kernels
+#define ELL_ROW_BLOCK   512    // rows of y accumulated in a local buffer by the ColMajor ELL kernels
+
+// multilevel graph partition (REORDER_PARTITION): coarsen until this many vertices,
+// allowed nnz imbalance of a bisection and refinement passes per level
+#define PARTITION_COARSEN_TO    128
+#define PARTITION_IMBALANCE     (0.03)
+#define PARTITION_REFINE_PASSES 8
+
+// column-blocked CSR: an x panel fills CBCSR_CACHE_FRACTION of one LLC instance;
+// suggested when x exceeds it, potReuseC >= CBCSR_MIN_POTREUSE_C (a column is touched
+// by that many row tiles on average) and uniqC >= CBCSR_MIN_UNIQC (little x reuse inside a tile)
+#define CBCSR_CACHE_FRACTION (0.5)
+#define CBCSR_MIN_POTREUSE_C (2.0)
+#define CBCSR_MIN_UNIQC      (0.5)
+
+// CSB: default beta = 2^ceil(log2(sqrt(max(rows, cols)))) clamped to [CSB_MIN_BETA, 65536];
+// kernel_flag = 2 splits a block row (or one block) recursively while it holds more than
+// max(CSB_MIN_TASK_NNZ, nnz / (CSB_TASKS_PER_THREAD * threads)) nnzs
+#define CSB_MIN_BETA         64
+#define CSB_TASKS_PER_THREAD 4
+#define CSB_MIN_TASK_NNZ     2048
+
+// transpose SpMV: nnz / cols >= TRANSPOSE_PRIVATE_NNZ_PER_COL scatters into per-thread private
+// column windows, sparser columns color TRANSPOSE_COLOR_BLOCKS row blocks per thread
+#define TRANSPOSE_PRIVATE_NNZ_PER_COL 4
+#define TRANSPOSE_COLOR_BLOCKS        4
+
+// huge pages (memopt.h): arrays below this size keep base pages, 1 GiB pages are only
+// used for arrays of at least MEM_HUGE_1G_MIN_BYTES, smaller ones get 2 MiB pages
+#define MEM_HUGE_PAGE_MIN_BYTES (2ULL << 20)
+#define MEM_HUGE_1G_MIN_BYTES   (1ULL << 30)
+
+// smallest block of an arena sub-arena (arena.h)
+#define ARENA_MIN_BLOCK (64ULL << 10)
+
+// incremental structural updates (sparse_dynamic.h): the delta is merged into the base format
+// in the background once delta + removed entries exceed max(DELTA_MERGE_MIN, DELTA_MERGE_RATIO * nnz);
+// the merge thread converts with DELTA_MERGE_THREADS omp threads, deltas below
+// DELTA_PARALLEL_MIN entries are applied serially in SpMV
+#define DELTA_MERGE_RATIO   (0.05)
+#define DELTA_MERGE_MIN     1024
+#define DELTA_MERGE_THREADS 1
+#define DELTA_PARALLEL_MIN  4096
+
+// value-indexed compression (compress_csr_values): the value table holds at most VALUE_TABLE_MAX
+// entries including 0 (<= 65536), tables of up to 256 entries use 8-bit codes, larger ones 16-bit
+// and only while the table fits in VALUE_TABLE_L1_FRACTION of the L1d of one core.
+// codes + table must stay below VALUE_INDEX_MAX_RATIO of the dense values, otherwise no compression
+#define VALUE_TABLE_MAX        65536
+#define VALUE_TABLE_L1_FRACTION (0.5)
+#define VALUE_INDEX_MAX_RATIO  (0.75)
 
 // OMP paramaters
 #define OMP_ROWS_SIZE 64
@@ -66,5 +118,16 @@
 
 #define MAT_FEATURES    "./features/mat_features.txt"
 #define MAT_PERFORMANCE "./performance/mat_perf.txt"
+#define MAT_SCALING     "./performance/thread_scaling.txt"
+
+// thread sweep: the knee is the first thread count reaching KNEE_RATIO of the peak bandwidth
+#define KNEE_RATIO (0.9)
+
+#define MAT_SOLVER      "./performance/solver_perf.txt"
+
+// Krylov solvers: relative residual tolerance, iteration limit, GMRES restart length
+#define SOLVER_TOL      (1e-8)
+#define SOLVER_MAX_ITER 1000
+#define GMRES_RESTART   30
 
 #endif /* GENERAL_CONFIG_H */
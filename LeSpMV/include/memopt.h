@@ -23,7 +23,100 @@
 #include <memory.h>
 #include <malloc.h>
 #include <stdio.h>
-#include "plat_config.h"
+#include "plat_runtime.h"
+////////////////////////////////////////////////////////////////////
+// page policy of host arrays
+////////////////////////////////////////////////////////////////////
+
+typedef enum
+{
+    MEM_PAGE_DEFAULT    = 0,  // memalign to the cache line, base pages
+    MEM_PAGE_THP        = 1,  // 2 MiB aligned + madvise(MADV_HUGEPAGE), transparent huge pages
+    MEM_PAGE_HUGETLB_2M = 2,  // mmap(MAP_HUGETLB) 2 MiB pages of hugetlbfs, falls back to THP
+    MEM_PAGE_HUGETLB_1G = 3   // mmap(MAP_HUGETLB) 1 GiB pages of hugetlbfs, falls back to 2 MiB
+} MemPagePolicy;
+
+typedef enum
+{
+    MEM_CLASS_MATRIX = 0,     // arrays of the sparse formats, default of new_array()
+    MEM_CLASS_VECTOR = 1,     // x, y and work vectors, new_vector()
+    MEM_CLASS_NUM    = 2
+} MemClass;
+
+/**
+ * @brief Page policy of each array class. The initial policy is read from the
+ *        environment LESPMV_PAGE_MATRIX / LESPMV_PAGE_VECTOR (default, thp, 2m, 1g).
+ *        Arrays smaller than MEM_HUGE_PAGE_MIN_BYTES always use base pages.
+ */
+void Le_set_page_policy(MemClass cls, MemPagePolicy policy);
+
+MemPagePolicy Le_get_page_policy(MemClass cls);
+
+// "default", "thp", "2m" or "1g", return false for an unknown name
+bool Le_parse_page_policy(const char *name, MemPagePolicy &policy);
+
+const char * Le_page_policy_name(MemPagePolicy policy);
+
+// allocate bytes with the policy of cls, aligned at least to the cache line
+void * Le_alloc_pages(const size_t bytes, MemClass cls);
+
+// free memory of Le_alloc_pages(), hugetlbfs mappings are unmapped
+void Le_free_pages(void *p);
+
+////////////////////////////////////////////////////////////////////
+// allocator hooks of new_array() / delete_array()
+////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Allocation hooks for arenas, NUMA-local or pinned memory. allocate must
+ *        return memory aligned at least to the cache line; ctx is passed back unchanged.
+ */
+struct Le_allocator
+{
+    void * (*allocate)(size_t bytes, MemClass cls, void *ctx);
+    void   (*deallocate)(void *p, void *ctx);
+    void   *ctx;
+};
+
+// Le_alloc_pages / Le_free_pages with the page policies above
+const Le_allocator * Le_default_allocator();
+
+/**
+ * @brief Allocator used by new_array() and delete_array(): the override of the calling
+ *        thread if one is set (Le_allocator_scope), otherwise the process-wide one.
+ *        Memory must be freed with the allocator it came from, Le_matrix records it.
+ */
+const Le_allocator * Le_get_allocator();
+
+// process-wide allocator, nullptr restores the default allocator, return the previous one
+const Le_allocator * Le_set_allocator(const Le_allocator *alloc);
+
+// override of the calling thread only, nullptr removes it, return the previous override
+const Le_allocator * Le_set_thread_allocator(const Le_allocator *alloc);
+
+// heap calls of LeSpMV: new_array(), delete_array() and arena blocks, for the benchmark
+void Le_count_heap_call();
+
+long long Le_heap_calls();
+
+/**
+ * @brief Use alloc on the calling thread for the lifetime of the scope, other threads
+ *        keep their allocator. OpenMP workers do not inherit the override: a region that
+ *        allocates captures Le_get_allocator() before it and opens its own scope inside.
+ */
+class Le_allocator_scope
+{
+public:
+    explicit Le_allocator_scope(const Le_allocator *alloc) : prev(Le_set_thread_allocator(alloc)) {}
+    ~Le_allocator_scope() { Le_set_thread_allocator(prev); }
+
+    Le_allocator_scope(const Le_allocator_scope &) = delete;
+    Le_allocator_scope & operator=(const Le_allocator_scope &) = delete;
+
+private:
+    const Le_allocator *prev;
+};
+
 ////////////////////////////////////////////////////////////////////
 // allocate and free data between host and device
 ////////////////////////////////////////////////////////////////////
@@ -33,20 +126,44 @@
  * 
  * @tparam T : float/double, size_t, int, eta.
  * @param N : the array's length
+ * @param cls : page policy class, matrix arrays by default
  * @return T* 
  */
 template <typename T>
-T* new_array(const size_t N){
+T* new_array(const size_t N, MemClass cls = MEM_CLASS_MATRIX){
     //dispatch on location
     // return (T*) malloc(N * sizeof(T));
     
     // aliment memory allocation
-    return (T*) memalign(CACHE_LINE, (uint64_t) N * sizeof(T));
+    const Le_allocator *alloc = Le_get_allocator();
+    Le_count_heap_call();
+    return (T*) alloc->allocate((size_t) N * sizeof(T), cls, alloc->ctx);
+}
+
+/**
+ * @brief new_array() of the vector class (x, y and work vectors)
+ */
+template <typename T>
+T* new_vector(const size_t N){
+    return new_array<T>(N, MEM_CLASS_VECTOR);
 }
 
 template <typename T>
 void delete_array(T* p){
-    free(p);
+    if (p == NULL)
+        return;
+    const Le_allocator *alloc = Le_get_allocator();
+    Le_count_heap_call();
+    alloc->deallocate((void *) p, alloc->ctx);
+}
+
+// free p with the allocator it came from, whatever the current allocator is
+template <typename T>
+void delete_array(T* p, const Le_allocator *alloc){
+    if (p == NULL)
+        return;
+    Le_count_heap_call();
+    alloc->deallocate((void *) p, alloc->ctx);
 }
 
 ////////////////////////////////////////////////////////////////////
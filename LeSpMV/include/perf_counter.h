@@ -0,0 +1,30 @@
+#ifndef PERF_COUNTER_H
+#define PERF_COUNTER_H
+/*
+ * @brief dTLB load misses of the OpenMP threads, counted by perf_event_open.
+ *        Each thread of the team opens a counter for itself in start(), so
+ *        the counts follow the threads that run the kernels.
+ *        When the kernel refuses the event (perf_event_paranoid, containers,
+ *        no PMU) available() is false and stop() returns -1.
+ */
+#include<vector>
+
+class Le_dtlb_counter
+{
+    std::vector<int> fds;
+    bool ok;
+
+    public:
+    Le_dtlb_counter();
+    ~Le_dtlb_counter();
+
+    bool available() const { return ok; }
+
+    // open and enable one counter per thread of Le_get_thread_num()
+    void start();
+
+    // disable, read and close the counters, return the summed misses
+    long long stop();
+};
+
+#endif /* PERF_COUNTER_H */
@@ -0,0 +1,81 @@
+#ifndef PLAT_RUNTIME_H
+#define PLAT_RUNTIME_H
+/*
+ * @brief Runtime platform detection.
+ *        The same parameters as plat_config.h (generated by detect_plat.sh)
+ *        are probed on the running host from sysfs, cpuid and sysconf.
+ *        The compiled-in macros are only used when a probe fails.
+ */
+#include <cstddef>
+#include "plat_config.h"
+
+struct Le_Platform
+{
+    double cpu_frequency;       // Hz
+    double cpu_max_frequency;   // Hz
+    double tick_frequency;      // Hz, calibrated rate of rdtsc() used by timer
+    int cpu_socket;
+    int cpu_cores_per_soc;
+    int cpu_hyper_thread;
+    int numa_regions;
+
+    // Cache size in Bytes, summed over all instances (same as lscpu)
+    size_t l3cache_size;
+    size_t l2cache_size;
+    size_t l1dcache_size;
+    size_t l1icache_size;
+
+    // Cache size in Bytes of one instance (per core / per socket)
+    size_t l3cache_instance;
+    size_t l2cache_instance;
+    size_t l1dcache_instance;
+    size_t cache_line;
+
+    // Main Memory size in Giga Bytes
+    size_t main_mem_size;
+
+    // SIMD width in bits
+    int simd_width;
+    int s_alignment;
+    int d_alignment;
+};
+
+// detected once per process, the first call may take ~10 ms for timer calibration
+const Le_Platform & Le_get_platform();
+
+void Le_print_platform();
+
+int Le_get_simd_width();
+
+size_t Le_get_cache_line();
+
+double Le_get_tick_frequency();
+
+// number of physical cores of all sockets, without hyper threads
+int Le_get_physical_core_num();
+
+// number of hardware threads of all sockets, including hyper threads
+int Le_get_hardware_thread_num();
+
+/**
+ * @brief Logical cpu ids ordered for thread binding, physical cores first
+ *        and hyper-thread siblings last.
+ *        compact = 1 : fill the cores of socket 0, then socket 1, ...
+ *        compact = 0 : round-robin over sockets (scatter)
+ *
+ * @param cpus   output, at least Le_get_hardware_thread_num() entries
+ * @return int   number of cpu ids written, 0 if the topology is unknown
+ */
+int Le_get_cpu_order(int compact, int *cpus);
+
+/**
+ * @brief SIMD lanes of ValueType on this host, used as default alignment
+ *        of ELL-family widths, DIA stride and BSR block columns.
+ */
+template <typename ValueType>
+inline int Le_get_alignment()
+{
+    return Le_get_simd_width() / 8 / sizeof(ValueType);
+}
+
+#endif /* PLAT_RUNTIME_H */
@@ -0,0 +1,121 @@
+/**
+ * @file quant_utils.h
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief Lossy value codes of the quantized storage modes: IEEE binary16 (FP16),
+ *        bfloat16 (BF16) and int8. Codes are scaled to [-1, 1] per row (or row group),
+ *        so the conversions only have to handle normalized magnitudes well.
+ * @version 0.1
+ * @date 2024-04-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef QUANT_UTILS_H
+#define QUANT_UTILS_H
+
+#include<cstdint>
+#include<cstring>
+#include<cmath>
+#if defined(__F16C__)
+#include<immintrin.h>
+#endif
+
+// 16 位编码的两种格式, 用不同的类型区分 kernel 的解码方式
+struct Le_half     { uint16_t bits; };
+struct Le_bfloat16 { uint16_t bits; };
+
+inline float le_bits_to_float(const uint32_t u)
+{
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+inline uint32_t le_float_to_bits(const float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+/**
+ * @brief 解码为 float, 再由调用方转为 ValueType (float / double) 累加
+ */
+inline float le_dequantize(const int8_t q) { return (float) q; }
+
+inline float le_dequantize(const Le_bfloat16 q) { return le_bits_to_float((uint32_t) q.bits << 16); }
+
+inline float le_dequantize(const Le_half q)
+{
+#if defined(__F16C__)
+    return _cvtsh_ss(q.bits);
+#else
+    const uint32_t sign = (uint32_t) (q.bits & 0x8000) << 16;
+    const uint32_t exp  = (q.bits >> 10) & 0x1F;
+    const uint32_t mant = q.bits & 0x3FF;
+    if (exp == 0x1F)
+        return le_bits_to_float(sign | 0x7F800000 | (mant << 13));
+    if (exp != 0)
+        return le_bits_to_float(sign | ((exp + 112) << 23) | (mant << 13));
+    // 非规格化数: mant * 2^-24
+    const float f = (float) mant * (1.0f / 16777216.0f);
+    return sign ? -f : f;
+#endif
+}
+
+/**
+ * @brief 编码, 就近舍入 (ties to even). int8 的输入已按 127 缩放, 截断到 [-127, 127]
+ */
+template <typename Code>
+Code le_quantize(const float v);
+
+template <>
+inline int8_t le_quantize<int8_t>(const float v)
+{
+    const float r = std::nearbyint(v);
+    return (int8_t) (r > 127 ? 127 : (r < -127 ? -127 : r));
+}
+
+template <>
+inline Le_bfloat16 le_quantize<Le_bfloat16>(const float v)
+{
+    const uint32_t u = le_float_to_bits(v);
+    if ((u & 0x7FFFFFFF) > 0x7F800000)
+        return Le_bfloat16{(uint16_t) ((u >> 16) | 0x40)};     // quiet NaN
+    return Le_bfloat16{(uint16_t) ((u + 0x7FFF + ((u >> 16) & 1)) >> 16)};
+}
+
+template <>
+inline Le_half le_quantize<Le_half>(const float v)
+{
+#if defined(__F16C__)
+    return Le_half{(uint16_t) _cvtss_sh(v, 0)};
+#else
+    const uint32_t u    = le_float_to_bits(v);
+    const uint16_t sign = (uint16_t) ((u >> 16) & 0x8000);
+    const uint32_t absu = u & 0x7FFFFFFF;
+    if (absu >= 0x7F800000)                              // Inf / NaN
+        return Le_half{(uint16_t) (sign | 0x7C00 | (absu > 0x7F800000 ? 0x200 : 0))};
+    if (absu >= 0x47800000)                              // >= 65536, 溢出为 Inf
+        return Le_half{(uint16_t) (sign | 0x7C00)};
+    if (absu < 0x38800000)                               // < 2^-14, 非规格化数或 0
+    {
+        if (absu < 0x33000000)
+            return Le_half{sign};
+        const uint32_t mant  = (absu & 0x7FFFFF) | 0x800000;
+        const int      shift = 126 - (int) (absu >> 23);
+        uint32_t h = mant >> shift;
+        const uint32_t rem = mant & ((1u << shift) - 1), half = 1u << (shift - 1);
+        if (rem > half || (rem == half && (h & 1)))
+            ++h;
+        return Le_half{(uint16_t) (sign | h)};
+    }
+    uint32_t h = (absu - 0x38000000) >> 13;               // 指数偏置 127 -> 15
+    const uint32_t rem = absu & 0x1FFF;
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+        ++h;                                             // 进位可以进到指数, 最大进到 Inf
+    return Le_half{(uint16_t) (sign | h)};
+#endif
+}
+
+#endif /* QUANT_UTILS_H */
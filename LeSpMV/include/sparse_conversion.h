@@ -4,7 +4,7 @@
 #include"sparse_format.h"
 #include"sparse_operation.h"
 #include"general_config.h"
-#include"plat_config.h"
+#include"plat_runtime.h"
 #include"thread.h"
 #include"memopt.h"
 #include"timer.h"
@@ -12,6 +12,10 @@
 #include <vector>
 #include <algorithm>
 #include <stdexcept>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+#include <atomic>
 
 // 宏，用于传递当前的函数名、文件名和行号
 #define CHECK_ALLOC(ptr) checkAlloc((ptr), __FUNCTION__, __FILE__, __LINE__)
@@ -26,6 +30,19 @@ inline void checkAlloc(const void* ptr, const char* func, const char* file, int
     }
 }
 
+// 宏, 检查源 CSR 是否带稠密数值: pattern-only 的 CSR 只能转换为 CSR5 / SELL-C-sigma,
+// 值编号压缩 / 量化的 CSR 只能转换为 SELL-C-sigma
+#define CHECK_VALUES(mat) checkValues((mat).value_storage, __FUNCTION__)
+
+inline void checkValues(const ValueStorage storage, const char* func) {
+    if (storage != DenseValues) {
+        std::cerr << func << " needs a matrix with values, pattern-only matrices"
+                  << " support CSR, CSR5 and SELL-C-sigma, value-indexed and quantized"
+                  << " matrices support CSR and SELL-C-sigma" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
 template <class IndexType, class ValueType>
 CSR_Matrix<IndexType, ValueType> coo_to_csr( const COO_Matrix<IndexType, ValueType> &coo, bool compact = false)
 {
@@ -90,60 +107,197 @@ CSR_Matrix<IndexType, ValueType> coo_to_csr( const COO_Matrix<IndexType, ValueTy
     return csr;
 }
 
+/**
+ * @brief 丢弃 CSR 的数值, 原地转为 pattern-only 矩阵 (每个非零元视为 1, values = nullptr).
+ *        之后只能计算 SpMV 或转换为 CSR5 / SELL-C-sigma.
+ */
 template <class IndexType, class ValueType>
-ELL_Matrix<IndexType, ValueType> coo_to_ell( const COO_Matrix<IndexType, ValueType> &coo, const LeadingDimension ld = RowMajor)
+void drop_csr_values(CSR_Matrix<IndexType, ValueType> &csr)
 {
-    ELL_Matrix<IndexType,ValueType> ell;
+    delete_array(csr.values);
+    csr.values = nullptr;
+    csr.value_storage = PatternValues;
+}
 
-    ell.num_rows = coo.num_rows;
-    ell.num_cols = coo.num_cols;
-    ell.num_nnzs = coo.num_nnzs;
+/**
+ * @brief 值表的最大项数: 8 位编号的 256 项总可以, 16 位编号只在值表放得进
+ *        VALUE_TABLE_L1_FRACTION 个 L1d 时使用, 否则查表的随机访问比稠密数值更慢
+ */
+template <class ValueType>
+size_t value_table_capacity()
+{
+    const size_t l1_entries = (size_t) (VALUE_TABLE_L1_FRACTION * Le_get_platform().l1dcache_instance) / sizeof(ValueType);
+    const size_t capacity = std::max((size_t) 256, std::min(l1_entries, (size_t) 65536));
+    return std::min((size_t) VALUE_TABLE_MAX, capacity);
+}
 
-    ell.tag = 0;
-    ell.ld = RowMajor;
-    std::vector<IndexType> rowCounts (ell.num_rows, 0);
+/**
+ * @brief 值编号压缩 (CSR-VI): 不同数值 (含 0) 不超过 value_table_capacity() 个时, 原地把 values 替换为
+ *        值表 value_table 和每个非零元的编号 packed_values, 不超过 256 个用 uint8_t, 否则 uint16_t.
+ *        有限元 / 图矩阵常只有少数几个不同值, 每个非零元的数值流量从 4 / 8 字节降为 1 / 2 字节.
+ *        不同值过多, 编号 + 值表不小于 VALUE_INDEX_MAX_RATIO 倍的稠密数值, 或含 NaN 时
+ *        矩阵保持不变, 返回 false.
+ */
+template <class IndexType, class ValueType>
+bool compress_csr_values(CSR_Matrix<IndexType, ValueType> &csr)
+{
+    CHECK_VALUES(csr);
+    const IndexType nnzs = csr.num_nnzs;
+    const size_t max_table = value_table_capacity<ValueType>();
+    const int thread_num = Le_get_thread_num();
+
+    // Step1. 各线程收集不同的非零值, 任一线程超过上限即全部提前结束
+    std::vector<std::vector<ValueType>> local(thread_num);
+    std::atomic<bool> fits(true);
+    #pragma omp parallel num_threads(thread_num)
+    {
+        std::unordered_set<ValueType> seen;
+        ValueType last = 0;
+        #pragma omp for schedule(static)
+        for (IndexType jj = 0; jj < nnzs; ++jj)
+        {
+            const ValueType v = csr.values[jj];
+            if (v == last || !fits.load(std::memory_order_relaxed))
+                continue;
+            last = v;
+            if (v != v)    // NaN 无法按值查表
+                fits.store(false, std::memory_order_relaxed);
+            else if (v != 0)
+            {
+                seen.insert(v);
+                if (seen.size() >= max_table)
+                    fits.store(false, std::memory_order_relaxed);
+            }
+        }
+        local[Le_get_thread_id()].assign(seen.begin(), seen.end());
+    }
+    if (!fits)
+        return false;
+
+    // Step2. 合并为升序值表, table[0] = 0 (SELL 的填充位也编号为 0)
+    std::vector<ValueType> table(1, ValueType(0));
+    for (const auto &l : local)
+        table.insert(table.end(), l.begin(), l.end());
+    std::sort(table.begin() + 1, table.end());
+    table.erase(std::unique(table.begin() + 1, table.end()), table.end());
+    if (table.size() > max_table)
+        return false;
+
+    // Step3. 只在明显省空间时压缩, 再二分查找编号
+    const ValueStorage storage = table.size() <= 256 ? IndexedValues8 : IndexedValues16;
+    const double indexed_bytes = (double) packed_value_bytes(storage) * nnzs + (double) sizeof(ValueType) * table.size();
+    if (indexed_bytes >= VALUE_INDEX_MAX_RATIO * sizeof(ValueType) * (double) nnzs)
+        return false;
+    unsigned char *packed = new_array<unsigned char>((size_t) nnzs * packed_value_bytes(storage));
+    CHECK_ALLOC(packed);
+    const ValueType *t_begin = table.data() + 1, *t_end = table.data() + table.size();
+    #pragma omp parallel for schedule(static) num_threads(thread_num)
+    for (IndexType jj = 0; jj < nnzs; ++jj)
+    {
+        const ValueType v = csr.values[jj];
+        const size_t code = v == 0 ? 0 : std::lower_bound(t_begin, t_end, v) - table.data();
+        if (storage == IndexedValues8)
+            packed[jj] = (uint8_t) code;
+        else
+            ((uint16_t *) packed)[jj] = (uint16_t) code;
+    }
+
+    delete_array(csr.values);
+    csr.values = nullptr;
+    csr.packed_values = packed;
+    csr.value_table_size = (IndexType) table.size();
+    csr.value_table = new_array<ValueType>(table.size());
+    CHECK_ALLOC(csr.value_table);
+    std::copy(table.begin(), table.end(), csr.value_table);
+    csr.value_storage = storage;
+    return true;
+}
+
+/**
+ * @brief 量化数值的缩放因子: FP16 / BF16 取不小于 max|a| 的 2 的幂 (除法无舍入, 编码落在 [-1, 1]),
+ *        int8 取 max|a| / 127. 全零的行组为 1.
+ */
+template <class ValueType>
+ValueType quantize_scale(const ValueType max_abs, const ValueStorage storage)
+{
+    if (!(max_abs > 0) || !std::isfinite(max_abs))
+        return ValueType(1);
+    if (storage == Int8Values)
+        return max_abs / 127;
+    int e;
+    std::frexp(max_abs, &e);
+    return std::ldexp(ValueType(1), e);
+}
+
+template <class Code, class ValueType>
+void quantize_values(const ValueType *values, const size_t n, const ValueType scale, unsigned char *codes)
+{
+    const ValueType inv = ValueType(1) / scale;
+    Code *q = (Code *) codes;
+    for (size_t k = 0; k < n; ++k)
+        q[k] = le_quantize<Code>((float) (values[k] * inv));
+}
 
-    for (IndexType i = 0; i < coo.num_nnzs; i++){
-        rowCounts[coo.row_index[i]]++;
+template <class ValueType>
+void quantize_values(const ValueStorage storage, const ValueType *values, const size_t n, const ValueType scale, unsigned char *codes)
+{
+    switch (storage)
+    {
+        case HalfValues:     quantize_values<Le_half>(values, n, scale, codes); break;
+        case BFloat16Values: quantize_values<Le_bfloat16>(values, n, scale, codes); break;
+        default:             quantize_values<int8_t>(values, n, scale, codes); break;
     }
+}
 
-    ell.max_row_width = *std::max_element(rowCounts.begin(), rowCounts.end());
-    // 分配矩阵空间
-    ell.col_index = new_array<IndexType> ((size_t) ell.num_rows * ell.max_row_width);
-    CHECK_ALLOC(ell.col_index);
-    ell.values    = new_array<ValueType> ((size_t) ell.num_rows * ell.max_row_width);
-    CHECK_ALLOC(ell.values);
-    // 初始化ELL格式的数组
-    std::fill_n(ell.col_index, ell.num_rows*ell.max_row_width, static_cast<IndexType> (-1)); // 使用 -1 作为填充值，因为它不是有效的列索引
-    std::fill_n(ell.values, ell.num_rows*ell.max_row_width, static_cast<ValueType> (0)); // 零填充values
-
-    // 用COO数据填充ELL数组
-    std::vector<IndexType> currentPos(ell.num_rows, 0); // 跟踪每行当前填充位置
-    if (ColMajor == ell.ld){
-        for (size_t i = 0; i < ell.num_nnzs; ++i) {
-            size_t row = coo.row_index[i];
-            size_t pos = row + (size_t) currentPos[row] * ell.num_rows;
-            ell.values[pos] = coo.values[i];
-            ell.col_index[pos] = coo.col_index[i];
-            currentPos[row]++;
-        }
+inline void checkQuantized(const ValueStorage storage, const char* func) {
+    if (storage != HalfValues && storage != BFloat16Values && storage != Int8Values) {
+        std::cerr << func << ": storage must be HalfValues, BFloat16Values or Int8Values" << std::endl;
+        exit(EXIT_FAILURE);
     }
-    else if (RowMajor == ell.ld){
-        for (size_t i = 0; i < ell.num_nnzs; ++i) {
-            size_t row = coo.row_index[i];
-            size_t pos = (size_t) row * ell.max_row_width + currentPos[row];
-            ell.values[pos] = coo.values[i];
-            ell.col_index[pos] = coo.col_index[i];
-            currentPos[row]++;
-        }
+}
+
+/**
+ * @brief 有损的量化存储: values 原地替换为 FP16 / BF16 / int8 编码 (packed_values), 每 scale_rows
+ *        个相邻行共用一个缩放因子 value_scale (1 为逐行). SpMV 在寄存器中解码, 以 ValueType 累加,
+ *        每个非零元的数值流量为 2 / 1 字节. 逐行缩放的 CSR 可再转换为 SELL-C-sigma.
+ */
+template <class IndexType, class ValueType>
+void quantize_csr_values(CSR_Matrix<IndexType, ValueType> &csr, const ValueStorage storage, const IndexType scale_rows = 1)
+{
+    CHECK_VALUES(csr);
+    checkQuantized(storage, __FUNCTION__);
+    const IndexType groups = (csr.num_rows + scale_rows - 1) / scale_rows;
+    const size_t code_bytes = packed_value_bytes(storage);
+
+    ValueType *scale = new_array<ValueType>(std::max(groups, (IndexType) 1));
+    CHECK_ALLOC(scale);
+    unsigned char *packed = new_array<unsigned char>((size_t) csr.num_nnzs * code_bytes);
+    CHECK_ALLOC(packed);
+
+    #pragma omp parallel for schedule(dynamic, 64) num_threads(Le_get_thread_num())
+    for (IndexType grp = 0; grp < groups; ++grp)
+    {
+        const IndexType begin = csr.row_offset[grp * scale_rows];
+        const IndexType end   = csr.row_offset[std::min((grp + 1) * scale_rows, csr.num_rows)];
+        ValueType max_abs = 0;
+        for (IndexType jj = begin; jj < end; ++jj)
+            max_abs = std::max(max_abs, (ValueType) std::fabs(csr.values[jj]));
+        scale[grp] = quantize_scale(max_abs, storage);
+        quantize_values(storage, csr.values + begin, (size_t) (end - begin), scale[grp], packed + (size_t) begin * code_bytes);
     }
 
-    return ell;
+    delete_array(csr.values);
+    csr.values = nullptr;
+    csr.packed_values = packed;
+    csr.value_scale   = scale;
+    csr.scale_rows    = scale_rows;
+    csr.value_storage = storage;
 }
 
 template <class IndexType, class ValueType>
 COO_Matrix<IndexType, ValueType> csr_to_coo( const CSR_Matrix<IndexType, ValueType> &csr)
 {
+    CHECK_VALUES(csr);
     COO_Matrix<IndexType, ValueType> coo;
 
     coo.num_rows = csr.num_rows;
@@ -164,9 +318,57 @@ COO_Matrix<IndexType, ValueType> csr_to_coo( const CSR_Matrix<IndexType, ValueTy
             coo.values[i] = csr.values[i];          // 非零值
         }
     }
+    coo.row_sorted = true;
     return coo;
 }
 
+/**
+ * @brief Stable counting sort of the COO triplets by row index (O(nnz + rows)),
+ *        the analysis step of the load balanced COO kernel (kernel_flag = 2),
+ *        sets coo.row_sorted.
+ *        csr_to_coo() already gives row-sorted COO, MatrixMarket files are
+ *        usually column-sorted.
+ */
+template <class IndexType, class ValueType>
+void sort_coo_by_row(COO_Matrix<IndexType, ValueType> &coo)
+{
+    bool sorted = true;
+    for (IndexType i = 1; i < coo.num_nnzs && sorted; ++i)
+        sorted = coo.row_index[i - 1] <= coo.row_index[i];
+    coo.row_sorted = true;
+    if (sorted)
+        return;
+
+    IndexType * row_ptr = new_array<IndexType> (coo.num_rows + 1);
+    CHECK_ALLOC(row_ptr);
+    std::fill_n(row_ptr, coo.num_rows + 1, static_cast<IndexType> (0));
+    for (IndexType i = 0; i < coo.num_nnzs; ++i)
+        row_ptr[coo.row_index[i] + 1]++;
+    for (IndexType row = 0; row < coo.num_rows; ++row)
+        row_ptr[row + 1] += row_ptr[row];
+
+    IndexType * col_index = new_array<IndexType> (coo.num_nnzs);
+    CHECK_ALLOC(col_index);
+    ValueType * values    = new_array<ValueType> (coo.num_nnzs);
+    CHECK_ALLOC(values);
+    for (IndexType i = 0; i < coo.num_nnzs; ++i)
+    {
+        IndexType dst = row_ptr[coo.row_index[i]]++;
+        col_index[dst] = coo.col_index[i];
+        values[dst]    = coo.values[i];
+    }
+    // row_ptr 现在是每行的结束位置
+    for (IndexType row = 0, i = 0; row < coo.num_rows; ++row)
+        for (; i < row_ptr[row]; ++i)
+            coo.row_index[i] = row;
+
+    delete_array(coo.col_index);
+    delete_array(coo.values);
+    coo.col_index = col_index;
+    coo.values    = values;
+    delete_array(row_ptr);
+}
+
 /**
  * @brief Create the ELL format matrix from CSR format in row-major
  *        This routine do not delete the CSR_Matrix handle
@@ -186,6 +388,7 @@ COO_Matrix<IndexType, ValueType> csr_to_coo( const CSR_Matrix<IndexType, ValueTy
 template <class IndexType, class ValueType>
 ELL_Matrix<IndexType, ValueType> csr_to_ell(const CSR_Matrix<IndexType, ValueType> &csr, const LeadingDimension ld = RowMajor)
 {
+    CHECK_VALUES(csr);
     ELL_Matrix<IndexType,ValueType> ell;
 
     ell.num_rows = csr.num_rows;
@@ -194,13 +397,18 @@ ELL_Matrix<IndexType, ValueType> csr_to_ell(const CSR_Matrix<IndexType, ValueTyp
 
     ell.tag = 0;
     ell.ld = ld;
+    const IndexType thread_num = Le_get_thread_num();
     IndexType max_nnz_per_row = 0;
+    IndexType min_nnz_per_row = (csr.num_rows > 0) ? csr.num_nnzs : 0;
     //计算每行的非零元数量并找到最大值
-    for (size_t i = 0; i < csr.num_rows; i++)
+    #pragma omp parallel for num_threads(thread_num) reduction(max:max_nnz_per_row) reduction(min:min_nnz_per_row)
+    for (IndexType i = 0; i < csr.num_rows; i++)
     {
         max_nnz_per_row = std::max( max_nnz_per_row, csr.row_offset[i+1] - csr.row_offset[i]);
+        min_nnz_per_row = std::min( min_nnz_per_row, csr.row_offset[i+1] - csr.row_offset[i]);
     }
     ell.max_row_width = max_nnz_per_row;
+    ell.min_row_width = min_nnz_per_row;
 
     // 分配矩阵空间
     ell.col_index = new_array<IndexType> ((size_t) ell.num_rows * ell.max_row_width);
@@ -208,45 +416,103 @@ ELL_Matrix<IndexType, ValueType> csr_to_ell(const CSR_Matrix<IndexType, ValueTyp
     ell.values    = new_array<ValueType> ((size_t) ell.num_rows * ell.max_row_width);
     CHECK_ALLOC(ell.values);
 
-    // 初始化ELL格式的数组
-    std::fill_n(ell.col_index, ell.num_rows*ell.max_row_width, static_cast<IndexType> (-1)); // 使用 -1 作为填充值，因为它不是有效的列索引
-    std::fill_n(ell.values, ell.num_rows*ell.max_row_width, static_cast<ValueType> (0)); // 零填充values
-
     if (ColMajor == ld)
     {
-        // 给ELL格式的两个数组进行赋值, col-major
-        #pragma omp parallel for
-        for (size_t rowId = 0; rowId < ell.num_rows; ++rowId)
+        // col-major: 第 item 列的各行连续, 按行块并行填充 (first touch 与 kernel 的行划分一致)
+        const IndexType num_blocks = (ell.num_rows + ELL_ROW_BLOCK - 1) / ELL_ROW_BLOCK;
+        #pragma omp parallel for num_threads(thread_num)
+        for (IndexType b = 0; b < num_blocks; ++b)
         {
-            size_t ellIndex = rowId;
-            // 遍历 CSR row_ptr中 这行的所有非零元素
-            for (size_t csrIndex = csr.row_offset[rowId]; csrIndex < csr.row_offset[rowId+1]; ++csrIndex)
+            const IndexType rs = b * ELL_ROW_BLOCK;
+            const IndexType re = std::min(ell.num_rows, rs + (IndexType) ELL_ROW_BLOCK);
+            for (IndexType item = 0; item < ell.max_row_width; ++item)
             {
-                ell.col_index[ellIndex] = csr.col_index[csrIndex];
-                ell.values[ellIndex]    =    csr.values[csrIndex];
-                ellIndex += ell.num_rows;
+                std::fill(ell.col_index + (size_t) item * ell.num_rows + rs, ell.col_index + (size_t) item * ell.num_rows + re, static_cast<IndexType> (-1));
+                std::fill(ell.values    + (size_t) item * ell.num_rows + rs, ell.values    + (size_t) item * ell.num_rows + re, ValueType(0));
+            }
+            for (IndexType rowId = rs; rowId < re; ++rowId)
+            {
+                size_t ellIndex = rowId;
+                // 遍历 CSR row_ptr中 这行的所有非零元素
+                for (IndexType csrIndex = csr.row_offset[rowId]; csrIndex < csr.row_offset[rowId+1]; ++csrIndex)
+                {
+                    ell.col_index[ellIndex] = csr.col_index[csrIndex];
+                    ell.values[ellIndex]    =    csr.values[csrIndex];
+                    ellIndex += ell.num_rows;
+                }
             }
         }
     }
     else if (RowMajor == ld)
     {
-        // 给ELL格式的两个数组进行赋值, row-major
-        #pragma omp parallel for
-        for (size_t rowId = 0; rowId < ell.num_rows; ++rowId)
+        // 给ELL格式的两个数组进行赋值, row-major, 填充值 -1 / 0 只写每行剩余部分
+        #pragma omp parallel for num_threads(thread_num)
+        for (IndexType rowId = 0; rowId < ell.num_rows; ++rowId)
         {
-            size_t ellIndex = rowId * ell.max_row_width;
+            size_t ellIndex = (size_t) rowId * ell.max_row_width;
             // 遍历 CSR row_ptr中 这行的所有非零元素
-            for (size_t csrIndex = csr.row_offset[rowId]; csrIndex < csr.row_offset[rowId+1]; ++csrIndex)
+            for (IndexType csrIndex = csr.row_offset[rowId]; csrIndex < csr.row_offset[rowId+1]; ++csrIndex)
             {
                 ell.col_index[ellIndex] = csr.col_index[csrIndex];
                 ell.values[ellIndex]    =    csr.values[csrIndex];
                 ellIndex ++;
-            }   
+            }
+            const size_t rowEnd = (size_t) (rowId + 1) * ell.max_row_width;
+            std::fill(ell.col_index + ellIndex, ell.col_index + rowEnd, static_cast<IndexType> (-1));
+            std::fill(ell.values    + ellIndex, ell.values    + rowEnd, ValueType(0));
         }
     }
     return ell;
 }
 
+/**
+ * @brief ELL from COO through CSR: coo_to_csr() keeps the order of the triplets within
+ *        each row, csr_to_ell() fills the ld layout in parallel
+ */
+template <class IndexType, class ValueType>
+ELL_Matrix<IndexType, ValueType> coo_to_ell( const COO_Matrix<IndexType, ValueType> &coo, const LeadingDimension ld = RowMajor)
+{
+    CSR_Matrix<IndexType, ValueType> csr = coo_to_csr(coo);
+    ELL_Matrix<IndexType, ValueType> ell = csr_to_ell(csr, ld);
+    delete_csr_matrix(csr);
+    return ell;
+}
+
+/**
+ * @brief SELL 系列格式的连续存储: chunk_ptr 为 chunk_width[chunk] * rows_per_chunk 的前缀和,
+ *        col_index / values 各一次对齐分配. 填充 col = -1, val = 0 按 chunk 并行完成,
+ *        与 kernel 相同的 static 划分使 chunk 的内存由使用它的线程 first touch.
+ *        with_values = false 时 (pattern-only) 不分配 values, values = nullptr.
+ */
+template <class IndexType, class ValueType>
+void alloc_sell_chunks(const IndexType chunk_num, const IndexType *chunk_width, const IndexType rows_per_chunk,
+                       IndexType *&chunk_ptr, IndexType *&col_index, ValueType *&values, const bool with_values = true)
+{
+    chunk_ptr = new_array<IndexType>(chunk_num + 1);
+    CHECK_ALLOC(chunk_ptr);
+    chunk_ptr[0] = 0;
+    for (IndexType chunk = 0; chunk < chunk_num; ++chunk)
+        chunk_ptr[chunk + 1] = chunk_ptr[chunk] + chunk_width[chunk] * rows_per_chunk;
+
+    const size_t elem_nums = chunk_ptr[chunk_num];
+    col_index = new_array<IndexType>(elem_nums);
+    CHECK_ALLOC(col_index);
+    values    = nullptr;
+    if (with_values)
+    {
+        values = new_array<ValueType>(elem_nums);
+        CHECK_ALLOC(values);
+    }
+
+    #pragma omp parallel for num_threads(Le_get_thread_num())
+    for (IndexType chunk = 0; chunk < chunk_num; ++chunk)
+    {
+        std::fill(col_index + chunk_ptr[chunk], col_index + chunk_ptr[chunk + 1], static_cast<IndexType>(-1));
+        if (with_values)
+            std::fill(values + chunk_ptr[chunk], values + chunk_ptr[chunk + 1], ValueType(0));
+    }
+}
+
 /**
  * @brief CSR to S_ELL format conversion
  *        Alignment in AVX512: float should be 4 bytes * 16 = 64 bytes. 
@@ -255,8 +521,9 @@ ELL_Matrix<IndexType, ValueType> csr_to_ell(const CSR_Matrix<IndexType, ValueTyp
  * @tparam ValueType 
  */
 template <class IndexType, class ValueType>
-S_ELL_Matrix<IndexType, ValueType> csr_to_sell(const CSR_Matrix<IndexType, ValueType> &csr, FILE *fp_feature, const int chunkwidth = CHUNK_SIZE,  const IndexType alignment = (SIMD_WIDTH/8/sizeof(ValueType)))
+S_ELL_Matrix<IndexType, ValueType> csr_to_sell(const CSR_Matrix<IndexType, ValueType> &csr, FILE *fp_feature, const int chunkwidth = CHUNK_SIZE,  const IndexType alignment = Le_get_alignment<ValueType>())
 {
+    CHECK_VALUES(csr);
     S_ELL_Matrix<IndexType, ValueType> sell;
 
     sell.num_rows = csr.num_rows;
@@ -276,65 +543,53 @@ S_ELL_Matrix<IndexType, ValueType> csr_to_sell(const CSR_Matrix<IndexType, Value
     CHECK_ALLOC(sell.row_width);
     memset(sell.row_width, 0 , sell.chunk_num * sizeof(IndexType));
 
-    // #pragma omp parallel for
-    for (IndexType row = 0; row < csr.num_rows; ++row) {
-        IndexType chunk_id = row / sell.sliceWidth;
-        IndexType row_nnz = csr.row_offset[row + 1] - csr.row_offset[row];
-        sell.row_width[chunk_id] = std::max(sell.row_width[chunk_id], row_nnz);
-    }
-    // 对每个chunk的最大行宽度进行对齐
-    // for (IndexType& width : sell.row_width) {
-    //     width = ((width + sell.alignment - 1) / sell.alignment) * sell.alignment;
-    // }
-    #pragma omp parallel for
-    for (IndexType i = 0; i < sell.chunk_num; i++)
+    // chunk 内按列优先存储: 第 i 列的 sliceWidth 行连续, pos = i * sliceWidth + row_within_chunk,
+    // kernel 在 chunk 内跨行做 SIMD, 填充位置 col = -1, val = 0
+    const IndexType thread_num = Le_get_thread_num();
+    #pragma omp parallel for num_threads(thread_num)
+    for (IndexType chunk = 0; chunk < sell.chunk_num; ++chunk)
     {
-        sell.row_width[i] = ((sell.row_width[i] + sell.alignment - 1) / sell.alignment) * sell.alignment;
-    }
-    
-    // 为每个chunk的行指针数组分配内存
-    sell.col_index = new IndexType*[sell.chunk_num];
-    sell.values = new ValueType*[sell.chunk_num];
-    for (IndexType chunk = 0; chunk < sell.chunk_num; ++chunk) {
-        size_t elem_nums = sell.row_width[chunk] * sell.sliceWidth;
-
-        sell.col_index[chunk] = new_array<IndexType> (elem_nums);
-        CHECK_ALLOC(sell.col_index[chunk]);
-        // 初始化col_index中的每个元素为-1
-        std::fill_n(sell.col_index[chunk], elem_nums, static_cast<IndexType>(-1));
-
-        sell.values[chunk] = new_array<ValueType> (elem_nums);
-        CHECK_ALLOC(sell.values[chunk]);
-        // 初始化values中的每个元素为0
-        std::fill_n(sell.values[chunk], elem_nums, ValueType(0));
+        const IndexType row_begin = chunk * sell.sliceWidth;
+        const IndexType row_end   = std::min(csr.num_rows, row_begin + sell.sliceWidth);
+
+        IndexType width = 0;
+        for (IndexType row = row_begin; row < row_end; ++row)
+            width = std::max(width, csr.row_offset[row + 1] - csr.row_offset[row]);
+        // 对每个chunk的最大行宽度进行对齐
+        sell.row_width[chunk] = ((width + sell.alignment - 1) / sell.alignment) * sell.alignment;
     }
 
+    alloc_sell_chunks(sell.chunk_num, (const IndexType *) sell.row_width, sell.sliceWidth, sell.chunk_ptr, sell.col_index, sell.values);
 
     //转换 CSR 到 S-ELL
-    #pragma omp parallel for
-    for (IndexType row = 0; row < csr.num_rows; ++row)
+    #pragma omp parallel for num_threads(thread_num)
+    for (IndexType chunk = 0; chunk < sell.chunk_num; ++chunk)
     {
-        IndexType chunk_id         = row / sell.sliceWidth;    // 所属的 chunk 号
-        IndexType row_within_chunk = row % sell.sliceWidth; // chunk 内部的行号 0 ~ sliceWidth-1
-        IndexType row_start        = csr.row_offset[row];
-        IndexType row_end          = csr.row_offset[row+1];
+        const IndexType row_begin = chunk * sell.sliceWidth;
+        const IndexType row_end   = std::min(csr.num_rows, row_begin + sell.sliceWidth);
+        IndexType * chunk_col = sell.chunk_col(chunk);
+        ValueType * chunk_val = sell.chunk_val(chunk);
 
-        for (IndexType idx = row_start; idx < row_end; idx++)
+        for (IndexType row = row_begin; row < row_end; ++row)
         {
-            IndexType col = csr.col_index[idx];
-            ValueType val = csr.values[idx];
+            IndexType row_within_chunk = row - row_begin; // chunk 内部的行号 0 ~ sliceWidth-1
+            IndexType row_start        = csr.row_offset[row];
+            IndexType row_end          = csr.row_offset[row+1];
 
-            IndexType pos = row_within_chunk * sell.row_width[chunk_id] + (idx - row_start);
-            sell.col_index[chunk_id][pos] = col;
-            sell.values[chunk_id][pos] = val;
-        } 
+            for (IndexType idx = row_start; idx < row_end; idx++)
+            {
+                size_t pos = (size_t) (idx - row_start) * sell.sliceWidth + row_within_chunk;
+                chunk_col[pos] = csr.col_index[idx];
+                chunk_val[pos] = csr.values[idx];
+            }
+        }
     }
     
     return sell;
 }
 
 template <class IndexType, class ValueType>
-SELL_C_Sigma_Matrix<IndexType, ValueType> csr_to_sell_c_sigma(const CSR_Matrix<IndexType, ValueType> &csr, FILE *fp_feature, const int slicewidth = SELL_SIGMA, const int chunkwidth = CHUNK_SIZE,  const IndexType alignment = (SIMD_WIDTH/8/sizeof(ValueType)))
+SELL_C_Sigma_Matrix<IndexType, ValueType> csr_to_sell_c_sigma(const CSR_Matrix<IndexType, ValueType> &csr, FILE *fp_feature, const int slicewidth = SELL_SIGMA, const int chunkwidth = Le_get_alignment<ValueType>(),  const IndexType alignment = Le_get_alignment<ValueType>())
 {
     SELL_C_Sigma_Matrix<IndexType, ValueType> sell_c_sigma;
 
@@ -371,7 +626,11 @@ SELL_C_Sigma_Matrix<IndexType, ValueType> csr_to_sell_c_sigma(const CSR_Matrix<I
     //  Step1. 确定重排序数组 
     /*-----------------------------------------------*/
     // Create a vector to hold the number of non-zeros per row and the original row index
-    std::vector<std::pair<IndexType, IndexType>> nnz_count(csr.num_rows);
+    // 临时数组取自调用线程的 arena, 反复转换时复用同一块内存
+    Le_arena &arena = Le_thread_arena();
+    arena.reserve_threads(1);
+    Le_arena_scope scope(arena);
+    std::pair<IndexType, IndexType> *nnz_count = arena.alloc_array<std::pair<IndexType, IndexType>>(csr.num_rows);
 
     // Count the non-zeros for each row
     #pragma omp parallel for
@@ -388,7 +647,7 @@ SELL_C_Sigma_Matrix<IndexType, ValueType> csr_to_sell_c_sigma(const CSR_Matrix<I
         IndexType end_row = std::min(start_row + sell_c_sigma.sliceWidth_Sigma, csr.num_rows);
 
         // Sort the rows in the slice by non-zero count
-        std::sort(nnz_count.begin() + start_row, nnz_count.begin() + end_row,
+        std::sort(nnz_count + start_row, nnz_count + end_row,
             std::greater<std::pair<IndexType, IndexType>>());
 
         // Fill the sell_c_sigma.reorder array with the new order of the rows
@@ -435,20 +694,40 @@ SELL_C_Sigma_Matrix<IndexType, ValueType> csr_to_sell_c_sigma(const CSR_Matrix<I
     /*-----------------------------------------------*/
     //  Step3. 确定 col_index 和  values. 在计算时可以只看chunk了
     /*-----------------------------------------------*/
-    sell_c_sigma.col_index = new IndexType*[sell_c_sigma.validchunkNum];
-    sell_c_sigma.values    = new ValueType*[sell_c_sigma.validchunkNum];
-    for (IndexType chunk = 0; chunk < sell_c_sigma.validchunkNum; chunk++)
+    // pattern-only 的 CSR 只转换列号, 值编号压缩 / 量化的 CSR 转换编号并复制值表 (SELL-VI) 或缩放因子
+    sell_c_sigma.value_storage = csr.value_storage;
+    const bool with_values = (csr.value_storage == DenseValues);
+    const size_t code_bytes = packed_value_bytes(csr.value_storage);
+    alloc_sell_chunks(sell_c_sigma.validchunkNum, (const IndexType *) sell_c_sigma.chunk_len, sell_c_sigma.chunkWidth_C, sell_c_sigma.chunk_ptr, sell_c_sigma.col_index, sell_c_sigma.values, with_values);
+    if (code_bytes > 0)
     {
-        size_t elem_nums = sell_c_sigma.chunk_len[chunk] * sell_c_sigma.chunkWidth_C;
-        sell_c_sigma.col_index[chunk] = new_array<IndexType> (elem_nums);
-        CHECK_ALLOC(sell_c_sigma.col_index[chunk]);
-        // 初始化 col_index 中每个元素为 -1
-        std::fill_n(sell_c_sigma.col_index[chunk], elem_nums, static_cast<IndexType>(-1));
-
-        sell_c_sigma.values[chunk] = new_array<ValueType> (elem_nums);
-        CHECK_ALLOC(sell_c_sigma.values[chunk]);
-        // 初始化 values 中每个元素为 0 
-        std::fill_n(sell_c_sigma.values[chunk], elem_nums, ValueType(0));
+        sell_c_sigma.packed_values = new_array<unsigned char>((size_t) sell_c_sigma.chunk_ptr[sell_c_sigma.validchunkNum] * code_bytes);
+        CHECK_ALLOC(sell_c_sigma.packed_values);
+        #pragma omp parallel for num_threads(Le_get_thread_num())
+        for (IndexType chunk = 0; chunk < sell_c_sigma.validchunkNum; ++chunk)
+            std::fill(sell_c_sigma.packed_values + sell_c_sigma.chunk_ptr[chunk] * code_bytes,
+                      sell_c_sigma.packed_values + sell_c_sigma.chunk_ptr[chunk + 1] * code_bytes, (unsigned char) 0);
+        if (csr.value_table != nullptr)
+        {
+            sell_c_sigma.value_table_size = csr.value_table_size;
+            sell_c_sigma.value_table = copy_array(csr.value_table, (size_t) csr.value_table_size);
+        }
+    }
+    // 量化数值: 逐行的缩放因子随行重排, 行组缩放跨越重排的行, 需在 SELL 上重新量化
+    if (csr.value_scale != nullptr)
+    {
+        if (csr.scale_rows != 1)
+        {
+            std::cerr << __FUNCTION__ << ": convert a CSR with per-row scales (scale_rows = 1),"
+                      << " use quantize_sell_c_sigma_values for per-chunk scales" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        sell_c_sigma.scale_rows  = 1;
+        sell_c_sigma.value_scale = new_array<ValueType>(std::max(csr.num_rows, (IndexType) 1));
+        CHECK_ALLOC(sell_c_sigma.value_scale);
+        #pragma omp parallel for
+        for (IndexType row = 0; row < csr.num_rows; ++row)
+            sell_c_sigma.value_scale[row] = csr.value_scale[sell_c_sigma.reorder[row]];
     }
 
     //转换 CSR 到 S-ELL-c-sigma
@@ -466,22 +745,96 @@ SELL_C_Sigma_Matrix<IndexType, ValueType> csr_to_sell_c_sigma(const CSR_Matrix<I
 
         for (IndexType idx = row_start; idx < row_end; idx++)
         {
-            IndexType col = csr.col_index[idx];
-            ValueType val = csr.values[idx];
-
-            IndexType pos = row_within_chunk * sell_c_sigma.chunk_len[chunk_id] + (idx - row_start);
-            sell_c_sigma.col_index[chunk_id][pos] = col;
-            sell_c_sigma.values[chunk_id][pos]    = val;
+            // chunk 内按列存储: 第 j 个元素的 C 行连续, kernel 以 C 行为 SIMD lane
+            IndexType pos = (idx - row_start) * sell_c_sigma.chunkWidth_C + row_within_chunk;
+            sell_c_sigma.chunk_col(chunk_id)[pos] = csr.col_index[idx];
+            if (with_values)
+                sell_c_sigma.chunk_val(chunk_id)[pos] = csr.values[idx];
+            else if (code_bytes > 0)
+                std::copy(csr.packed_values + idx * code_bytes, csr.packed_values + (idx + 1) * code_bytes,
+                          sell_c_sigma.packed_values + (sell_c_sigma.chunk_ptr[chunk_id] + pos) * code_bytes);
         }
     }
 
+    // 保留源 CSR 的行偏移, 数值更新时无需重新转换
+    sell_c_sigma.csr_row_offset = copy_array(csr.row_offset, csr.num_rows + 1);
+
     return sell_c_sigma;
 }
 
+/**
+ * @brief SELL-C-sigma 的量化存储, 与 quantize_csr_values 相同. 缩放因子按重排后的行组计:
+ *        scale_rows = chunkWidth_C 时每个 chunk 一个 (并入 kernel 的 alpha), 1 时逐行.
+ *        填充位的值为 0, 编码也为 0.
+ */
+template <class IndexType, class ValueType>
+void quantize_sell_c_sigma_values(SELL_C_Sigma_Matrix<IndexType, ValueType> &sell_c_sigma, const ValueStorage storage, IndexType scale_rows = 0)
+{
+    CHECK_VALUES(sell_c_sigma);
+    checkQuantized(storage, __FUNCTION__);
+    if (scale_rows <= 0)
+        scale_rows = sell_c_sigma.chunkWidth_C;
+    const IndexType C = sell_c_sigma.chunkWidth_C;
+    const IndexType num_rows = sell_c_sigma.num_rows;
+    const IndexType groups = (num_rows + scale_rows - 1) / scale_rows;
+    const size_t code_bytes = packed_value_bytes(storage);
+    const size_t elem_nums = sell_c_sigma.chunk_ptr[sell_c_sigma.validchunkNum];
+
+    // Step1. 每个重排后行的 max|a|: 第 row 行位于 chunk_val(row / C)[j * C + row % C]
+    std::vector<ValueType> row_max(num_rows, ValueType(0));
+    #pragma omp parallel for num_threads(Le_get_thread_num())
+    for (IndexType row = 0; row < num_rows; ++row)
+    {
+        const IndexType chunk = row / C;
+        const ValueType *v = sell_c_sigma.chunk_val(chunk) + row % C;
+        ValueType max_abs = 0;
+        for (IndexType j = 0; j < sell_c_sigma.chunk_len[chunk]; ++j)
+            max_abs = std::max(max_abs, (ValueType) std::fabs(v[(size_t) j * C]));
+        row_max[row] = max_abs;
+    }
+
+    ValueType *scale = new_array<ValueType>(std::max(groups, (IndexType) 1));
+    CHECK_ALLOC(scale);
+    #pragma omp parallel for num_threads(Le_get_thread_num())
+    for (IndexType grp = 0; grp < groups; ++grp)
+    {
+        ValueType max_abs = 0;
+        for (IndexType row = grp * scale_rows; row < std::min((grp + 1) * scale_rows, num_rows); ++row)
+            max_abs = std::max(max_abs, row_max[row]);
+        scale[grp] = quantize_scale(max_abs, storage);
+    }
+
+    // Step2. 按 chunk 编码, 与 alloc_sell_chunks 相同的 static 划分 first touch
+    unsigned char *packed = new_array<unsigned char>(elem_nums * code_bytes);
+    CHECK_ALLOC(packed);
+    #pragma omp parallel for num_threads(Le_get_thread_num())
+    for (IndexType chunk = 0; chunk < sell_c_sigma.validchunkNum; ++chunk)
+    {
+        const ValueType *v = sell_c_sigma.chunk_val(chunk);
+        unsigned char *q = packed + (size_t) sell_c_sigma.chunk_ptr[chunk] * code_bytes;
+        const IndexType rows_in_chunk = std::min(C, num_rows - chunk * C);
+        for (IndexType j = 0; j < sell_c_sigma.chunk_len[chunk]; ++j)
+            for (IndexType lane = 0; lane < C; ++lane)
+            {
+                const size_t pos = (size_t) j * C + lane;
+                const ValueType s = lane < rows_in_chunk ? scale[(chunk * C + lane) / scale_rows] : ValueType(1);
+                quantize_values(storage, v + pos, 1, s, q + pos * code_bytes);
+            }
+    }
+
+    delete_array(sell_c_sigma.values);
+    sell_c_sigma.values = nullptr;
+    sell_c_sigma.packed_values = packed;
+    sell_c_sigma.value_scale   = scale;
+    sell_c_sigma.scale_rows    = scale_rows;
+    sell_c_sigma.value_storage = storage;
+}
+
 // sell_c_sigma 的简化版， 重排序对完整的矩阵来做
 template <class IndexType, class ValueType>
-SELL_C_R_Matrix<IndexType, ValueType> csr_to_sell_c_R(const CSR_Matrix<IndexType, ValueType> &csr, FILE *fp_feature, const int chunkwidth = CHUNK_SIZE,  const IndexType alignment = (SIMD_WIDTH/8/sizeof(ValueType)))
+SELL_C_R_Matrix<IndexType, ValueType> csr_to_sell_c_R(const CSR_Matrix<IndexType, ValueType> &csr, FILE *fp_feature, const int chunkwidth = CHUNK_SIZE,  const IndexType alignment = Le_get_alignment<ValueType>())
 {
+    CHECK_VALUES(csr);
     SELL_C_R_Matrix<IndexType, ValueType> sell_c_R;
 
     sell_c_R.num_rows = csr.num_rows;
@@ -501,7 +854,11 @@ SELL_C_R_Matrix<IndexType, ValueType> csr_to_sell_c_R(const CSR_Matrix<IndexType
     //  Step1. 确定重排序数组 
     /*-----------------------------------------------*/
     // Create a vector to hold the number of non-zeros per row and the original row index
-    std::vector<std::pair<IndexType, IndexType>> nnz_count(csr.num_rows);
+    // 临时数组取自调用线程的 arena, 反复转换时复用同一块内存
+    Le_arena &arena = Le_thread_arena();
+    arena.reserve_threads(1);
+    Le_arena_scope scope(arena);
+    std::pair<IndexType, IndexType> *nnz_count = arena.alloc_array<std::pair<IndexType, IndexType>>(csr.num_rows);
 
     // Count the non-zeros for each row
     #pragma omp parallel for
@@ -511,7 +868,7 @@ SELL_C_R_Matrix<IndexType, ValueType> csr_to_sell_c_R(const CSR_Matrix<IndexType
     }
 
     // Sort all rows of matrix by non-zero count
-    std::sort(nnz_count.begin(), nnz_count.end(),
+    std::sort(nnz_count, nnz_count + csr.num_rows,
         std::greater<std::pair<IndexType, IndexType>>());
 
     // Fill the sell_c_sigma.reorder array with the new order of the rows
@@ -554,21 +911,7 @@ SELL_C_R_Matrix<IndexType, ValueType> csr_to_sell_c_R(const CSR_Matrix<IndexType
     /*-----------------------------------------------*/
     //  Step3. 确定 col_index 和  values. 在计算时可以只看chunk了
     /*-----------------------------------------------*/
-    sell_c_R.col_index = new IndexType*[sell_c_R.validchunkNum];
-    sell_c_R.values    = new ValueType*[sell_c_R.validchunkNum];
-    for (IndexType chunk = 0; chunk < sell_c_R.validchunkNum; chunk++)
-    {
-        size_t elem_nums = sell_c_R.chunk_len[chunk] * sell_c_R.chunkWidth_C;
-        sell_c_R.col_index[chunk] = new_array<IndexType> (elem_nums);
-        CHECK_ALLOC(sell_c_R.col_index[chunk]);
-        // 初始化 col_index 中每个元素为 -1
-        std::fill_n(sell_c_R.col_index[chunk], elem_nums, static_cast<IndexType>(-1));
-
-        sell_c_R.values[chunk] = new_array<ValueType> (elem_nums);
-        CHECK_ALLOC(sell_c_R.values[chunk]);
-        // 初始化 values 中每个元素为 0 
-        std::fill_n(sell_c_R.values[chunk], elem_nums, ValueType(0));
-    }
+    alloc_sell_chunks(sell_c_R.validchunkNum, (const IndexType *) sell_c_R.chunk_len, sell_c_R.chunkWidth_C, sell_c_R.chunk_ptr, sell_c_R.col_index, sell_c_R.values);
 
     //转换 CSR 到 S-ELL-c-R
     #pragma omp parallel for
@@ -589,14 +932,90 @@ SELL_C_R_Matrix<IndexType, ValueType> csr_to_sell_c_R(const CSR_Matrix<IndexType
             ValueType val = csr.values[idx];
 
             IndexType pos = row_within_chunk * sell_c_R.chunk_len[chunk_id] + (idx - row_start);
-            sell_c_R.col_index[chunk_id][pos] = col;
-            sell_c_R.values[chunk_id][pos]    = val;
+            sell_c_R.chunk_col(chunk_id)[pos] = col;
+            sell_c_R.chunk_val(chunk_id)[pos] = val;
         }
     }
 
     return sell_c_R;
 }
 
+/**
+ * @brief counts[(num_rows - i) + j] = number of nonzeros on the diagonal j - i,
+ *        counts has num_rows + num_cols entries. Each thread counts a block of rows
+ *        into its own array over the diagonals the block touches (a few for banded
+ *        matrices), the arrays are then summed per diagonal.
+ */
+template <class IndexType, class ValueType>
+void count_csr_diagonals(const CSR_Matrix<IndexType, ValueType> &csr, IndexType *counts)
+{
+    const IndexType thread_num = Le_get_thread_num();
+    const size_t map_len = (size_t) csr.num_rows + csr.num_cols;
+
+    // 每个线程的行块碰到的对角线范围 [lo, hi)
+    std::vector<size_t> lo(thread_num, 0), hi(thread_num, 0);
+    #pragma omp parallel num_threads(thread_num)
+    {
+        const IndexType tid = Le_get_thread_id();
+        const IndexType rs = (IndexType) ((long long) csr.num_rows * tid / thread_num);
+        const IndexType re = (IndexType) ((long long) csr.num_rows * (tid + 1) / thread_num);
+        size_t l = map_len, h = 0;
+        for (IndexType i = rs; i < re; i++)
+            for (IndexType jj = csr.row_offset[i]; jj < csr.row_offset[i+1]; jj++)
+            {
+                const size_t map_index = (size_t) (csr.num_rows - i) + csr.col_index[jj];
+                l = std::min(l, map_index);
+                h = std::max(h, map_index + 1);
+            }
+        if (l < h)
+        {
+            lo[tid] = l;
+            hi[tid] = h;
+        }
+    }
+
+    std::vector<size_t> local_offset(thread_num + 1, 0);
+    for (IndexType t = 0; t < thread_num; t++)
+        local_offset[t + 1] = local_offset[t] + (hi[t] - lo[t]);
+
+    // 对角线分布很散时各线程的范围接近整个 map, 串行计数以免 thread_num 份临时数组
+    if (local_offset[thread_num] > 2 * map_len)
+    {
+        std::fill_n(counts, map_len, static_cast<IndexType> (0));
+        for (IndexType i = 0; i < csr.num_rows; i++)
+            for (IndexType jj = csr.row_offset[i]; jj < csr.row_offset[i+1]; jj++)
+                counts[(size_t) (csr.num_rows - i) + csr.col_index[jj]]++;
+        return;
+    }
+
+    IndexType *local = new_array<IndexType>(std::max(local_offset[thread_num], (size_t) 1));
+    CHECK_ALLOC(local);
+    #pragma omp parallel num_threads(thread_num)
+    {
+        const IndexType tid = Le_get_thread_id();
+        const IndexType rs = (IndexType) ((long long) csr.num_rows * tid / thread_num);
+        const IndexType re = (IndexType) ((long long) csr.num_rows * (tid + 1) / thread_num);
+        IndexType *mine = local + local_offset[tid];
+        const size_t base = (size_t) csr.num_rows - lo[tid];
+        std::fill(mine, local + local_offset[tid + 1], static_cast<IndexType> (0));
+        for (IndexType i = rs; i < re; i++)
+            for (IndexType jj = csr.row_offset[i]; jj < csr.row_offset[i+1]; jj++)
+                mine[base - i + csr.col_index[jj]]++;
+
+        #pragma omp barrier
+        #pragma omp for schedule(static)
+        for (size_t n = 0; n < map_len; n++)
+        {
+            IndexType sum = 0;
+            for (IndexType t = 0; t < thread_num; t++)
+                if (lo[t] <= n && n < hi[t])
+                    sum += local[local_offset[t] + n - lo[t]];
+            counts[n] = sum;
+        }
+    }
+    delete_array(local);
+}
+
 /**
  * @brief CSR format to DIA format
  * 
@@ -609,8 +1028,9 @@ SELL_C_R_Matrix<IndexType, ValueType> csr_to_sell_c_R(const CSR_Matrix<IndexType
  * @return DIA_Matrix<IndexType, ValueType> 
  */
 template <class IndexType, class ValueType>
-DIA_Matrix<IndexType, ValueType> csr_to_dia(const CSR_Matrix<IndexType, ValueType> &csr, const IndexType max_diags, FILE *fp_feature, const IndexType alignment = (SIMD_WIDTH/8/sizeof(ValueType)))
+DIA_Matrix<IndexType, ValueType> csr_to_dia(const CSR_Matrix<IndexType, ValueType> &csr, const IndexType max_diags, FILE *fp_feature, const IndexType alignment = Le_get_alignment<ValueType>())
 {
+    CHECK_VALUES(csr);
     DIA_Matrix<IndexType, ValueType> dia;
 
     dia.num_rows     = csr.num_rows;
@@ -624,29 +1044,15 @@ DIA_Matrix<IndexType, ValueType> csr_to_dia(const CSR_Matrix<IndexType, ValueTyp
     IndexType complete_ndiags = 0;
     const IndexType unmarked = (IndexType) -1;
 
-    IndexType* diag_map = new_array<IndexType> (dia.num_rows + dia.num_cols);
-    CHECK_ALLOC(diag_map);
-    std::fill(diag_map, diag_map + dia.num_rows + dia.num_cols, unmarked);
+    // 先并行统计每条对角线的非零元数, 再按 offset 递增编号
+    Le_arena &arena = Le_thread_arena();
+    arena.reserve_threads(1);
+    Le_arena_scope scope(arena);
+    IndexType* diag_map = arena.alloc_array<IndexType> ((size_t) dia.num_rows + dia.num_cols);
+    count_csr_diagonals(csr, diag_map);
 
-    // IndexType* diag_map_2 = new_array<IndexType> (dia.num_rows + dia.num_cols);
-    // std::fill(diag_map_2, diag_map_2 + dia.num_rows + dia.num_cols, 0);
-
-    for (size_t i = 0; i < dia.num_rows; i++)
-    {
-        //  遍历 csr 的第 i 行元素
-        for (size_t jj = csr.row_offset[i]; jj < csr.row_offset[i+1]; jj++)
-        {
-            size_t j = csr.col_index[jj]; // j : 元素的列序号
-            size_t map_index = (csr.num_rows - i) + j; //offset shifted by + num_rows
-
-            if( diag_map[map_index] == unmarked)
-            {
-                diag_map[map_index] = complete_ndiags;
-                complete_ndiags ++;
-            }
-            // diag_map_2[map_index] ++;
-        }
-    }
+    for (size_t n = 0; n < (size_t) dia.num_rows + dia.num_cols; n++)
+        diag_map[n] = (diag_map[n] != 0) ? complete_ndiags++ : unmarked;
 
     // size_t j_ndiags = 0;
     // double ratio;
@@ -730,7 +1136,6 @@ DIA_Matrix<IndexType, ValueType> csr_to_dia(const CSR_Matrix<IndexType, ValueTyp
         // dia.num_nnzs     = 0;
         dia.stride       = 0; 
         dia.gflops	= 0;
-        delete_array(diag_map);
         exit(1);
         // return dia;
     }
@@ -743,31 +1148,149 @@ DIA_Matrix<IndexType, ValueType> csr_to_dia(const CSR_Matrix<IndexType, ValueTyp
     dia.diag_data    = new_array<ValueType> ((size_t) dia.complete_ndiags * dia.stride);
     CHECK_ALLOC(dia.diag_data);
 
-    std::fill(dia.diag_data, dia.diag_data + (size_t) dia.complete_ndiags * dia.stride, ValueType(0));
+    const IndexType thread_num = Le_get_thread_num();
+    #pragma omp parallel for num_threads(thread_num)
+    for (IndexType d = 0; d < dia.complete_ndiags; d++)
+        std::fill(dia.diag_data + (size_t) d * dia.stride, dia.diag_data + (size_t) (d + 1) * dia.stride, ValueType(0));
 
-    for(size_t n = 0; n < dia.num_rows + dia.num_cols; n++)
+    for(size_t n = 0; n < (size_t) dia.num_rows + dia.num_cols; n++)
         if(diag_map[n] != unmarked) // 算出offset
             dia.diag_offsets[diag_map[n]] = (long int) n - (long int) dia.num_rows;
-        
-    for (size_t i = 0; i < csr.num_rows; i++)
+
+    // 每行只写自己那一列 diag_data[diag*stride + i], 行间无冲突
+    #pragma omp parallel for num_threads(thread_num)
+    for (IndexType i = 0; i < csr.num_rows; i++)
     {
-        for(size_t jj = csr.row_offset[i]; jj < csr.row_offset[i+1]; jj++){
+        for(IndexType jj = csr.row_offset[i]; jj < csr.row_offset[i+1]; jj++){
             size_t j = csr.col_index[jj];
             size_t map_index = (csr.num_rows - i) + j; //offset shifted by + num_rows
             size_t diag = diag_map[map_index];
             dia.diag_data[diag*dia.stride + i] = csr.values[jj];
         }
     }
-    
-    delete_array(diag_map);
 
     return dia;
 
 }
 
+/**
+ * @brief CSR format to hybrid DIA + CSR format. A diagonal goes to the DIA part
+ *        when it holds at least fill_ratio * (its length) nonzeros; if more than
+ *        max_diags diagonals pass, the max_diags fullest ones are kept. All other
+ *        nonzeros go to the CSR part, so matrices with a band plus scattered
+ *        nonzeros are never rejected and the DIA storage stays bounded by
+ *        max_diags * stride. Both passes over the rows run in parallel.
+ *
+ * @param fill_ratio  1.0 keeps only full diagonals, 0 keeps every occupied one (plain DIA)
+ */
+template <class IndexType, class ValueType>
+DIA_CSR_Matrix<IndexType, ValueType> csr_to_dia_csr(const CSR_Matrix<IndexType, ValueType> &csr, const double fill_ratio = NTRATIO, const IndexType max_diags = MAX_DIAG_NUM, const IndexType alignment = Le_get_alignment<ValueType>())
+{
+    CHECK_VALUES(csr);
+    DIA_CSR_Matrix<IndexType, ValueType> hyb;
+
+    hyb.num_rows = csr.num_rows;
+    hyb.num_cols = csr.num_cols;
+    hyb.num_nnzs = csr.num_nnzs;
+    hyb.tag      = 0;
+
+    const IndexType thread_num = Le_get_thread_num();
+    const IndexType unmarked = (IndexType) -1;
+    const size_t map_len = (size_t) csr.num_rows + csr.num_cols;
+
+    Le_arena &arena = Le_thread_arena();
+    arena.reserve_threads(1);
+    Le_arena_scope scope(arena);
+    IndexType* diag_map = arena.alloc_array<IndexType> (map_len);
+    count_csr_diagonals(csr, diag_map);
+
+    // 稠密度达到 fill_ratio 的对角线作为候选
+    size_t *dense = arena.alloc_array<size_t> (map_len);
+    size_t num_dense = 0;
+    for (size_t n = 0; n < map_len; n++)
+    {
+        if (diag_map[n] == 0)
+            continue;
+        const long int offset = (long int) n - (long int) csr.num_rows;
+        const long int length = std::min((long int) csr.num_rows, (long int) csr.num_cols - offset) - std::max(0L, -offset);
+        if ((double) diag_map[n] >= fill_ratio * (double) length)
+            dense[num_dense++] = n;
+    }
+    if (num_dense > (size_t) max_diags)
+    {
+        std::nth_element(dense, dense + max_diags, dense + num_dense,
+                         [&](size_t a, size_t b) { return diag_map[a] > diag_map[b]; });
+        num_dense = max_diags;
+        std::sort(dense, dense + num_dense);
+    }
+
+    hyb.complete_ndiags = (IndexType) num_dense;
+    hyb.stride = alignment * ((hyb.num_rows + alignment - 1) / alignment);
+    hyb.dia_nnzs = 0;
+    for (size_t d = 0; d < num_dense; d++)
+        hyb.dia_nnzs += diag_map[dense[d]];
+
+    std::fill(diag_map, diag_map + map_len, unmarked);
+    hyb.diag_offsets = new_array<long int> ((size_t) hyb.complete_ndiags);
+    CHECK_ALLOC(hyb.diag_offsets);
+    for (IndexType d = 0; d < hyb.complete_ndiags; d++)
+    {
+        diag_map[dense[d]] = d;
+        hyb.diag_offsets[d] = (long int) dense[d] - (long int) hyb.num_rows;
+    }
+
+    hyb.diag_data = new_array<ValueType> ((size_t) hyb.complete_ndiags * hyb.stride);
+    CHECK_ALLOC(hyb.diag_data);
+    #pragma omp parallel for num_threads(thread_num)
+    for (IndexType d = 0; d < hyb.complete_ndiags; d++)
+        std::fill(hyb.diag_data + (size_t) d * hyb.stride, hyb.diag_data + (size_t) (d + 1) * hyb.stride, ValueType(0));
+
+    // CSR 部分: 先统计每行剩余的非零元
+    hyb.row_offset = new_array<IndexType> (hyb.num_rows + 1);
+    CHECK_ALLOC(hyb.row_offset);
+    hyb.row_offset[0] = 0;
+    #pragma omp parallel for num_threads(thread_num)
+    for (IndexType i = 0; i < csr.num_rows; i++)
+    {
+        IndexType rest = 0;
+        for (IndexType jj = csr.row_offset[i]; jj < csr.row_offset[i+1]; jj++)
+            rest += (diag_map[(size_t) (csr.num_rows - i) + csr.col_index[jj]] == unmarked);
+        hyb.row_offset[i + 1] = rest;
+    }
+    for (IndexType i = 0; i < hyb.num_rows; i++)
+        hyb.row_offset[i + 1] += hyb.row_offset[i];
+    hyb.csr_nnzs = hyb.row_offset[hyb.num_rows];
+
+    hyb.col_index = new_array<IndexType> (hyb.csr_nnzs);
+    CHECK_ALLOC(hyb.col_index);
+    hyb.values    = new_array<ValueType> (hyb.csr_nnzs);
+    CHECK_ALLOC(hyb.values);
+
+    #pragma omp parallel for num_threads(thread_num)
+    for (IndexType i = 0; i < csr.num_rows; i++)
+    {
+        IndexType pos = hyb.row_offset[i];
+        for (IndexType jj = csr.row_offset[i]; jj < csr.row_offset[i+1]; jj++)
+        {
+            const IndexType diag = diag_map[(size_t) (csr.num_rows - i) + csr.col_index[jj]];
+            if (diag != unmarked)
+                hyb.diag_data[(size_t) diag * hyb.stride + i] = csr.values[jj];
+            else
+            {
+                hyb.col_index[pos] = csr.col_index[jj];
+                hyb.values[pos]    = csr.values[jj];
+                pos++;
+            }
+        }
+    }
+
+    return hyb;
+}
+
 template <class IndexType, class ValueType>
-BSR_Matrix<IndexType, ValueType> csr_to_bsr(const CSR_Matrix<IndexType, ValueType> &csr, const IndexType blockDimRow = BSR_BlockDimRow, IndexType blockDimCol = (SIMD_WIDTH/8/sizeof(ValueType)))
+BSR_Matrix<IndexType, ValueType> csr_to_bsr(const CSR_Matrix<IndexType, ValueType> &csr, const IndexType blockDimRow = BSR_BlockDimRow, IndexType blockDimCol = Le_get_alignment<ValueType>())
 {
+    CHECK_VALUES(csr);
     BSR_Matrix<IndexType, ValueType> bsr;
     bsr.num_rows = csr.num_rows;
     bsr.num_cols = csr.num_cols;
@@ -885,6 +1408,13 @@ BSR_Matrix<IndexType, ValueType> csr_to_bsr(const CSR_Matrix<IndexType, ValueTyp
         }
     }
 
+    // CSR 非零元 -> block_data 位置, 供 update_values 复用; block_data 超出 IndexType 范围时不建立
+    if ((size_t) bsr.nnzb * bsr.blockNNZ <= (size_t) std::numeric_limits<IndexType>::max())
+    {
+        bsr.value_map = new_array<IndexType> (bsr.num_nnzs);
+        CHECK_ALLOC(bsr.value_map);
+    }
+
     // get bsr block values array.
     #pragma omp parallel for
     for (IndexType i = 0; i < bsr.num_rows; i++)
@@ -898,7 +1428,8 @@ BSR_Matrix<IndexType, ValueType> csr_to_bsr(const CSR_Matrix<IndexType, ValueTyp
         {
             IndexType blockCol = csr.col_index[j] / blockDimCol;
 
-            colIndex = -1;
+            // 每个线程私有, 不能复用上面串行循环的 colIndex
+            IndexType colIndex = -1;
 
             for (IndexType k = bsr.row_ptr[blockRow]; k < bsr.row_ptr[blockRow+1]; k++)
             {
@@ -919,12 +1450,25 @@ BSR_Matrix<IndexType, ValueType> csr_to_bsr(const CSR_Matrix<IndexType, ValueTyp
             size_t index = (size_t) bsr.row_ptr[blockRow] * blockDimRow * blockDimCol + colIndex * blockDimRow * blockDimCol + blockIndex;
 
             bsr.block_data[index] = csr.values[j];
+            if (bsr.value_map != nullptr)
+                bsr.value_map[j] = (IndexType) index;
         }
     }
 
     return bsr;
 }
 
+/**
+ * @brief Where the CSR arrays of a CSR5 matrix come from. CSR5 transposes
+ *        col_index / values inside the tiles but only reads row_offset.
+ */
+typedef enum
+{
+    CSR5_COPY_CSR         = 0,  // copy row_offset, col_index and values
+    CSR5_SHARE_ROW_OFFSET = 1,  // borrow row_offset (the csr must outlive the csr5), copy the others
+    CSR5_ADOPT_CSR        = 2   // take all three arrays, csr must not be used or freed afterwards
+} CSR5Source;
+
 /**
  * @brief CSR format to CSR5 format. Only deal with double precision from Weifeng Liu.
  * 
@@ -933,11 +1477,17 @@ BSR_Matrix<IndexType, ValueType> csr_to_bsr(const CSR_Matrix<IndexType, ValueTyp
  * @tparam ValueType 
  * @param csr 
  * @param fp_feature 
+ * @param source  CSR5_SHARE_ROW_OFFSET for views of external arrays, CSR5_ADOPT_CSR
+ *                when the csr is dropped after conversion (no extra nnz-sized array)
  * @return CSR5_Matrix<IndexType, UIndexType, ValueType> 
  */
 template <class IndexType, typename UIndexType, class ValueType>
-CSR5_Matrix<IndexType, UIndexType, ValueType> csr_to_csr5(const CSR_Matrix<IndexType, ValueType> &csr, FILE *fp_feature)
+CSR5_Matrix<IndexType, UIndexType, ValueType> csr_to_csr5(const CSR_Matrix<IndexType, ValueType> &csr, FILE *fp_feature, CSR5Source source = CSR5_COPY_CSR)
 {
+    // CSR5 的 tile 内转置只支持稠密或 pattern-only 的数值
+    if (packed_value_bytes(csr.value_storage) > 0)
+        checkValues(csr.value_storage, __FUNCTION__);
+
     int err = 0;
     double malloc_time = 0, tile_ptr_time = 0, tile_desc_time = 0, transpose_time = 0;
     anonymouslib_timer malloc_timer, tile_ptr_timer, tile_desc_timer, transpose_timer;
@@ -949,9 +1499,21 @@ CSR5_Matrix<IndexType, UIndexType, ValueType> csr_to_csr5(const CSR_Matrix<Index
     csr5.num_nnzs = csr.num_nnzs;
 
     // original CSR format array
-    csr5.row_offset = copy_array(csr.row_offset, csr.num_rows + 1);
-    csr5.col_index  = copy_array(csr.col_index , csr.num_nnzs);
-    csr5.values     = copy_array(csr.values    , csr.num_nnzs);
+    if (source == CSR5_ADOPT_CSR)
+    {
+        csr5.row_offset = csr.row_offset;
+        csr5.col_index  = csr.col_index;
+        csr5.values     = csr.values;
+    }
+    else
+    {
+        csr5.shared_row_offset = (source == CSR5_SHARE_ROW_OFFSET);
+        csr5.row_offset = csr5.shared_row_offset ? csr.row_offset : copy_array(csr.row_offset, csr.num_rows + 1);
+        csr5.col_index  = copy_array(csr.col_index , csr.num_nnzs);
+        csr5.values     = csr.value_storage == DenseValues ? copy_array(csr.values, csr.num_nnzs) : nullptr;
+    }
+    // pattern-only: values == nullptr, 只转置 col_index
+    csr5.value_storage = csr.value_storage;
 
     csr5.tile_ptr  = NULL;
     csr5.tile_desc = NULL;
@@ -960,6 +1522,7 @@ CSR5_Matrix<IndexType, UIndexType, ValueType> csr_to_csr5(const CSR_Matrix<Index
     csr5.calibrator           = NULL;
 
     // store sigma and omega (tiles row and column number)
+    // omega must match D_CSR5_OMEGA of the compiled AVX-512 kernel, keep it compile-time
     csr5.omega = SIMD_WIDTH / 8 / sizeof(ValueType);
     csr5.sigma = CSR5_SIGMA;  // fixed in paper   12 or 16
 /*
@@ -1006,7 +1569,7 @@ CSR5_Matrix<IndexType, UIndexType, ValueType> csr_to_csr5(const CSR_Matrix<Index
 
     malloc_timer.start();
     // malloc the newly added arrays for CSR5
-    csr5.tile_ptr = (UIndexType *) memalign(CACHE_LINE, (uint64_t) (csr5._p + 1) * sizeof(UIndexType));
+    csr5.tile_ptr = new_array<UIndexType>(csr5._p + 1);
     if (csr5.tile_ptr == NULL){
         printf("error: UNABLE TO ASIGN MEMORY IN CSR5 tile_ptr \n");
         exit(-2);
@@ -1015,7 +1578,7 @@ CSR5_Matrix<IndexType, UIndexType, ValueType> csr_to_csr5(const CSR_Matrix<Index
         csr5.tile_ptr[i] = 0;
     }
 
-    csr5.tile_desc = (UIndexType *) memalign(CACHE_LINE, (uint64_t)( csr5._p * csr5.omega * csr5.num_packets) * sizeof(UIndexType));
+    csr5.tile_desc = new_array<UIndexType>(csr5._p * csr5.omega * csr5.num_packets);
     if (csr5.tile_desc == NULL){
         printf("error: UNABLE TO ASIGN MEMORY IN CSR5 tile_desc \n");
         exit(-2);
@@ -1023,14 +1586,14 @@ CSR5_Matrix<IndexType, UIndexType, ValueType> csr_to_csr5(const CSR_Matrix<Index
     memset(csr5.tile_desc, 0, csr5._p * csr5.omega * csr5.num_packets * sizeof(UIndexType));
 
     int thread_num = Le_get_thread_num();
-    csr5.calibrator = (ValueType *) memalign(CACHE_LINE, (uint64_t)(thread_num * CACHE_LINE));
+    csr5.calibrator = (ValueType *) new_array<char>(thread_num * Le_get_cache_line());
     if (csr5.tile_desc == NULL){
         printf("error: UNABLE TO ASIGN MEMORY IN CSR5 calibrator \n");
         exit(-2);
     }
-    memset(csr5.calibrator, 0, thread_num * CACHE_LINE);
+    memset(csr5.calibrator, 0, thread_num * Le_get_cache_line());
 
-    csr5.tile_desc_offset_ptr = (IndexType *) memalign(CACHE_LINE, (uint64_t) (csr5._p + 1) * sizeof(IndexType));
+    csr5.tile_desc_offset_ptr = new_array<IndexType>(csr5._p + 1);
     if (csr5.tile_desc_offset_ptr == NULL){
         printf("error: UNABLE TO ASIGN MEMORY IN CSR5 tile_desc_offset_ptr \n");
         exit(-2);
@@ -1138,9 +1701,9 @@ CSR5_Matrix<IndexType, UIndexType, ValueType> csr_to_csr5(const CSR_Matrix<Index
     }
 
     // step 2.2 generate_tile_descriptor_s2_kernel
-    int *s_segn_scan_all = (int *) memalign(CACHE_LINE, (uint64_t) (2 * csr5.omega * thread_num) * sizeof(int));
+    int *s_segn_scan_all = (int *) memalign(Le_get_cache_line(), (uint64_t) (2 * csr5.omega * thread_num) * sizeof(int));
 
-    int *s_present_all   = (int *) memalign(CACHE_LINE, (uint64_t) (2 * csr5.omega * thread_num) * sizeof(int));
+    int *s_present_all   = (int *) memalign(Le_get_cache_line(), (uint64_t) (2 * csr5.omega * thread_num) * sizeof(int));
 
     for (int i = 0; i < thread_num; i++)
         s_present_all[i*2*csr5.omega + csr5.omega]=1;
@@ -1264,7 +1827,7 @@ CSR5_Matrix<IndexType, UIndexType, ValueType> csr_to_csr5(const CSR_Matrix<Index
     tile_desc_time += tile_desc_timer.stop();
 
     if (csr5.num_offsets) {
-        csr5.tile_desc_offset = (IndexType *) memalign(CACHE_LINE, (uint64_t)(csr5.num_offsets) * sizeof(IndexType));
+        csr5.tile_desc_offset = new_array<IndexType>(csr5.num_offsets);
 
         // generate_tile_descriptor_offset
         const int bit_bitflag = 32 - bit_all_offset;
@@ -1378,4 +1941,202 @@ CSR5_Matrix<IndexType, UIndexType, ValueType> csr_to_csr5(const CSR_Matrix<Index
     return csr5;
 }
 
+/**
+ * @brief Default panel width of the column-blocked CSR: the x panel takes
+ *        CBCSR_CACHE_FRACTION of one LLC instance of the running host.
+ */
+template <class ValueType>
+inline size_t cbcsr_panel_width()
+{
+    const size_t llc = Le_get_platform().l3cache_instance;
+    return std::max((size_t) 1, (size_t) (CBCSR_CACHE_FRACTION * llc / sizeof(ValueType)));
+}
+
+/**
+ * @brief Create the column-blocked CSR from CSR, panel by panel the rows keep
+ *        their CSR order and the nnzs of a row keep their order inside a panel.
+ *        This routine do not delete the CSR_Matrix handle
+ *
+ *         x  0 | x  0 | x      panel_width = 2, num_panels = 3
+ *         x  x | 0  0 | 0      panel 0: rows 0 1 2     panel_ptr = [0, 3, 6, 9]
+ *   A =   x  0 | 0  x | x      panel 1: rows 0 2 3     row_index = [0,1,2, 0,2,3, 0,2,3]
+ *         0  0 | x  x | x      panel 2: rows 0 2 3
+ *
+ * @param panel_width  columns per panel, default cbcsr_panel_width<ValueType>()
+ */
+template <class IndexType, class ValueType>
+CBCSR_Matrix<IndexType, ValueType> csr_to_cbcsr(const CSR_Matrix<IndexType, ValueType> &csr, IndexType panel_width = 0)
+{
+    CHECK_VALUES(csr);
+    CBCSR_Matrix<IndexType, ValueType> cbcsr;
+    cbcsr.num_rows = csr.num_rows;
+    cbcsr.num_cols = csr.num_cols;
+    cbcsr.num_nnzs = csr.num_nnzs;
+    cbcsr.sparsity = csr.sparsity;
+    cbcsr.kernel_flag = csr.kernel_flag;
+    cbcsr.partition = nullptr;
+
+    if (panel_width <= 0)
+        panel_width = (IndexType) std::min((size_t) std::max(csr.num_cols, (IndexType) 1), cbcsr_panel_width<ValueType>());
+    cbcsr.panel_width = panel_width;
+    cbcsr.num_panels  = std::max((IndexType) 1, (csr.num_cols + panel_width - 1) / panel_width);
+    const IndexType num_panels = cbcsr.num_panels;
+
+    // 1. 统计每个 panel 的非空行数和 nnz
+    std::vector<IndexType> panel_rows(num_panels, 0), panel_nnzs(num_panels, 0), last_row(num_panels, -1);
+    for (IndexType row = 0; row < csr.num_rows; ++row)
+    {
+        for (IndexType jj = csr.row_offset[row]; jj < csr.row_offset[row + 1]; ++jj)
+        {
+            const IndexType p = csr.col_index[jj] / panel_width;
+            if (last_row[p] != row)
+            {
+                last_row[p] = row;
+                panel_rows[p]++;
+            }
+            panel_nnzs[p]++;
+        }
+    }
+
+    cbcsr.panel_ptr = new_array<IndexType>(num_panels + 1);
+    CHECK_ALLOC(cbcsr.panel_ptr);
+    std::vector<IndexType> nnz_cursor(num_panels, 0);
+    cbcsr.panel_ptr[0] = 0;
+    for (IndexType p = 0; p < num_panels; ++p)
+    {
+        cbcsr.panel_ptr[p + 1] = cbcsr.panel_ptr[p] + panel_rows[p];
+        if (p + 1 < num_panels)
+            nnz_cursor[p + 1] = nnz_cursor[p] + panel_nnzs[p];
+    }
+    cbcsr.num_panel_rows = cbcsr.panel_ptr[num_panels];
+
+    cbcsr.row_index  = new_array<IndexType>(cbcsr.num_panel_rows);
+    CHECK_ALLOC(cbcsr.row_index);
+    cbcsr.row_offset = new_array<IndexType>(cbcsr.num_panel_rows + 1);
+    CHECK_ALLOC(cbcsr.row_offset);
+    cbcsr.col_index  = new_array<IndexType>(csr.num_nnzs);
+    CHECK_ALLOC(cbcsr.col_index);
+    cbcsr.values     = new_array<ValueType>(csr.num_nnzs);
+    CHECK_ALLOC(cbcsr.values);
+
+    // 2. 按行顺序填充, 一个 panel 的行连续, 下一 panel 行的起点即上一行的终点
+    std::vector<IndexType> row_cursor(cbcsr.panel_ptr, cbcsr.panel_ptr + num_panels);
+    std::fill(last_row.begin(), last_row.end(), -1);
+    for (IndexType row = 0; row < csr.num_rows; ++row)
+    {
+        for (IndexType jj = csr.row_offset[row]; jj < csr.row_offset[row + 1]; ++jj)
+        {
+            const IndexType p = csr.col_index[jj] / panel_width;
+            if (last_row[p] != row)
+            {
+                last_row[p] = row;
+                const IndexType k = row_cursor[p]++;
+                cbcsr.row_index[k]  = row;
+                cbcsr.row_offset[k] = nnz_cursor[p];
+            }
+            cbcsr.col_index[nnz_cursor[p]] = csr.col_index[jj];
+            cbcsr.values[nnz_cursor[p]]    = csr.values[jj];
+            nnz_cursor[p]++;
+        }
+    }
+    cbcsr.row_offset[cbcsr.num_panel_rows] = csr.num_nnzs;
+
+    return cbcsr;
+}
+
+/**
+ * @brief Create the CSB matrix from CSR, the nnzs of a block keep the row order of CSR.
+ *        This routine do not delete the CSR_Matrix handle
+ *
+ *         x  x | 0  0      beta = 2, nbr = nbc = 2
+ *         0  x | x  0      blk_ptr = [0, 3, 4, 5, 7]
+ *   A =   ---------        block (0,0): rloc = [0,0,1] cloc = [0,1,1]
+ *         0  0 | x  0      block (0,1): rloc = [1]     cloc = [0]
+ *         x  0 | 0  x      block (1,0): rloc = [1]     cloc = [0]
+ *                          block (1,1): rloc = [0,1]   cloc = [0,1]
+ * @param beta  block dim, power of 2 not larger than 65536, 0 for the default
+ */
+template <class IndexType, class ValueType>
+CSB_Matrix<IndexType, ValueType> csr_to_csb(const CSR_Matrix<IndexType, ValueType> &csr, IndexType beta = 0)
+{
+    CHECK_VALUES(csr);
+    CSB_Matrix<IndexType, ValueType> csb;
+    csb.num_rows = csr.num_rows;
+    csb.num_cols = csr.num_cols;
+    csb.num_nnzs = csr.num_nnzs;
+    csb.sparsity = csr.sparsity;
+    csb.kernel_flag = csr.kernel_flag;
+    csb.partition = nullptr;
+
+    if (beta <= 0)
+    {
+        const double dim = std::sqrt((double) std::max(csr.num_rows, csr.num_cols));
+        beta = CSB_MIN_BETA;
+        while (beta < dim && beta < 65536)
+            beta <<= 1;
+    }
+    if (beta > 65536 || (beta & (beta - 1)) != 0)
+        throw std::invalid_argument("csr_to_csb: beta must be a power of 2 not larger than 65536");
+
+    csb.beta = beta;
+    csb.log_beta = 0;
+    while (((IndexType) 1 << csb.log_beta) < beta)
+        csb.log_beta++;
+    csb.nbr = std::max((IndexType) 1, (csr.num_rows + beta - 1) / beta);
+    csb.nbc = std::max((IndexType) 1, (csr.num_cols + beta - 1) / beta);
+    const IndexType nbr = csb.nbr;
+    const IndexType nbc = csb.nbc;
+    const int log_beta = csb.log_beta;
+    const int thread_num = Le_get_thread_num();
+
+    csb.blk_ptr = new_array<IndexType>((size_t) nbr * nbc + 1);
+    CHECK_ALLOC(csb.blk_ptr);
+    std::fill(csb.blk_ptr, csb.blk_ptr + (size_t) nbr * nbc + 1, 0);
+
+    // 1. 每个 block 的 nnz, 一个 block row 的计数只由它自己的行写入
+    #pragma omp parallel for num_threads(thread_num) schedule(dynamic, 1)
+    for (IndexType br = 0; br < nbr; ++br)
+    {
+        IndexType *cnt = csb.blk_ptr + (size_t) br * nbc + 1;
+        const IndexType row_end = std::min(csr.num_rows, (br + 1) * beta);
+        for (IndexType row = br * beta; row < row_end; ++row)
+            for (IndexType jj = csr.row_offset[row]; jj < csr.row_offset[row + 1]; ++jj)
+                cnt[csr.col_index[jj] >> log_beta]++;
+    }
+    for (size_t b = 0; b < (size_t) nbr * nbc; ++b)
+        csb.blk_ptr[b + 1] += csb.blk_ptr[b];
+
+    csb.rloc   = new_array<uint16_t>(csr.num_nnzs);
+    CHECK_ALLOC(csb.rloc);
+    csb.cloc   = new_array<uint16_t>(csr.num_nnzs);
+    CHECK_ALLOC(csb.cloc);
+    csb.values = new_array<ValueType>(csr.num_nnzs);
+    CHECK_ALLOC(csb.values);
+
+    // 2. 按行顺序填充, block 内即行优先
+    #pragma omp parallel num_threads(thread_num)
+    {
+        std::vector<IndexType> cursor(nbc);
+        #pragma omp for schedule(dynamic, 1)
+        for (IndexType br = 0; br < nbr; ++br)
+        {
+            std::copy(csb.blk_ptr + (size_t) br * nbc, csb.blk_ptr + (size_t) (br + 1) * nbc, cursor.begin());
+            const IndexType row_end = std::min(csr.num_rows, (br + 1) * beta);
+            for (IndexType row = br * beta; row < row_end; ++row)
+            {
+                for (IndexType jj = csr.row_offset[row]; jj < csr.row_offset[row + 1]; ++jj)
+                {
+                    const IndexType col = csr.col_index[jj];
+                    const IndexType k = cursor[col >> log_beta]++;
+                    csb.rloc[k]   = (uint16_t) (row & (beta - 1));
+                    csb.cloc[k]   = (uint16_t) (col & (beta - 1));
+                    csb.values[k] = csr.values[jj];
+                }
+            }
+        }
+    }
+
+    return csb;
+}
+
 #endif /* SPARSE_CONVERSION_H */
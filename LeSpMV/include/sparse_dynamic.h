@@ -0,0 +1,608 @@
+/**
+ * @file sparse_dynamic.h
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Incremental structural updates of CSR and SELL-C-sigma matrices (adaptive meshes).
+ *         Entries already in the base pattern are changed in place; removed entries are
+ *         zeroed and flagged. New entries go to a COO delta, and SpMV computes base + delta.
+ *         Once delta + removed entries exceed the merge threshold, a background thread
+ *         rebuilds the CSR and the base format. Updates made during the merge are applied
+ *         to the old base and logged, then replayed on the new base when it is installed.
+ * @version 0.1
+ * @date 2024-04-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SPARSE_DYNAMIC_H
+#define SPARSE_DYNAMIC_H
+
+#include<atomic>
+#include<thread>
+#include<vector>
+#include<utility>
+#include<algorithm>
+#include<functional>
+#include<unordered_map>
+#include"general_config.h"
+#include"memopt.h"
+#include"thread.h"
+#include"sparse_format.h"
+#include"sparse_conversion.h"
+#include"spmv_csr.h"
+#include"spmv_sell_c_sigma.h"
+
+/**
+ * @brief How Le_dynamic_matrix builds, updates and multiplies its base format.
+ *        row_positions() gives the position of each CSR row inside the format (nullptr if
+ *        rows are not reordered), set_value() writes the j-th entry of a CSR row.
+ */
+template <typename Matrix>
+struct Le_dynamic_base;
+
+template <typename IndexType, typename ValueType>
+struct Le_dynamic_base<CSR_Matrix<IndexType, ValueType>>
+{
+    typedef CSR_Matrix<IndexType, ValueType> Matrix;
+
+    // 基础格式就是 CSR 本身, 共享数组
+    static Matrix build(const CSR_Matrix<IndexType, ValueType> &csr) { return csr; }
+    static void destroy(Matrix &) {}
+    static IndexType * row_positions(const Matrix &) { return nullptr; }
+    static void set_value(Matrix &, const IndexType *, IndexType, IndexType, ValueType) {}
+
+    static void spmv(const ValueType alpha, const Matrix &mat, const ValueType *x, const ValueType beta, ValueType *y)
+    {
+        LeSpMV_csr(alpha, mat, x, beta, y);
+    }
+};
+
+template <typename IndexType, typename ValueType>
+struct Le_dynamic_base<SELL_C_Sigma_Matrix<IndexType, ValueType>>
+{
+    typedef SELL_C_Sigma_Matrix<IndexType, ValueType> Matrix;
+
+    static Matrix build(const CSR_Matrix<IndexType, ValueType> &csr) { return csr_to_sell_c_sigma(csr, nullptr); }
+    static void destroy(Matrix &mat) { delete_host_matrix(mat); }
+
+    // reorder 的逆: CSR 行 -> SELL 中的行位置
+    static IndexType * row_positions(const Matrix &mat)
+    {
+        IndexType *row_pos = new_array<IndexType>(mat.num_rows);
+        CHECK_ALLOC(row_pos);
+        for (IndexType i = 0; i < mat.num_rows; ++i)
+            row_pos[mat.reorder[i]] = i;
+        return row_pos;
+    }
+
+    static void set_value(Matrix &mat, const IndexType *row_pos, IndexType row, IndexType j, ValueType val)
+    {
+        const IndexType pos = row_pos[row];
+        mat.chunk_val(pos / mat.chunkWidth_C)[(size_t) j * mat.chunkWidth_C + pos % mat.chunkWidth_C] = val;
+    }
+
+    static void spmv(const ValueType alpha, const Matrix &mat, const ValueType *x, const ValueType beta, ValueType *y)
+    {
+        LeSpMV_sell_c_sigma(alpha, mat, x, beta, y);
+    }
+};
+
+/**
+ * @brief Base matrix + COO delta with background merging, e.g.
+ *        Le_dynamic_matrix<SELL_C_Sigma_Matrix<int, double>> A(csr);
+ *        A.insert(i, j, v); A.remove_row(k); A.spmv(1.0, x, 0.0, y);
+ *        The object is not thread safe, only the merge runs concurrently with the caller.
+ *
+ * @tparam Matrix CSR_Matrix or SELL_C_Sigma_Matrix
+ */
+template <typename Matrix>
+class Le_dynamic_matrix
+{
+public:
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type ValueType;
+    typedef Le_dynamic_base<Matrix> Base;
+
+    /**
+     * @param csr          initial matrix, copied
+     * @param merge_ratio  merge when delta + removed entries exceed merge_ratio * nnz
+     */
+    explicit Le_dynamic_matrix(const CSR_Matrix<IndexType, ValueType> &csr, const double merge_ratio = DELTA_MERGE_RATIO)
+        : merge_ratio(merge_ratio), kernel_flag(csr.kernel_flag), delta_dirty(false), merge_done(false),
+          num_background_merges(0), num_replayed(0), merge_thread_num(0)
+    {
+        CHECK_VALUES(csr);
+        rows = csr.num_rows;
+        cols = csr.num_cols;
+        install(copy_csr(csr));
+    }
+
+    ~Le_dynamic_matrix()
+    {
+        if (merge_thread.joinable())
+        {
+            merge_thread.join();
+            Base::destroy(next_mat);
+            delete_csr_matrix(next_csr);
+            delete_array(next_row_pos);
+        }
+        release_base();
+    }
+
+    // 合并线程持有 this, 不能复制或移动
+    Le_dynamic_matrix(const Le_dynamic_matrix &) = delete;
+    Le_dynamic_matrix & operator=(const Le_dynamic_matrix &) = delete;
+
+    // A(row, col) = val, a new entry if it is not stored yet (nnz append)
+    void insert(const IndexType row, const IndexType col, const ValueType val)
+    {
+        update(Op{row, col, val, OP_INSERT});
+    }
+
+    // remove A(row, col) from the pattern, nothing happens if it is not stored
+    void remove(const IndexType row, const IndexType col)
+    {
+        update(Op{row, col, ValueType(0), OP_REMOVE});
+    }
+
+    // remove all entries of a row, the row stays (empty)
+    void remove_row(const IndexType row)
+    {
+        update(Op{row, 0, ValueType(0), OP_REMOVE_ROW});
+    }
+
+    // grow the matrix to num_rows x num_cols, new rows / columns are empty (row insert)
+    void resize(const IndexType num_rows, const IndexType num_cols)
+    {
+        update(Op{num_rows, num_cols, ValueType(0), OP_RESIZE});
+    }
+
+    /**
+     * @brief y = alpha * (base + delta) * x + beta * y, x has num_cols() and y num_rows() entries
+     */
+    void spmv(const ValueType alpha, const ValueType *x, const ValueType beta, ValueType *y)
+    {
+        poll_merge();
+        Base::spmv(alpha, mat, x, beta, y);
+
+        // 基础格式之外新增的行只有 delta
+        for (IndexType i = mat.num_rows; i < rows; ++i)
+            y[i] = (beta == ValueType(0)) ? ValueType(0) : beta * y[i];
+
+        delta_spmv(alpha, x, y);
+    }
+
+    // merge the delta into the base format now and wait for it
+    void merge()
+    {
+        if (merge_thread.joinable())
+        {
+            merge_thread.join();
+            finish_merge();
+        }
+        // 重放的更新留在新的 delta 中, 再合并一次
+        if (delta_row.size() > 0 || num_removed > 0)
+        {
+            start_merge();
+            merge_thread.join();
+            finish_merge();
+        }
+    }
+
+    bool merging() const { return merge_thread.joinable(); }
+
+    IndexType num_rows() const { return rows; }
+    IndexType num_cols() const { return cols; }
+    IndexType num_nnzs() const { return csr.num_nnzs - num_removed + (IndexType) delta_row.size(); }
+    IndexType delta_nnzs() const { return (IndexType) delta_row.size(); }
+    IndexType removed_nnzs() const { return num_removed; }
+
+    // merges started in the background by the threshold (merge() calls not included)
+    size_t background_merges() const { return num_background_merges; }
+    // updates made while a merge was running and replayed onto its result
+    size_t replayed_updates() const { return num_replayed; }
+    // omp threads of the conversions in the last merge (DELTA_MERGE_THREADS), 0 before the first merge
+    int merge_threads() const { return merge_thread_num.load(std::memory_order_relaxed); }
+
+    // base format of the last merge, removed entries are stored as zeros
+    const Matrix & base() const { return mat; }
+
+    void set_kernel_flag(const int flag) { kernel_flag = flag; mat.kernel_flag = flag; }
+
+private:
+    enum OpKind { OP_INSERT = 0, OP_REMOVE = 1, OP_REMOVE_ROW = 2, OP_RESIZE = 3 };
+    struct Op
+    {
+        IndexType row, col;
+        ValueType val;
+        int kind;
+    };
+
+    struct Key_hash
+    {
+        size_t operator()(const std::pair<IndexType, IndexType> &k) const
+        {
+            return std::hash<unsigned long long>()(((unsigned long long) k.first * 0x9E3779B97F4A7C15ULL) ^ (unsigned long long) k.second);
+        }
+    };
+
+    // 合并线程的输入: 值与删除标记是拷贝, 行列结构直接读旧的 csr (合并完成前不会释放)
+    struct Snapshot
+    {
+        IndexType num_rows, num_cols;
+        IndexType base_rows;
+        const IndexType *row_offset;
+        const IndexType *col_index;
+        ValueType *values;
+        char *removed;
+        std::vector<IndexType> delta_row, delta_col;
+        std::vector<ValueType> delta_val;
+    };
+
+    static CSR_Matrix<IndexType, ValueType> copy_csr(const CSR_Matrix<IndexType, ValueType> &src)
+    {
+        CSR_Matrix<IndexType, ValueType> dst;
+        dst.num_rows = src.num_rows;
+        dst.num_cols = src.num_cols;
+        dst.num_nnzs = src.num_nnzs;
+        dst.partition = nullptr;
+        dst.tag = 0;
+        dst.kernel_flag = src.kernel_flag;
+        dst.row_offset = copy_array(src.row_offset, src.num_rows + 1);
+        dst.col_index  = copy_array(src.col_index, src.num_nnzs);
+        dst.values     = copy_array(src.values, src.num_nnzs);
+        return dst;
+    }
+
+    void install(const CSR_Matrix<IndexType, ValueType> &new_csr)
+    {
+        csr = new_csr;
+        csr.kernel_flag = kernel_flag;
+        mat = Base::build(csr);
+        mat.kernel_flag = kernel_flag;
+        row_pos = Base::row_positions(mat);
+        removed = nullptr;
+        num_removed = 0;
+    }
+
+    void release_base()
+    {
+        Base::destroy(mat);
+        delete_csr_matrix(csr);
+        delete_array(row_pos);
+        delete_array(removed);
+        row_pos = nullptr;
+        removed = nullptr;
+    }
+
+    void update(const Op &op)
+    {
+        poll_merge();
+        apply(op);
+        if (merge_thread.joinable())
+            merge_log.push_back(op);
+        else if ((size_t) delta_row.size() + num_removed > merge_threshold())
+        {
+            start_merge();
+            ++num_background_merges;
+        }
+    }
+
+    size_t merge_threshold() const
+    {
+        return std::max((size_t) DELTA_MERGE_MIN, (size_t) (merge_ratio * (double) csr.num_nnzs));
+    }
+
+    // 基础格式中 (row, col) 的位置, 不存在返回 -1
+    IndexType find_base(const IndexType row, const IndexType col) const
+    {
+        if (row >= csr.num_rows)
+            return -1;
+        for (IndexType jj = csr.row_offset[row]; jj < csr.row_offset[row + 1]; ++jj)
+            if (csr.col_index[jj] == col)
+                return jj;
+        return -1;
+    }
+
+    void set_base(const IndexType row, const IndexType jj, const ValueType val)
+    {
+        csr.values[jj] = val;
+        Base::set_value(mat, row_pos, row, jj - csr.row_offset[row], val);
+    }
+
+    void remove_base(const IndexType row, const IndexType jj)
+    {
+        if (removed == nullptr)
+        {
+            removed = new_array<char>(csr.num_nnzs);
+            CHECK_ALLOC(removed);
+            std::fill(removed, removed + csr.num_nnzs, 0);
+        }
+        if (!removed[jj])
+        {
+            removed[jj] = 1;
+            ++num_removed;
+        }
+        set_base(row, jj, ValueType(0));
+    }
+
+    // 与最后一个元素交换后删除
+    void erase_delta(const size_t idx)
+    {
+        const size_t last = delta_row.size() - 1;
+        delta_map.erase(std::make_pair(delta_row[idx], delta_col[idx]));
+        if (idx != last)
+        {
+            delta_row[idx] = delta_row[last];
+            delta_col[idx] = delta_col[last];
+            delta_val[idx] = delta_val[last];
+            delta_map[std::make_pair(delta_row[idx], delta_col[idx])] = (IndexType) idx;
+        }
+        delta_row.pop_back();
+        delta_col.pop_back();
+        delta_val.pop_back();
+        delta_dirty = true;
+    }
+
+    void apply(const Op &op)
+    {
+        if (op.kind == OP_RESIZE)
+        {
+            rows = std::max(rows, op.row);
+            cols = std::max(cols, op.col);
+            return;
+        }
+        if (op.row < 0 || op.row >= rows || (op.kind != OP_REMOVE_ROW && (op.col < 0 || op.col >= cols)))
+        {
+            fprintf(stderr, "Error: entry (%lld, %lld) is outside the %lld x %lld dynamic matrix\n",
+                    (long long) op.row, (long long) op.col, (long long) rows, (long long) cols);
+            exit(EXIT_FAILURE);
+        }
+
+        if (op.kind == OP_REMOVE_ROW)
+        {
+            if (op.row < csr.num_rows)
+                for (IndexType jj = csr.row_offset[op.row]; jj < csr.row_offset[op.row + 1]; ++jj)
+                    remove_base(op.row, jj);
+            // 从后往前删, 换到 i 处的元素都已检查过
+            for (size_t i = delta_row.size(); i-- > 0; )
+                if (delta_row[i] == op.row)
+                    erase_delta(i);
+            return;
+        }
+
+        const IndexType jj = find_base(op.row, op.col);
+        if (op.kind == OP_REMOVE)
+        {
+            if (jj >= 0)
+                remove_base(op.row, jj);
+            else
+            {
+                auto it = delta_map.find(std::make_pair(op.row, op.col));
+                if (it != delta_map.end())
+                    erase_delta((size_t) it->second);
+            }
+            return;
+        }
+
+        // OP_INSERT
+        if (jj >= 0)
+        {
+            if (removed != nullptr && removed[jj])
+            {
+                removed[jj] = 0;
+                --num_removed;
+            }
+            set_base(op.row, jj, op.val);
+            return;
+        }
+        auto it = delta_map.find(std::make_pair(op.row, op.col));
+        if (it != delta_map.end())
+        {
+            delta_val[it->second] = op.val;
+            return;
+        }
+        delta_map[std::make_pair(op.row, op.col)] = (IndexType) delta_row.size();
+        delta_row.push_back(op.row);
+        delta_col.push_back(op.col);
+        delta_val.push_back(op.val);
+        delta_dirty = true;
+    }
+
+    /**
+     * @brief y += alpha * delta * x. The delta is sorted by (row, col) after it changed,
+     *        each thread takes a contiguous range of whole rows, so no atomics are needed.
+     */
+    void delta_spmv(const ValueType alpha, const ValueType *x, ValueType *y)
+    {
+        const size_t n = delta_row.size();
+        if (n == 0)
+            return;
+
+        if (delta_dirty)
+        {
+            delta_order.resize(n);
+            for (size_t i = 0; i < n; ++i)
+                delta_order[i] = (IndexType) i;
+            const IndexType *r = delta_row.data(), *c = delta_col.data();
+            std::sort(delta_order.begin(), delta_order.end(), [r, c](IndexType a, IndexType b) {
+                return r[a] < r[b] || (r[a] == r[b] && c[a] < c[b]);
+            });
+            delta_dirty = false;
+        }
+
+        const IndexType *order = delta_order.data();
+        const IndexType *d_row = delta_row.data();
+        const IndexType *d_col = delta_col.data();
+        const ValueType *d_val = delta_val.data();
+        const int thread_num = n < (size_t) DELTA_PARALLEL_MIN ? 1 : Le_get_thread_num();
+
+        // 分界点后移到行首, 相邻线程不会写同一行
+        auto row_start = [&](size_t k) {
+            while (k > 0 && k < n && d_row[order[k]] == d_row[order[k - 1]])
+                ++k;
+            return k;
+        };
+
+        #pragma omp parallel num_threads(thread_num)
+        {
+            const int tid = Le_get_thread_id();
+            const size_t lo = row_start(n * tid / thread_num);
+            const size_t hi = row_start(n * (tid + 1) / thread_num);
+            for (size_t k = lo; k < hi; )
+            {
+                const IndexType row = d_row[order[k]];
+                ValueType sum = 0;
+                for ( ; k < hi && d_row[order[k]] == row; ++k)
+                    sum += d_val[order[k]] * x[d_col[order[k]]];
+                y[row] += alpha * sum;
+            }
+        }
+    }
+
+    void start_merge()
+    {
+        Snapshot snap;
+        snap.num_rows   = rows;
+        snap.num_cols   = cols;
+        snap.base_rows  = csr.num_rows;
+        snap.row_offset = csr.row_offset;
+        snap.col_index  = csr.col_index;
+        snap.values     = copy_array(csr.values, csr.num_nnzs);
+        snap.removed    = removed != nullptr ? copy_array(removed, csr.num_nnzs) : nullptr;
+        snap.delta_row  = delta_row;
+        snap.delta_col  = delta_col;
+        snap.delta_val  = delta_val;
+
+        merge_done.store(false, std::memory_order_relaxed);
+        merge_thread = std::thread(&Le_dynamic_matrix::merge_worker, this, std::move(snap));
+    }
+
+    // 后台线程: 删除被标记的元素, 把 delta 接到各行末尾, 再转换基础格式
+    void merge_worker(Snapshot snap)
+    {
+        // 转换的并行区都用 num_threads(Le_get_thread_num()), 只在本线程改为 DELTA_MERGE_THREADS
+        Le_thread_num_scope threads(DELTA_MERGE_THREADS);
+        merge_thread_num.store(Le_get_thread_num(), std::memory_order_relaxed);
+        CSR_Matrix<IndexType, ValueType> merged;
+        merged.num_rows = snap.num_rows;
+        merged.num_cols = snap.num_cols;
+        merged.partition = nullptr;
+        merged.tag = 0;
+        merged.kernel_flag = 1;     // 安装时换成当前的 kernel_flag
+
+        merged.row_offset = new_array<IndexType>(snap.num_rows + 1);
+        CHECK_ALLOC(merged.row_offset);
+        std::fill(merged.row_offset, merged.row_offset + snap.num_rows + 1, 0);
+        for (IndexType i = 0; i < snap.base_rows; ++i)
+            for (IndexType jj = snap.row_offset[i]; jj < snap.row_offset[i + 1]; ++jj)
+                if (snap.removed == nullptr || !snap.removed[jj])
+                    merged.row_offset[i + 1]++;
+        for (size_t k = 0; k < snap.delta_row.size(); ++k)
+            merged.row_offset[snap.delta_row[k] + 1]++;
+        for (IndexType i = 0; i < snap.num_rows; ++i)
+            merged.row_offset[i + 1] += merged.row_offset[i];
+        merged.num_nnzs = merged.row_offset[snap.num_rows];
+
+        merged.col_index = new_array<IndexType>(merged.num_nnzs);
+        merged.values    = new_array<ValueType>(merged.num_nnzs);
+        IndexType *fill  = copy_array(merged.row_offset, snap.num_rows);
+        CHECK_ALLOC(merged.col_index);
+        CHECK_ALLOC(merged.values);
+        CHECK_ALLOC(fill);
+
+        for (IndexType i = 0; i < snap.base_rows; ++i)
+            for (IndexType jj = snap.row_offset[i]; jj < snap.row_offset[i + 1]; ++jj)
+                if (snap.removed == nullptr || !snap.removed[jj])
+                {
+                    merged.col_index[fill[i]] = snap.col_index[jj];
+                    merged.values[fill[i]++]  = snap.values[jj];
+                }
+        for (size_t k = 0; k < snap.delta_row.size(); ++k)
+        {
+            const IndexType i = snap.delta_row[k];
+            merged.col_index[fill[i]] = snap.delta_col[k];
+            merged.values[fill[i]++]  = snap.delta_val[k];
+        }
+        delete_array(fill);
+        delete_array(snap.values);
+        delete_array(snap.removed);
+
+        next_csr = merged;
+        next_mat = Base::build(next_csr);
+        next_row_pos = Base::row_positions(next_mat);
+        merge_done.store(true, std::memory_order_release);
+    }
+
+    void poll_merge()
+    {
+        if (merge_thread.joinable() && merge_done.load(std::memory_order_acquire))
+        {
+            merge_thread.join();
+            finish_merge();
+        }
+    }
+
+    // 换上新的基础格式, 重放合并期间的更新
+    void finish_merge()
+    {
+        release_base();
+        csr = next_csr;
+        mat = next_mat;
+        mat.kernel_flag = kernel_flag;
+        row_pos = next_row_pos;
+        num_removed = 0;
+
+        delta_row.clear();
+        delta_col.clear();
+        delta_val.clear();
+        delta_map.clear();
+        delta_dirty = true;
+
+        std::vector<Op> log;
+        log.swap(merge_log);
+        for (const Op &op : log)
+            apply(op);
+        num_replayed += log.size();
+    }
+
+    double merge_ratio;
+    int kernel_flag;
+    IndexType rows, cols;
+
+    // 基础格式
+    CSR_Matrix<IndexType, ValueType> csr;
+    Matrix mat;
+    IndexType *row_pos;
+    char *removed;          // 被删除的基础元素 (length = csr.num_nnzs), 首次删除时分配
+    IndexType num_removed;
+
+    // COO delta
+    std::vector<IndexType> delta_row, delta_col;
+    std::vector<ValueType> delta_val;
+    std::unordered_map<std::pair<IndexType, IndexType>, IndexType, Key_hash> delta_map;
+    std::vector<IndexType> delta_order;
+    bool delta_dirty;
+
+    // 后台合并
+    std::thread merge_thread;
+    std::atomic<bool> merge_done;
+    std::vector<Op> merge_log;
+    CSR_Matrix<IndexType, ValueType> next_csr;
+    Matrix next_mat;
+    IndexType *next_row_pos;
+    size_t num_background_merges;
+    size_t num_replayed;
+    std::atomic<int> merge_thread_num;
+};
+
+/**
+ * @brief y = alpha * A * x + beta * y for a Le_dynamic_matrix (base + delta)
+ */
+template <typename Matrix, typename ValueType>
+void LeSpMV_dynamic(const ValueType alpha, Le_dynamic_matrix<Matrix> &dyn, const ValueType *x, const ValueType beta, ValueType *y)
+{
+    dyn.spmv(alpha, x, beta, y);
+}
+
+#endif /* SPARSE_DYNAMIC_H */
@@ -27,13 +27,19 @@ class MTX{
             return t_num_blocks;
         }
         bool MtxLoad(const char* mat_path);
+        // load a matrix already in memory, e.g. built by sparse_generator.h
+        bool MtxLoad(const CSR_Matrix<IndexType, ValueType> &csr, const std::string &mat_name);
         bool FeaturesWrite(const char* file_path);
         bool ConvertToCSR(CSR_Matrix<IndexType, ValueType> &csr);
         void Stringsplit(const std::string& s, const char split, std::vector<std::string>& res);
         bool CalculateFeatures();
         bool CalculateTilesFeatures();
         bool CalculateTilesExtraFeatures(const char* mat_path);
+        bool CalculateTilesExtraFeatures(const CSR_Matrix<IndexType, ValueType> &csr);
         bool PrintImage(std::string& outputpath);
+        // column-blocked CSR (csr_to_cbcsr) is worth it: x exceeds the LLC share and
+        // the tile features show poor x reuse. Needs CalculateFeatures() first.
+        bool SuggestColumnBlocking();
         double MtxLoad_time_= 0.0;
         double CalculateFeatures_time_= 0.0;
         double ConvertToCSR_time_= 0.0;
@@ -141,6 +147,11 @@ class MTX{
         }
 
     private:
+        // MtxLoad stages: allocate statistics, add one nonzero, finish tile statistics
+        void LoadPrepare();
+        void LoadEntry(const IndexType row_idx, const IndexType col_idx, const ValueType value, const bool is_pattern);
+        void LoadFinish();
+
         bool is_symmetric_ = false;
         std::string matrixName;
         IndexType matrixID_ = 0;
@@ -256,6 +267,13 @@ class MTX{
         std::vector<std::vector<IndexType>> Rows_cnt;
         std::vector<std::vector<IndexType>> Cols_cnt;
 
+        // only used while loading, see LoadPrepare()
+        bool tile_flag_ = true;
+        IndexType RB_threshold_ = 0;
+        IndexType CB_threshold_ = 0;
+        std::vector<std::vector<bool>> Rows_flag_;
+        std::vector<std::vector<bool>> Cols_flag_;
+
         std::vector<IndexType> max_rownnz_per_tile_;
         std::vector<ValueType> ave_rownnz_per_tile_;
         std::vector<ValueType> std_rownnz_per_tile_;
@@ -299,7 +317,7 @@ class MTX{
         ValueType uniqC = -1.0;           // sum divide nnz
 
         // GrX_uniq  ; for cacheline evaluate
-        IndexType GrX = CACHE_LINE / sizeof(ValueType);
+        IndexType GrX = Le_get_cache_line() / sizeof(ValueType);
         std::vector<IndexType> GrX_uniqRB;
         std::vector<IndexType> GrX_uniqCB;
         ValueType GrX_uniqR = -1.0;       // sum divide nnz
@@ -28,6 +28,8 @@
 #define SPARSE_FORMAT_H
 
 #include"memopt.h"
+#include"arena.h"
+#include"quant_utils.h"
 #include<vector>
 
 /* Leading-dimension */
@@ -37,6 +39,89 @@ typedef enum
     ColMajor = 1  /* Fortran-style */
 } LeadingDimension;
 
+/* Storage of the nonzero values (CSR, CSR5 and SELL-C-sigma) */
+typedef enum
+{
+    DenseValues     = 0,  /* values[num_nnzs] */
+    PatternValues   = 1,  /* pattern only: every nonzero is 1, values == nullptr */
+    IndexedValues8  = 2,  /* value_table[packed_values[k]], uint8_t  codes, values == nullptr */
+    IndexedValues16 = 3,  /* value_table[packed_values[k]], uint16_t codes, values == nullptr */
+    HalfValues      = 4,  /* FP16 codes * value_scale[row / scale_rows], values == nullptr */
+    BFloat16Values  = 5,  /* BF16 codes * value_scale[row / scale_rows], values == nullptr */
+    Int8Values      = 6   /* int8 codes * value_scale[row / scale_rows], values == nullptr */
+} ValueStorage;
+
+/* Bytes per nonzero in packed_values (value codes), 0 for dense and pattern-only storage */
+inline size_t packed_value_bytes(const ValueStorage storage)
+{
+    switch (storage)
+    {
+        case IndexedValues8:  return 1;
+        case IndexedValues16: return 2;
+        case HalfValues:      return 2;
+        case BFloat16Values:  return 2;
+        case Int8Values:      return 1;
+        default:              return 0;
+    }
+}
+
+/**
+ * @brief kernel 中代替 values 指针的访问器: pattern-only 矩阵的每个非零元都是 1,
+ *        下标与偏移都返回常量, A[i,j] * x[j] 被编译器化简为 x[j], 不读任何值数组.
+ */
+template <typename ValueType>
+struct Pattern_Values
+{
+    ValueType operator[](const size_t) const { return ValueType(1); }
+    Pattern_Values operator+(const size_t) const { return *this; }
+};
+
+/**
+ * @brief 值编号压缩 (CSR-VI / SELL-VI) 的访问器: 第 k 个非零元的值为 table[index[k]].
+ *        值表只有几百到几万项, 计算时常驻 L1 / L2, 每个非零元只读 1 或 2 字节.
+ */
+template <typename ValueType, typename Code>
+struct Indexed_Values
+{
+    const ValueType *table;
+    const Code      *index;
+
+    ValueType operator[](const size_t k) const { return table[index[k]]; }
+    Indexed_Values operator+(const size_t n) const { return Indexed_Values{table, index + n}; }
+};
+
+/**
+ * @brief 量化数值 (FP16 / BF16 / int8) 的访问器: 第 k 个非零元在寄存器中解码为 ValueType,
+ *        以 ValueType 累加. 缩放因子每 scale_rows 行一个 (1 为逐行, C 为 SELL 的逐 chunk),
+ *        由 value_row_scale 在行末乘一次. operator+ 只移动编码, scale 始终从第 0 行起算.
+ */
+template <typename ValueType, typename Code>
+struct Quantized_Values
+{
+    const Code      *codes;
+    const ValueType *scale;
+    size_t           scale_rows;
+
+    ValueType operator[](const size_t k) const { return (ValueType) le_dequantize(codes[k]); }
+    Quantized_Values operator+(const size_t n) const { return Quantized_Values{codes + n, scale, scale_rows}; }
+};
+
+/**
+ * @brief 第 row 行 (SELL 为重排后的行) 的缩放因子, 只有量化数值不是 1.
+ *        乘 1 是精确的, 其他存储方式的 kernel 结果不变.
+ */
+template <typename ValueType>
+inline ValueType value_row_scale(const ValueType *, const size_t) { return ValueType(1); }
+
+template <typename ValueType>
+inline ValueType value_row_scale(const Pattern_Values<ValueType> &, const size_t) { return ValueType(1); }
+
+template <typename ValueType, typename Code>
+inline ValueType value_row_scale(const Indexed_Values<ValueType, Code> &, const size_t) { return ValueType(1); }
+
+template <typename ValueType, typename Code>
+inline ValueType value_row_scale(const Quantized_Values<ValueType, Code> &va, const size_t row) { return va.scale[row / va.scale_rows]; }
+
 /**
  * @brief General sparse matrix infos
  *        Basic features: rows, cols, nnzs, and sparsity
@@ -61,6 +146,9 @@ struct Matrix_Features
     // partition by number of rows_nnz balance
     IndexType *partition = nullptr;  // size: thread_num + 1 
 
+    // temporaries of the kernels, nullptr uses the arena of the calling thread (arena.h)
+    Le_arena *arena = nullptr;
+
     // Performance Statistics
     double time, gflops, gbytes;
     int tag;
@@ -82,6 +170,10 @@ struct COO_Matrix : public Matrix_Features<IndexType>
     IndexType *row_index;
     IndexType *col_index;
     ValueType *values;
+
+    // 三元组按行有序, 由 read_coo_matrix() / csr_to_coo() / sort_coo_by_row() 设置,
+    // 有序时 SpMV 走 carry kernel, 否则退回每线程一份 y 的拷贝
+    bool row_sorted = false;
 };
 // template struct COO_Matrix<int, float>;
 // template struct COO_Matrix<int, double>;
@@ -101,6 +193,19 @@ struct CSR_Matrix : public Matrix_Features<IndexType>
     IndexType *row_offset;
     IndexType *col_index;
     ValueType *values;
+
+    ValueStorage value_storage = DenseValues;
+
+    // value_storage 为 IndexedValues8 / 16 时: 每个非零元的值编号 (packed_value_bytes 字节),
+    // 值表 value_table[0] = 0, 其余为升序的非零值
+    unsigned char *packed_values = nullptr;
+    ValueType     *value_table   = nullptr;
+    IndexType      value_table_size = 0;
+
+    // value_storage 为 HalfValues / BFloat16Values / Int8Values 时: packed_values 为量化编码,
+    // 第 i 行的值 = 编码 * value_scale[i / scale_rows]
+    ValueType     *value_scale   = nullptr;
+    IndexType      scale_rows    = 0;
 };
 
 /**
@@ -126,6 +231,10 @@ struct BSR_Matrix : public Matrix_Features<IndexType>
     IndexType* row_ptr;
     IndexType* block_colindex;
     ValueType* block_data;      // store the nnzs of blocks in row major
+
+    // 源 CSR 第 j 个非零元在 block_data 中的位置 (length = num_nnzs), 供 update_values 使用
+    // 1x1 块时 block_data 与 CSR values 同序, 不建立
+    IndexType* value_map = nullptr;
 };
 
 
@@ -161,6 +270,9 @@ struct CSR5_Matrix : public CSR_Matrix<IndexType, ValueType>
     IndexType *tile_desc_offset_ptr;    // opt: CSR5 tile descriptor offset pointer CPU case
     IndexType *tile_desc_offset;        // opt: CSR5 tile descriptor offset CPU case
     ValueType *calibrator;              // opt: CSR5 calibrator CPU case
+
+    // row_offset 借用源 CSR 的数组 (CSR5_SHARE_ROW_OFFSET), delete 时不释放
+    bool shared_row_offset = false;
 };
 
 /**
@@ -182,6 +294,34 @@ struct DIA_Matrix : public Matrix_Features<IndexType>
     ValueType * diag_data;     //nonzero values stored in a (dia.complete_ndiags * dia.stride) matrix 
 };
 
+/**
+ * @brief Hybrid DIA + CSR: diagonals with a fill ratio of at least the threshold
+ *        are stored as DIA (same layout as DIA_Matrix), the remaining nonzeros
+ *        are stored in CSR with num_rows rows.
+ * 
+ * @tparam IndexType 
+ * @tparam ValueType 
+ */
+template <typename IndexType, typename ValueType>
+struct DIA_CSR_Matrix : public Matrix_Features<IndexType>
+{
+    typedef IndexType index_type;
+    typedef ValueType value_type;
+
+    // DIA part
+    IndexType stride;
+    IndexType complete_ndiags;
+    IndexType dia_nnzs;        // nonzeros stored in diag_data (without the zero fill)
+    long int  * diag_offsets;
+    ValueType * diag_data;
+
+    // CSR part
+    IndexType csr_nnzs;
+    IndexType * row_offset;
+    IndexType * col_index;
+    ValueType * values;
+};
+
 /**
  * @brief ELLPACK Sparse Matrix Format (row_major default)
  * 
@@ -227,12 +367,14 @@ struct S_ELL_Matrix : public Matrix_Features<IndexType>
     // std::vector<IndexType> row_width;       // length = chunk_num, 每个 width必须是 alignment 的整数倍
     IndexType * row_width;
 
-    // 默认按照行优先存储
-    // std::vector<std::vector<IndexType>> col_index; // col_index[chunk_num][c * row_width[chunk_id]]
-    // std::vector<std::vector<ValueType>> values; // values[chunk_num][c * row_width[chunk_id]]
-    // TODO: 将两个数组 col_index 和 values 改成 二维指针进行内存对齐
-    IndexType ** col_index;
-    ValueType ** values;
+    // 所有 chunk 连续存放在一块对齐的内存中, chunk 的元素位于 [chunk_ptr[chunk], chunk_ptr[chunk + 1])
+    // chunk 内按列优先存储: chunk_col(chunk)[i * sliceWidth + row_within_chunk], 填充为 -1
+    IndexType * chunk_ptr;        // length = chunk_num + 1, chunk_ptr[chunk + 1] - chunk_ptr[chunk] = row_width[chunk] * sliceWidth
+    IndexType * col_index;
+    ValueType * values;
+
+    IndexType * chunk_col(const IndexType chunk) const { return col_index + chunk_ptr[chunk]; }
+    ValueType * chunk_val(const IndexType chunk) const { return values + chunk_ptr[chunk]; }
 };
 
 /**
@@ -259,9 +401,28 @@ struct SELL_C_Sigma_Matrix : public Matrix_Features<IndexType>
     IndexType *reorder;             // Reordering of rows within each slice (length = num_rows)
     IndexType *chunk_len;           // Number of elements in each chunk (length = validchunkNum)
 
-    // 默认按照行优先存储
-    IndexType ** col_index;         // Column indices for non-zero values, per chunk
-    ValueType ** values;            // Non-zero values, per chunk
+    // 所有 chunk 连续存放在一块对齐的内存中, chunk 的元素位于 [chunk_ptr[chunk], chunk_ptr[chunk + 1])
+    // chunk 内按列优先存储: chunk 的第 j 列元素位于 [j * C, (j + 1) * C), 填充位 col_index = -1
+    IndexType * chunk_ptr;          // Offset of each chunk in col_index / values (length = validchunkNum + 1)
+    IndexType * col_index;          // Column indices for non-zero values, all chunks
+    ValueType * values;             // Non-zero values, all chunks
+
+    IndexType * chunk_col(const IndexType chunk) const { return col_index + chunk_ptr[chunk]; }
+    ValueType * chunk_val(const IndexType chunk) const { return values + chunk_ptr[chunk]; }
+
+    ValueStorage value_storage = DenseValues;
+
+    // 值编号压缩 (SELL-VI), 与 CSR 相同; 填充位的编号为 0, 对应值表中的 0
+    unsigned char * packed_values = nullptr;
+    ValueType * value_table = nullptr;
+    IndexType value_table_size = 0;
+
+    // 量化数值, 与 CSR 相同, 行号为重排后的行号: scale_rows = 1 逐行, = chunkWidth_C 逐 chunk
+    ValueType * value_scale = nullptr;
+    IndexType scale_rows = 0;
+
+    // 源 CSR 的 row_offset (length = num_rows + 1), 与 reorder 一起定位每行的值, 供 update_values 使用
+    IndexType * csr_row_offset = nullptr;
 
     // Extra
     // IndexType *chunkLengths;        // Actual number of non-zero elements in each row within the chunk
@@ -289,9 +450,92 @@ struct SELL_C_R_Matrix : public Matrix_Features<IndexType>
     IndexType *reorder;             // Reordering of rows within each slice (length = num_rows)
     IndexType *chunk_len;           // Number of elements in each chunk (length = validchunkNum)
 
-    // 默认按照行优先存储
-    IndexType ** col_index;         // Column indices for non-zero values, per chunk
-    ValueType ** values;            // Non-zero values, per chunk
+    // 所有 chunk 连续存放在一块对齐的内存中, chunk 的元素位于 [chunk_ptr[chunk], chunk_ptr[chunk + 1])
+    // chunk 内默认按照行优先存储
+    IndexType * chunk_ptr;          // Offset of each chunk in col_index / values (length = validchunkNum + 1)
+    IndexType * col_index;          // Column indices for non-zero values, all chunks
+    ValueType * values;             // Non-zero values, all chunks
+
+    IndexType * chunk_col(const IndexType chunk) const { return col_index + chunk_ptr[chunk]; }
+    ValueType * chunk_val(const IndexType chunk) const { return values + chunk_ptr[chunk]; }
+};
+
+/**
+ * @brief CSR Matrix after a symmetric permutation B = P A P^T, B(i,j) = A(perm[i], perm[j]).
+ *        LeSpMV_permuted_csr() gathers x and scatters y through scratch from the
+ *        matrix's arena, so it is used like A in the original ordering.
+ *
+ * @tparam IndexType
+ * @tparam ValueType
+ */
+template <typename IndexType, typename ValueType>
+struct Permuted_CSR_Matrix : public CSR_Matrix<IndexType, ValueType>
+{
+    typedef IndexType index_type;
+    typedef ValueType value_type;
+
+    int reorder_method;             // ReorderMethod in sparse_reorder.h
+    IndexType *perm;                // new row i is the old row perm[i] (length = num_rows)
+};
+
+/**
+ * @brief Column-blocked (x-tiled) CSR Matrix Format.
+ *        Columns are split into vertical panels of panel_width columns, each panel
+ *        keeps a CSR of its non-empty rows. The kernel sweeps all rows of one panel
+ *        before the next, so the x range of a panel stays cache-resident.
+ *
+ *        panel p owns panel rows [panel_ptr[p], panel_ptr[p+1]),
+ *        panel row k is row row_index[k] with nnzs [row_offset[k], row_offset[k+1]).
+ *        partition (kernel_flag = 2): num_panels * (thread_num + 1) panel rows.
+ *
+ * @tparam IndexType
+ * @tparam ValueType
+ */
+template <typename IndexType, typename ValueType>
+struct CBCSR_Matrix : public Matrix_Features<IndexType>
+{
+    typedef IndexType index_type;
+    typedef ValueType value_type;
+
+    IndexType panel_width;      // 每个 panel 的列数
+    IndexType num_panels;       // panel 数目 = ceil(num_cols / panel_width)
+    IndexType num_panel_rows;   // 所有 panel 中非空行的总数
+
+    IndexType *panel_ptr;       // length = num_panels + 1
+    IndexType *row_index;       // length = num_panel_rows
+    IndexType *row_offset;      // length = num_panel_rows + 1
+    IndexType *col_index;       // global column index, length = num_nnzs
+    ValueType *values;
+};
+
+/**
+ * @brief Compressed Sparse Blocks (CSB) Matrix Format
+ *  < Buluc, Aydin, et al. "Parallel sparse matrix-vector and matrix-transpose-vector
+ *  multiplication using compressed sparse blocks." SPAA 2009. >
+ *
+ *        The matrix is tiled into beta x beta blocks (beta <= 65536), blocks are
+ *        stored block row by block row, and a nnz keeps only its 16-bit row / col
+ *        offset inside its block. Inside a block the nnzs are ordered by row, then column.
+ *        block (br, bc) owns nnzs [blk_ptr[br * nbc + bc], blk_ptr[br * nbc + bc + 1]).
+ *
+ * @tparam IndexType
+ * @tparam ValueType
+ */
+template <typename IndexType, typename ValueType>
+struct CSB_Matrix : public Matrix_Features<IndexType>
+{
+    typedef IndexType index_type;
+    typedef ValueType value_type;
+
+    IndexType beta;             // block dim, power of 2
+    int       log_beta;         // beta = 1 << log_beta
+    IndexType nbr;              // number of block rows
+    IndexType nbc;              // number of block cols
+
+    IndexType *blk_ptr;         // length = nbr * nbc + 1
+    uint16_t  *rloc;            // row offset inside the block, length = num_nnzs
+    uint16_t  *cloc;            // col offset inside the block, length = num_nnzs
+    ValueType *values;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -311,6 +555,9 @@ void delete_csr_matrix(CSR_Matrix<IndexType,ValueType>& csr){
     delete_array(csr.row_offset);
     delete_array(csr.col_index);
     delete_array(csr.values);
+    delete_array(csr.packed_values);
+    delete_array(csr.value_table);
+    delete_array(csr.value_scale);
 }
 
 template <typename IndexType, typename ValueType>
@@ -320,11 +567,14 @@ void delete_bsr_matrix(BSR_Matrix<IndexType,ValueType>& bsr){
     delete_array(bsr.row_ptr);
     delete_array(bsr.block_colindex);
     delete_array(bsr.block_data);
+    delete_array(bsr.value_map);
+    bsr.value_map = nullptr;
 }
 
 template <typename IndexType, typename UIndexType, typename ValueType>
 void delete_csr5_matrix(CSR5_Matrix<IndexType,UIndexType,ValueType>& csr5){
-    delete_array(csr5.row_offset);
+    if (!csr5.shared_row_offset)
+        delete_array(csr5.row_offset);
     delete_array(csr5.col_index);
     delete_array(csr5.values);
     delete_array(csr5.tile_ptr);
@@ -368,13 +618,9 @@ void delete_s_ell_matrix(S_ELL_Matrix<IndexType,ValueType>& s_ell){
 
     // for new struct
     delete_array(s_ell.row_width);
-    for (IndexType chunk = 0; chunk < s_ell.chunk_num; chunk++)
-    {
-        delete_array(s_ell.col_index[chunk]);
-        delete_array(s_ell.values[chunk]);
-    }
-    delete[] s_ell.col_index;
-    delete[] s_ell.values;
+    delete_array(s_ell.chunk_ptr);
+    delete_array(s_ell.col_index);
+    delete_array(s_ell.values);
     s_ell.chunk_num = 0;
 }
 
@@ -387,13 +633,14 @@ void delete_s_ell_c_sigma_matrix(SELL_C_Sigma_Matrix<IndexType,ValueType>& s_ell
     delete_array(s_ell_c_sigma.reorder);
     delete_array(s_ell_c_sigma.chunk_len);
 
-    for (IndexType chunkID = 0; chunkID < s_ell_c_sigma.validchunkNum; chunkID++)
-    {
-        delete_array(s_ell_c_sigma.col_index[chunkID]);
-        delete_array(s_ell_c_sigma.values[chunkID]);
-    }
-    delete[] s_ell_c_sigma.col_index;
-    delete[] s_ell_c_sigma.values;
+    delete_array(s_ell_c_sigma.chunk_ptr);
+    delete_array(s_ell_c_sigma.col_index);
+    delete_array(s_ell_c_sigma.values);
+    delete_array(s_ell_c_sigma.packed_values);
+    delete_array(s_ell_c_sigma.value_table);
+    delete_array(s_ell_c_sigma.value_scale);
+    delete_array(s_ell_c_sigma.csr_row_offset);
+    s_ell_c_sigma.csr_row_offset = nullptr;
     s_ell_c_sigma.sliceNum  = 0;
     s_ell_c_sigma.chunkNum  = 0;
     s_ell_c_sigma.validchunkNum = 0;
@@ -408,15 +655,54 @@ void delete_s_ell_c_R_matrix(SELL_C_R_Matrix<IndexType,ValueType>& s_ell_c_R){
     delete_array(s_ell_c_R.reorder);
     delete_array(s_ell_c_R.chunk_len);
 
-    for (IndexType chunkID = 0; chunkID < s_ell_c_R.validchunkNum; chunkID++)
-    {
-        delete_array(s_ell_c_R.col_index[chunkID]);
-        delete_array(s_ell_c_R.values[chunkID]);
-    }
-    delete[] s_ell_c_R.col_index;
-    delete[] s_ell_c_R.values;
+    delete_array(s_ell_c_R.chunk_ptr);
+    delete_array(s_ell_c_R.col_index);
+    delete_array(s_ell_c_R.values);
     s_ell_c_R.validchunkNum  = 0;
 }
+template <typename IndexType, typename ValueType>
+void delete_permuted_csr_matrix(Permuted_CSR_Matrix<IndexType,ValueType>& pcsr){
+    delete_csr_matrix(pcsr);
+    if (pcsr.partition != nullptr)
+        delete_array(pcsr.partition);
+    pcsr.partition = nullptr;
+    delete_array(pcsr.perm);
+}
+
+template <typename IndexType, typename ValueType>
+void delete_cbcsr_matrix(CBCSR_Matrix<IndexType,ValueType>& cbcsr){
+    if (cbcsr.partition != nullptr)
+        delete_array(cbcsr.partition);
+    cbcsr.partition = nullptr;
+    delete_array(cbcsr.panel_ptr);
+    delete_array(cbcsr.row_index);
+    delete_array(cbcsr.row_offset);
+    delete_array(cbcsr.col_index);
+    delete_array(cbcsr.values);
+    cbcsr.num_panels = 0;
+    cbcsr.num_panel_rows = 0;
+}
+
+template <typename IndexType, typename ValueType>
+void delete_csb_matrix(CSB_Matrix<IndexType,ValueType>& csb){
+    delete_array(csb.blk_ptr);
+    delete_array(csb.rloc);
+    delete_array(csb.cloc);
+    delete_array(csb.values);
+    csb.nbr = 0;
+    csb.nbc = 0;
+}
+
+template <typename IndexType, typename ValueType>
+void delete_dia_csr_matrix(DIA_CSR_Matrix<IndexType,ValueType>& hyb){
+    delete_array(hyb.diag_offsets);
+    delete_array(hyb.diag_data);
+    delete_array(hyb.row_offset);
+    delete_array(hyb.col_index);
+    delete_array(hyb.values);
+    hyb.complete_ndiags = 0;
+    hyb.csr_nnzs = 0;
+}
 ////////////////////////////////////////////////////////////////////////////////
 // Delete Matrix struct
 ////////////////////////////////////////////////////////////////////////////////
@@ -448,4 +734,16 @@ void delete_host_matrix(SELL_C_Sigma_Matrix<IndexType,ValueType>& s_ell_c_sigma)
 template <typename IndexType, typename ValueType>
 void delete_host_matrix(SELL_C_R_Matrix<IndexType,ValueType>& s_ell_c_R){ delete_s_ell_c_R_matrix(s_ell_c_R); }
 
+template <typename IndexType, typename ValueType>
+void delete_host_matrix(Permuted_CSR_Matrix<IndexType,ValueType>& pcsr){ delete_permuted_csr_matrix(pcsr); }
+
+template <typename IndexType, typename ValueType>
+void delete_host_matrix(CBCSR_Matrix<IndexType,ValueType>& cbcsr){ delete_cbcsr_matrix(cbcsr); }
+
+template <typename IndexType, typename ValueType>
+void delete_host_matrix(CSB_Matrix<IndexType,ValueType>& csb){ delete_csb_matrix(csb); }
+
+template <typename IndexType, typename ValueType>
+void delete_host_matrix(DIA_CSR_Matrix<IndexType,ValueType>& hyb){ delete_dia_csr_matrix(hyb); }
+
 #endif /* SPARSE_FORMAT_H */
@@ -0,0 +1,92 @@
+#ifndef SPARSE_GENERATOR_H
+#define SPARSE_GENERATOR_H
+/*
+ * @brief Synthetic sparse matrix generators, build CSR directly in memory.
+ *        All generators run with Le_get_thread_num() threads and are
+ *        deterministic for a given seed, independent of the thread number:
+ *        every row (or R-MAT edge) draws from its own counter-based stream.
+ *        Columns of each row are sorted and unique.
+ */
+#include"sparse_format.h"
+#include<string>
+
+/**
+ * @brief Banded matrix, entries (i, j) with -lower <= j - i <= upper.
+ *        The diagonal is always kept, other in-band entries with probability fill.
+ */
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_banded_csr(const IndexType num_rows, const IndexType lower, const IndexType upper, const double fill, const unsigned long long seed);
+
+/**
+ * @brief Block diagonal matrix of block_size x block_size blocks (the last one may be smaller).
+ *        The diagonal is always kept, other block entries with probability density.
+ */
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_block_diag_csr(const IndexType num_rows, const IndexType block_size, const double density, const unsigned long long seed);
+
+/**
+ * @brief Random matrix with uniformly distributed columns.
+ *        Row lengths follow ave_row_nnz * w_i / mean(w), w_i = (rank_i + 1)^(-skew)
+ *        over a random permutation rank of the rows: skew = 0 gives equal rows,
+ *        a larger skew gives a power-law row distribution (larger Gini).
+ */
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_random_csr(const IndexType num_rows, const IndexType num_cols, const double ave_row_nnz, const double skew, const unsigned long long seed);
+
+/**
+ * @brief Same as generate_random_csr, the skew is chosen to reach the Gini
+ *        coefficient of the row lengths (0 <= gini < 1).
+ */
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_random_csr_gini(const IndexType num_rows, const IndexType num_cols, const double ave_row_nnz, const double gini, const unsigned long long seed);
+
+/**
+ * @brief R-MAT (recursive matrix) power-law graph of 2^scale vertices and
+ *        edge_factor * 2^scale edges, quadrant probabilities a, b, c and 1-a-b-c.
+ *        Duplicated edges are merged. Graph500 uses a=0.57, b=c=0.19.
+ */
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_rmat_csr(const int scale, const int edge_factor, const double a, const double b, const double c, const unsigned long long seed);
+
+/**
+ * @brief Finite-difference Laplacian on an nx x ny x nz grid.
+ *        points = 5 (2D, nz = 1), 7 or 27 (3D). Diagonal = points - 1, neighbours = -1,
+ *        so the matrix is symmetric positive (semi-)definite.
+ */
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_stencil_csr(const IndexType nx, const IndexType ny, const IndexType nz, const int points);
+
+/**
+ * @brief Sum of two matrices of the same shape, pattern is the union of both.
+ */
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> merge_csr_matrices(const CSR_Matrix<IndexType, ValueType> &a, const CSR_Matrix<IndexType, ValueType> &b);
+
+/**
+ * @brief Mixture of a banded part (bandwidth on each side, full) and a skewed
+ *        random part (ave_row_nnz, skew), like a PDE matrix with long coupling rows.
+ */
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_mixture_csr(const IndexType num_rows, const IndexType bandwidth, const double ave_row_nnz, const double skew, const unsigned long long seed);
+
+/**
+ * @brief Generate a matrix from a text spec, for drivers (--gen=spec):
+ *          banded:n,lower,upper[,fill]       blockdiag:n,block[,density]
+ *          random:n,m,ave[,skew]             gini:n,m,ave,gini
+ *          rmat:scale,edge_factor[,a,b,c]    stencil5:nx,ny
+ *          stencil7:nx,ny,nz                 stencil27:nx,ny,nz
+ *          mixture:n,bandwidth,ave,skew
+ *        Optional parameters in [] are given all or none (rmat: a, b, c >= 0 and
+ *        a + b + c < 1), any other count or a non-numeric parameter is invalid.
+ * @return an empty matrix (num_rows = 0) if the spec is invalid
+ */
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_csr_matrix(const std::string &spec, const unsigned long long seed);
+
+/**
+ * @brief Gini coefficient of the row lengths of csr
+ */
+template <typename IndexType, typename ValueType>
+double csr_row_gini(const CSR_Matrix<IndexType, ValueType> &csr);
+
+#endif /* SPARSE_GENERATOR_H */
@@ -21,7 +21,7 @@
 #include <cstdlib>
 #include <iostream>
 #include "mmio.h"
-#include "plat_config.h"
+#include "plat_runtime.h"
 #include "general_config.h"
 #include "sparse_format.h"
 #include "sparse_conversion.h"
@@ -46,10 +46,12 @@ COO_Matrix<IndexType,ValueType> read_coo_matrix(const char * mm_filename);
  * @tparam ValueType 
  * @param mm_filename The sparse matrix file, must in mtx format.
  * @param compact     Judge whether sum duplicates together in CSR or not
+ * @param pattern     Read "pattern" mtx files as pattern-only CSR (values == nullptr),
+ *                    other files are read with values
  * @return CSR_Matrix<IndexType, ValueType> 
  */
 template <class IndexType, class ValueType>
-CSR_Matrix<IndexType, ValueType> read_csr_matrix(const char * mm_filename, bool compact = false);
+CSR_Matrix<IndexType, ValueType> read_csr_matrix(const char * mm_filename, bool compact = false, bool pattern = false);
 
 /**
  * @brief Read sparse matrix in BSR format from ".mtx" format file.
@@ -62,7 +64,7 @@ CSR_Matrix<IndexType, ValueType> read_csr_matrix(const char * mm_filename, bool
  * @return BSR_Matrix<IndexType, ValueType> 
 */
 template <class IndexType, class ValueType>
-BSR_Matrix<IndexType, ValueType> read_bsr_matrix(const char * mm_filename, const IndexType blockDimRow = BSR_BlockDimRow, const IndexType blockDimCol = (SIMD_WIDTH/8/sizeof(ValueType)));
+BSR_Matrix<IndexType, ValueType> read_bsr_matrix(const char * mm_filename, const IndexType blockDimRow = BSR_BlockDimRow, const IndexType blockDimCol = Le_get_alignment<ValueType>());
 
 /**
  * @brief Read sparse matrix in CSR5 format from ".mtx" format file.
@@ -98,7 +100,7 @@ ELL_Matrix<IndexType, ValueType> read_ell_matrix(const char * mm_filename, Leadi
  * @return DIA_Matrix<IndexType, ValueType> 
  */
 template <class IndexType, class ValueType>
-DIA_Matrix<IndexType, ValueType> read_dia_matrix(const char * mm_filename, const IndexType max_diags, const IndexType alignment = (SIMD_WIDTH/8/sizeof(ValueType)));
+DIA_Matrix<IndexType, ValueType> read_dia_matrix(const char * mm_filename, const IndexType max_diags, const IndexType alignment = Le_get_alignment<ValueType>());
 
 /**
  * @brief Read sparse matrix in Sliced_ELL format from ".mtx" format file.
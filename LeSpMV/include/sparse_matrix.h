@@ -0,0 +1,264 @@
+/**
+ * @file sparse_matrix.h
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Move-only owners and non-owning views of the structs in sparse_format.h.
+ *         The owner remembers the allocator its arrays came from and frees them
+ *         (partition included) with it; a view never frees anything.
+ *         Le_csr_view wraps CSR arrays owned by another library without copying.
+ * @version 0.1
+ * @date 2024-04-02
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SPARSE_MATRIX_H
+#define SPARSE_MATRIX_H
+
+#include<limits>
+#include<type_traits>
+#include<utility>
+#include"memopt.h"
+#include"thread.h"
+#include"sparse_format.h"
+#include"sparse_conversion.h"
+#include"sparse_update.h"
+
+/**
+ * @brief Owning (or viewing) handle of a sparse matrix struct, e.g.
+ *        Le_matrix<SELL_C_Sigma_Matrix<int, double>>. Copies are disabled: the
+ *        struct itself holds raw pointers, so a copy would share arrays and free
+ *        them twice. Kernels take the plain struct through get() / operator*.
+ *
+ * @tparam Matrix one of the structs of sparse_format.h
+ */
+template <typename Matrix>
+class Le_matrix
+{
+public:
+    typedef Matrix matrix_type;
+
+    Le_matrix() : mat(), alloc(nullptr), owns(false) {}
+
+    /**
+     * @brief Take ownership of the arrays of m, which were allocated with alloc
+     */
+    explicit Le_matrix(const Matrix &m, const Le_allocator *alloc = Le_get_allocator())
+        : mat(m), alloc(alloc), owns(true) {}
+
+    ~Le_matrix() { reset(); }
+
+    Le_matrix(const Le_matrix &) = delete;
+    Le_matrix & operator=(const Le_matrix &) = delete;
+
+    Le_matrix(Le_matrix &&other) noexcept
+        : mat(other.mat), alloc(other.alloc), owns(other.owns)
+    {
+        other.owns = false;
+    }
+
+    Le_matrix & operator=(Le_matrix &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            mat   = other.mat;
+            alloc = other.alloc;
+            owns  = other.owns;
+            other.owns = false;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Non-owning view of m, e.g. for arrays owned by another library
+     */
+    static Le_matrix view(const Matrix &m)
+    {
+        Le_matrix v;
+        v.mat = m;
+        return v;
+    }
+
+    // free the arrays if owned, the handle becomes empty
+    void reset()
+    {
+        if (owns)
+        {
+            // Permuted_CSR / CBCSR 的 delete 函数自己释放 partition, 先置空避免重复释放
+            delete_array(mat.partition, alloc);
+            mat.partition = nullptr;
+            // delete_host_matrix 在本线程上调用 delete_array, 只覆盖本线程的分配器
+            Le_allocator_scope scope(alloc);
+            delete_host_matrix(mat);
+        }
+        owns = false;
+    }
+
+    // give up ownership, the caller frees the arrays with allocator()
+    Matrix release()
+    {
+        owns = false;
+        return mat;
+    }
+
+    Matrix & get() { return mat; }
+    const Matrix & get() const { return mat; }
+    Matrix & operator*() { return mat; }
+    const Matrix & operator*() const { return mat; }
+    Matrix * operator->() { return &mat; }
+    const Matrix * operator->() const { return &mat; }
+
+    bool owning() const { return owns; }
+    const Le_allocator * allocator() const { return alloc; }
+
+    // 稀疏结构不变时只刷新数值, csr_vals 按源 CSR 的顺序 (见 sparse_update.h)
+    void update_values(const typename Matrix::value_type *csr_vals) { ::update_values(mat, csr_vals); }
+
+private:
+    Matrix mat;
+    const Le_allocator *alloc;
+    bool owns;
+};
+
+/**
+ * @brief Run a conversion / reader with alloc as the allocator of the calling thread
+ *        and own its result, e.g.
+ *        auto sell = Le_make_matrix(&numa_alloc, [&]{ return csr_to_sell_c_sigma(csr, nullptr); });
+ *        Other threads (a background merge, concurrent conversions) are not affected.
+ */
+template <typename Builder>
+auto Le_make_matrix(const Le_allocator *alloc, Builder build) -> Le_matrix<decltype(build())>
+{
+    if (alloc == nullptr)
+        alloc = Le_default_allocator();
+    Le_allocator_scope scope(alloc);
+    return Le_matrix<decltype(build())>(build(), alloc);
+}
+
+template <typename Builder>
+auto Le_make_matrix(Builder build) -> Le_matrix<decltype(build())>
+{
+    return Le_make_matrix(Le_get_allocator(), build);
+}
+
+/**
+ * @brief CSR view over externally owned arrays (PETSc AIJ, Eigen, SciPy, MKL ...).
+ *        values are never copied. row_offset / col_index are used in place when they
+ *        are 0-based IndexType arrays, otherwise they are translated once into owned
+ *        IndexType arrays (1-based input, or int32 <-> int64 indices).
+ *        The external arrays must outlive the view. Conversions read get() like any
+ *        CSR and allocate only their own arrays, csr_to_csr5 with CSR5_SHARE_ROW_OFFSET.
+ */
+template <typename IndexType, typename ValueType>
+class Le_csr_view
+{
+public:
+    /**
+     * @param row_offset  num_rows + 1 entries, row_offset[0] == index_base
+     * @param index_base  0 (C) or 1 (Fortran / MKL one-based)
+     */
+    template <typename ForeignIndex>
+    Le_csr_view(const IndexType num_rows, const IndexType num_cols,
+                const ForeignIndex *row_offset, const ForeignIndex *col_index, const ValueType *values,
+                const int index_base = 0)
+        : csr(), alloc(Le_get_allocator()), owned_row_offset(nullptr), owned_col_index(nullptr)
+    {
+        const long long nnz = (long long) row_offset[num_rows] - (long long) row_offset[0];
+        if (nnz > (long long) std::numeric_limits<IndexType>::max())
+        {
+            fprintf(stderr, "Error: %lld nonzeros do not fit the index type of Le_csr_view\n", nnz);
+            exit(EXIT_FAILURE);
+        }
+        csr.num_rows = num_rows;
+        csr.num_cols = num_cols;
+        csr.num_nnzs = (IndexType) nnz;
+        csr.partition = nullptr;
+        csr.tag = 0;
+        csr.kernel_flag = 1;
+        csr.values = const_cast<ValueType *>(values);
+
+        if (std::is_same<ForeignIndex, IndexType>::value && index_base == 0)
+        {
+            csr.row_offset = (IndexType *) const_cast<ForeignIndex *>(row_offset);
+            csr.col_index  = (IndexType *) const_cast<ForeignIndex *>(col_index);
+            return;
+        }
+
+        owned_row_offset = new_array<IndexType>(num_rows + 1);
+        owned_col_index  = new_array<IndexType>(csr.num_nnzs);
+        CHECK_ALLOC(owned_row_offset);
+        CHECK_ALLOC(owned_col_index);
+        IndexType *ro = owned_row_offset, *ci = owned_col_index;
+        const IndexType nnzs = csr.num_nnzs;
+        #pragma omp parallel num_threads(Le_get_thread_num())
+        {
+            #pragma omp for schedule(static) nowait
+            for (IndexType i = 0; i <= num_rows; ++i)
+                ro[i] = (IndexType) (row_offset[i] - index_base);
+            #pragma omp for schedule(static) nowait
+            for (IndexType jj = 0; jj < nnzs; ++jj)
+                ci[jj] = (IndexType) (col_index[jj] - index_base);
+        }
+        csr.row_offset = owned_row_offset;
+        csr.col_index  = owned_col_index;
+    }
+
+    ~Le_csr_view() { reset(); }
+
+    Le_csr_view(const Le_csr_view &) = delete;
+    Le_csr_view & operator=(const Le_csr_view &) = delete;
+
+    Le_csr_view(Le_csr_view &&other) noexcept
+        : csr(other.csr), alloc(other.alloc), owned_row_offset(other.owned_row_offset), owned_col_index(other.owned_col_index)
+    {
+        other.csr.partition = nullptr;
+        other.owned_row_offset = nullptr;
+        other.owned_col_index  = nullptr;
+    }
+
+    Le_csr_view & operator=(Le_csr_view &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            csr   = other.csr;
+            alloc = other.alloc;
+            owned_row_offset = other.owned_row_offset;
+            owned_col_index  = other.owned_col_index;
+            other.csr.partition = nullptr;
+            other.owned_row_offset = nullptr;
+            other.owned_col_index  = nullptr;
+        }
+        return *this;
+    }
+
+    // free the translated index arrays and partition, the external arrays are untouched
+    void reset()
+    {
+        delete_array(owned_row_offset, alloc);
+        delete_array(owned_col_index, alloc);
+        delete_array(csr.partition, alloc);
+        owned_row_offset = nullptr;
+        owned_col_index  = nullptr;
+        csr.partition = nullptr;
+    }
+
+    // true if no index array was translated
+    bool zero_copy() const { return owned_row_offset == nullptr; }
+
+    CSR_Matrix<IndexType, ValueType> & get() { return csr; }
+    const CSR_Matrix<IndexType, ValueType> & get() const { return csr; }
+    CSR_Matrix<IndexType, ValueType> & operator*() { return csr; }
+    const CSR_Matrix<IndexType, ValueType> & operator*() const { return csr; }
+    CSR_Matrix<IndexType, ValueType> * operator->() { return &csr; }
+    const CSR_Matrix<IndexType, ValueType> * operator->() const { return &csr; }
+
+private:
+    CSR_Matrix<IndexType, ValueType> csr;
+    const Le_allocator *alloc;
+    IndexType *owned_row_offset;
+    IndexType *owned_col_index;
+};
+
+#endif /* SPARSE_MATRIX_H */
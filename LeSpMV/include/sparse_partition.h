@@ -36,7 +36,23 @@ void balanced_partition_row_by_nnz_ell(const IndexType *col_index, const IndexTy
 template <typename IndexType>
 void balanced_partition_row_by_nnz_ell_n2(const IndexType *col_index, const IndexType num_nnzs, IndexType num_rows, const IndexType max_width, IndexType num_threads, IndexType *partition);
 
+/**
+ * @brief Partition the chunks of S_ELL / SELL-c-sigma / SELL-c-R by the valid entries
+ *        (col_index >= 0) of [chunk_ptr[chunk], chunk_ptr[chunk + 1]).
+ */
+template <typename IndexType>
+void balanced_partition_row_by_nnz_sell(const IndexType *chunk_ptr, const IndexType *col_index, const IndexType num_nnzs, IndexType chunk_num, IndexType num_threads, IndexType *partition);
+
+/**
+ * @brief Balanced partition of the rows of each panel of a column-blocked CSR by nnzs
+ * @param panel_ptr     first panel row of each panel, size: num_panels + 1
+ * @param row_offset    nnz offset of each panel row, size: num_panel_rows + 1
+ * @param num_panels    number of panels
+ * @param num_threads   threads number
+ * @param partition     partition results array, size: num_panels * (num_threads + 1),
+ *                      global panel row indices, panel p starts at p * (num_threads + 1)
+ */
 template <typename IndexType>
-void balanced_partition_row_by_nnz_sell(const IndexType * const *col_index, const IndexType num_nnzs, IndexType chunk_size, IndexType chunk_num, const IndexType *row_width, IndexType num_threads, IndexType *partition);
+void balanced_partition_cbcsr(const IndexType *panel_ptr, const IndexType *row_offset, IndexType num_panels, IndexType num_threads, IndexType *partition);
 
 #endif /* SPARSE_PARTITION_H */
@@ -0,0 +1,109 @@
+#ifndef SPARSE_REORDER_H
+#define SPARSE_REORDER_H
+/*
+ * @brief Symmetric row/column reordering of square CSR matrices for x-vector locality.
+ *        A permutation is stored as perm[new] = old, the reordered matrix is
+ *        B = P A P^T with B(i,j) = A(perm[i], perm[j]).
+ *        Orderings use the pattern of A + A^T, so unsymmetric matrices are allowed;
+ *        a non-square matrix gets the identity from every reorder_* function.
+ */
+#include"sparse_format.h"
+
+typedef enum
+{
+    REORDER_NONE      = 0,  // identity
+    REORDER_RCM       = 1,  // reverse Cuthill-McKee from a pseudo-peripheral node
+    REORDER_DEGREE    = 2,  // rows sorted by ascending degree
+    REORDER_BANDWIDTH = 3,  // RCM with several start heuristics, the smallest bandwidth wins
+    REORDER_PARTITION = 4   // multilevel graph partition into Le_get_thread_num() parts
+} ReorderMethod;
+
+/**
+ * @brief Reverse Cuthill-McKee. Each component starts from a pseudo-peripheral
+ *        node (George-Liu); BFS levels are expanded in parallel and give the
+ *        same order as the serial algorithm.
+ * @return perm (length num_rows), free by delete_array()
+ */
+template <typename IndexType, typename ValueType>
+IndexType * reorder_rcm(const CSR_Matrix<IndexType, ValueType> &csr);
+
+/**
+ * @brief Rows sorted by ascending degree of A + A^T, ties by the row number
+ */
+template <typename IndexType, typename ValueType>
+IndexType * reorder_degree(const CSR_Matrix<IndexType, ValueType> &csr);
+
+/**
+ * @brief RCM started from the pseudo-peripheral node, the minimum degree node
+ *        and the far end of the pseudo-peripheral search of each component;
+ *        return the ordering with the smallest bandwidth.
+ */
+template <typename IndexType, typename ValueType>
+IndexType * reorder_bandwidth(const CSR_Matrix<IndexType, ValueType> &csr);
+
+/**
+ * @brief Multilevel recursive bisection of the graph of A + A^T into nparts parts:
+ *        heavy edge matching coarsening, greedy graph growing on the coarsest
+ *        graph and boundary refinement while uncoarsening. Parts are balanced
+ *        by the nnz of their rows, and the edge cut is kept small, so each part
+ *        mostly reads its own range of x.
+ * @param partition  output (length nparts + 1), the first new row of each part,
+ *                   in the format of Matrix_Features::partition for the *_omp_lb kernels
+ * @return perm with the rows of each part consecutive (original order inside a part)
+ */
+template <typename IndexType, typename ValueType>
+IndexType * reorder_partition(const CSR_Matrix<IndexType, ValueType> &csr, const IndexType nparts, IndexType *partition);
+
+/**
+ * @brief Fraction of nonzeros A(i,j) whose column j lies in the row range of the part of row i
+ */
+template <typename IndexType, typename ValueType>
+double csr_partition_locality(const CSR_Matrix<IndexType, ValueType> &csr, const IndexType nparts, const IndexType *partition);
+
+/**
+ * @brief Dispatch on method, a non-square matrix gets the identity
+ */
+template <typename IndexType, typename ValueType>
+IndexType * reorder_csr(const CSR_Matrix<IndexType, ValueType> &csr, const ReorderMethod method);
+
+/**
+ * @brief B = P A P^T, columns of each row of B are sorted
+ */
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> permute_csr(const CSR_Matrix<IndexType, ValueType> &csr, const IndexType *perm);
+
+/**
+ * @brief max |i - j| over the nonzeros A(i,j)
+ */
+template <typename IndexType, typename ValueType>
+IndexType csr_bandwidth(const CSR_Matrix<IndexType, ValueType> &csr);
+
+/**
+ * @brief Reorder csr by method and keep the permutation for LeSpMV_permuted_csr().
+ *        REORDER_PARTITION also sets pcsr.partition for kernel_flag = 2,
+ *        built for the current Le_get_thread_num().
+ */
+template <typename IndexType, typename ValueType>
+Permuted_CSR_Matrix<IndexType, ValueType> csr_to_permuted_csr(const CSR_Matrix<IndexType, ValueType> &csr, const ReorderMethod method);
+
+/**
+ * @brief y = alpha * A * x + beta * y with x, y in the original ordering:
+ *        x is gathered into scratch from Le_get_arena(pcsr.arena), the CSR kernel
+ *        selected by kernel_flag runs on B, and the permuted y is scattered back.
+ */
+template <typename IndexType, typename ValueType>
+void LeSpMV_permuted_csr(const ValueType alpha, const Permuted_CSR_Matrix<IndexType, ValueType>& pcsr, const ValueType * x, const ValueType beta, ValueType * y);
+
+/**
+ * @brief out[i] = in[perm[i]], original ordering to the permuted one
+ */
+template <typename IndexType, typename ValueType>
+void permute_vector(const IndexType n, const IndexType *perm, const ValueType *in, ValueType *out);
+
+/**
+ * @brief out[perm[i]] = in[i], permuted ordering back to the original one
+ */
+template <typename IndexType, typename ValueType>
+void unpermute_vector(const IndexType n, const IndexType *perm, const ValueType *in, ValueType *out);
+
+#endif /* SPARSE_REORDER_H */
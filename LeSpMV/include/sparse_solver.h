@@ -0,0 +1,457 @@
+#ifndef SPARSE_SOLVER_H
+#define SPARSE_SOLVER_H
+/*
+ * @brief Krylov solvers (CG, BiCGSTAB, restarted GMRES) for A x = b.
+ *        Like benchmark_spmv(), they are templated on the sparse matrix type
+ *        and its SpMV routine, e.g.
+ *              LeSolve_cg(sell, LeSpMV_sell_c_sigma<int, double>, b, x, inv_diag);
+ *        so every format of LeSpMV can be compared by the time to solution.
+ *        For CSR and SELL-c-sigma the fused kernels of spmv_fused.h are used
+ *        and the given spmv is ignored.
+ *        The optional preconditioner is Jacobi: inv_diag = 1 / diag(A), or nullptr.
+ *        Vector operations run with Le_get_thread_num() threads.
+ */
+
+#include"general_config.h"
+#include"sparse_format.h"
+#include"spmv_fused.h"
+#include"memopt.h"
+#include"thread.h"
+#include"timer.h"
+#include<cmath>
+#include<vector>
+#include<algorithm>
+#include<initializer_list>
+
+struct Solver_Result
+{
+    int    iterations;      // SpMV iterations (GMRES: inner iterations)
+    int    converged;       // 1 if ||b - Ax|| <= tol * ||b||
+    double residual;        // ||b - Ax|| / ||b|| at exit
+    double time;            // ms of the whole solve
+    double iters_per_sec;
+};
+
+/**
+ * @brief Jacobi preconditioner, 1 / A(i,i). Rows without (or with a zero)
+ *        diagonal get 1, so the preconditioner is the identity there.
+ *        Free the result by delete_array().
+ */
+template <typename IndexType, typename ValueType>
+ValueType * jacobi_inv_diag(const CSR_Matrix<IndexType, ValueType> &csr)
+{
+    CHECK_VALUES(csr);
+    ValueType * inv_diag = new_array<ValueType>(csr.num_rows);
+    const IndexType thread_num = Le_get_thread_num();
+
+    #pragma omp parallel for num_threads(thread_num)
+    for (IndexType row = 0; row < csr.num_rows; ++row)
+    {
+        ValueType diag = 0;
+        for (IndexType jj = csr.row_offset[row]; jj < csr.row_offset[row+1]; ++jj)
+            if (csr.col_index[jj] == row)
+                diag += csr.values[jj];
+        inv_diag[row] = (diag == 0) ? ValueType(1) : ValueType(1) / diag;
+    }
+    return inv_diag;
+}
+
+template <typename ValueType>
+ValueType __krylov_dot(const size_t n, const ValueType * a, const ValueType * b)
+{
+    const int thread_num = Le_get_thread_num();
+    ValueType sum = 0;
+    #pragma omp parallel for simd num_threads(thread_num) reduction(+:sum)
+    for (size_t i = 0; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+// z = M * r, M = diag(inv_diag) or the identity
+template <typename ValueType>
+void __krylov_precond(const size_t n, const ValueType * inv_diag, const ValueType * r, ValueType * z)
+{
+    const int thread_num = Le_get_thread_num();
+    if (inv_diag == nullptr)
+    {
+        if (z != r)
+            memcpy_array(z, r, n);
+        return;
+    }
+    #pragma omp parallel for simd num_threads(thread_num)
+    for (size_t i = 0; i < n; ++i)
+        z[i] = inv_diag[i] * r[i];
+}
+
+/**
+ * @brief y = alpha * A * x + beta * w, return dot(y, z) and dot(y, y) if asked.
+ *        Generic path: one SpMV and one pass over y.
+ */
+template <typename SparseMatrix, typename SpMV, typename ValueType>
+void __krylov_spmv_fused(const SparseMatrix &A, SpMV spmv, const ValueType alpha, const ValueType * x, const ValueType beta, const ValueType * w, ValueType * y, const ValueType * z, ValueType * dot_yz, ValueType * norm2_y)
+{
+    const size_t n = A.num_rows;
+    const int thread_num = Le_get_thread_num();
+
+    spmv(alpha, A, x, ValueType(0), y);
+
+    ValueType dot = 0, norm2 = 0;
+    #pragma omp parallel for simd num_threads(thread_num) reduction(+:dot, norm2)
+    for (size_t i = 0; i < n; ++i)
+    {
+        ValueType yi = y[i];
+        if (beta != 0)
+            yi += beta * w[i];
+        y[i] = yi;
+        if (z != nullptr)
+            dot += yi * z[i];
+        norm2 += yi * yi;
+    }
+    if (dot_yz != nullptr)
+        *dot_yz = dot;
+    if (norm2_y != nullptr)
+        *norm2_y = norm2;
+}
+
+template <typename IndexType, typename ValueType, typename SpMV>
+void __krylov_spmv_fused(const CSR_Matrix<IndexType, ValueType> &A, SpMV, const ValueType alpha, const ValueType * x, const ValueType beta, const ValueType * w, ValueType * y, const ValueType * z, ValueType * dot_yz, ValueType * norm2_y)
+{
+    LeSpMV_csr_fused(alpha, A, x, beta, w, y, z, dot_yz, norm2_y);
+}
+
+template <typename IndexType, typename ValueType, typename SpMV>
+void __krylov_spmv_fused(const SELL_C_Sigma_Matrix<IndexType, ValueType> &A, SpMV, const ValueType alpha, const ValueType * x, const ValueType beta, const ValueType * w, ValueType * y, const ValueType * z, ValueType * dot_yz, ValueType * norm2_y)
+{
+    LeSpMV_sell_c_sigma_fused(alpha, A, x, beta, w, y, z, dot_yz, norm2_y);
+}
+
+inline void __krylov_finish(Solver_Result &res, timer &t, const double rnorm, const double bnorm, const double tol)
+{
+    res.time          = t.milliseconds_elapsed();
+    res.residual      = (bnorm == 0) ? rnorm : rnorm / bnorm;
+    res.converged     = (res.residual <= tol) ? 1 : 0;
+    res.iters_per_sec = (res.time == 0) ? 0 : res.iterations / (res.time / 1000.0);
+}
+
+/**
+ * @brief Preconditioned conjugate gradient, A must be symmetric positive definite.
+ *        x is the initial guess on input and the solution on output.
+ */
+template <typename SparseMatrix, typename SpMV>
+Solver_Result LeSolve_cg(const SparseMatrix &A, SpMV spmv,
+                         const typename SparseMatrix::value_type * b,
+                         typename SparseMatrix::value_type * x,
+                         const typename SparseMatrix::value_type * inv_diag,
+                         const double tol = SOLVER_TOL, const int max_iter = SOLVER_MAX_ITER)
+{
+    typedef typename SparseMatrix::value_type ValueType;
+    const size_t n = A.num_rows;
+    const int thread_num = Le_get_thread_num();
+
+    Solver_Result res = {0, 0, 0, 0, 0};
+    timer t;
+
+    ValueType * r  = new_array<ValueType>(n);
+    ValueType * z  = new_array<ValueType>(n);
+    ValueType * p  = new_array<ValueType>(n);
+    ValueType * Ap = new_array<ValueType>(n);
+    // 部分 SpMV kernel 在 beta = 0 时仍读取 y, 工作向量先置零
+    for (ValueType * v : {r, z, p, Ap})
+        std::fill(v, v + n, ValueType(0));
+
+    const double bnorm = std::sqrt((double) __krylov_dot(n, b, b));
+
+    // r = b - A x
+    ValueType rr = 0;
+    __krylov_spmv_fused(A, spmv, ValueType(-1), x, ValueType(1), b, r, (const ValueType *) nullptr, (ValueType *) nullptr, &rr);
+    __krylov_precond(n, inv_diag, r, z);
+    memcpy_array(p, z, n);
+    ValueType rz = __krylov_dot(n, r, z);
+
+    while (res.iterations < max_iter && std::sqrt((double) rr) > tol * bnorm)
+    {
+        // Ap = A p, pAp = dot(p, Ap)
+        ValueType pAp = 0;
+        __krylov_spmv_fused(A, spmv, ValueType(1), p, ValueType(0), Ap, Ap, p, &pAp, (ValueType *) nullptr);
+        res.iterations++;
+        if (pAp == 0)
+            break;
+
+        const ValueType alpha = rz / pAp;
+
+        // x += alpha p, r -= alpha Ap, z = M r, 同一遍循环中求 rr 与 rz
+        ValueType rr_new = 0, rz_new = 0;
+        #pragma omp parallel for simd num_threads(thread_num) reduction(+:rr_new, rz_new)
+        for (size_t i = 0; i < n; ++i)
+        {
+            x[i] += alpha * p[i];
+            const ValueType ri = r[i] - alpha * Ap[i];
+            const ValueType zi = (inv_diag == nullptr) ? ri : inv_diag[i] * ri;
+            r[i] = ri;
+            z[i] = zi;
+            rr_new += ri * ri;
+            rz_new += ri * zi;
+        }
+
+        const ValueType beta = rz_new / rz;
+        rr = rr_new;
+        rz = rz_new;
+
+        #pragma omp parallel for simd num_threads(thread_num)
+        for (size_t i = 0; i < n; ++i)
+            p[i] = z[i] + beta * p[i];
+    }
+
+    __krylov_finish(res, t, std::sqrt((double) rr), bnorm, tol);
+
+    delete_array(r);
+    delete_array(z);
+    delete_array(p);
+    delete_array(Ap);
+    return res;
+}
+
+/**
+ * @brief Right preconditioned BiCGSTAB for general (nonsymmetric) A.
+ *        Each iteration takes two SpMV, res.iterations counts iterations.
+ */
+template <typename SparseMatrix, typename SpMV>
+Solver_Result LeSolve_bicgstab(const SparseMatrix &A, SpMV spmv,
+                               const typename SparseMatrix::value_type * b,
+                               typename SparseMatrix::value_type * x,
+                               const typename SparseMatrix::value_type * inv_diag,
+                               const double tol = SOLVER_TOL, const int max_iter = SOLVER_MAX_ITER)
+{
+    typedef typename SparseMatrix::value_type ValueType;
+    const size_t n = A.num_rows;
+    const int thread_num = Le_get_thread_num();
+
+    Solver_Result res = {0, 0, 0, 0, 0};
+    timer t;
+
+    ValueType * r    = new_array<ValueType>(n);
+    ValueType * r0   = new_array<ValueType>(n);
+    ValueType * p    = new_array<ValueType>(n);
+    ValueType * v    = new_array<ValueType>(n);
+    ValueType * s    = new_array<ValueType>(n);
+    ValueType * tt   = new_array<ValueType>(n);
+    ValueType * phat = new_array<ValueType>(n);
+    ValueType * shat = new_array<ValueType>(n);
+    for (ValueType * vec : {r, r0, p, v, s, tt, phat, shat})
+        std::fill(vec, vec + n, ValueType(0));
+
+    const double bnorm = std::sqrt((double) __krylov_dot(n, b, b));
+
+    ValueType rr = 0;
+    __krylov_spmv_fused(A, spmv, ValueType(-1), x, ValueType(1), b, r, (const ValueType *) nullptr, (ValueType *) nullptr, &rr);
+    memcpy_array(r0, r, n);
+
+    ValueType rho = 1, alpha = 1, omega = 1;
+    ValueType rho_new = rr;   // dot(r0, r) with r0 = r
+
+    while (res.iterations < max_iter && std::sqrt((double) rr) > tol * bnorm)
+    {
+        if (rho_new == 0 || omega == 0)
+            break;   // breakdown
+        const ValueType beta = (rho_new / rho) * (alpha / omega);
+        rho = rho_new;
+
+        // p = r + beta (p - omega v), phat = M p
+        #pragma omp parallel for simd num_threads(thread_num)
+        for (size_t i = 0; i < n; ++i)
+        {
+            p[i] = r[i] + beta * (p[i] - omega * v[i]);
+            phat[i] = (inv_diag == nullptr) ? p[i] : inv_diag[i] * p[i];
+        }
+
+        // v = A phat, dot(v, r0)
+        ValueType r0v = 0;
+        __krylov_spmv_fused(A, spmv, ValueType(1), phat, ValueType(0), v, v, r0, &r0v, (ValueType *) nullptr);
+        res.iterations++;
+        if (r0v == 0)
+            break;
+        alpha = rho / r0v;
+
+        // s = r - alpha v, shat = M s
+        ValueType ss = 0;
+        #pragma omp parallel for simd num_threads(thread_num) reduction(+:ss)
+        for (size_t i = 0; i < n; ++i)
+        {
+            const ValueType si = r[i] - alpha * v[i];
+            s[i] = si;
+            shat[i] = (inv_diag == nullptr) ? si : inv_diag[i] * si;
+            ss += si * si;
+        }
+
+        if (std::sqrt((double) ss) <= tol * bnorm)
+        {
+            #pragma omp parallel for simd num_threads(thread_num)
+            for (size_t i = 0; i < n; ++i)
+                x[i] += alpha * phat[i];
+            rr = ss;
+            break;
+        }
+
+        // t = A shat, dot(t, s) and dot(t, t)
+        ValueType ts = 0, t2 = 0;
+        __krylov_spmv_fused(A, spmv, ValueType(1), shat, ValueType(0), tt, tt, s, &ts, &t2);
+        omega = (t2 == 0) ? ValueType(0) : ts / t2;
+
+        // x += alpha phat + omega shat, r = s - omega t, 同时求 rr 与 dot(r0, r)
+        ValueType rr_new = 0, r0r = 0;
+        #pragma omp parallel for simd num_threads(thread_num) reduction(+:rr_new, r0r)
+        for (size_t i = 0; i < n; ++i)
+        {
+            x[i] += alpha * phat[i] + omega * shat[i];
+            const ValueType ri = s[i] - omega * tt[i];
+            r[i] = ri;
+            rr_new += ri * ri;
+            r0r += r0[i] * ri;
+        }
+        rr = rr_new;
+        rho_new = r0r;
+    }
+
+    __krylov_finish(res, t, std::sqrt((double) rr), bnorm, tol);
+
+    delete_array(r);
+    delete_array(r0);
+    delete_array(p);
+    delete_array(v);
+    delete_array(s);
+    delete_array(tt);
+    delete_array(phat);
+    delete_array(shat);
+    return res;
+}
+
+/**
+ * @brief Right preconditioned GMRES(restart), modified Gram-Schmidt and
+ *        Givens rotations. The true residual is recomputed at every restart.
+ */
+template <typename SparseMatrix, typename SpMV>
+Solver_Result LeSolve_gmres(const SparseMatrix &A, SpMV spmv,
+                            const typename SparseMatrix::value_type * b,
+                            typename SparseMatrix::value_type * x,
+                            const typename SparseMatrix::value_type * inv_diag,
+                            const double tol = SOLVER_TOL, const int max_iter = SOLVER_MAX_ITER,
+                            const int restart = GMRES_RESTART)
+{
+    typedef typename SparseMatrix::value_type ValueType;
+    const size_t n = A.num_rows;
+    const int m = std::max(1, restart);
+    const int thread_num = Le_get_thread_num();
+
+    Solver_Result res = {0, 0, 0, 0, 0};
+    timer t;
+
+    // Krylov basis V 为 (m+1) 个长度 n 的向量, 连续存放
+    ValueType * V = new_array<ValueType>((size_t)(m + 1) * n);
+    ValueType * w = new_array<ValueType>(n);
+    std::fill(V, V + (size_t)(m + 1) * n, ValueType(0));
+    std::fill(w, w + n, ValueType(0));
+    std::vector<double> H((size_t)(m + 1) * m, 0.0), cs(m, 0.0), sn(m, 0.0), g(m + 1, 0.0), yk(m, 0.0);
+
+    const double bnorm = std::sqrt((double) __krylov_dot(n, b, b));
+    double rnorm = 0;
+
+    while (true)
+    {
+        // V_0 = r = b - A x
+        ValueType rr = 0;
+        __krylov_spmv_fused(A, spmv, ValueType(-1), x, ValueType(1), b, V, (const ValueType *) nullptr, (ValueType *) nullptr, &rr);
+        rnorm = std::sqrt((double) rr);
+        if (rnorm <= tol * bnorm || res.iterations >= max_iter || rnorm == 0)
+            break;
+
+        const ValueType scale = ValueType(1.0 / rnorm);
+        #pragma omp parallel for simd num_threads(thread_num)
+        for (size_t i = 0; i < n; ++i)
+            V[i] *= scale;
+        std::fill(g.begin(), g.end(), 0.0);
+        g[0] = rnorm;
+
+        int k = 0;
+        for (; k < m && res.iterations < max_iter; ++k)
+        {
+            ValueType * vk  = V + (size_t) k * n;
+            ValueType * vk1 = V + (size_t)(k + 1) * n;
+
+            // vk1 = A M vk
+            __krylov_precond(n, inv_diag, vk, w);
+            spmv(ValueType(1), A, w, ValueType(0), vk1);
+            res.iterations++;
+
+            // modified Gram-Schmidt
+            for (int j = 0; j <= k; ++j)
+            {
+                const ValueType * vj = V + (size_t) j * n;
+                const ValueType hjk = __krylov_dot(n, vk1, vj);
+                H[(size_t) j * m + k] = hjk;
+                #pragma omp parallel for simd num_threads(thread_num)
+                for (size_t i = 0; i < n; ++i)
+                    vk1[i] -= hjk * vj[i];
+            }
+            const double hk1k = std::sqrt((double) __krylov_dot(n, vk1, vk1));
+            H[(size_t)(k + 1) * m + k] = hk1k;
+            if (hk1k != 0)
+            {
+                const ValueType inv = ValueType(1.0 / hk1k);
+                #pragma omp parallel for simd num_threads(thread_num)
+                for (size_t i = 0; i < n; ++i)
+                    vk1[i] *= inv;
+            }
+
+            // apply the previous rotations and build a new one
+            for (int j = 0; j < k; ++j)
+            {
+                const double h0 = H[(size_t) j * m + k], h1 = H[(size_t)(j + 1) * m + k];
+                H[(size_t) j * m + k]       =  cs[j] * h0 + sn[j] * h1;
+                H[(size_t)(j + 1) * m + k]  = -sn[j] * h0 + cs[j] * h1;
+            }
+            const double h0 = H[(size_t) k * m + k], h1 = H[(size_t)(k + 1) * m + k];
+            const double den = std::hypot(h0, h1);
+            cs[k] = (den == 0) ? 1.0 : h0 / den;
+            sn[k] = (den == 0) ? 0.0 : h1 / den;
+            H[(size_t) k * m + k] = den;
+            H[(size_t)(k + 1) * m + k] = 0;
+            g[k + 1] = -sn[k] * g[k];
+            g[k]     =  cs[k] * g[k];
+
+            if (std::fabs(g[k + 1]) <= tol * bnorm || hk1k == 0)
+            {
+                ++k;
+                break;
+            }
+        }
+
+        // solve H y = g (upper triangular k x k), x += M V y
+        for (int i = k - 1; i >= 0; --i)
+        {
+            double sum = g[i];
+            for (int j = i + 1; j < k; ++j)
+                sum -= H[(size_t) i * m + j] * yk[j];
+            yk[i] = (H[(size_t) i * m + i] == 0) ? 0.0 : sum / H[(size_t) i * m + i];
+        }
+        #pragma omp parallel for num_threads(thread_num)
+        for (size_t i = 0; i < n; ++i)
+        {
+            ValueType sum = 0;
+            for (int j = 0; j < k; ++j)
+                sum += ValueType(yk[j]) * V[(size_t) j * n + i];
+            w[i] = sum;
+        }
+        __krylov_precond(n, inv_diag, w, w);
+        #pragma omp parallel for simd num_threads(thread_num)
+        for (size_t i = 0; i < n; ++i)
+            x[i] += w[i];
+    }
+
+    __krylov_finish(res, t, rnorm, bnorm, tol);
+
+    delete_array(V);
+    delete_array(w);
+    return res;
+}
+
+#endif /* SPARSE_SOLVER_H */
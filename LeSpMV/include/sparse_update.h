@@ -0,0 +1,34 @@
+#ifndef SPARSE_UPDATE_H
+#define SPARSE_UPDATE_H
+/*
+ * @brief Value-only updates for matrices whose sparsity pattern is fixed, e.g. the
+ *        Jacobian of a Newton step or the operator of a time step.
+ *        csr_vals holds the new values in the order of the CSR the matrix was
+ *        converted from (length num_nnzs). They are scattered in parallel into the
+ *        existing arrays; reorder, chunk, partition and tile descriptors are reused.
+ *
+ *        SELL-C-sigma   csr_row_offset + reorder locate every row
+ *        BSR            value_map, one slot per CSR nonzero
+ *        CSR5           no map: the slot follows from tile_ptr and the in-tile transpose
+ *
+ *        csr_vals must not overlap the values of the matrix.
+ */
+#include"sparse_format.h"
+
+template <typename IndexType, typename ValueType>
+void update_values(CSR_Matrix<IndexType, ValueType> &csr, const ValueType *csr_vals);
+
+template <typename IndexType, typename ValueType>
+void update_values(SELL_C_Sigma_Matrix<IndexType, ValueType> &sell_c_sigma, const ValueType *csr_vals);
+
+template <typename IndexType, typename ValueType>
+void update_values(BSR_Matrix<IndexType, ValueType> &bsr, const ValueType *csr_vals);
+
+template <typename IndexType, typename UIndexType, typename ValueType>
+void update_values(CSR5_Matrix<IndexType, UIndexType, ValueType> &csr5, const ValueType *csr_vals);
+
+// 置换后的 CSR 值顺序与源 CSR 不同, 不能按 CSR_Matrix 复制
+template <typename IndexType, typename ValueType>
+void update_values(Permuted_CSR_Matrix<IndexType, ValueType> &pcsr, const ValueType *csr_vals) = delete;
+
+#endif /* SPARSE_UPDATE_H */
@@ -21,6 +21,7 @@
 #include"sparse_format.h"
 #include"general_config.h"
 #include"timer.h"
+#include"perf_counter.h"
 #include<cstring>
 
 template <typename IndexType, typename ValueType>
@@ -45,7 +46,13 @@ size_t bytes_per_spmv(const CSR_Matrix<IndexType,ValueType>& mtx)
     size_t bytes = 0;
     bytes += 2*sizeof(IndexType) * mtx.num_rows;     // row pointer
     bytes += 1*sizeof(IndexType) * mtx.num_nnzs; // column index
-    bytes += 2*sizeof(ValueType) * mtx.num_nnzs; // A[i,j] and x[j]
+    bytes += 1*sizeof(ValueType) * mtx.num_nnzs; // x[j]
+    if (packed_value_bytes(mtx.value_storage) > 0)
+        bytes += packed_value_bytes(mtx.value_storage) * mtx.num_nnzs + sizeof(ValueType) * mtx.value_table_size; // 编号 + 值表
+    if (mtx.value_scale != nullptr)
+        bytes += sizeof(ValueType) * ((mtx.num_rows + mtx.scale_rows - 1) / mtx.scale_rows);      // 量化的缩放因子
+    else if (mtx.value_storage != PatternValues)
+        bytes += 1*sizeof(ValueType) * mtx.num_nnzs; // A[i,j], pattern-only 矩阵不读
     bytes += 2*sizeof(ValueType) * mtx.num_rows;     // y[i] = y[i] + ...
     return bytes;
 }
@@ -67,7 +74,9 @@ size_t bytes_per_spmv(const CSR5_Matrix<IndexType, UIndexType, ValueType>& mtx)
     size_t bytes = 0;
     bytes += 2*sizeof(IndexType) * mtx.num_rows;     // row pointer
     bytes += 1*sizeof(IndexType) * mtx.num_nnzs; // column index
-    bytes += 2*sizeof(ValueType) * mtx.num_nnzs; // A[i,j] and x[j]
+    bytes += 1*sizeof(ValueType) * mtx.num_nnzs; // x[j]
+    if (mtx.value_storage != PatternValues)
+        bytes += 1*sizeof(ValueType) * mtx.num_nnzs; // A[i,j], pattern-only 矩阵不读
     bytes += 2*sizeof(ValueType) * mtx.num_rows;     // y[i] = y[i] + ...
     bytes += 1*sizeof(UIndexType)* mtx._p;           // tile_ptr
     bytes += 1*sizeof(UIndexType);                   // tile_desc
@@ -113,8 +122,14 @@ size_t bytes_per_spmv(const SELL_C_Sigma_Matrix<IndexType,ValueType>& mtx)
 
     for (IndexType chunk = 0; chunk < mtx.validchunkNum; ++chunk) {
         bytes += 1*sizeof(IndexType) * mtx.chunk_len[chunk] * mtx.chunkWidth_C; // column index for a chunk
-        bytes += 1*sizeof(IndexType) * mtx.chunk_len[chunk] * mtx.chunkWidth_C; // values for a chunk
+        if (packed_value_bytes(mtx.value_storage) > 0)
+            bytes += packed_value_bytes(mtx.value_storage) * mtx.chunk_len[chunk] * mtx.chunkWidth_C; // value codes for a chunk
+        else if (mtx.value_storage != PatternValues)
+            bytes += 1*sizeof(ValueType) * mtx.chunk_len[chunk] * mtx.chunkWidth_C; // values for a chunk
     }
+    bytes += sizeof(ValueType) * mtx.value_table_size; // 值表 (SELL-VI)
+    if (mtx.value_scale != nullptr)
+        bytes += sizeof(ValueType) * ((mtx.num_rows + mtx.scale_rows - 1) / mtx.scale_rows); // 量化的缩放因子
 
     bytes += 1*sizeof(ValueType) * mtx.num_nnzs;    // x[j]
     bytes += 2*sizeof(ValueType) * mtx.num_rows;    // y[i] = y[i] + ...
@@ -139,6 +154,30 @@ size_t bytes_per_spmv(const SELL_C_R_Matrix<IndexType,ValueType>& mtx)
     return bytes;
 }
 
+template <typename IndexType, typename ValueType>
+size_t bytes_per_spmv(const CBCSR_Matrix<IndexType,ValueType>& mtx)
+{
+    size_t bytes = 0;
+    bytes += 1*sizeof(IndexType) * mtx.num_panels;       // panel pointer
+    bytes += 3*sizeof(IndexType) * mtx.num_panel_rows;   // row index and row offset
+    bytes += 1*sizeof(IndexType) * mtx.num_nnzs;         // column index
+    bytes += 2*sizeof(ValueType) * mtx.num_nnzs;         // A[i,j] and x[j]
+    bytes += 2*sizeof(ValueType) * mtx.num_panel_rows;   // y[i] += ... once per panel
+    bytes += 2*sizeof(ValueType) * mtx.num_rows;         // y[i] = beta * y[i]
+    return bytes;
+}
+
+template <typename IndexType, typename ValueType>
+size_t bytes_per_spmv(const CSB_Matrix<IndexType,ValueType>& mtx)
+{
+    size_t bytes = 0;
+    bytes += 1*sizeof(IndexType) * ((size_t) mtx.nbr * mtx.nbc + 1); // block pointer
+    bytes += 2*sizeof(uint16_t)  * mtx.num_nnzs;     // in-block row and column offsets
+    bytes += 2*sizeof(ValueType) * mtx.num_nnzs;     // A[i,j] and x[j]
+    bytes += 2*sizeof(ValueType) * mtx.num_rows;     // y[i] = y[i] + ...
+    return bytes;
+}
+
 template <typename IndexType, typename ValueType>
 size_t bytes_per_spmv(const DIA_Matrix<IndexType,ValueType>& mtx)
 {
@@ -149,6 +188,18 @@ size_t bytes_per_spmv(const DIA_Matrix<IndexType,ValueType>& mtx)
     return bytes;
 }
 
+template <typename IndexType, typename ValueType>
+size_t bytes_per_spmv(const DIA_CSR_Matrix<IndexType,ValueType>& mtx)
+{
+    size_t bytes = 0;
+    bytes += 2*sizeof(ValueType) * mtx.dia_nnzs;           // DIA part: A[i,j] and x[j]
+    bytes += 1*sizeof(IndexType) * (mtx.num_rows + 1);      // CSR part: row pointer
+    bytes += 1*sizeof(IndexType) * mtx.csr_nnzs;           // CSR part: column index
+    bytes += 2*sizeof(ValueType) * mtx.csr_nnzs;           // CSR part: A[i,j] and x[j]
+    bytes += 2*sizeof(ValueType) * mtx.num_rows;           // y[i] = y[i] + ...
+    return bytes;
+}
+
 /**
  * @brief It's a benchmark for SpMV in different sparse matrix format
  *        Count the GFlops and GBytes on CPU.
@@ -170,8 +221,8 @@ double benchmark_spmv(SparseMatrix & sp_host, SpMV spmv, const int min_iteration
     typedef typename SparseMatrix::index_type IndexType;
 
     //initialize host arrays
-    ValueType * x_host = new_array<ValueType>(sp_host.num_cols);
-    ValueType * y_host = new_array<ValueType>(sp_host.num_rows);
+    ValueType * x_host = new_vector<ValueType>(sp_host.num_cols);
+    ValueType * y_host = new_vector<ValueType>(sp_host.num_rows);
 
     for(IndexType i = 0; i < sp_host.num_cols; i++)
         x_host[i] = rand() / (RAND_MAX + 1.0); 
@@ -195,11 +246,17 @@ double benchmark_spmv(SparseMatrix & sp_host, SpMV spmv, const int min_iteration
         num_iterations = std::min(max_iterations, std::max(min_iterations, (int) (seconds*1000 / estimated_time)) ); 
     printf("\tPerforming %d iterations\n", num_iterations);
 
-    // time several SpMV iterations
+    // time several SpMV iterations, dTLB misses and heap calls are counted outside the timer
+    // 预热之后临时数组都取自 arena, heap calls 应为 0
+    Le_dtlb_counter dtlb;
+    const long long heap_calls_begin = Le_heap_calls();
+    dtlb.start();
     timer t;
     for(int i = 0; i < num_iterations; i++)
        spmv(1.0, sp_host, x_host, 0.0, y_host); // alpha = 1, beta = 0;
     double msec_per_iteration = t.milliseconds_elapsed() / (double) num_iterations;
+    long long dtlb_misses = dtlb.stop();
+    const long long heap_calls = Le_heap_calls() - heap_calls_begin;
     double sec_per_iteration = msec_per_iteration / 1000.0;
 
     double GFLOPs = (sec_per_iteration == 0) ? 0 : (2.0 * (double) sp_host.num_nnzs / sec_per_iteration) / 1e9;
@@ -212,6 +269,11 @@ double benchmark_spmv(SparseMatrix & sp_host, SpMV spmv, const int min_iteration
     const char * location = "cpu" ;
     printf("\tbenchmarking %-20s [%s]: %8.4f ms ( %5.4f GFLOP/s %5.4f GB/s)\n", \
             method_name.c_str(), location, msec_per_iteration, GFLOPs, GBYTEs); 
+    if (dtlb_misses >= 0)
+        printf("\t\tdTLB load misses: %.0f per iteration ( %.4f per nnz, pages matrix %s, vector %s )\n",
+               (double) dtlb_misses / num_iterations, (double) dtlb_misses / num_iterations / std::max((double) sp_host.num_nnzs, 1.0),
+               Le_page_policy_name(Le_get_page_policy(MEM_CLASS_MATRIX)), Le_page_policy_name(Le_get_page_policy(MEM_CLASS_VECTOR)));
+    printf("\t\theap calls: %lld in %d iterations\n", heap_calls, num_iterations);
 
     //deallocate buffers
     delete_array(x_host);
@@ -14,7 +14,8 @@ void __spmv_bsr_serial_simple(  const IndexType num_rows,
                                 const ValueType *values,
                                 const ValueType *x,
                                 const ValueType beta,
-                                ValueType *y);
+                                ValueType *y,
+                                Le_arena &arena);
 
 template <typename IndexType, typename ValueType>
 void __spmv_bsr_omp_simple( const IndexType num_rows,
@@ -27,7 +28,8 @@ void __spmv_bsr_omp_simple( const IndexType num_rows,
                             const ValueType *values,
                             const ValueType *x,
                             const ValueType beta,
-                            ValueType *y);
+                            ValueType *y,
+                            Le_arena &arena);
 
 template <typename IndexType, typename ValueType>
 void __spmv_bsr_lb_alpha(   const IndexType blockDimRow,
@@ -40,12 +42,15 @@ void __spmv_bsr_lb_alpha(   const IndexType blockDimRow,
                             const ValueType *values,
                             const ValueType *x,
                             const ValueType beta,
-                            ValueType *y);                            
+                            ValueType *y,
+                            const IndexType* partition,
+                            Le_arena &arena);
 
 /**
  * @brief Compute y += alpha * A * x + beta * y for a sparse matrix
  *        Matrix Format: Blocked CSR
  *        Inside call : __spmv_bsr_omp_simple() to calculation
+ *        Block row buffers come from bsr.arena (or the calling thread's arena)
  * 
  * @tparam IndexType 
  * @tparam ValueType 
@@ -0,0 +1,62 @@
+#ifndef SPMV_CBCSR_H
+#define SPMV_CBCSR_H
+
+#include "sparse_format.h"
+
+/**
+ * @brief Compute y = alpha * A * x + beta * y for a sparse matrix
+ *        Matrix Format: column-blocked CSR (csr_to_cbcsr)
+ *        y is scaled by beta once, then the panels are swept one by one
+ *        and every panel row adds alpha * (A_panel * x_panel) to its y entry.
+ *        kernel_flag: 0 = serial, 1 = omp for over the rows of each panel,
+ *                     2 = nnz balanced rows of each panel (cbcsr.partition)
+ *
+ * @tparam IndexType
+ * @tparam ValueType
+ * @param alpha  scaling factor of A*x
+ * @param cbcsr  column-blocked CSR Matrix
+ * @param x      vector x
+ * @param beta   scaling factor of vector y
+ * @param y      result vector y
+ */
+template <typename IndexType, typename ValueType>
+void LeSpMV_cbcsr(const ValueType alpha, const CBCSR_Matrix<IndexType, ValueType>& cbcsr, const ValueType * x, const ValueType beta, ValueType * y);
+
+template <typename IndexType, typename ValueType>
+void __spmv_cbcsr_serial_simple(const IndexType num_rows,
+                                const IndexType num_panel_rows,
+                                const ValueType alpha,
+                                const IndexType *row_index,
+                                const IndexType *row_offset,
+                                const IndexType *col_index,
+                                const ValueType *values,
+                                const ValueType *x,
+                                const ValueType beta, ValueType *y);
+
+template <typename IndexType, typename ValueType>
+void __spmv_cbcsr_omp_simple(   const IndexType num_rows,
+                                const IndexType num_panels,
+                                const ValueType alpha,
+                                const IndexType *panel_ptr,
+                                const IndexType *row_index,
+                                const IndexType *row_offset,
+                                const IndexType *col_index,
+                                const ValueType *values,
+                                const ValueType *x,
+                                const ValueType beta, ValueType *y);
+
+template <typename IndexType, typename ValueType>
+void __spmv_cbcsr_omp_lb(   const IndexType num_rows,
+                            const IndexType num_panels,
+                            const ValueType alpha,
+                            const IndexType *panel_ptr,
+                            const IndexType *row_index,
+                            const IndexType *row_offset,
+                            const IndexType *col_index,
+                            const ValueType *values,
+                            const ValueType *x,
+                            const ValueType beta, ValueType *y,
+                            IndexType *partition,
+                            Le_arena &arena);
+
+#endif /* SPMV_CBCSR_H */
@@ -6,7 +6,11 @@
 /**
  * @brief Compute y += alpha * A * x + beta * y for a sparse matrix
  *        Matrix Format: COO
- *        Inside call : __spmv_coo_omp_simple() to calculation
+ *        kernel_flag = 0     : __spmv_coo_serial_simple()
+ *        kernel_flag = 1 / 2 : __spmv_coo_omp_lb() (default), nnz split evenly with a carry per thread.
+ *                              read_coo_matrix / csr_to_coo / sort_coo_by_row give row-sorted
+ *                              triplets (coo.row_sorted); unsorted ones use __spmv_coo_omp_alpha()
+ *        kernel_flag = 3     : __spmv_coo_omp_alpha(), per-thread copies of y
  * 
  * @tparam IndexType 
  * @tparam ValueType 
@@ -19,21 +23,6 @@
 template <typename IndexType, typename ValueType>
 void LeSpMV_coo(const ValueType alpha, const COO_Matrix<IndexType, ValueType>& coo, const ValueType * x, const ValueType beta, ValueType * y);
 
-/**
- * @brief Ai = coo.row_index
- *        Aj = coo.col_index
- *        Ax = coo.values
- */
-template <typename IndexType, typename ValueType>
-void __spmv_coo_omp_simple (const IndexType num_rows,
-                            const IndexType num_nnzs, 
-                            const ValueType alpha, 
-                            const IndexType *Ai,
-                            const IndexType *Aj,
-                            const ValueType *Ax,
-                            const ValueType * x, 
-                            const ValueType beta, ValueType * y);
-
 template <typename IndexType, typename ValueType>
 void __spmv_coo_serial_simple(  const IndexType num_rows,
                                 const IndexType num_nnzs, 
@@ -44,6 +33,13 @@ void __spmv_coo_serial_simple(  const IndexType num_rows,
                                 const ValueType * x, 
                                 const ValueType beta, ValueType * y);
 
+/**
+ * @brief nnz are split evenly over the threads, every thread keeps the sum of
+ *        the current row segment in a register. A row continued from the previous
+ *        thread goes to a carry array (one entry per thread) which is added after
+ *        the parallel region, so no atomics and no per-thread y copies are used.
+ *        Ai must be sorted by row. The carry array comes from arena.
+ */
 template <typename IndexType, typename ValueType>
 void __spmv_coo_omp_lb (    const IndexType num_rows,
                             const IndexType num_nnzs, 
@@ -52,8 +48,10 @@ void __spmv_coo_omp_lb (    const IndexType num_rows,
                             const IndexType *Aj,
                             const ValueType *Ax,
                             const ValueType * x, 
-                            const ValueType beta, ValueType * y);
+                            const ValueType beta, ValueType * y,
+                            Le_arena &arena);
 
+// per-thread y copies in the sub-arenas of arena, reduced into y
 template <typename IndexType, typename ValueType>
 void __spmv_coo_omp_alpha (    const IndexType num_rows,
                                 const IndexType num_nnzs, 
@@ -62,6 +60,7 @@ void __spmv_coo_omp_alpha (    const IndexType num_rows,
                                 const IndexType *Aj,
                                 const ValueType *Ax,
                                 const ValueType * x, 
-                                const ValueType beta, ValueType * y);
+                                const ValueType beta, ValueType * y,
+                                Le_arena &arena);
 
 #endif /* SPMV_COO_H */
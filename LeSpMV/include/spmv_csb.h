@@ -0,0 +1,43 @@
+#ifndef SPMV_CSB_H
+#define SPMV_CSB_H
+
+#include "sparse_format.h"
+
+/**
+ * @brief Compute y = alpha * A * x + beta * y for a sparse matrix
+ *        Matrix Format: Compressed Sparse Blocks (csr_to_csb)
+ *        Block rows own disjoint beta-row segments of y, so they run in parallel
+ *        without atomics; each block reads a beta-long segment of x.
+ *        kernel_flag: 0 = serial, 1 = omp dynamic over block rows,
+ *                     2 = block rows with recursive splitting of dense block rows
+ *
+ * @tparam IndexType
+ * @tparam ValueType
+ * @param alpha  scaling factor of A*x
+ * @param csb    CSB Matrix
+ * @param x      vector x
+ * @param beta   scaling factor of vector y
+ * @param y      result vector y
+ */
+template <typename IndexType, typename ValueType>
+void LeSpMV_csb(const ValueType alpha, const CSB_Matrix<IndexType, ValueType>& csb, const ValueType * x, const ValueType beta, ValueType * y);
+
+template <typename IndexType, typename ValueType>
+void __spmv_csb_serial_simple(  const CSB_Matrix<IndexType, ValueType>& csb,
+                                const ValueType alpha,
+                                const ValueType *x,
+                                const ValueType beta, ValueType *y);
+
+template <typename IndexType, typename ValueType>
+void __spmv_csb_omp_simple( const CSB_Matrix<IndexType, ValueType>& csb,
+                            const ValueType alpha,
+                            const ValueType *x,
+                            const ValueType beta, ValueType *y);
+
+template <typename IndexType, typename ValueType>
+void __spmv_csb_omp_lb( const CSB_Matrix<IndexType, ValueType>& csb,
+                        const ValueType alpha,
+                        const ValueType *x,
+                        const ValueType beta, ValueType *y);
+
+#endif /* SPMV_CSB_H */
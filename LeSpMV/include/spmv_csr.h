@@ -7,6 +7,8 @@
  * @brief Compute y += alpha * A * x + beta * y for a sparse matrix
  *        Matrix Format: CSR
  *        Inside call : __spmv_csr_omp_simple() to calculation
+ *        Pattern-only matrices (value_storage == PatternValues) only gather x,
+ *        alpha is applied once per row.
  * 
  * @tparam IndexType 
  * @tparam ValueType 
@@ -22,41 +24,44 @@ void LeSpMV_csr(const ValueType alpha, const CSR_Matrix<IndexType, ValueType>& c
 /**
  * @brief Ap = csr.row_offest
  *        Aj = csr.col_index
- *        Ax = csr.values
+ *        Ax = csr.values, Pattern_Values<ValueType>() for a pattern-only matrix,
+ *        Indexed_Values<ValueType, uint8_t / uint16_t> for a value-indexed (CSR-VI) matrix or
+ *        Quantized_Values<ValueType, Le_half / Le_bfloat16 / int8_t> for quantized values
  */
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 void __spmv_csr_omp_simple (const IndexType num_rows, 
                             const ValueType alpha, 
                             const IndexType *Ap,
                             const IndexType *Aj,
-                            const ValueType *Ax,
+                            const ValueArray Ax,
                             const ValueType * x, 
                             const ValueType beta, ValueType * y);
 
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 void __spmv_csr_serial_simple(  const IndexType num_rows, 
                                 const ValueType alpha, 
                                 const IndexType *Ap,
                                 const IndexType *Aj,
-                                const ValueType *Ax,
+                                const ValueArray Ax,
                                 const ValueType * x, 
                                 const ValueType beta, ValueType * y);
 
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 void __spmv_csr_omp_lb (const IndexType num_rows, 
                         const ValueType alpha, 
                         const IndexType *Ap,
                         const IndexType *Aj,
-                        const ValueType *Ax,
+                        const ValueArray Ax,
                         const ValueType * x, 
                         const ValueType beta, ValueType * y,
-                        IndexType *partition);
+                        IndexType *partition,
+                        Le_arena &arena);
 
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 inline void  __spmv_csr_perthread(  const ValueType alpha, 
                                     const IndexType *Ap,
                                     const IndexType *Aj,
-                                    const ValueType *Ax,
+                                    const ValueArray Ax,
                                     const ValueType * x, 
                                     const ValueType beta, ValueType * y,
                                     const IndexType local_m_s,
@@ -6,7 +6,8 @@
 /**
  * @brief Compute y += alpha * A * x + beta * y for a sparse matrix
  *        Matrix Format: DIA
- *        Inside call : 
+ *        Inside call : __spmv_dia_omp_simple(), row blocks of DIA_ROW_BLOCK rows run
+ *                      in parallel over all diagonals, y is written once per row
  * 
  * @tparam IndexType 
  * @tparam ValueType 
@@ -19,9 +20,18 @@
 template <typename IndexType, typename ValueType>
 void LeSpMV_dia(const ValueType alpha, const DIA_Matrix<IndexType, ValueType>& dia, const ValueType * x, const ValueType beta, ValueType * y);
 
+/**
+ * @brief Compute y = alpha * A * x + beta * y for the hybrid DIA + CSR format (csr_to_dia_csr)
+ *        Row blocks of DIA_ROW_BLOCK rows run the DIA diagonals and the CSR rows of
+ *        the block together and write y once. kernel_flag = 0 is serial.
+ */
+template <typename IndexType, typename ValueType>
+void LeSpMV_dia_csr(const ValueType alpha, const DIA_CSR_Matrix<IndexType, ValueType>& hyb, const ValueType * x, const ValueType beta, ValueType * y);
+
 template <typename IndexType, typename ValueType>
 void __spmv_dia_serial_simple(  const ValueType alpha, 
                                 const IndexType num_rows,
+                                const IndexType num_cols,
                                 const IndexType stride,
                                 const IndexType complete_ndiags,
                                 const long int  * dia_offset,
@@ -32,6 +42,7 @@ void __spmv_dia_serial_simple(  const ValueType alpha,
 template <typename IndexType, typename ValueType>
 void __spmv_dia_omp_simple(  const ValueType alpha, 
                                 const IndexType num_rows,
+                                const IndexType num_cols,
                                 const IndexType stride,
                                 const IndexType complete_ndiags,
                                 const long int  * dia_offset,
@@ -39,14 +50,17 @@ void __spmv_dia_omp_simple(  const ValueType alpha,
                                 const ValueType * x,
                                 const ValueType beta, ValueType * y);
 
+// per-thread y copies in the sub-arenas of arena, reduced into y
 template <typename IndexType, typename ValueType>
 void __spmv_dia_alpha(  const ValueType alpha, 
                         const IndexType num_rows,
+                        const IndexType num_cols,
                         const IndexType stride,
                         const IndexType complete_ndiags,
                         const long int  * dia_offset,
                         const ValueType * dia_data,
                         const ValueType * x,
-                        const ValueType beta, ValueType * y);                                
+                        const ValueType beta, ValueType * y,
+                        Le_arena &arena);
 
 #endif /* SPMV_DIA_H */
@@ -33,7 +33,8 @@ void __spmv_ell_omp_lb_row( const IndexType num_rows,
                             const ValueType * x, 
                             const ValueType beta, ValueType * y,
                             const LeadingDimension ld,
-                            IndexType *partition);
+                            IndexType *partition,
+                            Le_arena &arena);
 
 
 /**
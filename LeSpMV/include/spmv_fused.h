@@ -0,0 +1,74 @@
+#ifndef SPMV_FUSED_H
+#define SPMV_FUSED_H
+
+#include "sparse_format.h"
+
+/**
+ * @brief Fused SpMV and vector operations for Krylov solvers.
+ *        Compute y = alpha * A * x + beta * w, and in the same pass over y
+ *              dot_yz  = dot(y, z)   if dot_yz  != nullptr
+ *              norm2_y = dot(y, y)   if norm2_y != nullptr
+ *        w may be y itself (the usual y = alpha*A*x + beta*y) or nullptr (same as y).
+ *        Dispatch on kernel_flag like LeSpMV_csr: 0 serial, 1 omp simple,
+ *        2 load balanced by the nnz partition of the matrix.
+ *
+ * @tparam IndexType
+ * @tparam ValueType
+ * @param alpha    scaling factor of A*x
+ * @param csr      CSR Matrix
+ * @param x        vector x
+ * @param beta     scaling factor of vector w
+ * @param w        input vector w (size num_rows), may alias y
+ * @param y        result vector y
+ * @param z        vector z for dot(y, z), may be nullptr
+ * @param dot_yz   output, may be nullptr
+ * @param norm2_y  output, may be nullptr
+ */
+template <typename IndexType, typename ValueType>
+void LeSpMV_csr_fused(const ValueType alpha, const CSR_Matrix<IndexType, ValueType>& csr, const ValueType * x, const ValueType beta, const ValueType * w, ValueType * y, const ValueType * z, ValueType * dot_yz, ValueType * norm2_y);
+
+/**
+ * @brief Same as LeSpMV_csr_fused() for SELL-c-sigma, z and w are in the original row order.
+ */
+template <typename IndexType, typename ValueType>
+void LeSpMV_sell_c_sigma_fused(const ValueType alpha, const SELL_C_Sigma_Matrix<IndexType, ValueType>& sell_c_sigma, const ValueType * x, const ValueType beta, const ValueType * w, ValueType * y, const ValueType * z, ValueType * dot_yz, ValueType * norm2_y);
+
+/**
+ * @brief Ap = A * p and return dot(p, Ap), as in CG
+ */
+template <typename IndexType, typename ValueType>
+inline ValueType LeSpMV_csr_pAp(const CSR_Matrix<IndexType, ValueType>& csr, const ValueType * p, ValueType * Ap)
+{
+    ValueType pAp = 0;
+    LeSpMV_csr_fused(ValueType(1), csr, p, ValueType(0), Ap, Ap, p, &pAp, (ValueType *) nullptr);
+    return pAp;
+}
+
+/**
+ * @brief r = b - A * x and return dot(r, r)
+ */
+template <typename IndexType, typename ValueType>
+inline ValueType LeSpMV_csr_residual(const CSR_Matrix<IndexType, ValueType>& csr, const ValueType * x, const ValueType * b, ValueType * r)
+{
+    ValueType rr = 0;
+    LeSpMV_csr_fused(ValueType(-1), csr, x, ValueType(1), b, r, (const ValueType *) nullptr, (ValueType *) nullptr, &rr);
+    return rr;
+}
+
+template <typename IndexType, typename ValueType>
+inline ValueType LeSpMV_sell_c_sigma_pAp(const SELL_C_Sigma_Matrix<IndexType, ValueType>& sell_c_sigma, const ValueType * p, ValueType * Ap)
+{
+    ValueType pAp = 0;
+    LeSpMV_sell_c_sigma_fused(ValueType(1), sell_c_sigma, p, ValueType(0), Ap, Ap, p, &pAp, (ValueType *) nullptr);
+    return pAp;
+}
+
+template <typename IndexType, typename ValueType>
+inline ValueType LeSpMV_sell_c_sigma_residual(const SELL_C_Sigma_Matrix<IndexType, ValueType>& sell_c_sigma, const ValueType * x, const ValueType * b, ValueType * r)
+{
+    ValueType rr = 0;
+    LeSpMV_sell_c_sigma_fused(ValueType(-1), sell_c_sigma, x, ValueType(1), b, r, (const ValueType *) nullptr, (ValueType *) nullptr, &rr);
+    return rr;
+}
+
+#endif /* SPMV_FUSED_H */
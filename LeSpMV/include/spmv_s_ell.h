@@ -9,11 +9,13 @@ void __spmv_sell_serial_simple(const IndexType num_rows,
                             const IndexType total_chunk_num,
                             const ValueType alpha,
                             const IndexType *max_row_width,
-                            const IndexType * const *col_index,
-                            const ValueType * const *values,
+                            const IndexType *chunk_ptr,
+                            const IndexType *col_index,
+                            const ValueType *values,
                             const ValueType * x, 
                             const ValueType beta, 
-                            ValueType * y);
+                            ValueType * y,
+                            Le_arena &arena);
 
 template <typename IndexType, typename ValueType>
 void __spmv_sell_omp_simple(const IndexType num_rows,
@@ -21,11 +23,13 @@ void __spmv_sell_omp_simple(const IndexType num_rows,
                             const IndexType total_chunk_num,
                             const ValueType alpha,
                             const IndexType *max_row_width,
-                            const IndexType * const *col_index,
-                            const ValueType * const *values,
+                            const IndexType *chunk_ptr,
+                            const IndexType *col_index,
+                            const ValueType *values,
                             const ValueType * x, 
                             const ValueType beta, 
-                            ValueType * y);
+                            ValueType * y,
+                            Le_arena &arena);
 
 template <typename IndexType, typename ValueType>
 void __spmv_sell_omp_lb_row(const IndexType num_rows,
@@ -34,12 +38,14 @@ void __spmv_sell_omp_lb_row(const IndexType num_rows,
                             const IndexType num_nnzs, 
                             const ValueType alpha, 
                             const IndexType *max_row_width,
-                            const IndexType * const *col_index,
-                            const ValueType * const *values,
+                            const IndexType *chunk_ptr,
+                            const IndexType *col_index,
+                            const ValueType *values,
                             const ValueType * x, 
                             const ValueType beta, 
                             ValueType * y,
-                            IndexType *partition);
+                            IndexType *partition,
+                            Le_arena &arena);
 
 /**
  * @brief Compute y += alpha * A * x + beta * y for a sparse matrix
@@ -10,8 +10,9 @@ void __spmv_sell_cR_serial_simple( const IndexType * Reorder,
                                    const IndexType total_chunk_num,
                                    const ValueType alpha,
                                    const IndexType *max_row_width,
-                                   const IndexType * const *col_index,
-                                   const ValueType * const *values,
+                                   const IndexType *chunk_ptr,
+                                   const IndexType *col_index,
+                                   const ValueType *values,
                                    const ValueType * x, 
                                    const ValueType beta, 
                                    ValueType * y);
@@ -23,8 +24,9 @@ void __spmv_sell_cR_omp_simple( const IndexType * Reorder,
                                 const IndexType total_chunk_num,
                                 const ValueType alpha,
                                 const IndexType *max_row_width,
-                                const IndexType * const *col_index,
-                                const ValueType * const *values,
+                                const IndexType *chunk_ptr,
+                                const IndexType *col_index,
+                                const ValueType *values,
                                 const ValueType * x, 
                                 const ValueType beta, 
                                 ValueType * y);
@@ -37,12 +39,14 @@ void __spmv_sell_cR_omp_lb_row( const IndexType * Reorder,
                                 const IndexType num_nnzs, 
                                 const ValueType alpha, 
                                 const IndexType *max_row_width,
-                                const IndexType * const *col_index,
-                                const ValueType * const *values,
+                                const IndexType *chunk_ptr,
+                                const IndexType *col_index,
+                                const ValueType *values,
                                 const ValueType * x, 
                                 const ValueType beta, 
                                 ValueType * y,
-                                IndexType *partition);
+                                IndexType *partition,
+                                Le_arena &arena);
 
 /**
  * @brief Compute y += alpha * A * x + beta * y for a sparse matrix
@@ -3,33 +3,35 @@
 
 #include "sparse_format.h"
 
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 void __spmv_sell_cs_serial_simple( const IndexType * Reorder,
                                    const IndexType num_rows,
                                    const IndexType chunk_rowNum,
                                    const IndexType total_chunk_num,
                                    const ValueType alpha,
                                    const IndexType *max_row_width,
-                                   const IndexType * const *col_index,
-                                   const ValueType * const *values,
+                                   const IndexType *chunk_ptr,
+                                   const IndexType *col_index,
+                                   const ValueArray values,
                                    const ValueType * x, 
                                    const ValueType beta, 
                                    ValueType * y);
 
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 void __spmv_sell_cs_omp_simple( const IndexType * Reorder,
                                 const IndexType num_rows,
                                 const IndexType chunk_rowNum,
                                 const IndexType total_chunk_num,
                                 const ValueType alpha,
                                 const IndexType *max_row_width,
-                                const IndexType * const *col_index,
-                                const ValueType * const *values,
+                                const IndexType *chunk_ptr,
+                                const IndexType *col_index,
+                                const ValueArray values,
                                 const ValueType * x, 
                                 const ValueType beta, 
                                 ValueType * y);
 
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 void __spmv_sell_cs_omp_lb_row( const IndexType * Reorder,
                                 const IndexType num_rows,
                                 const IndexType row_num_perC,
@@ -37,17 +39,25 @@ void __spmv_sell_cs_omp_lb_row( const IndexType * Reorder,
                                 const IndexType num_nnzs, 
                                 const ValueType alpha, 
                                 const IndexType *max_row_width,
-                                const IndexType * const *col_index,
-                                const ValueType * const *values,
+                                const IndexType *chunk_ptr,
+                                const IndexType *col_index,
+                                const ValueArray values,
                                 const ValueType * x, 
                                 const ValueType beta, 
                                 ValueType * y,
-                                IndexType *partition);
+                                IndexType *partition,
+                                Le_arena &arena);
 
 /**
  * @brief Compute y += alpha * A * x + beta * y for a sparse matrix
  *        Matrix Format: SELL-c-sigma
  *        Inside call : __spmv_sell_cs_omp_simple() to calculation
+ *        The C rows of a chunk are stored column-major and computed as SIMD lanes
+ *        (masked gathers of x, results scattered through reorder), so C should be
+ *        a multiple of the SIMD lanes: csr_to_sell_c_sigma() defaults to
+ *        C = Le_get_alignment<ValueType>(), 8 for double and 16 for float on AVX-512.
+ *        Pattern-only matrices (value_storage == PatternValues) only gather x,
+ *        alpha is applied once per row when y is written back.
  * 
  * @tparam IndexType 
  * @tparam ValueType 
@@ -0,0 +1,55 @@
+#ifndef SPMV_TRANSPOSE_H
+#define SPMV_TRANSPOSE_H
+/*
+ * @brief Transpose SpMV y = alpha * A^T * x + beta * y without building A^T,
+ *        x has num_rows entries and y has num_cols entries.
+ *        kernel_flag = 0 runs a serial scatter, otherwise the parallel scatter
+ *        picks a conflict-free strategy by nnz / num_cols:
+ *        TRANSPOSE_PRIVATE : every thread scatters its nnz balanced rows into a
+ *                            private buffer covering only its column window, the
+ *                            buffers are summed column-parallel into y.
+ *        TRANSPOSE_COLOR   : row blocks are colored so that blocks of one color have
+ *                            disjoint column windows, colors run one after another
+ *                            and scatter straight into y.
+ *        No atomics are used and the memory is bounded by the column windows.
+ */
+#include "sparse_format.h"
+
+typedef enum
+{
+    TRANSPOSE_PRIVATE = 0,
+    TRANSPOSE_COLOR   = 1
+} TransposeStrategy;
+
+/**
+ * @brief Strategy of the parallel scatter for nnz nonzeros over num_cols columns:
+ *        TRANSPOSE_PRIVATE when nnz / num_cols >= TRANSPOSE_PRIVATE_NNZ_PER_COL.
+ *        TRANSPOSE_COLOR falls back to the private buffers at run time when the
+ *        column windows overlap too much to give every thread a block per color.
+ */
+template <typename IndexType>
+TransposeStrategy transpose_strategy(const IndexType num_nnzs, const IndexType num_cols);
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_csr_transpose(const ValueType alpha, const CSR_Matrix<IndexType, ValueType>& csr, const ValueType * x, const ValueType beta, ValueType * y);
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_sell_c_sigma_transpose(const ValueType alpha, const SELL_C_Sigma_Matrix<IndexType, ValueType>& sell_c_sigma, const ValueType * x, const ValueType beta, ValueType * y);
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_bsr_transpose(const ValueType alpha, const BSR_Matrix<IndexType, ValueType>& bsr, const ValueType * x, const ValueType beta, ValueType * y);
+
+/**
+ * @brief CSR5 tiles are walked in their original nnz order (the row advances along
+ *        row_offset), the column-major tile layout is only an address mapping.
+ */
+template <typename IndexType, typename UIndexType, typename ValueType>
+void LeSpMV_csr5_transpose(const ValueType alpha, const CSR5_Matrix<IndexType, UIndexType, ValueType>& csr5, const ValueType * x, const ValueType beta, ValueType * y);
+
+/**
+ * @brief CSB needs no strategy: block columns own disjoint y segments and run in parallel.
+ */
+template <typename IndexType, typename ValueType>
+void LeSpMV_csb_transpose(const ValueType alpha, const CSB_Matrix<IndexType, ValueType>& csb, const ValueType * x, const ValueType beta, ValueType * y);
+
+#endif /* SPMV_TRANSPOSE_H */
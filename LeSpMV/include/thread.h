@@ -13,11 +13,48 @@ void Le_set_thread_num(const int thread_num);
 
 // get the avaliable number of threads setting by --threads=x
 // if not setting, using omp_get_num_procs() to obtain
+// a Le_thread_num_scope of the calling thread takes precedence
 int Le_get_thread_num();
 
+// thread number of the calling thread only, 0 removes the override, return the previous override
+int Le_set_thread_num_override(const int thread_num);
+
+/**
+ * @brief Le_get_thread_num() returns thread_num on the calling thread for the lifetime
+ *        of the scope, e.g. for a background thread that must not take all cores.
+ *        Other threads keep the --threads setting.
+ */
+class Le_thread_num_scope
+{
+public:
+    explicit Le_thread_num_scope(const int thread_num) : prev(Le_set_thread_num_override(thread_num)) {}
+    ~Le_thread_num_scope() { Le_set_thread_num_override(prev); }
+
+    Le_thread_num_scope(const Le_thread_num_scope &) = delete;
+    Le_thread_num_scope & operator=(const Le_thread_num_scope &) = delete;
+
+private:
+    int prev;
+};
+
 // get thread own ID index
 int Le_get_thread_id();
 
 void set_omp_schedule(int sche_mode, int chunk_size);
 
+// Thread binding policy
+// BIND_NONE    : threads may run on any cpu
+// BIND_COMPACT : fill the physical cores of one socket first, hyper threads last
+// BIND_SCATTER : round-robin over sockets, hyper threads last
+typedef enum
+{
+    BIND_NONE = 0,
+    BIND_COMPACT = 1,
+    BIND_SCATTER = 2
+} BindPolicy;
+
+// pin the Le_get_thread_num() omp threads according to bind_mode,
+// call it again whenever the thread number changes
+void Le_bind_threads(BindPolicy bind_mode);
+
 #endif /* THREAD_H */
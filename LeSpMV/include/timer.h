@@ -22,7 +22,7 @@
 #include <time.h>
 #include"rdtsc.h"
 #include"general_config.h"
-#include"plat_config.h"
+#include"plat_runtime.h"
 #include<sys/time.h>
 
 class timer
@@ -41,14 +41,16 @@ class timer
         double elapsed_time;
 	    end = rdtsc();
         // elapsed_time = 1000*(end - start)/CPU_FREQUENCY;
-        elapsed_time = (double) 1000*(end - start)/CPU_MAX_FREQUENCY;
+        // elapsed_time = (double) 1000*(end - start)/CPU_MAX_FREQUENCY;
+        elapsed_time = (double) 1000*(end - start)/Le_get_tick_frequency();
         return elapsed_time;
     }
     double seconds_elapsed()
     {
         end = rdtsc();
         // return (end - start)/CPU_FREQUENCY;
-        return (double)(end - start)/CPU_MAX_FREQUENCY;
+        // return (double)(end - start)/CPU_MAX_FREQUENCY;
+        return (double)(end - start)/Le_get_tick_frequency();
     }
 };
 
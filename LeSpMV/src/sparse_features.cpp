@@ -13,6 +13,7 @@
 #include"../include/thread.h"
 #include"../include/sparse_features.h"
 #include"../include/sparse_partition.h"
+#include"../include/plat_runtime.h"
 #include"../include/thread.h"
 
 
@@ -168,6 +169,71 @@ bool MTX<IndexType, ValueType>::MtxLoad(const char* mat_path)
         exit(1);
     }
 
+    LoadPrepare();
+
+    std::cout << "- Reading sparse matrix from file: "<< mat_path << std::endl;
+    fflush(stdout);
+
+    if(mm_is_pattern(mat_code)){        // 二进制矩阵， 元素只有0/1
+        for (IndexType i = 0; i < nnz_mtx_; i++)
+        {
+            IndexType row_idx, col_idx;
+            if constexpr(std::is_same<IndexType, int>::value) {
+                assert(fscanf(mtx_file,"%d %d\n", &row_idx, &col_idx) == 2);
+            } else if constexpr(std::is_same<IndexType, long long>::value) {
+                assert(fscanf(mtx_file,"%lld %lld\n", &row_idx, &col_idx) == 2);
+            }
+            // adjust from 1-based to 0-based indexing
+            LoadEntry(row_idx - 1, col_idx - 1, 1.0, true);
+        }
+    }else if (mm_is_real(mat_code) || mm_is_integer(mat_code)){
+        for( IndexType i = 0; i < nnz_mtx_; i++ ){
+            IndexType row_id, col_id;
+            double V;
+            if constexpr(std::is_same<IndexType, int>::value) {
+                assert(fscanf(mtx_file, "%d %d %lf\n", &row_id, &col_id, &V) == 3);
+            } else if constexpr(std::is_same<IndexType, long long>::value) {
+                assert(fscanf(mtx_file, "%lld %lld %lf\n", &row_id, &col_id, &V) == 3);
+            }
+            LoadEntry(row_id - 1, col_id - 1, (ValueType) V, false);
+        }
+    }else{
+        std::cout << "Unsupported data type" << std::endl;
+        exit(1);
+    }
+
+    LoadFinish();
+
+    fclose(mtx_file);
+    return true;
+}
+
+template <typename IndexType, typename ValueType>
+bool MTX<IndexType, ValueType>::MtxLoad(const CSR_Matrix<IndexType, ValueType> &csr, const std::string &mat_name)
+{
+    // 内存中的矩阵 (如 sparse_generator 生成), 按非对称 general 矩阵处理
+    matrixName    = mat_name;
+    is_symmetric_ = false;
+    num_rows      = csr.num_rows;
+    num_cols      = csr.num_cols;
+    nnz_mtx_      = csr.num_nnzs;
+
+    LoadPrepare();
+
+    std::cout << "- Reading sparse matrix from memory: "<< mat_name << std::endl;
+    fflush(stdout);
+
+    for (IndexType row_idx = 0; row_idx < csr.num_rows; row_idx++)
+        for (IndexType j = csr.row_offset[row_idx]; j < csr.row_offset[row_idx + 1]; j++)
+            LoadEntry(row_idx, csr.col_index[j], csr.values[j], false);
+
+    LoadFinish();
+    return true;
+}
+
+template <typename IndexType, typename ValueType>
+void MTX<IndexType, ValueType>::LoadPrepare()
+{
     nnz_by_row_.resize(num_rows, 0);
     nnz_by_col_.resize(num_cols, 0);
     Diag_Dom.resize(num_rows, 0.0);
@@ -179,11 +245,11 @@ bool MTX<IndexType, ValueType>::MtxLoad(const char* mat_path)
     symm_pair_.reserve(nnz_mtx_);
 
     //  判断矩阵是否足够大分 tile 读取 tile特征
-    // bool tile_flag = (num_rows >= t_num_blocks) && (num_cols >= t_num_blocks);
-    bool tile_flag = true; // 假设不论矩阵大小，都必须完成划分
+    // tile_flag_ = (num_rows >= t_num_blocks) && (num_cols >= t_num_blocks);
+    tile_flag_ = true; // 假设不论矩阵大小，都必须完成划分
     
     //  可以存 tile features
-    if (tile_flag)
+    if (tile_flag_)
     {
         // 为避免空块，只能向下取整； 多出的元素均匀分给 前t_mod_RB 行，和 前 t_mod_CB 列 
         t_num_RB = num_rows / t_num_blocks; t_mod_RB = num_rows % t_num_blocks;
@@ -201,279 +267,154 @@ bool MTX<IndexType, ValueType>::MtxLoad(const char* mat_path)
     // Cols_cnt[colidx][t_row_idx] 用于统计 colidx 在 t_row_idx 的 Tile 中的列非零元数目
     Cols_cnt.resize(num_cols, std::vector<IndexType>(t_num_blocks, 0));
 
-    // Rows_flag[rowidx][t_col_idx] 表示第 rowidx 行是否已经被统计到列块 ID 为 t_col_idx 的 tiles中了, false表示统计过了.
-    std::vector<std::vector<bool>> Rows_flag(num_rows, std::vector<bool>(t_num_blocks, true));
-    // Cols_flag[colidx][t_row_idx] 表示第 colidx 列是否已经被统计到行块 ID 为 Cols_flag 的 tiles中了, false表示统计过了.
-    std::vector<std::vector<bool>> Cols_flag(num_cols, std::vector<bool>(t_num_blocks, true));
+    // Rows_flag_[rowidx][t_col_idx] 表示第 rowidx 行是否已经被统计到列块 ID 为 t_col_idx 的 tiles中了, false表示统计过了.
+    Rows_flag_.assign(num_rows, std::vector<bool>(t_num_blocks, true));
+    // Cols_flag_[colidx][t_row_idx] 表示第 colidx 列是否已经被统计到行块 ID 为 Cols_flag_ 的 tiles中了, false表示统计过了.
+    Cols_flag_.assign(num_cols, std::vector<bool>(t_num_blocks, true));
 
-    IndexType row_idx, col_idx, diaoffset;
-    IndexType t_rowidx, t_colidx, t_tileID;   // tiles 中的序号
     // rowidx < threshold  tile_size = (t_num_RB + 1); else tile_size = t_num_RB
     // 前 threshold 的 RB 和 CB 包含的 行数和列数要多 1
-    IndexType RB_threshold = t_mod_RB * (t_num_RB + 1);
-    IndexType CB_threshold = t_mod_CB * (t_num_CB + 1);
-    ValueType value;
-    ValueType value_abs;
+    RB_threshold_ = t_mod_RB * (t_num_RB + 1);
+    CB_threshold_ = t_mod_CB * (t_num_CB + 1);
+}
 
-    std::cout << "- Reading sparse matrix from file: "<< mat_path << std::endl;
-    fflush(stdout);
+template <typename IndexType, typename ValueType>
+void MTX<IndexType, ValueType>::LoadEntry(const IndexType row_idx, const IndexType col_idx, const ValueType value, const bool is_pattern)
+{
+    IndexType t_rowidx = 0, t_colidx = 0, t_tileID;   // tiles 中的序号
+    const ValueType value_abs = std::abs(value);
+    const IndexType diaoffset = col_idx - row_idx;
+
+    nnz_by_row_[row_idx]++; // 本行的 nnz 加一
+    nnz_by_col_[col_idx]++; // 本列的 nnz 加一
+    // 记录对角距离的分布频率
+    diag_offset_[diaoffset]++;
+
+    // 存一下分tile的信息
+    if (tile_flag_){
+        t_rowidx = (row_idx < RB_threshold_)? (row_idx / (t_num_RB+1)):(t_mod_RB + (row_idx - RB_threshold_)/t_num_RB);
+        t_colidx = (col_idx < CB_threshold_)? (col_idx / (t_num_CB+1)):(t_mod_CB + (col_idx - CB_threshold_)/t_num_CB);
+        
+        // tile 按 行优先存储
+        t_tileID = t_rowidx * t_num_blocks + t_colidx;
 
-    if(mm_is_pattern(mat_code)){        // 二进制矩阵， 元素只有0/1
-        for (IndexType i = 0; i < nnz_mtx_; i++)
+        nnz_by_Tiles_[t_tileID]++;
+        nnz_by_RB_[t_rowidx]++;
+        nnz_by_CB_[t_colidx]++;
+
+        Rows_cnt[row_idx][t_colidx]++;
+        Cols_cnt[col_idx][t_rowidx]++;
+
+        if(Rows_flag_[row_idx][t_colidx])
         {
-            if constexpr(std::is_same<IndexType, int>::value) {
-                assert(fscanf(mtx_file,"%d %d\n", &row_idx, &col_idx) == 2);
-            } else if constexpr(std::is_same<IndexType, long long>::value) {
-                assert(fscanf(mtx_file,"%lld %lld\n", &row_idx, &col_idx) == 2);
-            }
-            // adjust from 1-based to 0-based indexing
-            --row_idx;
-            --col_idx;
-            diaoffset = col_idx - row_idx;
-            value = 1.0;
-            value_abs = 1.0;
-            
-            nnz_by_row_[row_idx]++; // 本行的 nnz 加一
-            nnz_by_col_[col_idx]++; // 本列的 nnz 加一
-            // 记录对角距离的分布频率
-            diag_offset_[diaoffset]++;
-            
-            // 存一下分tile的信息
-            if (tile_flag){
-                t_rowidx = (row_idx < RB_threshold)? (row_idx / (t_num_RB+1)):(t_mod_RB + (row_idx - RB_threshold)/t_num_RB);
-                t_colidx = (col_idx < CB_threshold)? (col_idx / (t_num_CB+1)):(t_mod_CB + (col_idx - CB_threshold)/t_num_CB);
-                // tile 按 行优先存储
-                t_tileID = t_rowidx * t_num_blocks + t_colidx;
+            uniq_RB[t_tileID]++;
+            Rows_flag_[row_idx][t_colidx] = false;
+        }
+
+        if(Cols_flag_[col_idx][t_rowidx])
+        {
+            uniq_CB[t_tileID]++;
+            Cols_flag_[col_idx][t_rowidx] = false;
+        }
+    }
 
+    if(is_symmetric_){
+        if(row_idx == col_idx){
+            nnz_diagonal_ ++;
+            Diag_Dom[row_idx] += value_abs;
+            max_value_diagonal_ = max_value_diagonal_ > value_abs ? max_value_diagonal_ : value_abs;
+
+        } else{
+            nnz_by_row_[col_idx]++;     // 对称的情况，把列号所在的nnz也加进来
+            nnz_by_col_[row_idx]++;     // 对称的情况，把行号所在的nnz也加进来
+            // 记录对角距离的分布频率
+            diag_offset_[-diaoffset]++;
+            if(tile_flag_)
+            {
+                // 此时为对称的 tileID 位置, t_colidx 是其行号，t_rowidx 是其列号
+                t_tileID = t_colidx * t_num_blocks + t_rowidx;
                 nnz_by_Tiles_[t_tileID]++;
-                nnz_by_RB_[t_rowidx]++;
-                nnz_by_CB_[t_colidx]++;
-                
-                Rows_cnt[row_idx][t_colidx]++;
-                Cols_cnt[col_idx][t_rowidx]++;
+                nnz_by_RB_[t_colidx]++;
+                nnz_by_CB_[t_rowidx]++;
+
+                Rows_cnt[col_idx][t_rowidx]++;
+                Cols_cnt[row_idx][t_colidx]++;
 
-                if(Rows_flag[row_idx][t_colidx])
+                if(Rows_flag_[col_idx][t_rowidx])
                 {
                     uniq_RB[t_tileID]++;
-                    Rows_flag[row_idx][t_colidx] = false;
+                    Rows_flag_[col_idx][t_rowidx] = false;
                 }
-                // 
 
-                if(Cols_flag[col_idx][t_rowidx])
+                if(Cols_flag_[row_idx][t_colidx])
                 {
                     uniq_CB[t_tileID]++;
-                    Cols_flag[col_idx][t_rowidx] = false;
+                    Cols_flag_[row_idx][t_colidx] = false;
                 }
-                // 
-            }
-
-            if(is_symmetric_){              // 对称矩阵情况
-                if(row_idx == col_idx){     // 对角线
-                    nnz_diagonal_ ++;
-                    Diag_Dom[row_idx] += value_abs;
-                    max_value_diagonal_ = 1.0; // pattern matrix only have 1.0
-                } else{                     // 非对角线
-                    nnz_by_row_[col_idx]++;     // 对称的情况，把列号所在的nnz也加进来
-                    nnz_by_col_[row_idx]++;     // 对称的情况，把行号所在的nnz也加进来
-                    // 记录对角距离的分布频率
-                    diag_offset_[-diaoffset]++;
-
-                    // 存一下 tile 的信息
-                    if(tile_flag)
-                    {
-                        // 此时为对称的 tileID 位置, t_colidx 是其行号，t_rowidx 是其列号
-                        t_tileID = t_colidx * t_num_blocks + t_rowidx;
-                        nnz_by_Tiles_[t_tileID]++;
-                        nnz_by_RB_[t_colidx]++;
-                        nnz_by_CB_[t_rowidx]++;
-
-                        Rows_cnt[col_idx][t_rowidx]++;
-                        Cols_cnt[row_idx][t_colidx]++;
-
-                        if(Rows_flag[col_idx][t_rowidx])
-                        {
-                            uniq_RB[t_tileID]++;
-                            Rows_flag[col_idx][t_rowidx] = false;
-                        }
-                        // 
-
-                        if(Cols_flag[row_idx][t_colidx])
-                        {
-                            uniq_CB[t_tileID]++;
-                            Cols_flag[row_idx][t_colidx] = false;
-                        }
-                        // 
-                    }
-                    nnz_lower_ ++;
-                    nnz_upper_ ++;
-                    Diag_Dom[row_idx] -= 1.0;
-                    Diag_Dom[col_idx] -= 1.0;
-                    max_value_offdiag_ = 1.0;
-                }
-            }else { // 非对称矩阵
-                if (row_idx == col_idx)  // 行 == 列， 对角线
-                {
-                    nnz_diagonal_ ++;
-                    max_value_diagonal_ = max_value_diagonal_ > value_abs ? max_value_diagonal_ : value_abs;
-                    Diag_Dom[row_idx] += value_abs;
-                } else {                    // 非对角线情况
-                    if (row_idx > col_idx) { // 行 > 列，元素在下三角
-                        nnz_lower_ ++;
-                    } else{                  // 行 < 列，元素在上三角
-                        nnz_upper_ ++;
-                    }
-                    max_value_offdiag_ = max_value_offdiag_ > value_abs ? max_value_offdiag_ : value_abs;
-                    Diag_Dom[row_idx] -= value_abs;
-                }
-                char buffer[100];
-                sprintf(buffer, "%lf", value);
-                std::string str_value  = buffer;
-                std::string str_insert = my_to_String(row_idx) + "_" + my_to_String(col_idx);
-                m_.insert(std::make_pair(str_insert, str_value));
-                symm_pair_.push_back(str_insert);
             }
+            nnz_lower_ ++;
+            nnz_upper_ ++;
+            Diag_Dom[row_idx] -= value_abs;
+            Diag_Dom[col_idx] -= value_abs;
+            max_value_offdiag_ = max_value_offdiag_ > value_abs ? max_value_offdiag_ : value_abs;
         }
-    }else if (mm_is_real(mat_code) || mm_is_integer(mat_code)){
-        for( IndexType i = 0; i < nnz_mtx_; i++ ){
-            IndexType row_id, col_id;
-            double V;
-            if constexpr(std::is_same<IndexType, int>::value) {
-                assert(fscanf(mtx_file, "%d %d %lf\n", &row_id, &col_id, &V) == 3);
-            } else if constexpr(std::is_same<IndexType, long long>::value) {
-                assert(fscanf(mtx_file, "%lld %lld %lf\n", &row_id, &col_id, &V) == 3);
+        // 记录row-variability 和 col-variability : log10(max/min), pattern 矩阵不统计
+        if(!is_pattern){
+            if(max_each_row_[row_idx] < log10(value_abs)) { max_each_row_[row_idx] = log10(value_abs); }
+            if(max_each_row_[col_idx] < log10(value_abs)) { max_each_row_[col_idx] = log10(value_abs); }
+            if(value_abs > 0.0 && min_each_row_[row_idx] > log10(value_abs)) { min_each_row_[row_idx] = log10(value_abs); }
+            if(value_abs > 0.0 && min_each_row_[col_idx] > log10(value_abs)) { min_each_row_[col_idx] = log10(value_abs); }
+
+            if(max_each_col_[col_idx] < log10(value_abs)) { max_each_col_[col_idx] = log10(value_abs); }
+            if(max_each_col_[row_idx] < log10(value_abs)) { max_each_col_[row_idx] = log10(value_abs); }
+            if(value_abs > 0.0 && min_each_col_[col_idx] > log10(value_abs)) { min_each_col_[col_idx] = log10(value_abs); }
+            if(value_abs > 0.0 && min_each_col_[row_idx] > log10(value_abs)) { min_each_col_[row_idx] = log10(value_abs); }
+        }
+    }
+    else { // 非对称矩阵
+        if (row_idx == col_idx)  // 行 == 列， 对角线
+        {
+            nnz_diagonal_ ++;
+            max_value_diagonal_ = max_value_diagonal_ > value_abs ? max_value_diagonal_ : value_abs;
+            Diag_Dom[row_idx] += value_abs;
+        } else {                    // 非对角线情况
+            if (row_idx > col_idx) { // 行 > 列，元素在下三角
+                nnz_lower_ ++;
+            } else{                  // 行 < 列，元素在上三角
+                nnz_upper_ ++;
             }
+            max_value_offdiag_ = max_value_offdiag_ > value_abs ? max_value_offdiag_ : value_abs;
+            Diag_Dom[row_idx] -= value_abs;
+        }
 
-            row_idx   = (IndexType) row_id - 1;
-            col_idx   = (IndexType) col_id - 1;
-            value     = (ValueType) V;
-            value_abs = std::abs(value);
-            diaoffset = col_idx - row_idx;
-
-            // if(value){ // value 非零才记录
-                nnz_by_row_[row_idx]++;
-                nnz_by_col_[col_idx]++;
-                // 记录对角距离的分布频率
-                diag_offset_[diaoffset]++;
-
-                // 存一下分tile的信息
-                if (tile_flag){
-                    t_rowidx = (row_idx < RB_threshold)? (row_idx / (t_num_RB+1)):(t_mod_RB + (row_idx - RB_threshold)/t_num_RB);
-                    t_colidx = (col_idx < CB_threshold)? (col_idx / (t_num_CB+1)):(t_mod_CB + (col_idx - CB_threshold)/t_num_CB);
-                    
-                    // tile 按 行优先存储
-                    t_tileID = t_rowidx * t_num_blocks + t_colidx;
-
-                    nnz_by_Tiles_[t_tileID]++;
-                    nnz_by_RB_[t_rowidx]++;
-                    nnz_by_CB_[t_colidx]++;
-
-                    Rows_cnt[row_idx][t_colidx]++;
-                    Cols_cnt[col_idx][t_rowidx]++;
-
-                    if(Rows_flag[row_idx][t_colidx])
-                    {
-                        uniq_RB[t_tileID]++;
-                        Rows_flag[row_idx][t_colidx] = false;
-                    }
-                    // 
-
-                    if(Cols_flag[col_idx][t_rowidx])
-                    {
-                        uniq_CB[t_tileID]++;
-                        Cols_flag[col_idx][t_rowidx] = false;
-                    }
-                    // 
-                }
-            
-                if(is_symmetric_){
-                    if(row_idx == col_idx){
-                        nnz_diagonal_ ++;
-                        Diag_Dom[row_idx] += value_abs;
-                        max_value_diagonal_ = max_value_diagonal_ > value_abs ? max_value_diagonal_ : value_abs;
-
-                    } else{
-                        nnz_by_row_[col_idx]++;
-                        nnz_by_col_[row_idx]++;
-                        // 记录对角距离的分布频率
-                        diag_offset_[-diaoffset]++;
-                        if(tile_flag)
-                        {
-                            // 此时为对称的 tileID 位置, t_colidx 是其行号，t_rowidx 是其列号
-                            t_tileID = t_colidx * t_num_blocks + t_rowidx;
-                            nnz_by_Tiles_[t_tileID]++;
-                            nnz_by_RB_[t_colidx]++;
-                            nnz_by_CB_[t_rowidx]++;
-
-                            Rows_cnt[col_idx][t_rowidx]++;
-                            Cols_cnt[row_idx][t_colidx]++;
-
-                            if(Rows_flag[col_idx][t_rowidx])
-                            {
-                                uniq_RB[t_tileID]++;
-                                Rows_flag[col_idx][t_rowidx] = false;
-                            }
-                            // 
-
-                            if(Cols_flag[row_idx][t_colidx])
-                            {
-                                uniq_CB[t_tileID]++;
-                                Cols_flag[row_idx][t_colidx] = false;
-                            }
-                            // 
-                        }
-                        nnz_lower_ ++;
-                        nnz_upper_ ++;
-                        Diag_Dom[row_idx] -= value_abs;
-                        Diag_Dom[col_idx] -= value_abs;
-                        max_value_offdiag_ = max_value_offdiag_ > value_abs ? max_value_offdiag_ : value_abs;
-                    }
-                    // 记录row-variability 和 col-variability : log10(max/min)
-                    if(max_each_row_[row_idx] < log10(value_abs)) { max_each_row_[row_idx] = log10(value_abs); }
-                    if(max_each_row_[col_idx] < log10(value_abs)) { max_each_row_[col_idx] = log10(value_abs); }
-                    if(value_abs > 0.0 && min_each_row_[row_idx] > log10(value_abs)) { min_each_row_[row_idx] = log10(value_abs); }
-                    if(value_abs > 0.0 && min_each_row_[col_idx] > log10(value_abs)) { min_each_row_[col_idx] = log10(value_abs); }
-
-                    if(max_each_col_[col_idx] < log10(value_abs)) { max_each_col_[col_idx] = log10(value_abs); }
-                    if(max_each_col_[row_idx] < log10(value_abs)) { max_each_col_[row_idx] = log10(value_abs); }
-                    if(value_abs > 0.0 && min_each_col_[col_idx] > log10(value_abs)) { min_each_col_[col_idx] = log10(value_abs); }
-                    if(value_abs > 0.0 && min_each_col_[row_idx] > log10(value_abs)) { min_each_col_[row_idx] = log10(value_abs); }
-                }
-                else { // 非对称矩阵
-                    if (row_idx == col_idx)  // 行 == 列， 对角线
-                    {
-                        nnz_diagonal_ ++;
-                        max_value_diagonal_ = max_value_diagonal_ > value_abs ? max_value_diagonal_ : value_abs;
-                        Diag_Dom[row_idx] += value_abs;
-                    } else {                    // 非对角线情况
-                        if (row_idx > col_idx) { // 行 > 列，元素在下三角
-                            nnz_lower_ ++;
-                        } else{                  // 行 < 列，元素在上三角
-                            nnz_upper_ ++;
-                        }
-                        max_value_offdiag_ = max_value_offdiag_ > value_abs ? max_value_offdiag_ : value_abs;
-                        Diag_Dom[row_idx] -= value_abs;
-                    }
-
-                    char buffer[100];
-                    sprintf(buffer, "%lf", value);
-                    std::string str_value  = buffer;
-                    std::string str_insert = my_to_String(row_idx) + "_" + my_to_String(col_idx);
-                    m_.insert(std::make_pair(str_insert, str_value));
-                    symm_pair_.push_back(str_insert);
+        char buffer[100];
+        sprintf(buffer, "%lf", (double) value);
+        std::string str_value  = buffer;
+        std::string str_insert = my_to_String(row_idx) + "_" + my_to_String(col_idx);
+        m_.insert(std::make_pair(str_insert, str_value));
+        symm_pair_.push_back(str_insert);
 
-                    // 记录row-variability 和 col-variability : log10(max/min)
-                    if(max_each_row_[row_idx] < log10(value_abs)) { max_each_row_[row_idx] = log10(value_abs); }
-                    if(value_abs > 0.0 && min_each_row_[row_idx] > log10(value_abs)) { min_each_row_[row_idx] = log10(value_abs); }
+        // 记录row-variability 和 col-variability : log10(max/min), pattern 矩阵不统计
+        if(!is_pattern){
+            if(max_each_row_[row_idx] < log10(value_abs)) { max_each_row_[row_idx] = log10(value_abs); }
+            if(value_abs > 0.0 && min_each_row_[row_idx] > log10(value_abs)) { min_each_row_[row_idx] = log10(value_abs); }
 
-                    if(max_each_col_[col_idx] < log10(value_abs)) { max_each_col_[col_idx] = log10(value_abs); }
-                    if(value_abs > 0.0 && min_each_col_[col_idx] > log10(value_abs)) { min_each_col_[col_idx] = log10(value_abs); }
-                }
-            // }  // value != 0
+            if(max_each_col_[col_idx] < log10(value_abs)) { max_each_col_[col_idx] = log10(value_abs); }
+            if(value_abs > 0.0 && min_each_col_[col_idx] > log10(value_abs)) { min_each_col_[col_idx] = log10(value_abs); }
         }
-    }else{
-        std::cout << "Unsupported data type" << std::endl;
-        exit(1);
     }
+}
+
+template <typename IndexType, typename ValueType>
+void MTX<IndexType, ValueType>::LoadFinish()
+{
+    IndexType t_rowidx = 0;
+    const IndexType RB_threshold = RB_threshold_;
+    const IndexType CB_threshold = CB_threshold_;
+
+    // 标记数组只在读入时使用
+    std::vector<std::vector<bool>>().swap(Rows_flag_);
+    std::vector<std::vector<bool>>().swap(Cols_flag_);
 
     if(is_symmetric_){
         num_nnzs = nnz_lower_*2 + nnz_diagonal_;
@@ -597,10 +538,6 @@ bool MTX<IndexType, ValueType>::MtxLoad(const char* mat_path)
         }
         std_colnnz_per_CB_[i] = std::sqrt(std_colnnz_per_CB_[i]); 
     }
-    
-
-    fclose(mtx_file);
-    return true;
 }
 
 template bool MTX<int, float>::MtxLoad(const char* mat_path);
@@ -608,6 +545,11 @@ template bool MTX<int, double>::MtxLoad(const char* mat_path);
 template bool MTX<long long, float>::MtxLoad(const char* mat_path);
 template bool MTX<long long, double>::MtxLoad(const char* mat_path);
 
+template bool MTX<int, float>::MtxLoad(const CSR_Matrix<int, float> &csr, const std::string &mat_name);
+template bool MTX<int, double>::MtxLoad(const CSR_Matrix<int, double> &csr, const std::string &mat_name);
+template bool MTX<long long, float>::MtxLoad(const CSR_Matrix<long long, float> &csr, const std::string &mat_name);
+template bool MTX<long long, double>::MtxLoad(const CSR_Matrix<long long, double> &csr, const std::string &mat_name);
+
 template <typename IndexType, typename ValueType>
 void P_ratioAndGini(const std::vector<IndexType> vec, const IndexType num_nnzs, ValueType &p_ratio, ValueType &Gini)
 {
@@ -944,6 +886,15 @@ bool MTX<IndexType, ValueType>::CalculateTilesExtraFeatures(const char* mat_path
     CSR_Matrix<IndexType, ValueType> csr;
     csr = read_csr_matrix<IndexType, ValueType>(mat_path);
 
+    bool ret = CalculateTilesExtraFeatures(csr);
+    delete_csr_matrix(csr);
+    return ret;
+}
+
+template <typename IndexType, typename ValueType>
+bool MTX<IndexType, ValueType>::CalculateTilesExtraFeatures(const CSR_Matrix<IndexType, ValueType> &csr)
+{
+
     // 计算每行 nnz的 distance
     std::vector<IndexType> dis_row_nnz_(csr.num_rows, 0);
     for (size_t i = 0; i < csr.num_rows; i++)
@@ -1084,7 +1035,6 @@ bool MTX<IndexType, ValueType>::CalculateTilesExtraFeatures(const char* mat_path
     }
     delete_bsr_matrix(bsr);
 #endif // BSR_ANA
-    delete_csr_matrix(csr);
     return true;
 }
 template bool MTX<int, float>::CalculateTilesExtraFeatures(const char* mat_path);
@@ -1092,6 +1042,11 @@ template bool MTX<int, double>::CalculateTilesExtraFeatures(const char* mat_path
 template bool MTX<long long, float>::CalculateTilesExtraFeatures(const char* mat_path);
 template bool MTX<long long, double>::CalculateTilesExtraFeatures(const char* mat_path);
 
+template bool MTX<int, float>::CalculateTilesExtraFeatures(const CSR_Matrix<int, float> &csr);
+template bool MTX<int, double>::CalculateTilesExtraFeatures(const CSR_Matrix<int, double> &csr);
+template bool MTX<long long, float>::CalculateTilesExtraFeatures(const CSR_Matrix<long long, float> &csr);
+template bool MTX<long long, double>::CalculateTilesExtraFeatures(const CSR_Matrix<long long, double> &csr);
+
 template <typename IndexType, typename ValueType>
 bool MTX<IndexType, ValueType>::PrintImage(std::string& outputpath){
     std::string image_s = "image=";
@@ -1131,6 +1086,27 @@ int inline WriteImage(std::string filePath, std::vector<IndexType> data, size_t
     return EXIT_SUCCESS;
 }
 
+template <typename IndexType, typename ValueType>
+bool MTX<IndexType, ValueType>::SuggestColumnBlocking()
+{
+    // 特征尚未计算
+    if (potReuseC < 0 || uniqC < 0)
+        return false;
+
+    const double x_bytes = (double) num_cols * sizeof(ValueType);
+    const double x_cache = CBCSR_CACHE_FRACTION * Le_get_platform().l3cache_instance;
+    if (x_bytes <= x_cache)
+        return false;
+
+    // potReuseC: 平均每列被多少个 tile 行块访问, 即 x[j] 在一次 SpMV 中被重新加载的次数
+    // uniqC    : tile 内非零列数 / nnz, 接近 1 说明 tile 内几乎没有 x 的复用
+    return (potReuseC >= CBCSR_MIN_POTREUSE_C) && (uniqC >= CBCSR_MIN_UNIQC);
+}
+template bool MTX<int, float>::SuggestColumnBlocking();
+template bool MTX<int, double>::SuggestColumnBlocking();
+template bool MTX<long long, float>::SuggestColumnBlocking();
+template bool MTX<long long, double>::SuggestColumnBlocking();
+
 template <typename IndexType, typename ValueType>
 bool MTX<IndexType, ValueType>::FeaturesWrite(const char* file_path)
 {
@@ -0,0 +1,605 @@
+/**
+ * @file sparse_generator.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief Synthetic sparse matrix generators (banded, block diagonal, random,
+ *        R-MAT, stencils and mixtures), built in CSR without disk I/O.
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include"../include/LeSpMV.h"
+#include"../include/sparse_generator.h"
+#include<vector>
+#include<algorithm>
+#include<unordered_set>
+#include<sstream>
+#include<cmath>
+
+// counter-based stream (splitmix64): the same (seed, stream) always gives the same sequence
+struct GenRandom
+{
+    unsigned long long state;
+
+    GenRandom(const unsigned long long seed, const unsigned long long stream)
+    {
+        state = seed ^ ((stream + 1) * 0x9E3779B97F4A7C15ULL);
+        next();
+    }
+
+    unsigned long long next()
+    {
+        unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // [0, 1)
+    double uniform()
+    {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // [0, n)
+    unsigned long long below(const unsigned long long n)
+    {
+        return next() % n;
+    }
+
+    // [-1, 1) without 0
+    double value()
+    {
+        double v = 2.0 * uniform() - 1.0;
+        return (v == 0.0) ? 1.0 : v;
+    }
+};
+
+/**
+ * @brief Two passes over the rows: count, then fill. gen_row(i, rng, cols, vals)
+ *        must return sorted unique columns, rng is reset to the same row stream
+ *        in both passes so the result does not depend on the thread number.
+ */
+template <typename IndexType, typename ValueType, typename RowGen>
+static CSR_Matrix<IndexType, ValueType> build_csr_by_rows(const IndexType num_rows, const IndexType num_cols, const unsigned long long seed, RowGen gen_row)
+{
+    CSR_Matrix<IndexType, ValueType> csr;
+    csr.num_rows = num_rows;
+    csr.num_cols = num_cols;
+    csr.tag = 0;
+    csr.kernel_flag = KERNEL_FLAG;
+
+    csr.row_offset = new_array<IndexType>(num_rows + 1);
+    CHECK_ALLOC(csr.row_offset);
+
+    const int thread_num = Le_get_thread_num();
+
+    #pragma omp parallel num_threads(thread_num)
+    {
+        std::vector<IndexType> cols;
+        std::vector<ValueType> vals;
+        #pragma omp for schedule(dynamic, OMP_ROWS_SIZE)
+        for (IndexType i = 0; i < num_rows; i++)
+        {
+            GenRandom rng(seed, i);
+            cols.clear(); vals.clear();
+            gen_row(i, rng, cols, vals);
+            csr.row_offset[i + 1] = cols.size();
+        }
+    }
+
+    csr.row_offset[0] = 0;
+    for (IndexType i = 0; i < num_rows; i++)
+        csr.row_offset[i + 1] += csr.row_offset[i];
+    csr.num_nnzs = csr.row_offset[num_rows];
+    csr.sparsity = (num_rows && num_cols) ? 1.0 - (double) csr.num_nnzs / ((double) num_rows * num_cols) : 0.0;
+
+    csr.col_index = new_array<IndexType>(csr.num_nnzs);
+    CHECK_ALLOC(csr.col_index);
+    csr.values    = new_array<ValueType>(csr.num_nnzs);
+    CHECK_ALLOC(csr.values);
+
+    #pragma omp parallel num_threads(thread_num)
+    {
+        std::vector<IndexType> cols;
+        std::vector<ValueType> vals;
+        #pragma omp for schedule(dynamic, OMP_ROWS_SIZE)
+        for (IndexType i = 0; i < num_rows; i++)
+        {
+            GenRandom rng(seed, i);
+            cols.clear(); vals.clear();
+            gen_row(i, rng, cols, vals);
+            std::copy(cols.begin(), cols.end(), csr.col_index + csr.row_offset[i]);
+            std::copy(vals.begin(), vals.end(), csr.values + csr.row_offset[i]);
+        }
+    }
+
+    return csr;
+}
+
+// len distinct sorted columns out of [0, num_cols), Floyd's sampling
+template <typename IndexType>
+static void sample_columns(GenRandom &rng, const IndexType len, const IndexType num_cols, std::vector<IndexType> &cols)
+{
+    if (len <= 0)
+        return;
+
+    if (2 * len > num_cols)
+    {
+        // dense row: drop num_cols - len columns instead
+        std::unordered_set<IndexType> dropped;
+        for (IndexType j = len; j < num_cols; j++)
+        {
+            IndexType t = rng.below(j + 1);
+            if (!dropped.insert(t).second)
+                dropped.insert(j);
+        }
+        for (IndexType j = 0; j < num_cols; j++)
+            if (dropped.find(j) == dropped.end())
+                cols.push_back(j);
+        return;
+    }
+
+    std::unordered_set<IndexType> chosen;
+    chosen.reserve(2 * len);
+    for (IndexType j = num_cols - len; j < num_cols; j++)
+    {
+        IndexType t = rng.below(j + 1);
+        if (!chosen.insert(t).second)
+            chosen.insert(j);
+    }
+    cols.assign(chosen.begin(), chosen.end());
+    std::sort(cols.begin(), cols.end());
+}
+
+// Gini coefficient of an ascending sorted sequence
+static double sorted_gini(const std::vector<double> &x)
+{
+    const size_t n = x.size();
+    double sum = 0, weighted = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        sum      += x[i];
+        weighted += (double)(i + 1) * x[i];
+    }
+    if (n == 0 || sum == 0)
+        return 0;
+    return 2.0 * weighted / (n * sum) - (double)(n + 1) / n;
+}
+
+// random permutation of [0, n), sequential Fisher-Yates so it only depends on the seed
+template <typename IndexType>
+static std::vector<IndexType> random_permutation(const IndexType n, const unsigned long long seed)
+{
+    std::vector<IndexType> perm(n);
+    for (IndexType i = 0; i < n; i++)
+        perm[i] = i;
+    GenRandom rng(seed, ~0ULL);
+    for (IndexType i = n - 1; i > 0; i--)
+        std::swap(perm[i], perm[rng.below(i + 1)]);
+    return perm;
+}
+
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_banded_csr(const IndexType num_rows, const IndexType lower, const IndexType upper, const double fill, const unsigned long long seed)
+{
+    return build_csr_by_rows<IndexType, ValueType>(num_rows, num_rows, seed,
+        [&](const IndexType i, GenRandom &rng, std::vector<IndexType> &cols, std::vector<ValueType> &vals)
+        {
+            const IndexType start = std::max((IndexType) 0, i - lower);
+            const IndexType end   = std::min(num_rows - 1, i + upper);
+            IndexType diag_pos = 0;
+            for (IndexType j = start; j <= end; j++)
+            {
+                if (j == i)
+                {
+                    diag_pos = cols.size();
+                    cols.push_back(j);
+                    vals.push_back(0);
+                }
+                else if (rng.uniform() < fill)
+                {
+                    cols.push_back(j);
+                    vals.push_back((ValueType) rng.value());
+                }
+            }
+            // diagonally dominant
+            vals[diag_pos] = (ValueType) cols.size();
+        });
+}
+
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_block_diag_csr(const IndexType num_rows, const IndexType block_size, const double density, const unsigned long long seed)
+{
+    return build_csr_by_rows<IndexType, ValueType>(num_rows, num_rows, seed,
+        [&](const IndexType i, GenRandom &rng, std::vector<IndexType> &cols, std::vector<ValueType> &vals)
+        {
+            const IndexType start = (i / block_size) * block_size;
+            const IndexType end   = std::min(num_rows, start + block_size);
+            IndexType diag_pos = 0;
+            for (IndexType j = start; j < end; j++)
+            {
+                if (j == i)
+                {
+                    diag_pos = cols.size();
+                    cols.push_back(j);
+                    vals.push_back(0);
+                }
+                else if (rng.uniform() < density)
+                {
+                    cols.push_back(j);
+                    vals.push_back((ValueType) rng.value());
+                }
+            }
+            vals[diag_pos] = (ValueType) cols.size();
+        });
+}
+
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_random_csr(const IndexType num_rows, const IndexType num_cols, const double ave_row_nnz, const double skew, const unsigned long long seed)
+{
+    // expected length of the row with rank r is scale * (r+1)^(-skew)
+    std::vector<IndexType> rank = random_permutation(num_rows, seed);
+    double weight_sum = 0;
+    for (IndexType r = 0; r < num_rows; r++)
+        weight_sum += std::pow((double) r + 1, -skew);
+    const double scale = (weight_sum > 0) ? ave_row_nnz * num_rows / weight_sum : 0;
+
+    return build_csr_by_rows<IndexType, ValueType>(num_rows, num_cols, seed,
+        [&](const IndexType i, GenRandom &rng, std::vector<IndexType> &cols, std::vector<ValueType> &vals)
+        {
+            double expect = scale * std::pow((double) rank[i] + 1, -skew);
+            // stochastic rounding keeps the total close to ave_row_nnz * num_rows
+            IndexType len = (IndexType) expect;
+            if (rng.uniform() < expect - (double) len)
+                len++;
+            len = std::min(len, num_cols);
+
+            sample_columns(rng, len, num_cols, cols);
+            for (size_t k = 0; k < cols.size(); k++)
+                vals.push_back((ValueType) rng.value());
+        });
+}
+
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_random_csr_gini(const IndexType num_rows, const IndexType num_cols, const double ave_row_nnz, const double gini, const unsigned long long seed)
+{
+    // Gini of (r+1)^(-skew) grows with skew, bisection on skew
+    std::vector<double> weights(num_rows);
+    double lo = 0.0, hi = 16.0;
+    for (int iter = 0; iter < 50; iter++)
+    {
+        double mid = 0.5 * (lo + hi);
+        for (IndexType r = 0; r < num_rows; r++)
+            weights[num_rows - 1 - r] = std::pow((double) r + 1, -mid);   // ascending
+        if (sorted_gini(weights) < gini)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return generate_random_csr<IndexType, ValueType>(num_rows, num_cols, ave_row_nnz, 0.5 * (lo + hi), seed);
+}
+
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_rmat_csr(const int scale, const int edge_factor, const double a, const double b, const double c, const unsigned long long seed)
+{
+    const IndexType num_vertices = (IndexType) 1 << scale;
+    const size_t num_edges = (size_t) edge_factor * num_vertices;
+    const int thread_num = Le_get_thread_num();
+
+    IndexType *edge_row = new_array<IndexType>(num_edges);
+    CHECK_ALLOC(edge_row);
+    IndexType *edge_col = new_array<IndexType>(num_edges);
+    CHECK_ALLOC(edge_col);
+
+    // 行号高位作为行块, 每个线程统计自己的边段落在各行块的数量
+    int block_bits = 4;
+    while ((1 << block_bits) < 16 * thread_num)
+        block_bits++;
+    block_bits = std::min(block_bits, scale);
+    const int shift = scale - block_bits;
+    const IndexType num_blocks = (IndexType) 1 << block_bits;
+    std::vector<size_t> block_count((size_t) thread_num * num_blocks, 0);
+
+    #pragma omp parallel num_threads(thread_num)
+    {
+        const int tid = Le_get_thread_id();
+        const size_t e_begin = num_edges * tid / thread_num;
+        const size_t e_end   = num_edges * (tid + 1) / thread_num;
+        size_t *count = block_count.data() + (size_t) tid * num_blocks;
+        for (size_t e = e_begin; e < e_end; e++)
+        {
+            GenRandom rng(seed, e);
+            IndexType row = 0, col = 0;
+            for (int level = 0; level < scale; level++)
+            {
+                double r = rng.uniform();
+                row <<= 1; col <<= 1;
+                if (r < a) {}
+                else if (r < a + b) { col |= 1; }
+                else if (r < a + b + c) { row |= 1; }
+                else { row |= 1; col |= 1; }
+            }
+            edge_row[e] = row;
+            edge_col[e] = col;
+            count[row >> shift]++;
+        }
+    }
+
+    // 前缀和: 行块优先, 块内按线程顺序, 分散后同一行的边保持生成顺序
+    std::vector<size_t> block_start(num_blocks + 1, 0);
+    size_t sum = 0;
+    for (IndexType blk = 0; blk < num_blocks; blk++)
+    {
+        block_start[blk] = sum;
+        for (int t = 0; t < thread_num; t++)
+        {
+            const size_t n = block_count[(size_t) t * num_blocks + blk];
+            block_count[(size_t) t * num_blocks + blk] = sum;
+            sum += n;
+        }
+    }
+    block_start[num_blocks] = num_edges;
+
+    IndexType *block_row = new_array<IndexType>(num_edges);
+    CHECK_ALLOC(block_row);
+    IndexType *block_col = new_array<IndexType>(num_edges);
+    CHECK_ALLOC(block_col);
+    #pragma omp parallel num_threads(thread_num)
+    {
+        const int tid = Le_get_thread_id();
+        const size_t e_begin = num_edges * tid / thread_num;
+        const size_t e_end   = num_edges * (tid + 1) / thread_num;
+        size_t *cursor = block_count.data() + (size_t) tid * num_blocks;
+        for (size_t e = e_begin; e < e_end; e++)
+        {
+            const size_t dst = cursor[edge_row[e] >> shift]++;
+            block_row[dst] = edge_row[e];
+            block_col[dst] = edge_col[e];
+        }
+    }
+    delete_array(edge_row);
+
+    // 每个行块由一个线程按行计数并分散到 bucket, 块内的行连续, 互不重叠
+    IndexType *row_count = new_array<IndexType>(num_vertices + 1);
+    CHECK_ALLOC(row_count);
+    IndexType *bucket = edge_col;
+    row_count[0] = 0;
+    const IndexType rows_per_block = (IndexType) 1 << shift;
+    #pragma omp parallel num_threads(thread_num)
+    {
+        std::vector<IndexType> cursor(rows_per_block);
+        #pragma omp for schedule(dynamic, 1)
+        for (IndexType blk = 0; blk < num_blocks; blk++)
+        {
+            const IndexType row_begin = blk << shift;
+            std::fill(cursor.begin(), cursor.end(), 0);
+            for (size_t k = block_start[blk]; k < block_start[blk + 1]; k++)
+                cursor[block_row[k] - row_begin]++;
+            IndexType sum = (IndexType) block_start[blk];
+            for (IndexType r = 0; r < rows_per_block; r++)
+            {
+                const IndexType n = cursor[r];
+                cursor[r] = sum;
+                sum += n;
+                row_count[row_begin + r + 1] = sum;
+            }
+            for (size_t k = block_start[blk]; k < block_start[blk + 1]; k++)
+                bucket[cursor[block_row[k] - row_begin]++] = block_col[k];
+        }
+    }
+    delete_array(block_row);
+    delete_array(block_col);
+
+    #pragma omp parallel for num_threads(thread_num) schedule(dynamic, OMP_ROWS_SIZE)
+    for (IndexType i = 0; i < num_vertices; i++)
+        std::sort(bucket + row_count[i], bucket + row_count[i + 1]);
+
+    CSR_Matrix<IndexType, ValueType> csr = build_csr_by_rows<IndexType, ValueType>(num_vertices, num_vertices, seed,
+        [&](const IndexType i, GenRandom &rng, std::vector<IndexType> &cols, std::vector<ValueType> &vals)
+        {
+            for (IndexType k = row_count[i]; k < row_count[i + 1]; k++)
+            {
+                if (k > row_count[i] && bucket[k] == bucket[k - 1])
+                    continue;
+                cols.push_back(bucket[k]);
+                vals.push_back((ValueType) rng.value());
+            }
+        });
+
+    delete_array(bucket);
+    delete_array(row_count);
+    return csr;
+}
+
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_stencil_csr(const IndexType nx, const IndexType ny, const IndexType nz, const int points)
+{
+    const IndexType num_rows = nx * ny * nz;
+    // offsets ordered by (dz, dy, dx), so the columns come out sorted
+    std::vector<int> dxs, dys, dzs;
+    for (int dz = -1; dz <= 1; dz++)
+    for (int dy = -1; dy <= 1; dy++)
+    for (int dx = -1; dx <= 1; dx++)
+    {
+        int dist = std::abs(dx) + std::abs(dy) + std::abs(dz);
+        bool keep = (points == 27) || (points == 7 && dist <= 1) || (points == 5 && dz == 0 && dist <= 1);
+        if (keep)
+        {
+            dxs.push_back(dx); dys.push_back(dy); dzs.push_back(dz);
+        }
+    }
+
+    return build_csr_by_rows<IndexType, ValueType>(num_rows, num_rows, 0,
+        [&](const IndexType i, GenRandom &rng, std::vector<IndexType> &cols, std::vector<ValueType> &vals)
+        {
+            const IndexType x = i % nx;
+            const IndexType y = (i / nx) % ny;
+            const IndexType z = i / (nx * ny);
+            for (size_t k = 0; k < dxs.size(); k++)
+            {
+                IndexType xx = x + dxs[k], yy = y + dys[k], zz = z + dzs[k];
+                if (xx < 0 || xx >= nx || yy < 0 || yy >= ny || zz < 0 || zz >= nz)
+                    continue;
+                IndexType j = (zz * ny + yy) * nx + xx;
+                cols.push_back(j);
+                vals.push_back((j == i) ? (ValueType)(points - 1) : (ValueType) -1);
+            }
+        });
+}
+
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> merge_csr_matrices(const CSR_Matrix<IndexType, ValueType> &a, const CSR_Matrix<IndexType, ValueType> &b)
+{
+    return build_csr_by_rows<IndexType, ValueType>(a.num_rows, a.num_cols, 0,
+        [&](const IndexType i, GenRandom &rng, std::vector<IndexType> &cols, std::vector<ValueType> &vals)
+        {
+            IndexType ja = a.row_offset[i], ea = a.row_offset[i + 1];
+            IndexType jb = b.row_offset[i], eb = b.row_offset[i + 1];
+            while (ja < ea || jb < eb)
+            {
+                if (jb == eb || (ja < ea && a.col_index[ja] < b.col_index[jb]))
+                {
+                    cols.push_back(a.col_index[ja]); vals.push_back(a.values[ja]); ja++;
+                }
+                else if (ja == ea || b.col_index[jb] < a.col_index[ja])
+                {
+                    cols.push_back(b.col_index[jb]); vals.push_back(b.values[jb]); jb++;
+                }
+                else
+                {
+                    cols.push_back(a.col_index[ja]); vals.push_back(a.values[ja] + b.values[jb]); ja++; jb++;
+                }
+            }
+        });
+}
+
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_mixture_csr(const IndexType num_rows, const IndexType bandwidth, const double ave_row_nnz, const double skew, const unsigned long long seed)
+{
+    CSR_Matrix<IndexType, ValueType> band = generate_banded_csr<IndexType, ValueType>(num_rows, bandwidth, bandwidth, 1.0, seed);
+    CSR_Matrix<IndexType, ValueType> rand = generate_random_csr<IndexType, ValueType>(num_rows, num_rows, ave_row_nnz, skew, seed + 1);
+    CSR_Matrix<IndexType, ValueType> mix  = merge_csr_matrices(band, rand);
+    delete_csr_matrix(band);
+    delete_csr_matrix(rand);
+    return mix;
+}
+
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> generate_csr_matrix(const std::string &spec, const unsigned long long seed)
+{
+    CSR_Matrix<IndexType, ValueType> csr;
+    csr.num_rows = 0;
+    csr.num_cols = 0;
+    csr.num_nnzs = 0;
+    csr.row_offset = NULL;
+    csr.col_index  = NULL;
+    csr.values     = NULL;
+
+    std::string name = spec.substr(0, spec.find(':'));
+    std::vector<double> p;
+    bool numeric = true;
+    if (spec.find(':') != std::string::npos)
+    {
+        std::stringstream ss(spec.substr(spec.find(':') + 1));
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            char *end = NULL;
+            p.push_back(strtod(item.c_str(), &end));
+            numeric = numeric && !item.empty() && *end == '\0';
+        }
+        // getline 不返回末尾的空项
+        numeric = numeric && spec.back() != ',';
+    }
+
+    // 参数个数必须完全匹配: 可选参数要么全给, 要么全省略
+    const size_t np = numeric ? p.size() : 0;
+    if (name == "banded" && (np == 3 || np == 4))
+        return generate_banded_csr<IndexType, ValueType>(p[0], p[1], p[2], np == 4 ? p[3] : 1.0, seed);
+    else if (name == "blockdiag" && (np == 2 || np == 3))
+        return generate_block_diag_csr<IndexType, ValueType>(p[0], p[1], np == 3 ? p[2] : 1.0, seed);
+    else if (name == "random" && (np == 3 || np == 4))
+        return generate_random_csr<IndexType, ValueType>(p[0], p[1], p[2], np == 4 ? p[3] : 0.0, seed);
+    else if (name == "gini" && np == 4)
+        return generate_random_csr_gini<IndexType, ValueType>(p[0], p[1], p[2], p[3], seed);
+    else if (name == "rmat" && (np == 2 || np == 5))
+    {
+        // d = 1 - a - b - c 也必须为正
+        const double a = (np == 5) ? p[2] : 0.57, b = (np == 5) ? p[3] : 0.19, c = (np == 5) ? p[4] : 0.19;
+        if (a >= 0 && b >= 0 && c >= 0 && a + b + c < 1)
+            return generate_rmat_csr<IndexType, ValueType>(p[0], p[1], a, b, c, seed);
+    }
+    else if (name == "stencil5" && np == 2)
+        return generate_stencil_csr<IndexType, ValueType>(p[0], p[1], 1, 5);
+    else if (name == "stencil7" && np == 3)
+        return generate_stencil_csr<IndexType, ValueType>(p[0], p[1], p[2], 7);
+    else if (name == "stencil27" && np == 3)
+        return generate_stencil_csr<IndexType, ValueType>(p[0], p[1], p[2], 27);
+    else if (name == "mixture" && np == 4)
+        return generate_mixture_csr<IndexType, ValueType>(p[0], p[1], p[2], p[3], seed);
+
+    std::cout << "Invalid generator spec: " << spec << std::endl;
+    return csr;
+}
+
+template <typename IndexType, typename ValueType>
+double csr_row_gini(const CSR_Matrix<IndexType, ValueType> &csr)
+{
+    std::vector<double> len(csr.num_rows);
+    for (IndexType i = 0; i < csr.num_rows; i++)
+        len[i] = csr.row_offset[i + 1] - csr.row_offset[i];
+    std::sort(len.begin(), len.end());
+    return sorted_gini(len);
+}
+
+template CSR_Matrix<int, float> generate_banded_csr<int, float>(const int num_rows, const int lower, const int upper, const double fill, const unsigned long long seed);
+template CSR_Matrix<int, double> generate_banded_csr<int, double>(const int num_rows, const int lower, const int upper, const double fill, const unsigned long long seed);
+template CSR_Matrix<long long, float> generate_banded_csr<long long, float>(const long long num_rows, const long long lower, const long long upper, const double fill, const unsigned long long seed);
+template CSR_Matrix<long long, double> generate_banded_csr<long long, double>(const long long num_rows, const long long lower, const long long upper, const double fill, const unsigned long long seed);
+
+template CSR_Matrix<int, float> generate_block_diag_csr<int, float>(const int num_rows, const int block_size, const double density, const unsigned long long seed);
+template CSR_Matrix<int, double> generate_block_diag_csr<int, double>(const int num_rows, const int block_size, const double density, const unsigned long long seed);
+template CSR_Matrix<long long, float> generate_block_diag_csr<long long, float>(const long long num_rows, const long long block_size, const double density, const unsigned long long seed);
+template CSR_Matrix<long long, double> generate_block_diag_csr<long long, double>(const long long num_rows, const long long block_size, const double density, const unsigned long long seed);
+
+template CSR_Matrix<int, float> generate_random_csr<int, float>(const int num_rows, const int num_cols, const double ave_row_nnz, const double skew, const unsigned long long seed);
+template CSR_Matrix<int, double> generate_random_csr<int, double>(const int num_rows, const int num_cols, const double ave_row_nnz, const double skew, const unsigned long long seed);
+template CSR_Matrix<long long, float> generate_random_csr<long long, float>(const long long num_rows, const long long num_cols, const double ave_row_nnz, const double skew, const unsigned long long seed);
+template CSR_Matrix<long long, double> generate_random_csr<long long, double>(const long long num_rows, const long long num_cols, const double ave_row_nnz, const double skew, const unsigned long long seed);
+
+template CSR_Matrix<int, float> generate_random_csr_gini<int, float>(const int num_rows, const int num_cols, const double ave_row_nnz, const double gini, const unsigned long long seed);
+template CSR_Matrix<int, double> generate_random_csr_gini<int, double>(const int num_rows, const int num_cols, const double ave_row_nnz, const double gini, const unsigned long long seed);
+template CSR_Matrix<long long, float> generate_random_csr_gini<long long, float>(const long long num_rows, const long long num_cols, const double ave_row_nnz, const double gini, const unsigned long long seed);
+template CSR_Matrix<long long, double> generate_random_csr_gini<long long, double>(const long long num_rows, const long long num_cols, const double ave_row_nnz, const double gini, const unsigned long long seed);
+
+template CSR_Matrix<int, float> generate_rmat_csr<int, float>(const int scale, const int edge_factor, const double a, const double b, const double c, const unsigned long long seed);
+template CSR_Matrix<int, double> generate_rmat_csr<int, double>(const int scale, const int edge_factor, const double a, const double b, const double c, const unsigned long long seed);
+template CSR_Matrix<long long, float> generate_rmat_csr<long long, float>(const int scale, const int edge_factor, const double a, const double b, const double c, const unsigned long long seed);
+template CSR_Matrix<long long, double> generate_rmat_csr<long long, double>(const int scale, const int edge_factor, const double a, const double b, const double c, const unsigned long long seed);
+
+template CSR_Matrix<int, float> generate_stencil_csr<int, float>(const int nx, const int ny, const int nz, const int points);
+template CSR_Matrix<int, double> generate_stencil_csr<int, double>(const int nx, const int ny, const int nz, const int points);
+template CSR_Matrix<long long, float> generate_stencil_csr<long long, float>(const long long nx, const long long ny, const long long nz, const int points);
+template CSR_Matrix<long long, double> generate_stencil_csr<long long, double>(const long long nx, const long long ny, const long long nz, const int points);
+
+template CSR_Matrix<int, float> merge_csr_matrices<int, float>(const CSR_Matrix<int, float> &a, const CSR_Matrix<int, float> &b);
+template CSR_Matrix<int, double> merge_csr_matrices<int, double>(const CSR_Matrix<int, double> &a, const CSR_Matrix<int, double> &b);
+template CSR_Matrix<long long, float> merge_csr_matrices<long long, float>(const CSR_Matrix<long long, float> &a, const CSR_Matrix<long long, float> &b);
+template CSR_Matrix<long long, double> merge_csr_matrices<long long, double>(const CSR_Matrix<long long, double> &a, const CSR_Matrix<long long, double> &b);
+
+template CSR_Matrix<int, float> generate_mixture_csr<int, float>(const int num_rows, const int bandwidth, const double ave_row_nnz, const double skew, const unsigned long long seed);
+template CSR_Matrix<int, double> generate_mixture_csr<int, double>(const int num_rows, const int bandwidth, const double ave_row_nnz, const double skew, const unsigned long long seed);
+template CSR_Matrix<long long, float> generate_mixture_csr<long long, float>(const long long num_rows, const long long bandwidth, const double ave_row_nnz, const double skew, const unsigned long long seed);
+template CSR_Matrix<long long, double> generate_mixture_csr<long long, double>(const long long num_rows, const long long bandwidth, const double ave_row_nnz, const double skew, const unsigned long long seed);
+
+template CSR_Matrix<int, float> generate_csr_matrix<int, float>(const std::string &spec, const unsigned long long seed);
+template CSR_Matrix<int, double> generate_csr_matrix<int, double>(const std::string &spec, const unsigned long long seed);
+template CSR_Matrix<long long, float> generate_csr_matrix<long long, float>(const std::string &spec, const unsigned long long seed);
+template CSR_Matrix<long long, double> generate_csr_matrix<long long, double>(const std::string &spec, const unsigned long long seed);
+
+template double csr_row_gini<int, float>(const CSR_Matrix<int, float> &csr);
+template double csr_row_gini<int, double>(const CSR_Matrix<int, double> &csr);
+template double csr_row_gini<long long, float>(const CSR_Matrix<long long, float> &csr);
+template double csr_row_gini<long long, double>(const CSR_Matrix<long long, double> &csr);
@@ -0,0 +1,1038 @@
+/**
+ * @file sparse_reorder.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief Bandwidth reducing symmetric reordering (RCM, degree, best-of RCM),
+ *        multilevel graph partition for per-thread x locality,
+ *        and SpMV that carries the permutation.
+ * @version 0.1
+ * @date 2024-03-20
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include"../include/LeSpMV.h"
+#include"../include/sparse_reorder.h"
+#include<vector>
+#include<deque>
+#include<algorithm>
+#include<limits>
+#include<cstdlib>
+
+/**
+ * @brief Adjacency (xadj, adj) of the pattern of A + A^T without the diagonal,
+ *        neighbours of each node are sorted and unique.
+ */
+template <typename IndexType, typename ValueType>
+static void build_symmetric_graph(const CSR_Matrix<IndexType, ValueType> &csr, std::vector<IndexType> &xadj, std::vector<IndexType> &adj)
+{
+    const IndexType n = csr.num_rows;
+    const int thread_num = Le_get_thread_num();
+
+    // A^T 的行指针与列号, 按行序填入, 每行已有序
+    std::vector<IndexType> t_ptr(n + 1, 0), t_idx(csr.num_nnzs);
+    for (IndexType jj = 0; jj < csr.num_nnzs; ++jj)
+        t_ptr[csr.col_index[jj] + 1]++;
+    for (IndexType i = 0; i < n; ++i)
+        t_ptr[i + 1] += t_ptr[i];
+    {
+        std::vector<IndexType> next(t_ptr.begin(), t_ptr.end() - 1);
+        for (IndexType i = 0; i < n; ++i)
+            for (IndexType jj = csr.row_offset[i]; jj < csr.row_offset[i+1]; ++jj)
+                t_idx[next[csr.col_index[jj]]++] = i;
+    }
+
+    // 每行先写入 A 与 A^T 的并集, 排序去重后再压缩
+    std::vector<IndexType> buf(2 * (size_t) csr.num_nnzs), len(n + 1, 0);
+    #pragma omp parallel for num_threads(thread_num) schedule(dynamic, 256)
+    for (IndexType i = 0; i < n; ++i)
+    {
+        IndexType *row = buf.data() + csr.row_offset[i] + t_ptr[i];
+        IndexType cnt = 0;
+        for (IndexType jj = csr.row_offset[i]; jj < csr.row_offset[i+1]; ++jj)
+            if (csr.col_index[jj] != i)
+                row[cnt++] = csr.col_index[jj];
+        for (IndexType jj = t_ptr[i]; jj < t_ptr[i+1]; ++jj)
+            if (t_idx[jj] != i)
+                row[cnt++] = t_idx[jj];
+        std::sort(row, row + cnt);
+        len[i + 1] = std::unique(row, row + cnt) - row;
+    }
+
+    xadj.assign(n + 1, 0);
+    for (IndexType i = 0; i < n; ++i)
+        xadj[i + 1] = xadj[i] + len[i + 1];
+    adj.resize(xadj[n]);
+
+    #pragma omp parallel for num_threads(thread_num)
+    for (IndexType i = 0; i < n; ++i)
+        std::copy(buf.data() + csr.row_offset[i] + t_ptr[i], buf.data() + csr.row_offset[i] + t_ptr[i] + len[i + 1], adj.data() + xadj[i]);
+}
+
+/**
+ * @brief Serial BFS from root inside its component.
+ *        Return the eccentricity of root, last_level gets the nodes of the last level.
+ *        level must be -1 for the component on input and is restored on output.
+ */
+template <typename IndexType>
+static IndexType bfs_levels(const std::vector<IndexType> &xadj, const std::vector<IndexType> &adj, const IndexType root,
+                            std::vector<IndexType> &level, std::vector<IndexType> &queue, std::vector<IndexType> &last_level)
+{
+    queue.clear();
+    queue.push_back(root);
+    level[root] = 0;
+    size_t head = 0;
+    while (head < queue.size())
+    {
+        const IndexType u = queue[head++];
+        for (IndexType jj = xadj[u]; jj < xadj[u + 1]; ++jj)
+        {
+            const IndexType v = adj[jj];
+            if (level[v] < 0)
+            {
+                level[v] = level[u] + 1;
+                queue.push_back(v);
+            }
+        }
+    }
+    const IndexType ecc = level[queue.back()];
+    last_level.clear();
+    for (size_t k = queue.size(); k > 0 && level[queue[k - 1]] == ecc; --k)
+        last_level.push_back(queue[k - 1]);
+    for (IndexType u : queue)
+        level[u] = -1;
+    return ecc;
+}
+
+/**
+ * @brief George-Liu pseudo-peripheral node search starting from start,
+ *        far_end gets the minimum degree node of the last BFS level.
+ */
+template <typename IndexType>
+static IndexType pseudo_peripheral_node(const std::vector<IndexType> &xadj, const std::vector<IndexType> &adj, const IndexType start,
+                                        std::vector<IndexType> &level, std::vector<IndexType> &queue, IndexType &far_end)
+{
+    std::vector<IndexType> last_level;
+    IndexType root = start;
+    IndexType ecc = bfs_levels(xadj, adj, root, level, queue, last_level);
+    far_end = root;
+
+    while (true)
+    {
+        IndexType cand = last_level[0];
+        for (IndexType v : last_level)
+        {
+            const IndexType dv = xadj[v + 1] - xadj[v], dc = xadj[cand + 1] - xadj[cand];
+            if (dv < dc || (dv == dc && v < cand))
+                cand = v;
+        }
+        far_end = cand;
+        std::vector<IndexType> cand_last;
+        const IndexType cand_ecc = bfs_levels(xadj, adj, cand, level, queue, cand_last);
+        if (cand_ecc <= ecc)
+            break;
+        // cand 更"边缘", 继续从 cand 出发
+        root = cand;
+        ecc = cand_ecc;
+        last_level.swap(cand_last);
+    }
+    return root;
+}
+
+template <typename IndexType>
+static inline void atomic_min(IndexType *addr, const IndexType val)
+{
+    IndexType old = __atomic_load_n(addr, __ATOMIC_RELAXED);
+    while (val < old && !__atomic_compare_exchange_n(addr, &old, val, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+/**
+ * @brief Cuthill-McKee order of the component of root, appended to order.
+ *        Level synchronous: every unvisited neighbour is owned by its first
+ *        parent in the frontier (atomic min of the parent position), each parent
+ *        sorts its own children by degree. This equals the serial CM order.
+ */
+template <typename IndexType>
+static void cuthill_mckee_component(const std::vector<IndexType> &xadj, const std::vector<IndexType> &adj, const IndexType root,
+                                    std::vector<IndexType> &owner, std::vector<char> &visited, std::vector<IndexType> &order)
+{
+    const int thread_num = Le_get_thread_num();
+    const IndexType unowned = std::numeric_limits<IndexType>::max();
+
+    size_t front_start = order.size();
+    order.push_back(root);
+    visited[root] = 1;
+
+    std::vector<IndexType> child_cnt;
+    while (front_start < order.size())
+    {
+        const size_t front_end = order.size();
+        const IndexType front_len = (IndexType)(front_end - front_start);
+        const IndexType *front = order.data() + front_start;
+
+        #pragma omp parallel for num_threads(thread_num) schedule(dynamic, 64) if(front_len > 256)
+        for (IndexType k = 0; k < front_len; ++k)
+        {
+            const IndexType u = front[k];
+            for (IndexType jj = xadj[u]; jj < xadj[u + 1]; ++jj)
+                if (!visited[adj[jj]])
+                    atomic_min(&owner[adj[jj]], k);
+        }
+
+        child_cnt.assign(front_len + 1, 0);
+        #pragma omp parallel for num_threads(thread_num) schedule(dynamic, 64) if(front_len > 256)
+        for (IndexType k = 0; k < front_len; ++k)
+        {
+            const IndexType u = front[k];
+            IndexType cnt = 0;
+            for (IndexType jj = xadj[u]; jj < xadj[u + 1]; ++jj)
+                if (owner[adj[jj]] == k && !visited[adj[jj]])
+                    cnt++;
+            child_cnt[k + 1] = cnt;
+        }
+        for (IndexType k = 0; k < front_len; ++k)
+            child_cnt[k + 1] += child_cnt[k];
+
+        order.resize(front_end + child_cnt[front_len]);
+        front = order.data() + front_start;   // resize 可能重新分配
+
+        #pragma omp parallel for num_threads(thread_num) schedule(dynamic, 64) if(front_len > 256)
+        for (IndexType k = 0; k < front_len; ++k)
+        {
+            const IndexType u = front[k];
+            IndexType *out = order.data() + front_end + child_cnt[k];
+            IndexType cnt = 0;
+            for (IndexType jj = xadj[u]; jj < xadj[u + 1]; ++jj)
+                if (owner[adj[jj]] == k && !visited[adj[jj]])
+                    out[cnt++] = adj[jj];
+            std::sort(out, out + cnt, [&](const IndexType a, const IndexType b){
+                const IndexType da = xadj[a + 1] - xadj[a], db = xadj[b + 1] - xadj[b];
+                return (da < db) || (da == db && a < b);
+            });
+        }
+
+        #pragma omp parallel for num_threads(thread_num) if(order.size() - front_end > 1024)
+        for (size_t k = front_end; k < order.size(); ++k)
+        {
+            visited[order[k]] = 1;
+            owner[order[k]] = unowned;
+        }
+        front_start = front_end;
+    }
+}
+
+// start_rule: 0 pseudo-peripheral node, 1 minimum degree node, 2 far end of the pseudo-peripheral search
+template <typename IndexType>
+static void reverse_cuthill_mckee(const std::vector<IndexType> &xadj, const std::vector<IndexType> &adj, const int start_rule, IndexType *perm)
+{
+    const IndexType n = (IndexType) xadj.size() - 1;
+    std::vector<IndexType> owner(n, std::numeric_limits<IndexType>::max()), level(n, -1), queue, order, comp;
+    std::vector<char> visited(n, 0);
+    order.reserve(n);
+
+    for (IndexType i = 0; i < n; ++i)
+    {
+        if (visited[i])
+            continue;
+
+        IndexType root = i;
+        if (start_rule == 1)
+        {
+            // 在该连通分量内找最小度节点
+            std::vector<IndexType> last;
+            bfs_levels(xadj, adj, i, level, comp, last);
+            for (IndexType v : comp)
+            {
+                const IndexType dv = xadj[v + 1] - xadj[v], dr = xadj[root + 1] - xadj[root];
+                if (dv < dr || (dv == dr && v < root))
+                    root = v;
+            }
+        }
+        else
+        {
+            IndexType far_end;
+            root = pseudo_peripheral_node(xadj, adj, i, level, queue, far_end);
+            if (start_rule == 2)
+                root = far_end;
+        }
+        cuthill_mckee_component(xadj, adj, root, owner, visited, order);
+    }
+
+    // reverse
+    for (IndexType k = 0; k < n; ++k)
+        perm[k] = order[n - 1 - k];
+}
+
+template <typename IndexType>
+static IndexType permuted_bandwidth(const std::vector<IndexType> &xadj, const std::vector<IndexType> &adj, const IndexType *perm)
+{
+    const IndexType n = (IndexType) xadj.size() - 1;
+    const int thread_num = Le_get_thread_num();
+    std::vector<IndexType> iperm(n);
+    for (IndexType k = 0; k < n; ++k)
+        iperm[perm[k]] = k;
+
+    IndexType bw = 0;
+    #pragma omp parallel for num_threads(thread_num) reduction(max:bw)
+    for (IndexType u = 0; u < n; ++u)
+        for (IndexType jj = xadj[u]; jj < xadj[u + 1]; ++jj)
+        {
+            const IndexType d = iperm[u] > iperm[adj[jj]] ? iperm[u] - iperm[adj[jj]] : iperm[adj[jj]] - iperm[u];
+            bw = std::max(bw, d);
+        }
+    return bw;
+}
+
+template <typename IndexType>
+static IndexType * identity_permutation(const IndexType n)
+{
+    IndexType *perm = new_array<IndexType>(n);
+    CHECK_ALLOC(perm);
+    for (IndexType i = 0; i < n; ++i)
+        perm[i] = i;
+    return perm;
+}
+
+/**
+ * @brief Symmetric reordering needs a square matrix, the callers keep the original order otherwise
+ */
+template <typename IndexType, typename ValueType>
+static bool reorder_square(const CSR_Matrix<IndexType, ValueType> &csr)
+{
+    if (csr.num_rows == csr.num_cols)
+        return true;
+    printf("\tSymmetric reordering needs a square matrix, keep the original order\n");
+    return false;
+}
+
+template <typename IndexType, typename ValueType>
+IndexType * reorder_rcm(const CSR_Matrix<IndexType, ValueType> &csr)
+{
+    if (!reorder_square(csr))
+        return identity_permutation(csr.num_rows);
+
+    std::vector<IndexType> xadj, adj;
+    build_symmetric_graph(csr, xadj, adj);
+
+    IndexType *perm = new_array<IndexType>(csr.num_rows);
+    CHECK_ALLOC(perm);
+    reverse_cuthill_mckee(xadj, adj, 0, perm);
+    return perm;
+}
+
+template <typename IndexType, typename ValueType>
+IndexType * reorder_degree(const CSR_Matrix<IndexType, ValueType> &csr)
+{
+    if (!reorder_square(csr))
+        return identity_permutation(csr.num_rows);
+
+    std::vector<IndexType> xadj, adj;
+    build_symmetric_graph(csr, xadj, adj);
+
+    IndexType *perm = identity_permutation(csr.num_rows);
+    std::stable_sort(perm, perm + csr.num_rows, [&](const IndexType a, const IndexType b){
+        return (xadj[a + 1] - xadj[a]) < (xadj[b + 1] - xadj[b]);
+    });
+    return perm;
+}
+
+template <typename IndexType, typename ValueType>
+IndexType * reorder_bandwidth(const CSR_Matrix<IndexType, ValueType> &csr)
+{
+    if (!reorder_square(csr))
+        return identity_permutation(csr.num_rows);
+
+    std::vector<IndexType> xadj, adj;
+    build_symmetric_graph(csr, xadj, adj);
+
+    const IndexType n = csr.num_rows;
+    IndexType *perm = new_array<IndexType>(n);
+    IndexType *trial = new_array<IndexType>(n);
+    CHECK_ALLOC(perm);
+    CHECK_ALLOC(trial);
+
+    reverse_cuthill_mckee(xadj, adj, 0, perm);
+    IndexType best_bw = permuted_bandwidth(xadj, adj, perm);
+
+    for (int rule = 1; rule <= 2; ++rule)
+    {
+        reverse_cuthill_mckee(xadj, adj, rule, trial);
+        const IndexType bw = permuted_bandwidth(xadj, adj, trial);
+        if (bw < best_bw)
+        {
+            best_bw = bw;
+            std::swap(perm, trial);
+        }
+    }
+    delete_array(trial);
+    return perm;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Multilevel graph partition (recursive bisection)
+////////////////////////////////////////////////////////////////////////////////
+
+// 带权无向图, vwgt 为行的 nnz + 1, ewgt 为合并后的边权
+template <typename IndexType>
+struct PartGraph
+{
+    IndexType n;
+    std::vector<IndexType> xadj, adj;
+    std::vector<long long> ewgt, vwgt;
+};
+
+/**
+ * @brief Heavy edge matching: vertices are visited by ascending degree, each
+ *        unmatched vertex is merged with the unmatched neighbour of the heaviest
+ *        edge. Return the number of coarse vertices, cmap maps fine to coarse.
+ */
+template <typename IndexType>
+static IndexType heavy_edge_matching(const PartGraph<IndexType> &g, const long long max_vwgt, std::vector<IndexType> &cmap)
+{
+    const IndexType n = g.n;
+    std::vector<IndexType> order(n), match(n, -1);
+    for (IndexType u = 0; u < n; ++u)
+        order[u] = u;
+    std::stable_sort(order.begin(), order.end(), [&](const IndexType a, const IndexType b){
+        return (g.xadj[a + 1] - g.xadj[a]) < (g.xadj[b + 1] - g.xadj[b]);
+    });
+
+    for (IndexType u : order)
+    {
+        if (match[u] >= 0)
+            continue;
+        IndexType best = u;
+        long long best_w = -1;
+        for (IndexType jj = g.xadj[u]; jj < g.xadj[u + 1]; ++jj)
+        {
+            const IndexType v = g.adj[jj];
+            if (match[v] < 0 && g.ewgt[jj] > best_w && g.vwgt[u] + g.vwgt[v] <= max_vwgt)
+            {
+                best = v;
+                best_w = g.ewgt[jj];
+            }
+        }
+        match[u] = best;
+        match[best] = u;
+    }
+
+    cmap.assign(n, -1);
+    IndexType nc = 0;
+    for (IndexType u = 0; u < n; ++u)
+        if (cmap[u] < 0)
+        {
+            cmap[u] = nc;
+            cmap[match[u]] = nc;
+            nc++;
+        }
+    return nc;
+}
+
+template <typename IndexType>
+static void contract_graph(const PartGraph<IndexType> &g, const std::vector<IndexType> &cmap, const IndexType nc, PartGraph<IndexType> &cg)
+{
+    // 每个粗节点的 (至多两个) 细节点
+    std::vector<IndexType> first(nc, -1), second(nc, -1);
+    for (IndexType u = 0; u < g.n; ++u)
+    {
+        if (first[cmap[u]] < 0)
+            first[cmap[u]] = u;
+        else
+            second[cmap[u]] = u;
+    }
+
+    cg.n = nc;
+    cg.xadj.assign(nc + 1, 0);
+    cg.vwgt.assign(nc, 0);
+    cg.adj.clear();
+    cg.ewgt.clear();
+    cg.adj.reserve(g.adj.size());
+    cg.ewgt.reserve(g.adj.size());
+
+    std::vector<IndexType> marker(nc, -1);
+    for (IndexType c = 0; c < nc; ++c)
+    {
+        const IndexType row_start = (IndexType) cg.adj.size();
+        for (IndexType u : {first[c], second[c]})
+        {
+            if (u < 0)
+                continue;
+            cg.vwgt[c] += g.vwgt[u];
+            for (IndexType jj = g.xadj[u]; jj < g.xadj[u + 1]; ++jj)
+            {
+                const IndexType cv = cmap[g.adj[jj]];
+                if (cv == c)
+                    continue;
+                if (marker[cv] < 0)
+                {
+                    marker[cv] = (IndexType) cg.adj.size();
+                    cg.adj.push_back(cv);
+                    cg.ewgt.push_back(g.ewgt[jj]);
+                }
+                else
+                    cg.ewgt[marker[cv]] += g.ewgt[jj];
+            }
+        }
+        for (IndexType jj = row_start; jj < (IndexType) cg.adj.size(); ++jj)
+            marker[cg.adj[jj]] = -1;
+        cg.xadj[c + 1] = (IndexType) cg.adj.size();
+    }
+}
+
+template <typename IndexType>
+static long long bisection_cut(const PartGraph<IndexType> &g, const std::vector<char> &side)
+{
+    long long cut = 0;
+    for (IndexType u = 0; u < g.n; ++u)
+        for (IndexType jj = g.xadj[u]; jj < g.xadj[u + 1]; ++jj)
+            if (side[u] != side[g.adj[jj]])
+                cut += g.ewgt[jj];
+    return cut / 2;
+}
+
+/**
+ * @brief Greedy boundary refinement of a bisection: first restore the balance
+ *        w0 in [min_w0, max_w0], then move boundary vertices with a positive gain
+ *        (or zero gain towards target_w0) while the balance holds.
+ */
+template <typename IndexType>
+static void refine_bisection(const PartGraph<IndexType> &g, std::vector<char> &side, const long long target_w0, const long long min_w0, const long long max_w0)
+{
+    const IndexType n = g.n;
+    long long w0 = 0;
+    for (IndexType u = 0; u < n; ++u)
+        if (side[u] == 0)
+            w0 += g.vwgt[u];
+
+    auto gain_of = [&](const IndexType u){
+        long long ext = 0, in = 0;
+        for (IndexType jj = g.xadj[u]; jj < g.xadj[u + 1]; ++jj)
+            (side[g.adj[jj]] != side[u] ? ext : in) += g.ewgt[jj];
+        return ext - in;
+    };
+
+    std::vector<std::pair<long long, IndexType>> cand;
+    for (int pass = 0; pass < PARTITION_REFINE_PASSES + 1; ++pass)
+    {
+        const bool balance_pass = (w0 < min_w0 || w0 > max_w0);
+        // 平衡阶段从重的一侧移出; 否则考虑所有边界节点
+        const char from = (w0 > max_w0) ? 0 : 1;
+
+        cand.clear();
+        for (IndexType u = 0; u < n; ++u)
+        {
+            if (balance_pass && side[u] != from)
+                continue;
+            bool boundary = false;
+            for (IndexType jj = g.xadj[u]; jj < g.xadj[u + 1] && !boundary; ++jj)
+                boundary = (side[g.adj[jj]] != side[u]);
+            if (boundary || (balance_pass && g.xadj[u] == g.xadj[u + 1]))
+                cand.push_back(std::make_pair(-gain_of(u), u));
+        }
+        if (balance_pass && cand.empty())
+            for (IndexType u = 0; u < n; ++u)
+                if (side[u] == from)
+                    cand.push_back(std::make_pair(-gain_of(u), u));
+        std::sort(cand.begin(), cand.end());
+
+        IndexType moved = 0;
+        for (const auto &c : cand)
+        {
+            const IndexType u = c.second;
+            const long long gain = gain_of(u);
+            const long long new_w0 = (side[u] == 0) ? w0 - g.vwgt[u] : w0 + g.vwgt[u];
+
+            bool accept;
+            if (balance_pass)
+            {
+                if (w0 >= min_w0 && w0 <= max_w0)
+                    break;
+                accept = (side[u] == from) && std::llabs(new_w0 - target_w0) < std::llabs(w0 - target_w0);
+            }
+            else
+            {
+                const bool in_bounds = (new_w0 >= min_w0 && new_w0 <= max_w0);
+                accept = in_bounds && (gain > 0 || (gain == 0 && std::llabs(new_w0 - target_w0) < std::llabs(w0 - target_w0)));
+            }
+            if (accept)
+            {
+                side[u] = 1 - side[u];
+                w0 = new_w0;
+                moved++;
+            }
+        }
+        if (moved == 0 && !balance_pass)
+            break;
+    }
+}
+
+/**
+ * @brief Greedy graph growing: BFS from seed adds vertices to side 0 until
+ *        its weight reaches target_w0 (other components are started when the queue drains).
+ */
+template <typename IndexType>
+static void grow_bisection(const PartGraph<IndexType> &g, const IndexType seed, const long long target_w0, std::vector<char> &side)
+{
+    const IndexType n = g.n;
+    side.assign(n, 1);
+    std::vector<char> queued(n, 0);
+    std::vector<IndexType> queue;
+    queue.reserve(n);
+
+    long long w0 = 0;
+    IndexType next_start = 0;
+    queue.push_back(seed);
+    queued[seed] = 1;
+    size_t head = 0;
+    while (w0 < target_w0)
+    {
+        if (head == queue.size())
+        {
+            while (next_start < n && queued[next_start])
+                next_start++;
+            if (next_start == n)
+                break;
+            queue.push_back(next_start);
+            queued[next_start] = 1;
+        }
+        const IndexType u = queue[head++];
+        side[u] = 0;
+        w0 += g.vwgt[u];
+        for (IndexType jj = g.xadj[u]; jj < g.xadj[u + 1]; ++jj)
+            if (!queued[g.adj[jj]])
+            {
+                queued[g.adj[jj]] = 1;
+                queue.push_back(g.adj[jj]);
+            }
+    }
+}
+
+/**
+ * @brief Multilevel bisection of g, side 0 gets about fraction of the vertex weight
+ */
+template <typename IndexType>
+static void multilevel_bisect(const PartGraph<IndexType> &g, const double fraction, std::vector<char> &side)
+{
+    long long total = 0;
+    for (IndexType u = 0; u < g.n; ++u)
+        total += g.vwgt[u];
+    const long long target_w0 = (long long) (fraction * total);
+    // 重节点使平衡不可达时, 平衡阶段只接受更接近 target_w0 的移动, 停在最接近处
+    const long long slack = std::max((long long) 1, (long long) (PARTITION_IMBALANCE * total));
+    const long long min_w0 = target_w0 - slack, max_w0 = target_w0 + slack;
+
+    // 粗化, deque 在尾部追加时不移动已有元素, cur 始终有效
+    std::deque<PartGraph<IndexType>> levels;
+    std::vector<std::vector<IndexType>> cmaps;
+    const PartGraph<IndexType> *cur = &g;
+    const long long max_vwgt = std::max((long long) 1, (long long) (1.5 * total / PARTITION_COARSEN_TO));
+    while (cur->n > PARTITION_COARSEN_TO)
+    {
+        std::vector<IndexType> cmap;
+        const IndexType nc = heavy_edge_matching(*cur, max_vwgt, cmap);
+        if (nc > 0.95 * cur->n)
+            break;
+        levels.emplace_back();
+        contract_graph(*cur, cmap, nc, levels.back());
+        cmaps.push_back(std::move(cmap));
+        cur = &levels.back();
+    }
+
+    // 最粗图上多次 graph growing, 取割边最小者
+    const IndexType cn = cur->n;
+    std::vector<char> best, trial;
+    long long best_cut = -1;
+    const IndexType seeds[] = {0, cn / 4, cn / 2, (3 * cn) / 4, cn - 1};
+    for (IndexType seed : seeds)
+    {
+        if (cn == 0)
+            break;
+        grow_bisection(*cur, seed, target_w0, trial);
+        refine_bisection(*cur, trial, target_w0, min_w0, max_w0);
+        const long long cut = bisection_cut(*cur, trial);
+        if (best_cut < 0 || cut < best_cut)
+        {
+            best_cut = cut;
+            best = trial;
+        }
+    }
+
+    // 逐层投影并细化
+    for (size_t l = levels.size(); l > 0; --l)
+    {
+        const PartGraph<IndexType> &fine = (l == 1) ? g : levels[l - 2];
+        const std::vector<IndexType> &cmap = cmaps[l - 1];
+        std::vector<char> fine_side(fine.n);
+        for (IndexType u = 0; u < fine.n; ++u)
+            fine_side[u] = best[cmap[u]];
+        refine_bisection(fine, fine_side, target_w0, min_w0, max_w0);
+        best.swap(fine_side);
+    }
+    side.swap(best);
+}
+
+template <typename IndexType>
+static void induced_subgraph(const PartGraph<IndexType> &g, const std::vector<char> &side, const char which,
+                             const std::vector<IndexType> &ids, PartGraph<IndexType> &sub, std::vector<IndexType> &sub_ids)
+{
+    std::vector<IndexType> local(g.n, -1);
+    sub_ids.clear();
+    for (IndexType u = 0; u < g.n; ++u)
+        if (side[u] == which)
+        {
+            local[u] = (IndexType) sub_ids.size();
+            sub_ids.push_back(ids[u]);
+        }
+
+    sub.n = (IndexType) sub_ids.size();
+    sub.xadj.assign(sub.n + 1, 0);
+    sub.vwgt.resize(sub.n);
+    sub.adj.clear();
+    sub.ewgt.clear();
+    for (IndexType u = 0; u < g.n; ++u)
+    {
+        if (side[u] != which)
+            continue;
+        const IndexType lu = local[u];
+        sub.vwgt[lu] = g.vwgt[u];
+        for (IndexType jj = g.xadj[u]; jj < g.xadj[u + 1]; ++jj)
+            if (side[g.adj[jj]] == which)
+            {
+                sub.adj.push_back(local[g.adj[jj]]);
+                sub.ewgt.push_back(g.ewgt[jj]);
+            }
+        sub.xadj[lu + 1] = (IndexType) sub.adj.size();
+    }
+}
+
+// ids 为 g 中节点对应的原矩阵行号, 子问题作为 omp task 并行
+template <typename IndexType>
+static void recursive_bisection(const PartGraph<IndexType> &g, const std::vector<IndexType> &ids, const IndexType nparts, const IndexType part_base, IndexType *part_of)
+{
+    if (nparts <= 1 || g.n == 0)
+    {
+        for (IndexType u = 0; u < g.n; ++u)
+            part_of[ids[u]] = part_base;
+        return;
+    }
+
+    const IndexType k0 = nparts / 2;
+    std::vector<char> side;
+    multilevel_bisect(g, (double) k0 / nparts, side);
+
+    PartGraph<IndexType> *g0 = new PartGraph<IndexType>(), *g1 = new PartGraph<IndexType>();
+    std::vector<IndexType> *ids0 = new std::vector<IndexType>(), *ids1 = new std::vector<IndexType>();
+    induced_subgraph(g, side, (char) 0, ids, *g0, *ids0);
+    induced_subgraph(g, side, (char) 1, ids, *g1, *ids1);
+
+    #pragma omp task shared(part_of) firstprivate(g0, ids0) if(g0->n > 4096)
+    {
+        recursive_bisection(*g0, *ids0, k0, part_base, part_of);
+        delete g0;
+        delete ids0;
+    }
+    #pragma omp task shared(part_of) firstprivate(g1, ids1) if(g1->n > 4096)
+    {
+        recursive_bisection(*g1, *ids1, nparts - k0, part_base + k0, part_of);
+        delete g1;
+        delete ids1;
+    }
+    #pragma omp taskwait
+}
+
+template <typename IndexType, typename ValueType>
+IndexType * reorder_partition(const CSR_Matrix<IndexType, ValueType> &csr, const IndexType nparts, IndexType *partition)
+{
+    const IndexType n = csr.num_rows;
+    const IndexType parts = std::max((IndexType) 1, nparts);
+
+    if (!reorder_square(csr))
+    {
+        // 原序按行数均分
+        if (partition != nullptr)
+            for (IndexType p = 0; p <= parts; ++p)
+                partition[p] = (IndexType) ((long long) n * p / parts);
+        return identity_permutation(n);
+    }
+
+    PartGraph<IndexType> g;
+    g.n = n;
+    build_symmetric_graph(csr, g.xadj, g.adj);
+    g.ewgt.assign(g.adj.size(), 1);
+    g.vwgt.resize(n);
+    for (IndexType i = 0; i < n; ++i)
+        g.vwgt[i] = (long long) (csr.row_offset[i + 1] - csr.row_offset[i]) + 1;
+
+    std::vector<IndexType> ids(n);
+    for (IndexType i = 0; i < n; ++i)
+        ids[i] = i;
+
+    std::vector<IndexType> part_of(n, 0);
+    const int thread_num = Le_get_thread_num();
+    #pragma omp parallel num_threads(thread_num)
+    {
+        #pragma omp single
+        recursive_bisection(g, ids, parts, (IndexType) 0, part_of.data());
+    }
+
+    // 按 part 计数排序, part 内保持原顺序
+    std::vector<IndexType> start(parts + 1, 0);
+    for (IndexType i = 0; i < n; ++i)
+        start[part_of[i] + 1]++;
+    for (IndexType p = 0; p < parts; ++p)
+        start[p + 1] += start[p];
+    if (partition != nullptr)
+        std::copy(start.begin(), start.end(), partition);
+
+    IndexType *perm = new_array<IndexType>(n);
+    CHECK_ALLOC(perm);
+    for (IndexType i = 0; i < n; ++i)
+        perm[start[part_of[i]]++] = i;
+    return perm;
+}
+
+template <typename IndexType, typename ValueType>
+double csr_partition_locality(const CSR_Matrix<IndexType, ValueType> &csr, const IndexType nparts, const IndexType *partition)
+{
+    const int thread_num = Le_get_thread_num();
+    long long local = 0;
+    #pragma omp parallel for num_threads(thread_num) reduction(+:local) schedule(dynamic, 1)
+    for (IndexType p = 0; p < nparts; ++p)
+        for (IndexType i = partition[p]; i < partition[p + 1]; ++i)
+            for (IndexType jj = csr.row_offset[i]; jj < csr.row_offset[i+1]; ++jj)
+                if (csr.col_index[jj] >= partition[p] && csr.col_index[jj] < partition[p + 1])
+                    local++;
+    return (csr.num_nnzs == 0) ? 1.0 : (double) local / csr.num_nnzs;
+}
+
+template <typename IndexType, typename ValueType>
+IndexType * reorder_csr(const CSR_Matrix<IndexType, ValueType> &csr, const ReorderMethod method)
+{
+    if (method != REORDER_NONE && !reorder_square(csr))
+        return identity_permutation(csr.num_rows);
+
+    switch (method)
+    {
+        case REORDER_RCM:
+            return reorder_rcm(csr);
+        case REORDER_DEGREE:
+            return reorder_degree(csr);
+        case REORDER_BANDWIDTH:
+            return reorder_bandwidth(csr);
+        case REORDER_PARTITION:
+            return reorder_partition(csr, (IndexType) Le_get_thread_num(), (IndexType *) nullptr);
+        default:
+            return identity_permutation(csr.num_rows);
+    }
+}
+
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> permute_csr(const CSR_Matrix<IndexType, ValueType> &csr, const IndexType *perm)
+{
+    CHECK_VALUES(csr);
+    const IndexType n = csr.num_rows;
+    const int thread_num = Le_get_thread_num();
+
+    CSR_Matrix<IndexType, ValueType> res;
+    res.num_rows = csr.num_rows;
+    res.num_cols = csr.num_cols;
+    res.num_nnzs = csr.num_nnzs;
+    res.sparsity = csr.sparsity;
+    res.tag = csr.tag;
+    res.kernel_flag = csr.kernel_flag;
+    res.partition = nullptr;
+
+    res.row_offset = new_array<IndexType>(n + 1);
+    res.col_index  = new_array<IndexType>(csr.num_nnzs);
+    res.values     = new_array<ValueType>(csr.num_nnzs);
+    CHECK_ALLOC(res.row_offset);
+    CHECK_ALLOC(res.col_index);
+    CHECK_ALLOC(res.values);
+
+    // 非方阵只置换行
+    IndexType *iperm = identity_permutation(csr.num_cols);
+    if (csr.num_rows == csr.num_cols)
+        for (IndexType k = 0; k < n; ++k)
+            iperm[perm[k]] = k;
+
+    res.row_offset[0] = 0;
+    for (IndexType i = 0; i < n; ++i)
+        res.row_offset[i + 1] = res.row_offset[i] + (csr.row_offset[perm[i] + 1] - csr.row_offset[perm[i]]);
+
+    #pragma omp parallel num_threads(thread_num)
+    {
+        std::vector<std::pair<IndexType, ValueType>> row;
+        #pragma omp for schedule(dynamic, 256)
+        for (IndexType i = 0; i < n; ++i)
+        {
+            const IndexType old = perm[i];
+            row.clear();
+            for (IndexType jj = csr.row_offset[old]; jj < csr.row_offset[old + 1]; ++jj)
+                row.push_back(std::make_pair(iperm[csr.col_index[jj]], csr.values[jj]));
+            std::sort(row.begin(), row.end(), [](const std::pair<IndexType, ValueType> &a, const std::pair<IndexType, ValueType> &b){
+                return a.first < b.first;
+            });
+            IndexType pos = res.row_offset[i];
+            for (const auto &e : row)
+            {
+                res.col_index[pos] = e.first;
+                res.values[pos]    = e.second;
+                pos++;
+            }
+        }
+    }
+    delete_array(iperm);
+    return res;
+}
+
+template <typename IndexType, typename ValueType>
+IndexType csr_bandwidth(const CSR_Matrix<IndexType, ValueType> &csr)
+{
+    const int thread_num = Le_get_thread_num();
+    IndexType bw = 0;
+    #pragma omp parallel for num_threads(thread_num) reduction(max:bw)
+    for (IndexType i = 0; i < csr.num_rows; ++i)
+        for (IndexType jj = csr.row_offset[i]; jj < csr.row_offset[i+1]; ++jj)
+        {
+            const IndexType j = csr.col_index[jj];
+            bw = std::max(bw, (i > j) ? i - j : j - i);
+        }
+    return bw;
+}
+
+template <typename IndexType, typename ValueType>
+Permuted_CSR_Matrix<IndexType, ValueType> csr_to_permuted_csr(const CSR_Matrix<IndexType, ValueType> &csr, const ReorderMethod method)
+{
+    Permuted_CSR_Matrix<IndexType, ValueType> pcsr;
+    pcsr.reorder_method = (csr.num_rows == csr.num_cols) ? method : REORDER_NONE;
+
+    IndexType *partition = nullptr;
+    if (pcsr.reorder_method == REORDER_PARTITION)
+    {
+        partition = new_array<IndexType>(Le_get_thread_num() + 1);
+        CHECK_ALLOC(partition);
+        pcsr.perm = reorder_partition(csr, (IndexType) Le_get_thread_num(), partition);
+    }
+    else
+        pcsr.perm = reorder_csr(csr, method);
+
+    CSR_Matrix<IndexType, ValueType> &base = pcsr;
+    base = permute_csr(csr, pcsr.perm);
+    pcsr.partition = partition;
+    return pcsr;
+}
+
+template <typename IndexType, typename ValueType>
+void permute_vector(const IndexType n, const IndexType *perm, const ValueType *in, ValueType *out)
+{
+    const int thread_num = Le_get_thread_num();
+    #pragma omp parallel for num_threads(thread_num)
+    for (IndexType i = 0; i < n; ++i)
+        out[i] = in[perm[i]];
+}
+
+template <typename IndexType, typename ValueType>
+void unpermute_vector(const IndexType n, const IndexType *perm, const ValueType *in, ValueType *out)
+{
+    const int thread_num = Le_get_thread_num();
+    #pragma omp parallel for num_threads(thread_num)
+    for (IndexType i = 0; i < n; ++i)
+        out[perm[i]] = in[i];
+}
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_permuted_csr(const ValueType alpha, const Permuted_CSR_Matrix<IndexType, ValueType>& pcsr, const ValueType * x, const ValueType beta, ValueType * y)
+{
+    const int thread_num = Le_get_thread_num();
+    const IndexType n = pcsr.num_rows;
+
+    // 置换后的 x, y 取自 arena, pcsr 本身不被修改
+    Le_arena &arena = Le_get_arena(pcsr.arena);
+    arena.reserve_threads(1);
+    Le_arena_scope scope(arena);
+    ValueType *x_perm = arena.alloc_array<ValueType>(pcsr.num_cols);
+    ValueType *y_perm = arena.alloc_array<ValueType>(n);
+
+    if (pcsr.num_rows == pcsr.num_cols)
+    {
+        #pragma omp parallel for num_threads(thread_num)
+        for (IndexType i = 0; i < n; ++i)
+        {
+            x_perm[i] = x[pcsr.perm[i]];
+            y_perm[i] = (beta != 0) ? y[pcsr.perm[i]] : ValueType(0);
+        }
+    }
+    else
+    {
+        // 非方阵只置换了行, x 保持原序
+        memcpy_array(x_perm, x, pcsr.num_cols);
+        if (beta != 0)
+            permute_vector(n, pcsr.perm, (const ValueType *) y, y_perm);
+        else
+            std::fill(y_perm, y_perm + n, ValueType(0));
+    }
+
+    LeSpMV_csr(alpha, (const CSR_Matrix<IndexType, ValueType> &) pcsr, (const ValueType *) x_perm, beta, y_perm);
+
+    unpermute_vector(n, pcsr.perm, (const ValueType *) y_perm, y);
+}
+
+template int * reorder_rcm<int, float>(const CSR_Matrix<int, float> &csr);
+template int * reorder_rcm<int, double>(const CSR_Matrix<int, double> &csr);
+template long long * reorder_rcm<long long, float>(const CSR_Matrix<long long, float> &csr);
+template long long * reorder_rcm<long long, double>(const CSR_Matrix<long long, double> &csr);
+
+template int * reorder_degree<int, float>(const CSR_Matrix<int, float> &csr);
+template int * reorder_degree<int, double>(const CSR_Matrix<int, double> &csr);
+template long long * reorder_degree<long long, float>(const CSR_Matrix<long long, float> &csr);
+template long long * reorder_degree<long long, double>(const CSR_Matrix<long long, double> &csr);
+
+template int * reorder_bandwidth<int, float>(const CSR_Matrix<int, float> &csr);
+template int * reorder_bandwidth<int, double>(const CSR_Matrix<int, double> &csr);
+template long long * reorder_bandwidth<long long, float>(const CSR_Matrix<long long, float> &csr);
+template long long * reorder_bandwidth<long long, double>(const CSR_Matrix<long long, double> &csr);
+
+template int * reorder_csr<int, float>(const CSR_Matrix<int, float> &csr, const ReorderMethod method);
+template int * reorder_csr<int, double>(const CSR_Matrix<int, double> &csr, const ReorderMethod method);
+template long long * reorder_csr<long long, float>(const CSR_Matrix<long long, float> &csr, const ReorderMethod method);
+template long long * reorder_csr<long long, double>(const CSR_Matrix<long long, double> &csr, const ReorderMethod method);
+
+template int * reorder_partition<int, float>(const CSR_Matrix<int, float> &csr, const int nparts, int *partition);
+template int * reorder_partition<int, double>(const CSR_Matrix<int, double> &csr, const int nparts, int *partition);
+template long long * reorder_partition<long long, float>(const CSR_Matrix<long long, float> &csr, const long long nparts, long long *partition);
+template long long * reorder_partition<long long, double>(const CSR_Matrix<long long, double> &csr, const long long nparts, long long *partition);
+
+template double csr_partition_locality<int, float>(const CSR_Matrix<int, float> &csr, const int nparts, const int *partition);
+template double csr_partition_locality<int, double>(const CSR_Matrix<int, double> &csr, const int nparts, const int *partition);
+template double csr_partition_locality<long long, float>(const CSR_Matrix<long long, float> &csr, const long long nparts, const long long *partition);
+template double csr_partition_locality<long long, double>(const CSR_Matrix<long long, double> &csr, const long long nparts, const long long *partition);
+
+template CSR_Matrix<int, float> permute_csr<int, float>(const CSR_Matrix<int, float> &csr, const int *perm);
+template CSR_Matrix<int, double> permute_csr<int, double>(const CSR_Matrix<int, double> &csr, const int *perm);
+template CSR_Matrix<long long, float> permute_csr<long long, float>(const CSR_Matrix<long long, float> &csr, const long long *perm);
+template CSR_Matrix<long long, double> permute_csr<long long, double>(const CSR_Matrix<long long, double> &csr, const long long *perm);
+
+template int csr_bandwidth<int, float>(const CSR_Matrix<int, float> &csr);
+template int csr_bandwidth<int, double>(const CSR_Matrix<int, double> &csr);
+template long long csr_bandwidth<long long, float>(const CSR_Matrix<long long, float> &csr);
+template long long csr_bandwidth<long long, double>(const CSR_Matrix<long long, double> &csr);
+
+template Permuted_CSR_Matrix<int, float> csr_to_permuted_csr<int, float>(const CSR_Matrix<int, float> &csr, const ReorderMethod method);
+template Permuted_CSR_Matrix<int, double> csr_to_permuted_csr<int, double>(const CSR_Matrix<int, double> &csr, const ReorderMethod method);
+template Permuted_CSR_Matrix<long long, float> csr_to_permuted_csr<long long, float>(const CSR_Matrix<long long, float> &csr, const ReorderMethod method);
+template Permuted_CSR_Matrix<long long, double> csr_to_permuted_csr<long long, double>(const CSR_Matrix<long long, double> &csr, const ReorderMethod method);
+
+template void permute_vector<int, float>(const int n, const int *perm, const float *in, float *out);
+template void permute_vector<int, double>(const int n, const int *perm, const double *in, double *out);
+template void permute_vector<long long, float>(const long long n, const long long *perm, const float *in, float *out);
+template void permute_vector<long long, double>(const long long n, const long long *perm, const double *in, double *out);
+
+template void unpermute_vector<int, float>(const int n, const int *perm, const float *in, float *out);
+template void unpermute_vector<int, double>(const int n, const int *perm, const double *in, double *out);
+template void unpermute_vector<long long, float>(const long long n, const long long *perm, const float *in, float *out);
+template void unpermute_vector<long long, double>(const long long n, const long long *perm, const double *in, double *out);
+
+template void LeSpMV_permuted_csr<int, float>(const float, const Permuted_CSR_Matrix<int, float>&, const float*, const float, float*);
+template void LeSpMV_permuted_csr<int, double>(const double, const Permuted_CSR_Matrix<int, double>&, const double*, const double, double*);
+template void LeSpMV_permuted_csr<long long, float>(const float, const Permuted_CSR_Matrix<long long, float>&, const float*, const float, float*);
+template void LeSpMV_permuted_csr<long long, double>(const double, const Permuted_CSR_Matrix<long long, double>&, const double*, const double, double*);
@@ -0,0 +1,140 @@
+/**
+ * @file sparse_update.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief Value-only updates of converted matrices with a fixed sparsity pattern.
+ *        Each update is one parallel pass over the nonzeros, no conversion step is repeated.
+ * @version 0.1
+ * @date 2024-04-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include"../include/LeSpMV.h"
+#include"../include/sparse_update.h"
+#include<algorithm>
+#include<cstdlib>
+
+template <typename IndexType, typename ValueType>
+void update_values(CSR_Matrix<IndexType, ValueType> &csr, const ValueType *csr_vals)
+{
+    CHECK_VALUES(csr);
+    ValueType *values = csr.values;
+    const IndexType nnzs = csr.num_nnzs;
+
+    #pragma omp parallel for schedule(static) num_threads(Le_get_thread_num())
+    for (IndexType jj = 0; jj < nnzs; ++jj)
+        values[jj] = csr_vals[jj];
+}
+
+template <typename IndexType, typename ValueType>
+void update_values(SELL_C_Sigma_Matrix<IndexType, ValueType> &sell_c_sigma, const ValueType *csr_vals)
+{
+    CHECK_VALUES(sell_c_sigma);
+    if (sell_c_sigma.csr_row_offset == nullptr)
+    {
+        fprintf(stderr, "Error: SELL-C-sigma matrix has no csr_row_offset, convert it by csr_to_sell_c_sigma()\n");
+        exit(EXIT_FAILURE);
+    }
+
+    const IndexType C = sell_c_sigma.chunkWidth_C;
+    const IndexType *ro = sell_c_sigma.csr_row_offset;
+
+    // 按 chunk 划分, 同一 chunk 的 C 行由一个线程写, 避免 lane 间的伪共享
+    #pragma omp parallel for schedule(static) num_threads(Le_get_thread_num())
+    for (IndexType chunk = 0; chunk < sell_c_sigma.validchunkNum; ++chunk)
+    {
+        ValueType *chunk_val = sell_c_sigma.chunk_val(chunk);
+        const IndexType row_end = std::min((chunk + 1) * C, sell_c_sigma.num_rows);
+
+        for (IndexType row = chunk * C; row < row_end; ++row)
+        {
+            const IndexType real_rowID = sell_c_sigma.reorder[row];
+            const IndexType row_start  = ro[real_rowID];
+            const IndexType row_len    = ro[real_rowID + 1] - row_start;
+
+            // chunk 内按列存储, 第 j 个元素位于 j * C + lane, 填充位保持为 0
+            ValueType *dst = chunk_val + (row - chunk * C);
+            for (IndexType j = 0; j < row_len; ++j)
+                dst[(size_t) j * C] = csr_vals[row_start + j];
+        }
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void update_values(BSR_Matrix<IndexType, ValueType> &bsr, const ValueType *csr_vals)
+{
+    ValueType *block_data = bsr.block_data;
+    const IndexType nnzs = bsr.num_nnzs;
+
+    // 1x1 块: block_data 与 CSR values 同序
+    if (bsr.blockNNZ == 1)
+    {
+        #pragma omp parallel for schedule(static) num_threads(Le_get_thread_num())
+        for (IndexType jj = 0; jj < nnzs; ++jj)
+            block_data[jj] = csr_vals[jj];
+        return;
+    }
+
+    if (bsr.value_map == nullptr)
+    {
+        fprintf(stderr, "Error: BSR matrix has no value_map, convert it by csr_to_bsr()\n");
+        exit(EXIT_FAILURE);
+    }
+
+    const IndexType *value_map = bsr.value_map;
+    #pragma omp parallel for schedule(static) num_threads(Le_get_thread_num())
+    for (IndexType jj = 0; jj < nnzs; ++jj)
+        block_data[value_map[jj]] = csr_vals[jj];
+}
+
+template <typename IndexType, typename UIndexType, typename ValueType>
+void update_values(CSR5_Matrix<IndexType, UIndexType, ValueType> &csr5, const ValueType *csr_vals)
+{
+    CHECK_VALUES(csr5);
+    const IndexType sigma = csr5.sigma;
+    const IndexType omega = csr5.omega;
+    const size_t tile_size = (size_t) sigma * omega;
+    ValueType *values = csr5.values;
+
+    // 与 aosoa_transpose 相同: 前 _p - 1 个 tile 做列优先转置 (fast track tile 除外), 尾部保持 CSR 顺序
+    const IndexType num_tiles = std::max(csr5._p - 1, (IndexType) 0);
+
+    #pragma omp parallel for schedule(static) num_threads(Le_get_thread_num())
+    for (IndexType par_id = 0; par_id < num_tiles; ++par_id)
+    {
+        const ValueType *src = csr_vals + par_id * tile_size;
+        ValueType *dst = values + par_id * tile_size;
+
+        if (csr5.tile_ptr[par_id] == csr5.tile_ptr[par_id + 1])
+        {
+            std::copy(src, src + tile_size, dst);
+            continue;
+        }
+
+        // CSR 顺序的第 idx 个元素转置到 (idx % sigma) * omega + idx / sigma
+        for (IndexType lane = 0; lane < sigma; ++lane)
+            for (IndexType k = 0; k < omega; ++k)
+                dst[lane * omega + k] = src[k * sigma + lane];
+    }
+
+    for (size_t jj = num_tiles * tile_size; jj < (size_t) csr5.num_nnzs; ++jj)
+        values[jj] = csr_vals[jj];
+}
+
+template void update_values<int, float>(CSR_Matrix<int, float> &csr, const float *csr_vals);
+template void update_values<int, double>(CSR_Matrix<int, double> &csr, const double *csr_vals);
+template void update_values<long long, float>(CSR_Matrix<long long, float> &csr, const float *csr_vals);
+template void update_values<long long, double>(CSR_Matrix<long long, double> &csr, const double *csr_vals);
+
+template void update_values<int, float>(SELL_C_Sigma_Matrix<int, float> &sell_c_sigma, const float *csr_vals);
+template void update_values<int, double>(SELL_C_Sigma_Matrix<int, double> &sell_c_sigma, const double *csr_vals);
+template void update_values<long long, float>(SELL_C_Sigma_Matrix<long long, float> &sell_c_sigma, const float *csr_vals);
+template void update_values<long long, double>(SELL_C_Sigma_Matrix<long long, double> &sell_c_sigma, const double *csr_vals);
+
+template void update_values<int, float>(BSR_Matrix<int, float> &bsr, const float *csr_vals);
+template void update_values<int, double>(BSR_Matrix<int, double> &bsr, const double *csr_vals);
+template void update_values<long long, float>(BSR_Matrix<long long, float> &bsr, const float *csr_vals);
+template void update_values<long long, double>(BSR_Matrix<long long, double> &bsr, const double *csr_vals);
+
+template void update_values<int, uint32_t, float>(CSR5_Matrix<int, uint32_t, float> &csr5, const float *csr_vals);
+template void update_values<int, uint32_t, double>(CSR5_Matrix<int, uint32_t, double> &csr5, const double *csr_vals);
@@ -25,14 +25,19 @@ void __spmv_bsr_serial_simple(  const IndexType num_rows,
                                 const ValueType *values,
                                 const ValueType *x,
                                 const ValueType beta,
-                                ValueType *y)
+                                ValueType *y,
+                                Le_arena &arena)
 {
+    arena.reserve_threads(1);
+    Le_arena_scope scope(arena);
+    ValueType *tmp = arena.alloc_array<ValueType>(blockDimRow);
+
     for (size_t i = 0; i < mb; i++)
     {
         size_t start = row_ptr[i];
         size_t end   = row_ptr[i+1];
 
-        std::vector<ValueType> tmp(blockDimRow,0);
+        std::fill(tmp, tmp + blockDimRow, (ValueType) 0);
 
         for (size_t j = start; j < end; j++)
         {
@@ -76,42 +81,52 @@ void __spmv_bsr_omp_simple( const IndexType num_rows,
                             const ValueType *values,
                             const ValueType *x,
                             const ValueType beta,
-                            ValueType *y)
+                            ValueType *y,
+                            Le_arena &arena)
 {
     const size_t thread_num = Le_get_thread_num();
+    arena.reserve_threads(thread_num);
 
-    #pragma omp parallel for num_threads(thread_num)
-    for (size_t i = 0; i < mb; i++)
+    #pragma omp parallel num_threads(thread_num)
     {
-        size_t start = row_ptr[i];
-        size_t end   = row_ptr[i+1];
+        // 每个线程一份 block 行的累加缓冲, 取自自己的 sub-arena
+        const int tid = Le_get_thread_id();
+        Le_arena_scope scope(arena, tid);
+        ValueType *tmp = arena.alloc_array<ValueType>(blockDimRow, tid);
 
-        std::vector<ValueType> tmp(blockDimRow,0);
-
-        for (size_t j = start; j < end; j++)
+        #pragma omp for
+        for (size_t i = 0; i < mb; i++)
         {
-            // 获取当前块的列索引
-            size_t block_col = col_index[j];
+            size_t start = row_ptr[i];
+            size_t end   = row_ptr[i+1];
 
-            // 执行块与向量的乘法
-            for (size_t br = 0; br < blockDimRow; ++br) {
-                #pragma omp simd
-                for (size_t bc = 0; bc < blockDimCol; ++bc) {
-                    // 计算输入向量x 的索引
-                    size_t x_index = block_col * blockDimCol + bc;
-                    // 累加结果
-                    tmp[br] += values[j * blockDimRow * blockDimCol + br * blockDimCol + bc] * x[x_index];
+            std::fill(tmp, tmp + blockDimRow, (ValueType) 0);
+
+            for (size_t j = start; j < end; j++)
+            {
+                // 获取当前块的列索引
+                size_t block_col = col_index[j];
+
+                // 执行块与向量的乘法
+                for (size_t br = 0; br < blockDimRow; ++br) {
+                    #pragma omp simd
+                    for (size_t bc = 0; bc < blockDimCol; ++bc) {
+                        // 计算输入向量x 的索引
+                        size_t x_index = block_col * blockDimCol + bc;
+                        // 累加结果
+                        tmp[br] += values[j * blockDimRow * blockDimCol + br * blockDimCol + bc] * x[x_index];
+                    }
                 }
             }
-        }
-        // 更新 y
-        for (size_t br = 0; br < blockDimRow; br++)
-        {
-            // 计算输出向量的索引
-            size_t y_index = i * blockDimRow + br;
-            if (y_index < num_rows)
+            // 更新 y
+            for (size_t br = 0; br < blockDimRow; br++)
             {
-                y[y_index] = alpha * tmp[br] + beta * y[y_index];
+                // 计算输出向量的索引
+                size_t y_index = i * blockDimRow + br;
+                if (y_index < num_rows)
+                {
+                    y[y_index] = alpha * tmp[br] + beta * y[y_index];
+                }
             }
         }
     }
@@ -130,13 +145,14 @@ inline void __spmv_bsr_perthread(   const ValueType alpha,
                                     const ValueType beta,
                                     ValueType *y,
                                     const IndexType lrs,
-                                    const IndexType lre)
+                                    const IndexType lre,
+                                    ValueType *tmp)
 {
     // 这里 lrs ~ lre 代表要计算的 row_block 数目
     size_t task_rows = (lre - lrs) * blockDimRow;
 
     // For matC, block_layout is defaulted as row_major
-    std::vector<ValueType> tmp(task_rows,0);
+    std::fill(tmp, tmp + task_rows, (ValueType) 0);
 
     // Only support Rowmajor layout of BSR format
     for (size_t i = lrs, j = 0; i < lre; ++i, ++j)
@@ -192,14 +208,18 @@ void __spmv_bsr_lb_alpha(   const IndexType blockDimRow,
                             const ValueType *x,
                             const ValueType beta,
                             ValueType *y,
-                            IndexType* partition)
+                            const IndexType* partition,
+                            Le_arena &arena)
 {
     const IndexType thread_num = Le_get_thread_num();
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
 
     if(partition == nullptr)
     {
-        partition = new_array<IndexType>(thread_num + 1);
-        balanced_partition_row_by_nnz(row_ptr, mb, thread_num, partition);
+        IndexType *local_partition = arena.alloc_array<IndexType>(thread_num + 1);
+        balanced_partition_row_by_nnz(row_ptr, mb, thread_num, local_partition);
+        partition = local_partition;
     }
 
     #pragma omp parallel num_threads(thread_num)
@@ -207,7 +227,9 @@ void __spmv_bsr_lb_alpha(   const IndexType blockDimRow,
         IndexType tid = Le_get_thread_id();
         IndexType local_m_start = partition[tid];
         IndexType local_m_end   = partition[tid + 1];
-        __spmv_bsr_perthread(alpha, blockDimRow, blockDimCol, mb, num_rows, row_ptr, col_index, values, x, beta, y, local_m_start, local_m_end);
+        Le_arena_scope thread_scope(arena, tid);
+        ValueType *tmp = arena.alloc_array<ValueType>((size_t) (local_m_end - local_m_start) * blockDimRow, tid);
+        __spmv_bsr_perthread(alpha, blockDimRow, blockDimCol, mb, num_rows, row_ptr, col_index, values, x, beta, y, local_m_start, local_m_end, tmp);
     }
 }                            
 
@@ -216,19 +238,19 @@ void LeSpMV_bsr(const ValueType alpha, const BSR_Matrix<IndexType, ValueType>& b
 {
     if ( 0 == bsr.kernel_flag)
     {
-        __spmv_bsr_serial_simple(bsr.num_rows, bsr.blockDim_r, bsr.blockDim_c, bsr.mb, alpha, bsr.row_ptr, bsr.block_colindex, bsr.block_data, x, beta, y);
+        __spmv_bsr_serial_simple(bsr.num_rows, bsr.blockDim_r, bsr.blockDim_c, bsr.mb, alpha, bsr.row_ptr, bsr.block_colindex, bsr.block_data, x, beta, y, Le_get_arena(bsr.arena));
     }
     else if (1 == bsr.kernel_flag)
     {
-        __spmv_bsr_omp_simple(bsr.num_rows, bsr.blockDim_r, bsr.blockDim_c, bsr.mb, alpha, bsr.row_ptr, bsr.block_colindex, bsr.block_data, x, beta, y);
+        __spmv_bsr_omp_simple(bsr.num_rows, bsr.blockDim_r, bsr.blockDim_c, bsr.mb, alpha, bsr.row_ptr, bsr.block_colindex, bsr.block_data, x, beta, y, Le_get_arena(bsr.arena));
     }
     else if(2 == bsr.kernel_flag)
     {
-        __spmv_bsr_lb_alpha(bsr.blockDim_r, bsr.blockDim_c, bsr.mb, bsr.num_rows, alpha, bsr.row_ptr, bsr.block_colindex, bsr.block_data, x, beta, y, bsr.partition);
+        __spmv_bsr_lb_alpha(bsr.blockDim_r, bsr.blockDim_c, bsr.mb, bsr.num_rows, alpha, bsr.row_ptr, bsr.block_colindex, bsr.block_data, x, beta, y, bsr.partition, Le_get_arena(bsr.arena));
     }
     else
     {
-        __spmv_bsr_omp_simple(bsr.num_rows, bsr.blockDim_r, bsr.blockDim_c, bsr.mb, alpha, bsr.row_ptr, bsr.block_colindex, bsr.block_data, x, beta, y);
+        __spmv_bsr_omp_simple(bsr.num_rows, bsr.blockDim_r, bsr.blockDim_c, bsr.mb, alpha, bsr.row_ptr, bsr.block_colindex, bsr.block_data, x, beta, y, Le_get_arena(bsr.arena));
     }
 }
 
@@ -0,0 +1,160 @@
+/**
+ * @file spmv_cbcsr.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  SpMV in column-blocked (x-tiled) CSR format.
+ *         All rows of a panel are swept before the next panel, so the x gathers
+ *         of a panel hit the cache even when the whole x exceeds the LLC.
+ * @version 0.1
+ * @date 2024-03-25
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include"../include/LeSpMV.h"
+
+#include"../include/thread.h"
+
+/**
+ * @brief Panel rows ks to ke: y[row_index[k]] += alpha * (row k of the panel) * x
+ */
+template <typename IndexType, typename ValueType>
+inline void __spmv_cbcsr_perthread( const ValueType alpha,
+                                    const IndexType *row_index,
+                                    const IndexType *row_offset,
+                                    const IndexType *col_index,
+                                    const ValueType *values,
+                                    const ValueType *x,
+                                    ValueType *y,
+                                    const IndexType ks,
+                                    const IndexType ke)
+{
+    for (IndexType k = ks; k < ke; ++k)
+    {
+        ValueType sum = 0;
+        #pragma omp simd reduction(+:sum)
+        for (IndexType jj = row_offset[k]; jj < row_offset[k + 1]; ++jj)
+            sum += values[jj] * x[col_index[jj]];
+        y[row_index[k]] += alpha * sum;
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void __spmv_cbcsr_serial_simple(const IndexType num_rows,
+                                const IndexType num_panel_rows,
+                                const ValueType alpha,
+                                const IndexType *row_index,
+                                const IndexType *row_offset,
+                                const IndexType *col_index,
+                                const ValueType *values,
+                                const ValueType *x,
+                                const ValueType beta, ValueType *y)
+{
+    for (IndexType row = 0; row < num_rows; ++row)
+        y[row] = (beta == 0) ? 0 : beta * y[row];
+
+    // panel 的行在存储上连续, 顺序遍历即逐 panel 扫描
+    __spmv_cbcsr_perthread(alpha, row_index, row_offset, col_index, values, x, y, (IndexType) 0, num_panel_rows);
+}
+
+template <typename IndexType, typename ValueType>
+void __spmv_cbcsr_omp_simple(   const IndexType num_rows,
+                                const IndexType num_panels,
+                                const ValueType alpha,
+                                const IndexType *panel_ptr,
+                                const IndexType *row_index,
+                                const IndexType *row_offset,
+                                const IndexType *col_index,
+                                const ValueType *values,
+                                const ValueType *x,
+                                const ValueType beta, ValueType *y)
+{
+    const IndexType thread_num = Le_get_thread_num();
+
+    #pragma omp parallel num_threads(thread_num)
+    {
+        #pragma omp for
+        for (IndexType row = 0; row < num_rows; ++row)
+            y[row] = (beta == 0) ? 0 : beta * y[row];
+
+        // 同一 panel 内各行互不相同, omp for 结束时的隐式 barrier 隔开不同 panel 对 y 的更新
+        for (IndexType p = 0; p < num_panels; ++p)
+        {
+            #pragma omp for schedule(SCHEDULE_STRATEGY)
+            for (IndexType k = panel_ptr[p]; k < panel_ptr[p + 1]; ++k)
+            {
+                ValueType sum = 0;
+                #pragma omp simd reduction(+:sum)
+                for (IndexType jj = row_offset[k]; jj < row_offset[k + 1]; ++jj)
+                    sum += values[jj] * x[col_index[jj]];
+                y[row_index[k]] += alpha * sum;
+            }
+        }
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void __spmv_cbcsr_omp_lb(   const IndexType num_rows,
+                            const IndexType num_panels,
+                            const ValueType alpha,
+                            const IndexType *panel_ptr,
+                            const IndexType *row_index,
+                            const IndexType *row_offset,
+                            const IndexType *col_index,
+                            const ValueType *values,
+                            const ValueType *x,
+                            const ValueType beta, ValueType *y,
+                            IndexType *partition,
+                            Le_arena &arena)
+{
+    const IndexType thread_num = Le_get_thread_num();
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
+    if (partition == nullptr)
+    {
+        partition = arena.alloc_array<IndexType>(num_panels * (thread_num + 1));
+        balanced_partition_cbcsr(panel_ptr, row_offset, num_panels, thread_num, partition);
+    }
+
+    #pragma omp parallel num_threads(thread_num)
+    {
+        const IndexType tid = Le_get_thread_id();
+
+        #pragma omp for
+        for (IndexType row = 0; row < num_rows; ++row)
+            y[row] = (beta == 0) ? 0 : beta * y[row];
+
+        for (IndexType p = 0; p < num_panels; ++p)
+        {
+            const IndexType *part = partition + p * (thread_num + 1);
+            __spmv_cbcsr_perthread(alpha, row_index, row_offset, col_index, values, x, y, part[tid], part[tid + 1]);
+            #pragma omp barrier
+        }
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_cbcsr(const ValueType alpha, const CBCSR_Matrix<IndexType, ValueType>& cbcsr, const ValueType * x, const ValueType beta, ValueType * y)
+{
+    if (0 == cbcsr.kernel_flag)
+    {
+        __spmv_cbcsr_serial_simple(cbcsr.num_rows, cbcsr.num_panel_rows, alpha, cbcsr.row_index, cbcsr.row_offset, cbcsr.col_index, cbcsr.values, x, beta, y);
+    }
+    else if (2 == cbcsr.kernel_flag)
+    {
+        __spmv_cbcsr_omp_lb(cbcsr.num_rows, cbcsr.num_panels, alpha, cbcsr.panel_ptr, cbcsr.row_index, cbcsr.row_offset, cbcsr.col_index, cbcsr.values, x, beta, y, cbcsr.partition, Le_get_arena(cbcsr.arena));
+    }
+    else
+    {
+        // DEFAULT: omp simple implementation
+        __spmv_cbcsr_omp_simple(cbcsr.num_rows, cbcsr.num_panels, alpha, cbcsr.panel_ptr, cbcsr.row_index, cbcsr.row_offset, cbcsr.col_index, cbcsr.values, x, beta, y);
+    }
+}
+
+template void LeSpMV_cbcsr<int, float>(const float, const CBCSR_Matrix<int, float>&, const float* , const float, float*);
+
+template void LeSpMV_cbcsr<int, double>(const double, const CBCSR_Matrix<int, double>&, const double* , const double, double*);
+
+template void LeSpMV_cbcsr<long long, float>(const float, const CBCSR_Matrix<long long, float>&, const float* , const float, float*);
+
+template void LeSpMV_cbcsr<long long, double>(const double, const CBCSR_Matrix<long long, double>&, const double* , const double, double*);
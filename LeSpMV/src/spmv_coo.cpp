@@ -33,63 +33,91 @@ void __spmv_coo_serial_simple(  const IndexType num_rows,
     }
 }
 
-//直接 omp 并行
+/**
+ * @brief y[rs, re) = beta * y[rs, re), rows without nonzeros
+ */
 template <typename IndexType, typename ValueType>
-void __spmv_coo_omp_simple (const IndexType num_rows,
+static inline void __spmv_coo_scale_rows(const ValueType beta, ValueType * y, const IndexType rs, const IndexType re)
+{
+    if (beta == 0)
+        for (IndexType row = rs; row < re; ++row)
+            y[row] = 0;
+    else if (beta != 1)
+        for (IndexType row = rs; row < re; ++row)
+            y[row] *= beta;
+}
+
+// 按 nnz 均分, 要求 Ai 按行有序 (sort_coo_by_row)
+// 每个线程在寄存器里累加行段的和, 行起始于本线程的段直接写 y = beta * y + alpha * sum,
+// 从上一个线程延续过来的第一个行段存入 carry, 并行区结束后串行补加
+template <typename IndexType, typename ValueType>
+void __spmv_coo_omp_lb (    const IndexType num_rows,
                             const IndexType num_nnzs, 
                             const ValueType alpha, 
                             const IndexType *Ai,
                             const IndexType *Aj,
                             const ValueType *Ax,
                             const ValueType * x, 
-                            const ValueType beta, ValueType * y)
+                            const ValueType beta, ValueType * y,
+                            Le_arena &arena)
 {
     const IndexType thread_num = Le_get_thread_num();
-    if (beta){
-        // #pragma omp parallel for schedule(static) num_threads(thread_num)
-        #pragma omp parallel for num_threads(thread_num)
-        for (IndexType i = 0; i < num_rows; ++i) {
-            y[i] *= beta;
-        }
+    if (num_nnzs == 0)
+    {
+        __spmv_coo_scale_rows(beta, y, (IndexType) 0, num_rows);
+        return;
     }
 
-    if ( 1 == alpha)
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
+    IndexType * carry_row = arena.alloc_array<IndexType>(thread_num);
+    ValueType * carry_val = arena.alloc_array<ValueType>(thread_num);
+
+    #pragma omp parallel num_threads(thread_num)
     {
-        // omp automatic parallel but not using SIMD
-        // #pragma omp parallel for schedule(static) num_threads(thread_num)
-        #pragma omp parallel for num_threads(thread_num)
-        for (IndexType i = 0; i < num_nnzs; ++i) {
-            // OpenMP的reduction机制确保线程安全地更新y向量
-            #pragma omp atomic
-            y[Ai[i]] += Ax[i] * x[Aj[i]];
-        }
-    }
-    else{
-        // omp automatic parallel but not using SIMD
-        // #pragma omp parallel for schedule(static) num_threads(thread_num)
-        #pragma omp parallel for num_threads(thread_num)
-        for (IndexType i = 0; i < num_nnzs; ++i) {
-            // OpenMP的reduction机制确保线程安全地更新y向量
-            #pragma omp atomic
-            y[Ai[i]] += alpha * Ax[i] * x[Aj[i]];
+        const IndexType tid = Le_get_thread_id();
+        const IndexType start = (IndexType) ((long long) num_nnzs * tid / thread_num);
+        const IndexType end   = (IndexType) ((long long) num_nnzs * (tid + 1) / thread_num);
+        carry_row[tid] = -1;
+
+        if (start < end)
+        {
+            // 上一个线程最后的行, 两者之间的空行由本线程缩放
+            const IndexType prev_row = (start == 0) ? -1 : Ai[start - 1];
+            IndexType last_row = prev_row;
+            IndexType i = start;
+            while (i < end)
+            {
+                const IndexType row = Ai[i];
+                ValueType sum = 0;
+                for (; i < end && Ai[i] == row; ++i)
+                    sum += Ax[i] * x[Aj[i]];
+
+                if (row == prev_row)
+                {
+                    carry_row[tid] = row;
+                    carry_val[tid] = alpha * sum;
+                }
+                else
+                {
+                    __spmv_coo_scale_rows(beta, y, last_row + 1, row);
+                    y[row] = (beta == 0 ? 0 : beta * y[row]) + alpha * sum;
+                }
+                last_row = row;
+            }
+            if (end == num_nnzs)
+                __spmv_coo_scale_rows(beta, y, last_row + 1, num_rows);
         }
     }
-}
 
-template <typename IndexType, typename ValueType>
-void __spmv_coo_omp_lb (    const IndexType num_rows,
-                            const IndexType num_nnzs, 
-                            const ValueType alpha, 
-                            const IndexType *Ai,
-                            const IndexType *Aj,
-                            const ValueType *Ax,
-                            const ValueType * x, 
-                            const ValueType beta, ValueType * y)
-{
-    // omp is enough for nnz load balanced
+    // 跨线程的行: 同一行可能被多个线程延续, 串行补加无冲突
+    for (IndexType t = 0; t < thread_num; ++t)
+        if (carry_row[t] >= 0)
+            y[carry_row[t]] += carry_val[t];
 }
 
 //openmp load balanced in alphasparse
+// 每个线程在自己的 sub-arena 上放一份 y 的拷贝, 同一并行区内归约
 template <typename IndexType, typename ValueType>
 void __spmv_coo_omp_alpha (    const IndexType num_rows,
                             const IndexType num_nnzs, 
@@ -98,60 +126,63 @@ void __spmv_coo_omp_alpha (    const IndexType num_rows,
                             const IndexType *Aj,
                             const ValueType *Ax,
                             const ValueType * x, 
-                            const ValueType beta, ValueType * y)
+                            const ValueType beta, ValueType * y,
+                            Le_arena &arena)
 {
     // or CPU_SOCKET * CPU_CORES_PER_SOC * CPU_HYPER_THREAD
     const IndexType thread_num = Le_get_thread_num();
-    ValueType **tmp = (ValueType **)malloc(thread_num*sizeof(ValueType *));
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
+    ValueType **tmp = arena.alloc_array<ValueType *>(thread_num);
 
-    #pragma omp parallel for num_threads(thread_num)
-    for (IndexType i = 0; i < thread_num; i++)
+    #pragma omp parallel num_threads(thread_num)
     {
-        tmp[i] = (ValueType *)malloc(num_rows * sizeof(ValueType));
-        memset(tmp[i], 0 , num_rows * sizeof(ValueType));
-    }
+        const IndexType threadId = Le_get_thread_id();
+        Le_arena_scope thread_scope(arena, threadId);
+        tmp[threadId] = arena.alloc_array<ValueType>(num_rows, threadId);
+        memset(tmp[threadId], 0 , num_rows * sizeof(ValueType));
+        #pragma omp barrier
 
 // 计算 alpha * A * x
-    if ( 1 == alpha){
-        #pragma omp parallel for num_threads(thread_num)
-        for (IndexType i = 0; i < num_nnzs; i++)
-        {
-            const IndexType threadId = Le_get_thread_id();
-            const IndexType rowId = Ai[i];
-            const IndexType colId = Aj[i];
-            ValueType v;
-            // alpha_mul(v, A->values[i], x[c]);
-            v = Ax[i] * x[colId];
-            // alpha_madde(tmp[threadId][rowId], alpha, v);
-            // #pragma omp atomic
-            tmp[threadId][rowId] += v;
+        if ( 1 == alpha){
+            #pragma omp for
+            for (IndexType i = 0; i < num_nnzs; i++)
+            {
+                const IndexType rowId = Ai[i];
+                const IndexType colId = Aj[i];
+                ValueType v;
+                // alpha_mul(v, A->values[i], x[c]);
+                v = Ax[i] * x[colId];
+                // alpha_madde(tmp[threadId][rowId], alpha, v);
+                // #pragma omp atomic
+                tmp[threadId][rowId] += v;
+            }
         }
-    }
-    else{
-        #pragma omp parallel for num_threads(thread_num)
-        for (IndexType i = 0; i < num_nnzs; i++)
-        {
-            const IndexType threadId = Le_get_thread_id();
-            const IndexType rowId = Ai[i];
-            const IndexType colId = Aj[i];
-            ValueType v;
-            // alpha_mul(v, A->values[i], x[c]);
-            v = Ax[i] * x[colId];
-            // alpha_madde(tmp[threadId][rowId], alpha, v);
-            // #pragma omp atomic
-            tmp[threadId][rowId] += alpha*v;
+        else{
+            #pragma omp for
+            for (IndexType i = 0; i < num_nnzs; i++)
+            {
+                const IndexType rowId = Ai[i];
+                const IndexType colId = Aj[i];
+                ValueType v;
+                // alpha_mul(v, A->values[i], x[c]);
+                v = Ax[i] * x[colId];
+                // alpha_madde(tmp[threadId][rowId], alpha, v);
+                // #pragma omp atomic
+                tmp[threadId][rowId] += alpha*v;
+            }
         }
-    }
 
-// 计算beta
-    #pragma omp parallel for num_threads(thread_num)
-    for (IndexType i = 0; i < num_rows; ++i)
-	{
-        y[i] = beta * y[i];
-        for (IndexType j = 0; j < thread_num; ++j)
-		{
-            // alpha_add(y[i], y[i], tmp[j][i]);
-            y[i] = y[i] + tmp[j][i];
+// 计算beta, omp for 结束的 barrier 之后各线程才释放自己的拷贝
+        #pragma omp for
+        for (IndexType i = 0; i < num_rows; ++i)
+        {
+            y[i] = beta * y[i];
+            for (IndexType j = 0; j < thread_num; ++j)
+            {
+                // alpha_add(y[i], y[i], tmp[j][i]);
+                y[i] = y[i] + tmp[j][i];
+            }
         }
     }
 }
@@ -163,21 +194,13 @@ void LeSpMV_coo(const ValueType alpha, const COO_Matrix<IndexType, ValueType>& c
     if (0 == coo.kernel_flag){
         __spmv_coo_serial_simple(coo.num_rows, coo.num_nnzs, alpha, coo.row_index, coo.col_index, coo.values, x, beta, y);
     }
-    else if (1 == coo.kernel_flag){
-        __spmv_coo_omp_simple(coo.num_rows, coo.num_nnzs, alpha, coo.row_index, coo.col_index, coo.values, x, beta, y);
+    else if (3 == coo.kernel_flag || !coo.row_sorted){
+        // 每线程一份 y 的拷贝, 与三元组的顺序无关 (手工构造、未按行排序的 COO)
+        __spmv_coo_omp_alpha(coo.num_rows, coo.num_nnzs, alpha, coo.row_index, coo.col_index, coo.values, x, beta, y, Le_get_arena(coo.arena));
     }
-    else if (2 == coo.kernel_flag){
-    
-        __spmv_coo_omp_lb(coo.num_rows, coo.num_nnzs, alpha, coo.row_index, coo.col_index, coo.values, x, beta, y);
-    }
-    else if (3 == coo.kernel_flag){
-    
-        __spmv_coo_omp_alpha(coo.num_rows, coo.num_nnzs, alpha, coo.row_index, coo.col_index, coo.values, x, beta, y);
-    }
-    else
-    {
-        // DEFAULT: omp simple implementation
-        __spmv_coo_omp_simple(coo.num_rows, coo.num_nnzs, alpha, coo.row_index, coo.col_index, coo.values, x, beta, y);
+    else{
+        // DEFAULT (kernel_flag 1 / 2): 按 nnz 均分, 跨线程的行经 carry 补加, 无 atomic
+        __spmv_coo_omp_lb(coo.num_rows, coo.num_nnzs, alpha, coo.row_index, coo.col_index, coo.values, x, beta, y, Le_get_arena(coo.arena));
     }
 }
 
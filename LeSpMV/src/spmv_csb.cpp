@@ -0,0 +1,224 @@
+/**
+ * @file spmv_csb.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  SpMV in Compressed Sparse Blocks format.
+ *         Parallel over block rows; dense block rows are split recursively into
+ *         block ranges (with a temporary y segment) and a dense block into row halves.
+ * @version 0.1
+ * @date 2024-03-27
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include"../include/LeSpMV.h"
+
+#include"../include/thread.h"
+
+/**
+ * @brief y_seg += alpha * (blocks bs to be of one block row) * x, nnzs ks to ke of
+ *        the blocks only (ks / ke inside [blk_ptr[bs], blk_ptr[be]]).
+ */
+template <typename IndexType, typename ValueType>
+inline void __spmv_csb_blocks(  const CSB_Matrix<IndexType, ValueType>& csb,
+                                const ValueType alpha,
+                                const ValueType *x,
+                                ValueType *y_seg,
+                                const IndexType bs,
+                                const IndexType be,
+                                const IndexType ks,
+                                const IndexType ke)
+{
+    const IndexType nbc = csb.nbc;
+    for (IndexType b = bs; b < be; ++b)
+    {
+        const ValueType *x_seg = x + ((b % nbc) << csb.log_beta);
+        const IndexType k_start = std::max(ks, csb.blk_ptr[b]);
+        const IndexType k_end   = std::min(ke, csb.blk_ptr[b + 1]);
+        for (IndexType k = k_start; k < k_end; ++k)
+            y_seg[csb.rloc[k]] += alpha * csb.values[k] * x_seg[csb.cloc[k]];
+    }
+}
+
+template <typename IndexType, typename ValueType>
+inline void __spmv_csb_scale_y(const ValueType beta, ValueType *y, const IndexType rs, const IndexType re)
+{
+    if (beta == 0)
+        std::fill(y + rs, y + re, ValueType(0));
+    else if (beta != 1)
+        for (IndexType row = rs; row < re; ++row)
+            y[row] *= beta;
+}
+
+/**
+ * @brief One dense block: nnzs ks to ke are split at a row boundary, the two
+ *        halves write different rows of y_seg and run as tasks.
+ */
+template <typename IndexType, typename ValueType>
+static void __spmv_csb_block_recursive( const CSB_Matrix<IndexType, ValueType>& csb,
+                                        const ValueType alpha,
+                                        const ValueType *x,
+                                        ValueType *y_seg,
+                                        const IndexType b,
+                                        const IndexType ks,
+                                        const IndexType ke,
+                                        const IndexType threshold)
+{
+    if (ke - ks <= threshold)
+    {
+        __spmv_csb_blocks(csb, alpha, x, y_seg, b, b + 1, ks, ke);
+        return;
+    }
+    // 中点移到行边界, block 内按行有序
+    IndexType mid = ks + (ke - ks) / 2;
+    const uint16_t mid_row = csb.rloc[mid];
+    mid = (IndexType) (std::lower_bound(csb.rloc + ks, csb.rloc + ke, mid_row) - csb.rloc);
+    if (mid == ks)
+        mid = (IndexType) (std::upper_bound(csb.rloc + ks, csb.rloc + ke, mid_row) - csb.rloc);
+    if (mid == ke)
+    {
+        // 单行, 无法再按行切分
+        __spmv_csb_blocks(csb, alpha, x, y_seg, b, b + 1, ks, ke);
+        return;
+    }
+
+    #pragma omp task shared(csb, x, y_seg)
+    __spmv_csb_block_recursive(csb, alpha, x, y_seg, b, ks, mid, threshold);
+    __spmv_csb_block_recursive(csb, alpha, x, y_seg, b, mid, ke, threshold);
+    #pragma omp taskwait
+}
+
+/**
+ * @brief Blocks bs to be of a block row: split at the nnz median into two block
+ *        ranges, the second one accumulates into a temporary y segment that is added
+ *        after both tasks finish.
+ */
+template <typename IndexType, typename ValueType>
+static void __spmv_csb_blockrow_recursive(  const CSB_Matrix<IndexType, ValueType>& csb,
+                                            const ValueType alpha,
+                                            const ValueType *x,
+                                            ValueType *y_seg,
+                                            const IndexType seg_len,
+                                            const IndexType bs,
+                                            const IndexType be,
+                                            const IndexType threshold,
+                                            Le_arena &arena)
+{
+    const IndexType ks = csb.blk_ptr[bs];
+    const IndexType ke = csb.blk_ptr[be];
+    if (ke - ks <= threshold)
+    {
+        __spmv_csb_blocks(csb, alpha, x, y_seg, bs, be, ks, ke);
+        return;
+    }
+    if (be - bs == 1)
+    {
+        __spmv_csb_block_recursive(csb, alpha, x, y_seg, bs, ks, ke, threshold);
+        return;
+    }
+
+    IndexType bm = (IndexType) (std::upper_bound(csb.blk_ptr + bs, csb.blk_ptr + be, ks + (ke - ks) / 2) - csb.blk_ptr) - 1;
+    bm = std::min(std::max(bm, bs + 1), be - 1);
+
+    // tied task 在 taskwait 期间只会执行自己的后代任务, sub-arena 的作用域保持 LIFO
+    const int tid = Le_get_thread_id();
+    Le_arena_scope scope(arena, tid);
+    ValueType *y_tmp = arena.alloc_array<ValueType>(seg_len, tid);
+    std::fill(y_tmp, y_tmp + seg_len, ValueType(0));
+
+    #pragma omp task shared(csb, x, y_seg, arena)
+    __spmv_csb_blockrow_recursive(csb, alpha, x, y_seg, seg_len, bs, bm, threshold, arena);
+    __spmv_csb_blockrow_recursive(csb, alpha, x, y_tmp, seg_len, bm, be, threshold, arena);
+    #pragma omp taskwait
+
+    #pragma omp simd
+    for (IndexType i = 0; i < seg_len; ++i)
+        y_seg[i] += y_tmp[i];
+}
+
+template <typename IndexType, typename ValueType>
+void __spmv_csb_serial_simple(  const CSB_Matrix<IndexType, ValueType>& csb,
+                                const ValueType alpha,
+                                const ValueType *x,
+                                const ValueType beta, ValueType *y)
+{
+    __spmv_csb_scale_y(beta, y, (IndexType) 0, csb.num_rows);
+    for (IndexType br = 0; br < csb.nbr; ++br)
+    {
+        const IndexType bs = br * csb.nbc;
+        __spmv_csb_blocks(csb, alpha, x, y + (br << csb.log_beta), bs, bs + csb.nbc, csb.blk_ptr[bs], csb.blk_ptr[bs + csb.nbc]);
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void __spmv_csb_omp_simple( const CSB_Matrix<IndexType, ValueType>& csb,
+                            const ValueType alpha,
+                            const ValueType *x,
+                            const ValueType beta, ValueType *y)
+{
+    const IndexType thread_num = Le_get_thread_num();
+
+    #pragma omp parallel for num_threads(thread_num) schedule(dynamic, 1)
+    for (IndexType br = 0; br < csb.nbr; ++br)
+    {
+        const IndexType rs = br << csb.log_beta;
+        const IndexType re = std::min(csb.num_rows, rs + csb.beta);
+        __spmv_csb_scale_y(beta, y, rs, re);
+
+        const IndexType bs = br * csb.nbc;
+        __spmv_csb_blocks(csb, alpha, x, y + rs, bs, bs + csb.nbc, csb.blk_ptr[bs], csb.blk_ptr[bs + csb.nbc]);
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void __spmv_csb_omp_lb( const CSB_Matrix<IndexType, ValueType>& csb,
+                        const ValueType alpha,
+                        const ValueType *x,
+                        const ValueType beta, ValueType *y)
+{
+    const IndexType thread_num = Le_get_thread_num();
+    const IndexType threshold  = std::max((IndexType) CSB_MIN_TASK_NNZ, csb.num_nnzs / (CSB_TASKS_PER_THREAD * thread_num));
+    // 在调用线程上确定 arena, 任务里的 Le_thread_arena() 属于工作线程
+    Le_arena &arena = Le_get_arena(csb.arena);
+    arena.reserve_threads(thread_num);
+
+    #pragma omp parallel num_threads(thread_num)
+    {
+        #pragma omp for schedule(dynamic, 1)
+        for (IndexType br = 0; br < csb.nbr; ++br)
+        {
+            const IndexType rs = br << csb.log_beta;
+            const IndexType re = std::min(csb.num_rows, rs + csb.beta);
+            __spmv_csb_scale_y(beta, y, rs, re);
+
+            const IndexType bs = br * csb.nbc;
+            __spmv_csb_blockrow_recursive(csb, alpha, x, y + rs, re - rs, bs, bs + csb.nbc, threshold, arena);
+        }
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_csb(const ValueType alpha, const CSB_Matrix<IndexType, ValueType>& csb, const ValueType * x, const ValueType beta, ValueType * y)
+{
+    if (0 == csb.kernel_flag)
+    {
+        __spmv_csb_serial_simple(csb, alpha, x, beta, y);
+    }
+    else if (2 == csb.kernel_flag)
+    {
+        __spmv_csb_omp_lb(csb, alpha, x, beta, y);
+    }
+    else
+    {
+        // DEFAULT: omp simple implementation
+        __spmv_csb_omp_simple(csb, alpha, x, beta, y);
+    }
+}
+
+template void LeSpMV_csb<int, float>(const float, const CSB_Matrix<int, float>&, const float* , const float, float*);
+
+template void LeSpMV_csb<int, double>(const double, const CSB_Matrix<int, double>&, const double* , const double, double*);
+
+template void LeSpMV_csb<long long, float>(const float, const CSB_Matrix<long long, float>&, const float* , const float, float*);
+
+template void LeSpMV_csb<long long, double>(const double, const CSB_Matrix<long long, double>&, const double* , const double, double*);
@@ -23,18 +23,19 @@
  * @param alpha 
  * @param Ap 
  * @param Aj 
- * @param Ax 
+ * @param Ax  values, Pattern_Values for a pattern-only matrix, Indexed_Values (CSR-VI)
+ *            or Quantized_Values (FP16 / BF16 / int8 with row scales)
  * @param x 
  * @param beta 
  * @param y 
  * @param lrs 
  * @param lre 
  */
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 inline void  __spmv_csr_perthread(  const ValueType alpha, 
                                     const IndexType *Ap,
                                     const IndexType *Aj,
-                                    const ValueType *Ax,
+                                    const ValueArray Ax,
                                     const ValueType * x, 
                                     const ValueType beta, ValueType * y,
                                     const IndexType lrs,
@@ -51,6 +52,8 @@ inline void  __spmv_csr_perthread(  const ValueType alpha,
         for (IndexType col_id = pks; col_id < pke; ++col_id) {
             sum += Ax[col_id] * x[Aj[col_id]];
         }
+        // 量化数值的行缩放因子, 其他存储方式为 1
+        sum *= value_row_scale(Ax, (size_t) row);
         // 更新y向量
         if ( alpha == 1 && beta ==0){
             y[row] = sum;
@@ -61,12 +64,12 @@ inline void  __spmv_csr_perthread(  const ValueType alpha,
     }
 }
 
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 void __spmv_csr_serial_simple(  const IndexType num_rows, 
                                 const ValueType alpha, 
                                 const IndexType *Ap,
                                 const IndexType *Aj,
-                                const ValueType *Ax,
+                                const ValueArray Ax,
                                 const ValueType * x, 
                                 const ValueType beta, ValueType * y)
 {
@@ -79,6 +82,8 @@ void __spmv_csr_serial_simple(  const IndexType num_rows,
         for (IndexType jj = row_start; jj < row_end; ++jj) {
             sum += Ax[jj] * x[Aj[jj]];
         }
+        // 量化数值的行缩放因子, 其他存储方式为 1
+        sum *= value_row_scale(Ax, (size_t) row);
         // 更新y向量
         if ( alpha == 1 && beta ==0){
             y[row] = sum;
@@ -90,12 +95,12 @@ void __spmv_csr_serial_simple(  const IndexType num_rows,
 }
 
 
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 void __spmv_csr_omp_simple (const IndexType num_rows, 
                             const ValueType alpha, 
                             const IndexType *Ap,
                             const IndexType *Aj,
-                            const ValueType *Ax,
+                            const ValueArray Ax,
                             const ValueType * x, 
                             const ValueType beta, ValueType * y)
 {
@@ -115,6 +120,8 @@ void __spmv_csr_omp_simple (const IndexType num_rows,
             sum += Ax[jj] * x[Aj[jj]];
         }
 
+        // 量化数值的行缩放因子, 其他存储方式为 1
+        sum *= value_row_scale(Ax, (size_t) row);
         // 更新y向量
         y[row] = alpha * sum + beta * y[row];
     } 
@@ -134,21 +141,24 @@ void __spmv_csr_omp_simple (const IndexType num_rows,
  * @param beta 
  * @param y 
  */
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 void __spmv_csr_omp_lb (const IndexType num_rows, 
                         const ValueType alpha, 
                         const IndexType *Ap,
                         const IndexType *Aj,
-                        const ValueType *Ax,
+                        const ValueArray Ax,
                         const ValueType * x, 
                         const ValueType beta, ValueType * y,
-                        IndexType* partition)
+                        IndexType* partition,
+                        Le_arena &arena)
 {
     const IndexType thread_num = Le_get_thread_num();
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
     // IndexType partition[thread_num + 1];
     if(partition == nullptr)
     {
-        partition = new_array<IndexType>(thread_num + 1);
+        partition = arena.alloc_array<IndexType>(thread_num + 1);
         balanced_partition_row_by_nnz(Ap, num_rows, thread_num, partition);
     }
 
@@ -161,26 +171,56 @@ void __spmv_csr_omp_lb (const IndexType num_rows,
     }
 }
 
-template <typename IndexType, typename ValueType>
-void LeSpMV_csr(const ValueType alpha, const CSR_Matrix<IndexType, ValueType>& csr, const ValueType * x, const ValueType beta, ValueType * y)
+template <typename IndexType, typename ValueType, typename ValueArray>
+void __spmv_csr(const ValueType alpha, const CSR_Matrix<IndexType, ValueType>& csr, const ValueArray Ax, const ValueType * x, const ValueType beta, ValueType * y)
 {
     if (0 == csr.kernel_flag)
     {
         // call the simple serial implementation of CSR SpMV
-        __spmv_csr_serial_simple(csr.num_rows, alpha, csr.row_offset, csr.col_index, csr.values, x, beta, y);
+        __spmv_csr_serial_simple(csr.num_rows, alpha, csr.row_offset, csr.col_index, Ax, x, beta, y);
     }
     else if (1 == csr.kernel_flag){
         // call the simple OMP implementation of CSR SpMV.
-        __spmv_csr_omp_simple(csr.num_rows, alpha, csr.row_offset, csr.col_index, csr.values, x, beta, y);
+        __spmv_csr_omp_simple(csr.num_rows, alpha, csr.row_offset, csr.col_index, Ax, x, beta, y);
     }
     else if (2 == csr.kernel_flag)
     {
         // Call the load balanced by nnzs of rows of CSR SpMV
-        __spmv_csr_omp_lb(csr.num_rows, alpha, csr.row_offset, csr.col_index, csr.values, x, beta, y, csr.partition);
+        __spmv_csr_omp_lb(csr.num_rows, alpha, csr.row_offset, csr.col_index, Ax, x, beta, y, csr.partition, Le_get_arena(csr.arena));
     }
     else{
         // DEFAULT: omp simple implementation
-        __spmv_csr_omp_simple(csr.num_rows, alpha, csr.row_offset, csr.col_index, csr.values, x, beta, y);
+        __spmv_csr_omp_simple(csr.num_rows, alpha, csr.row_offset, csr.col_index, Ax, x, beta, y);
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_csr(const ValueType alpha, const CSR_Matrix<IndexType, ValueType>& csr, const ValueType * x, const ValueType beta, ValueType * y)
+{
+    // pattern-only: 每行只累加 x[col], alpha 在行末乘一次; 值编号压缩: 按编号查值表;
+    // 量化数值: 编码在寄存器中解码, 行缩放因子在行末乘一次
+    switch (csr.value_storage)
+    {
+        case PatternValues:
+            __spmv_csr(alpha, csr, Pattern_Values<ValueType>(), x, beta, y);
+            break;
+        case IndexedValues8:
+            __spmv_csr(alpha, csr, Indexed_Values<ValueType, uint8_t>{csr.value_table, (const uint8_t *) csr.packed_values}, x, beta, y);
+            break;
+        case IndexedValues16:
+            __spmv_csr(alpha, csr, Indexed_Values<ValueType, uint16_t>{csr.value_table, (const uint16_t *) csr.packed_values}, x, beta, y);
+            break;
+        case HalfValues:
+            __spmv_csr(alpha, csr, Quantized_Values<ValueType, Le_half>{(const Le_half *) csr.packed_values, csr.value_scale, (size_t) csr.scale_rows}, x, beta, y);
+            break;
+        case BFloat16Values:
+            __spmv_csr(alpha, csr, Quantized_Values<ValueType, Le_bfloat16>{(const Le_bfloat16 *) csr.packed_values, csr.value_scale, (size_t) csr.scale_rows}, x, beta, y);
+            break;
+        case Int8Values:
+            __spmv_csr(alpha, csr, Quantized_Values<ValueType, int8_t>{(const int8_t *) csr.packed_values, csr.value_scale, (size_t) csr.scale_rows}, x, beta, y);
+            break;
+        default:
+            __spmv_csr(alpha, csr, (const ValueType *) csr.values, x, beta, y);
     }
 }
 
@@ -54,7 +54,7 @@ inline __m512d hscan_avx512(__m512d scan512d, __m512d zero512d)
     return scan512d;
 }
 
-template<typename iT, typename vT>
+template<bool Pattern, typename iT, typename vT>
 void partition_fast_track(const vT           *d_value_partition,
                                  const vT           *d_x,
                                  const iT           *d_column_index_partition,
@@ -79,7 +79,6 @@ void partition_fast_track(const vT           *d_value_partition,
     #pragma unroll(CSR5_SIGMA)
     for (int i = 0; i < CSR5_SIGMA; i++)
     {
-        value512d = _mm512_load_pd(&d_value_partition[i * D_CSR5_OMEGA]);
         // column_index512i = (i % 2) ?
         //             _mm512_permute4f128_epi32(column_index512i, _MM_PERM_BADC) :
         //             _mm512_load_epi32(&d_column_index_partition[i * omega]);
@@ -87,7 +86,13 @@ void partition_fast_track(const vT           *d_value_partition,
                     _mm512_shuffle_i32x4(column_index512i, column_index512i, _MM_PERM_BADC) :
                     _mm512_load_epi32(&d_column_index_partition[i * D_CSR5_OMEGA]);
         x512d = _mm512_i32logather_pd(column_index512i, d_x, 8);
-        sum512d = _mm512_fmadd_pd(value512d, x512d, sum512d); // csr5.value * x = sum
+        if constexpr (Pattern)
+            sum512d = _mm512_add_pd(x512d, sum512d);
+        else
+        {
+            value512d = _mm512_load_pd(&d_value_partition[i * D_CSR5_OMEGA]);
+            sum512d = _mm512_fmadd_pd(value512d, x512d, sum512d); // csr5.value * x = sum
+        }
     }
 
     vT sum = _mm512_reduce_add_pd(sum512d);
@@ -109,7 +114,7 @@ void partition_fast_track(const vT           *d_value_partition,
 }
 
 
-template<typename iT, typename uiT, typename vT>
+template<bool Pattern, typename iT, typename uiT, typename vT>
 void spmv_csr5_compute_kernel(const iT           *d_column_index,
                               const vT           *d_value,
                               const iT           *d_row_pointer,
@@ -135,7 +140,7 @@ void spmv_csr5_compute_kernel(const iT           *d_column_index,
     const __m512d c_zero512d        = _mm512_setzero_pd();
     const __m512i c_one512i         = _mm512_set1_epi32(1);
 
-    const int stride_vT = CACHE_LINE / sizeof(vT);
+    const int stride_vT = Le_get_cache_line() / sizeof(vT);
     const int num_thread_active = ceil((p-1.0)/chunk);
 
     #pragma omp parallel
@@ -166,7 +171,8 @@ void spmv_csr5_compute_kernel(const iT           *d_column_index,
         #pragma omp for schedule(static, chunk)
         for (int par_id = 0; par_id < p - 1; par_id++)
         {
-            const vT *d_value_partition = &d_value[par_id * D_CSR5_OMEGA * c_sigma];
+            // pattern-only: d_value == nullptr, 不读 values
+            const vT *d_value_partition = Pattern ? d_value : &d_value[par_id * D_CSR5_OMEGA * c_sigma];
             const int *d_column_index_partition = &d_column_index[par_id * D_CSR5_OMEGA * c_sigma];
 
             uiT row_start     = d_partition_pointer[par_id];
@@ -178,7 +184,7 @@ void spmv_csr5_compute_kernel(const iT           *d_column_index,
                 // => we are the first writing data to d_y[row_start]
                 bool fast_direct = (d_partition_descriptor[par_id * D_CSR5_OMEGA * num_packet] >>
                                                     (31 - (bit_y_offset + bit_scansum_offset)) & 0x1);
-                partition_fast_track<iT, vT>
+                partition_fast_track<Pattern, iT, vT>
                         (d_value_partition, d_x, d_column_index_partition,
                          d_calibrator, d_y, row_start, par_id,
                          tid, start_row_start, alpha, beta, c_sigma, D_CSR5_OMEGA, stride_vT, fast_direct);
@@ -234,13 +240,17 @@ void spmv_csr5_compute_kernel(const iT           *d_column_index,
                 start512i = _mm512_mask_blend_epi32(local_bit16, c_one512i, _mm512_setzero_epi32());
                 direct16 = _mm512_kand(local_bit16, 0xFE);
 
-                value512d = _mm512_load_pd(d_value_partition);
-
                 column_index512i = _mm512_load_epi32(d_column_index_partition);
                 x512d = _mm512_i32logather_pd(column_index512i, d_x, 8);
                 x512d = _mm512_mul_pd(x512d, alpha512_d);   // x = alpha * x
 
-                sum512d = _mm512_mul_pd(value512d, x512d);
+                if constexpr (Pattern)
+                    sum512d = x512d;
+                else
+                {
+                    value512d = _mm512_load_pd(d_value_partition);
+                    sum512d = _mm512_mul_pd(value512d, x512d);
+                }
                 // sum512d = _mm512_mul_pd(sum512d, alpha512_d);  // * alpha
 
                 // step 1. thread-level seg sum
@@ -299,10 +309,15 @@ void spmv_csr5_compute_kernel(const iT           *d_column_index,
                         stop512i = _mm512_mask_add_epi32(stop512i, direct16, stop512i, c_one512i);
                     }
 
-                    value512d = _mm512_load_pd(&d_value_partition[i * D_CSR5_OMEGA]);
                     x512d = _mm512_i32logather_pd(column_index512i, d_x, 8);
                     x512d = _mm512_mul_pd(x512d, alpha512_d);   // x = alpha * x
-                    sum512d = _mm512_fmadd_pd(value512d, x512d, sum512d);
+                    if constexpr (Pattern)
+                        sum512d = _mm512_add_pd(x512d, sum512d);
+                    else
+                    {
+                        value512d = _mm512_load_pd(&d_value_partition[i * D_CSR5_OMEGA]);
+                        sum512d = _mm512_fmadd_pd(value512d, x512d, sum512d);
+                    }
 
                 }
 
@@ -372,7 +387,7 @@ void spmv_csr5_calibrate_kernel(const uiT *d_partition_pointer,
 {
     const int num_thread = Le_get_thread_num();
     const int chunk = ceil((double)(p-1) / (double)num_thread);
-    const int stride_vT = CACHE_LINE / sizeof(vT);
+    const int stride_vT = Le_get_cache_line() / sizeof(vT);
     // calculate the number of maximal active threads (for a static loop scheduling with size chunk)
     int num_thread_active = ceil((p-1.0)/chunk);
     int num_cali = num_thread_active < num_thread ? num_thread_active : num_thread;
@@ -383,7 +398,7 @@ void spmv_csr5_calibrate_kernel(const uiT *d_partition_pointer,
     }
 }
 
-template<typename iT, typename uiT, typename vT>
+template<bool Pattern, typename iT, typename uiT, typename vT>
 void spmv_csr5_tail_partition_kernel(const iT           *d_row_pointer,
                                      const iT           *d_column_index,
                                      const vT           *d_value,
@@ -405,10 +420,19 @@ void spmv_csr5_tail_partition_kernel(const iT           *d_row_pointer,
         const iT idx_stop  = d_row_pointer[row_id + 1];
 
         vT sum = 0;
-        for (iT idx = idx_start; idx < idx_stop; idx++)
+        if constexpr (Pattern)
+        {
+            for (iT idx = idx_start; idx < idx_stop; idx++)
+                sum += d_x[d_column_index[idx]];
+            sum *= alpha;
+        }
+        else
         {
-            // sum += d_value[idx] * d_x[d_column_index[idx]];
-            sum += d_value[idx] * d_x[d_column_index[idx]] * alpha;  // * alpha;
+            for (iT idx = idx_start; idx < idx_stop; idx++)
+            {
+                // sum += d_value[idx] * d_x[d_column_index[idx]];
+                sum += d_value[idx] * d_x[d_column_index[idx]] * alpha;  // * alpha;
+            }
         }
 
         if(row_id == tail_partition_start && d_row_pointer[row_id] != index_first_element_tail)
@@ -423,23 +447,11 @@ void spmv_csr5_tail_partition_kernel(const iT           *d_row_pointer,
     }
 }                            
 
-/**
- * @brief CSR spmv from Liu wei feng's code. Need to test correctness 12.24.2023.
- * 
- * @tparam IndexType 
- * @tparam UIndexType 
- * @tparam ValueType 
- * @param alpha 
- * @param csr5 
- * @param x 
- * @param beta 
- * @param y 
- */
-template <typename IndexType, typename UIndexType, typename ValueType>
-void LeSpMV_csr5(const ValueType alpha, const CSR5_Matrix<IndexType, UIndexType, ValueType>& csr5, const ValueType * x, const ValueType beta, ValueType * y)
+template <bool Pattern, typename IndexType, typename UIndexType, typename ValueType>
+void __spmv_csr5(const ValueType alpha, const CSR5_Matrix<IndexType, UIndexType, ValueType>& csr5, const ValueType * x, const ValueType beta, ValueType * y)
 {
     spmv_csr5_compute_kernel
-            <IndexType, UIndexType, ValueType>
+            <Pattern, IndexType, UIndexType, ValueType>
             (csr5.col_index, csr5.values, csr5.row_offset, x,
              csr5.tile_ptr, csr5.tile_desc,
              csr5.tile_desc_offset_ptr, csr5.tile_desc_offset,
@@ -451,9 +463,32 @@ void LeSpMV_csr5(const ValueType alpha, const CSR5_Matrix<IndexType, UIndexType,
             (csr5.tile_ptr, csr5.calibrator, y, csr5._p);
 
     spmv_csr5_tail_partition_kernel
-            <IndexType, UIndexType, ValueType>
+            <Pattern, IndexType, UIndexType, ValueType>
             (csr5.row_offset, csr5.col_index, csr5.values, x, y,
              csr5.tail_partition_start, csr5._p, csr5.num_rows, csr5.sigma, csr5.omega, alpha, beta);
 }
 
+/**
+ * @brief CSR spmv from Liu wei feng's code. Need to test correctness 12.24.2023.
+ *        Pattern-only matrices (value_storage == PatternValues) gather x only, the
+ *        tiles keep alpha folded into x, the tail applies alpha per row.
+ * 
+ * @tparam IndexType 
+ * @tparam UIndexType 
+ * @tparam ValueType 
+ * @param alpha 
+ * @param csr5 
+ * @param x 
+ * @param beta 
+ * @param y 
+ */
+template <typename IndexType, typename UIndexType, typename ValueType>
+void LeSpMV_csr5(const ValueType alpha, const CSR5_Matrix<IndexType, UIndexType, ValueType>& csr5, const ValueType * x, const ValueType beta, ValueType * y)
+{
+    if (csr5.value_storage == PatternValues)
+        __spmv_csr5<true>(alpha, csr5, x, beta, y);
+    else
+        __spmv_csr5<false>(alpha, csr5, x, beta, y);
+}
+
 template void LeSpMV_csr5<int, uint32_t, double>(const double, const CSR5_Matrix<int, uint32_t, double>&, const double* , const double, double*);
\ No newline at end of file
@@ -12,9 +12,104 @@
 
 #include"../include/LeSpMV.h"
 
+/**
+ * @brief sum[0, re - rs) = A[rs:re, :] * x over all diagonals: every diagonal is
+ *        clipped to the rows and columns it covers, so the inner loop reads
+ *        dia_data and x contiguously without branches and vectorizes.
+ */
+template <typename IndexType, typename ValueType>
+static inline void __spmv_dia_block_sum(const IndexType num_cols,
+                                        const IndexType stride,
+                                        const IndexType complete_ndiags,
+                                        const long int  * dia_offset,
+                                        const ValueType * dia_data,
+                                        const ValueType * x,
+                                        const IndexType rs, const IndexType re,
+                                        ValueType * sum)
+{
+    for (IndexType i = 0; i < re - rs; ++i)
+        sum[i] = 0;
+
+    for (IndexType d = 0; d < complete_ndiags; ++d)
+    {
+        const IndexType offset = dia_offset[d];
+        const IndexType start = std::max(rs, -offset);
+        const IndexType end   = std::min(re, num_cols - offset);
+        const ValueType * val = dia_data + (size_t) d * stride;
+        const ValueType * xd  = x + offset;
+
+        #pragma omp simd
+        for (IndexType i = start; i < end; ++i)
+            sum[i - rs] += val[i] * xd[i];
+    }
+}
+
+template <typename IndexType, typename ValueType>
+static inline void __spmv_dia_block_store(const ValueType alpha, const ValueType * sum, const ValueType beta, ValueType * y,
+                                          const IndexType rs, const IndexType re)
+{
+    if (beta == 0)
+        for (IndexType i = rs; i < re; ++i)
+            y[i] = alpha * sum[i - rs];
+    else
+        for (IndexType i = rs; i < re; ++i)
+            y[i] = beta * y[i] + alpha * sum[i - rs];
+}
+
+/**
+ * @brief Rows [rs, re): the sums stay in a DIA_ROW_BLOCK buffer and y is written once.
+ */
+template <typename IndexType, typename ValueType>
+static inline void __spmv_dia_rowblock( const ValueType alpha,
+                                        const IndexType num_cols,
+                                        const IndexType stride,
+                                        const IndexType complete_ndiags,
+                                        const long int  * dia_offset,
+                                        const ValueType * dia_data,
+                                        const ValueType * x,
+                                        const ValueType beta, ValueType * y,
+                                        const IndexType rs, const IndexType re)
+{
+    ValueType sum[DIA_ROW_BLOCK];
+    __spmv_dia_block_sum(num_cols, stride, complete_ndiags, dia_offset, dia_data, x, rs, re, sum);
+    __spmv_dia_block_store(alpha, sum, beta, y, rs, re);
+}
+
+/**
+ * @brief DIA + CSR in one pass: the CSR rows of the block are added to the DIA sums
+ *        before y is written.
+ */
+template <typename IndexType, typename ValueType>
+static inline void __spmv_dia_csr_rowblock( const ValueType alpha,
+                                            const DIA_CSR_Matrix<IndexType, ValueType>& hyb,
+                                            const ValueType * x,
+                                            const ValueType beta, ValueType * y,
+                                            const IndexType rs, const IndexType re)
+{
+    ValueType sum[DIA_ROW_BLOCK];
+    __spmv_dia_block_sum(hyb.num_cols, hyb.stride, hyb.complete_ndiags, hyb.diag_offsets, hyb.diag_data, x, rs, re, sum);
+
+    const IndexType *Ap = hyb.row_offset;
+    const IndexType *Aj = hyb.col_index;
+    const ValueType *Ax = hyb.values;
+    // 纯对角块跳过 CSR 部分
+    if (Ap[re] != Ap[rs])
+    {
+        for (IndexType i = rs; i < re; ++i)
+        {
+            ValueType s = 0;
+            for (IndexType jj = Ap[i]; jj < Ap[i + 1]; ++jj)
+                s += Ax[jj] * x[Aj[jj]];
+            sum[i - rs] += s;
+        }
+    }
+    __spmv_dia_block_store(alpha, sum, beta, y, rs, re);
+}
+
 template <typename IndexType, typename ValueType>
 void __spmv_dia_serial_simple(  const ValueType alpha, 
                                 const IndexType num_rows,
+                                const IndexType num_cols,
                                 const IndexType stride,
                                 const IndexType complete_ndiags,
                                 const long int  * dia_offset,
@@ -22,29 +117,16 @@ void __spmv_dia_serial_simple(  const ValueType alpha,
                                 const ValueType * x,
                                 const ValueType beta, ValueType * y)
 {
-    for (size_t i = 0; i < num_rows; ++i) {
-        y[i] = beta * y[i];
-    }
-
-    // 按照对角线来找数进行计算
-    for (size_t d = 0; d < complete_ndiags; ++d) {
-        IndexType offset = dia_offset[d]; // 获取当前对角线的偏移量
-        IndexType start = std::max((IndexType)0, -offset); // 如果是负的，说明行要从 -offset 开始算
-        IndexType end = std::min(num_rows, num_rows - offset); // 这个则是对应对角线最后一个元素实际的最大行号 end是多少， 如果是正的，说明对角线在上方，行号到不了最后一行
-
-        // 遍历当前对角线上的非零元素， 按行号 i ，也是这条对角线往后的位移
-        for (IndexType i = start; i < end; ++i) {
-            IndexType j = i + offset; // 计算实际的列索引
-            ValueType val = dia_data[d * stride + i];
-            // #pragma omp atomic
-            y[i] += alpha * val * x[j];
-        }
-    }
+    for (IndexType rs = 0; rs < num_rows; rs += DIA_ROW_BLOCK)
+        __spmv_dia_rowblock(alpha, num_cols, stride, complete_ndiags, dia_offset, dia_data, x, beta, y,
+                            rs, std::min(num_rows, rs + (IndexType) DIA_ROW_BLOCK));
 }
 
+// 按行块并行, 每个行块遍历全部对角线, 行块之间写 y 不冲突, 不需要 atomic
 template <typename IndexType, typename ValueType>
 void __spmv_dia_omp_simple(  const ValueType alpha, 
                                 const IndexType num_rows,
+                                const IndexType num_cols,
                                 const IndexType stride,
                                 const IndexType complete_ndiags,
                                 const long int  * dia_offset,
@@ -53,47 +135,14 @@ void __spmv_dia_omp_simple(  const ValueType alpha,
                                 const ValueType beta, ValueType * y)
 {
     const IndexType thread_num = Le_get_thread_num();
-    if (beta){
-        #pragma omp parallel for num_threads(thread_num)
-        for (size_t i = 0; i < num_rows; ++i) {
-            y[i] *= beta;
-        }
-    }
+    const IndexType num_blocks = (num_rows + DIA_ROW_BLOCK - 1) / DIA_ROW_BLOCK;
 
-    if ( 1 == alpha)
+    #pragma omp parallel for num_threads(thread_num)
+    for (IndexType b = 0; b < num_blocks; ++b)
     {
-        // alpha 不乘
-        #pragma omp parallel for num_threads(thread_num)
-        for (size_t d = 0; d < complete_ndiags; ++d) {
-            IndexType offset = dia_offset[d]; // 获取当前偏移量
-            IndexType start = std::max((IndexType)0, -offset);
-            IndexType end = std::min(num_rows, num_rows - offset);
-
-            // 遍历当前对角线上的非零元素
-            for (IndexType i = start; i < end; ++i) {
-                IndexType j = i + offset; // 计算实际的列索引
-                ValueType val = dia_data[d * stride + i];
-                #pragma omp atomic
-                y[i] += val * x[j];
-            }
-        }
-    }
-    else {
-        // 然后并行计算矩阵向量乘法
-        #pragma omp parallel for num_threads(thread_num)
-        for (size_t d = 0; d < complete_ndiags; ++d) {
-            IndexType offset = dia_offset[d]; // 获取当前偏移量
-            IndexType start = std::max((IndexType)0, -offset);
-            IndexType end = std::min(num_rows, num_rows - offset);
-
-            // 遍历当前对角线上的非零元素
-            for (IndexType i = start; i < end; ++i) {
-                IndexType j = i + offset; // 计算实际的列索引
-                ValueType val = alpha * dia_data[d * stride + i];
-                #pragma omp atomic
-                y[i] += val * x[j];
-            }
-        }
+        const IndexType rs = b * DIA_ROW_BLOCK;
+        __spmv_dia_rowblock(alpha, num_cols, stride, complete_ndiags, dia_offset, dia_data, x, beta, y,
+                            rs, std::min(num_rows, rs + (IndexType) DIA_ROW_BLOCK));
     }
 }
 
@@ -106,71 +155,69 @@ void __spmv_dia_alpha(  const ValueType alpha,
                         const long int  * dia_offset,
                         const ValueType * dia_data,
                         const ValueType * x,
-                        const ValueType beta, ValueType * y)
+                        const ValueType beta, ValueType * y,
+                        Le_arena &arena)
 {
     const IndexType thread_num = Le_get_thread_num();
-    ValueType **tmp = (ValueType**)malloc(sizeof(ValueType*) * thread_num);
-    for (int i = 0; i < thread_num; i++)
-    {
-        tmp[i] = (ValueType*)malloc(sizeof(ValueType) * num_rows);
-        memset(tmp[i], 0 , sizeof(ValueType) * num_rows);
-    }
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
+    ValueType **tmp = arena.alloc_array<ValueType *>(thread_num);
 
-    if ( 1 == alpha)
+    // 每个线程在自己的 sub-arena 上分配并首次访问 y 的拷贝, 整个计算在同一并行区内
+    #pragma omp parallel num_threads(thread_num)
     {
-        #pragma omp parallel for num_threads(thread_num)
-        for (size_t i = 0; i < complete_ndiags; ++i)
+        const IndexType threadId = Le_get_thread_id();
+        Le_arena_scope thread_scope(arena, threadId);
+        tmp[threadId] = arena.alloc_array<ValueType>(num_rows, threadId);
+        memset(tmp[threadId], 0 , sizeof(ValueType) * num_rows);
+        #pragma omp barrier
+
+        if ( 1 == alpha)
         {
-            const IndexType threadId = Le_get_thread_id();
-            const IndexType dis = dia_offset[i];
-            const IndexType row_start = std::max((IndexType)0, -dis);
-            const IndexType col_start = std::max((IndexType)0, dis);
-            const IndexType nnz = (num_rows - row_start)<(num_cols - col_start)?(num_rows - row_start):(num_cols - col_start);
-            const IndexType start = i * stride;
-            for (size_t j = 0; j < nnz; ++j)
+            #pragma omp for
+            for (size_t i = 0; i < complete_ndiags; ++i)
             {
-                // ValueType v = alpha * dia_data[start + row_start + j];
-                tmp[threadId][row_start + j] += dia_data[start + row_start + j] * x[col_start + j];
+                const IndexType dis = dia_offset[i];
+                const IndexType row_start = std::max((IndexType)0, -dis);
+                const IndexType col_start = std::max((IndexType)0, dis);
+                const IndexType nnz = (num_rows - row_start)<(num_cols - col_start)?(num_rows - row_start):(num_cols - col_start);
+                const IndexType start = i * stride;
+                for (size_t j = 0; j < nnz; ++j)
+                {
+                    // ValueType v = alpha * dia_data[start + row_start + j];
+                    tmp[threadId][row_start + j] += dia_data[start + row_start + j] * x[col_start + j];
+                }
             }
         }
-    }
-    else{
-        #pragma omp parallel for num_threads(thread_num)
-        for (size_t i = 0; i < complete_ndiags; ++i)
+        else{
+            #pragma omp for
+            for (size_t i = 0; i < complete_ndiags; ++i)
+            {
+                const IndexType dis = dia_offset[i];
+                const IndexType row_start = std::max((IndexType)0, -dis);
+                const IndexType col_start = std::max((IndexType)0, dis);
+                const IndexType nnz = (num_rows - row_start)<(num_cols - col_start)?(num_rows - row_start):(num_cols - col_start);
+                const IndexType start = i * stride;
+                for (size_t j = 0; j < nnz; ++j)
+                {
+                    ValueType v = alpha * dia_data[start + row_start + j];
+                    tmp[threadId][row_start + j] += v * x[col_start + j];
+                }
+            }
+        }
+
+        // omp for 结束的 barrier 之后各线程才释放自己的拷贝
+        #pragma omp for
+        for(size_t i = 0; i < num_rows; ++i)
         {
-            const IndexType threadId = Le_get_thread_id();
-            const IndexType dis = dia_offset[i];
-            const IndexType row_start = std::max((IndexType)0, -dis);
-            const IndexType col_start = std::max((IndexType)0, dis);
-            const IndexType nnz = (num_rows - row_start)<(num_cols - col_start)?(num_rows - row_start):(num_cols - col_start);
-            const IndexType start = i * stride;
-            for (size_t j = 0; j < nnz; ++j)
+            y[i] *= beta;
+            for(size_t j = 0; j < thread_num; ++j)
             {
-                ValueType v = alpha * dia_data[start + row_start + j];
-                tmp[threadId][row_start + j] += v * x[col_start + j];
+                // alpha_add(y[i], y[i], tmp[j][i]);
+                y[i] += tmp[j][i];
             }
         }
     }
-
-    #pragma omp parallel for num_threads(thread_num)
-    for(size_t i = 0; i < num_rows; ++i)
-	{
-        y[i] *= beta;
-		for(size_t j = 0; j < thread_num; ++j)
-	 	{
-			// alpha_add(y[i], y[i], tmp[j][i]);
-            y[i] += tmp[j][i];
-	 	}
-	}
-
-    #pragma omp parallel for num_threads(thread_num)
-    for(int i = 0; i < thread_num; ++i)
-	{
-		free(tmp[i]);
-	}
-
-	free(tmp);
-
 }
 
 template <typename IndexType, typename ValueType>
@@ -179,20 +226,45 @@ void LeSpMV_dia(const ValueType alpha, const DIA_Matrix<IndexType, ValueType>& d
     if ( 0 == dia.kernel_flag)
     {
         // call the simple serial implementation of DIA SpMV
-        __spmv_dia_serial_simple(alpha, dia.num_rows, dia.stride, dia.complete_ndiags, dia.diag_offsets, dia.diag_data, x, beta, y);
+        __spmv_dia_serial_simple(alpha, dia.num_rows, dia.num_cols, dia.stride, dia.complete_ndiags, dia.diag_offsets, dia.diag_data, x, beta, y);
     }
     else if( 1 == dia.kernel_flag)
     {
         // call the simple OMP implementation of DIA SpMV.
-        __spmv_dia_omp_simple(alpha, dia.num_rows, dia.stride, dia.complete_ndiags, dia.diag_offsets, dia.diag_data, x, beta, y);
+        __spmv_dia_omp_simple(alpha, dia.num_rows, dia.num_cols, dia.stride, dia.complete_ndiags, dia.diag_offsets, dia.diag_data, x, beta, y);
     }
     else if (2 == dia.kernel_flag)
     {
-        __spmv_dia_alpha(alpha, dia.num_rows, dia.num_cols, dia.stride, dia.complete_ndiags, dia.diag_offsets, dia.diag_data, x, beta, y);
+        __spmv_dia_alpha(alpha, dia.num_rows, dia.num_cols, dia.stride, dia.complete_ndiags, dia.diag_offsets, dia.diag_data, x, beta, y, Le_get_arena(dia.arena));
     }
     else // default
     {
-        __spmv_dia_omp_simple(alpha, dia.num_rows, dia.stride, dia.complete_ndiags, dia.diag_offsets, dia.diag_data, x, beta, y);
+        __spmv_dia_omp_simple(alpha, dia.num_rows, dia.num_cols, dia.stride, dia.complete_ndiags, dia.diag_offsets, dia.diag_data, x, beta, y);
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_dia_csr(const ValueType alpha, const DIA_CSR_Matrix<IndexType, ValueType>& hyb, const ValueType * x, const ValueType beta, ValueType * y)
+{
+    const IndexType num_blocks = (hyb.num_rows + DIA_ROW_BLOCK - 1) / DIA_ROW_BLOCK;
+    if (0 == hyb.kernel_flag)
+    {
+        for (IndexType b = 0; b < num_blocks; ++b)
+        {
+            const IndexType rs = b * DIA_ROW_BLOCK;
+            __spmv_dia_csr_rowblock(alpha, hyb, x, beta, y, rs, std::min(hyb.num_rows, rs + (IndexType) DIA_ROW_BLOCK));
+        }
+    }
+    else
+    {
+        // CSR 部分每块的非零元数不同, 动态调度
+        const IndexType thread_num = Le_get_thread_num();
+        #pragma omp parallel for num_threads(thread_num) schedule(dynamic)
+        for (IndexType b = 0; b < num_blocks; ++b)
+        {
+            const IndexType rs = b * DIA_ROW_BLOCK;
+            __spmv_dia_csr_rowblock(alpha, hyb, x, beta, y, rs, std::min(hyb.num_rows, rs + (IndexType) DIA_ROW_BLOCK));
+        }
     }
 }
 
@@ -202,4 +274,12 @@ template void LeSpMV_dia<int, double>(const double, const DIA_Matrix<int, double
 
 template void LeSpMV_dia<long long, float>(const float, const DIA_Matrix<long long, float>&, const float*, const float, float*);
 
-template void LeSpMV_dia<long long, double>(const double, const DIA_Matrix<long long, double>&, const double*, const double, double*);
\ No newline at end of file
+template void LeSpMV_dia<long long, double>(const double, const DIA_Matrix<long long, double>&, const double*, const double, double*);
+
+template void LeSpMV_dia_csr<int, float>(const float, const DIA_CSR_Matrix<int, float>&, const float*, const float, float*);
+
+template void LeSpMV_dia_csr<int, double>(const double, const DIA_CSR_Matrix<int, double>&, const double*, const double, double*);
+
+template void LeSpMV_dia_csr<long long, float>(const float, const DIA_CSR_Matrix<long long, float>&, const float*, const float, float*);
+
+template void LeSpMV_dia_csr<long long, double>(const double, const DIA_CSR_Matrix<long long, double>&, const double*, const double, double*);
\ No newline at end of file
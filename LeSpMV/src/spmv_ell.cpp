@@ -13,6 +13,51 @@
 #include"../include/LeSpMV.h"
 
 #include"../include/thread.h"
+
+/**
+ * @brief ColMajor ELL rows [rs, re): blocks of ELL_ROW_BLOCK rows, for every item
+ *        the rows of the block are contiguous in colIndex / values, so the inner
+ *        loop runs SIMD across rows with masked gathers of x (padding col = -1).
+ *        The block sums stay in a local buffer, y is written once.
+ */
+template <typename IndexType, typename ValueType>
+static inline void __spmv_ell_colmajor_rows(const ValueType alpha,
+                                            const IndexType *colIndex,
+                                            const ValueType *values,
+                                            const ValueType * x,
+                                            const ValueType beta, ValueType * y,
+                                            const IndexType rs,
+                                            const IndexType re,
+                                            const IndexType num_rows,
+                                            const IndexType maxNonzeros)
+{
+    ValueType sum[ELL_ROW_BLOCK];
+    for (IndexType bs = rs; bs < re; bs += ELL_ROW_BLOCK)
+    {
+        const IndexType be = std::min(re, bs + (IndexType) ELL_ROW_BLOCK);
+        for (IndexType r = 0; r < be - bs; ++r)
+            sum[r] = 0;
+
+        for (IndexType item = 0; item < maxNonzeros; ++item)
+        {
+            const IndexType * ci = colIndex + (size_t) item * num_rows + bs;
+            const ValueType * va = values   + (size_t) item * num_rows + bs;
+            #pragma omp simd
+            for (IndexType r = 0; r < be - bs; ++r)
+            {
+                const IndexType col = ci[r];
+                sum[r] += (col >= 0) ? va[r] * x[col] : ValueType(0);
+            }
+        }
+
+        if (beta == 0)
+            for (IndexType r = bs; r < be; ++r)
+                y[r] = alpha * sum[r - bs];
+        else
+            for (IndexType r = bs; r < be; ++r)
+                y[r] = alpha * sum[r - bs] + beta * y[r];
+    }
+}
 template <typename IndexType, typename ValueType>
 void __spmv_ell_serial_simple(  const IndexType num_rows,
                                 const IndexType maxNonzeros, 
@@ -26,22 +71,7 @@ void __spmv_ell_serial_simple(  const IndexType num_rows,
 // COLMAJOR ELL:
     if(ColMajor == ld)
     {
-        // #pragma omp parallel for num_threads(thread_num) schedule(SCHEDULE_STRATEGY)
-        for (size_t rowId = 0; rowId < num_rows; ++rowId)
-        {
-            ValueType sum = 0.0;
-            // #pragma omp simd reduction(+:sum)
-            for (size_t item = 0; item < maxNonzeros; item++)
-            {
-                IndexType colID = colIndex[rowId + item * num_rows];
-                ValueType val = values[rowId + item * num_rows];   // 放外面可能是为SIMD
-                if (colID >= 0)  // colID != -1
-                {
-                    sum += val * x[colID];
-                }
-            }
-            y[rowId] = alpha * sum + beta * y[rowId];
-        }
+        __spmv_ell_colmajor_rows(alpha, colIndex, values, x, beta, y, (IndexType) 0, num_rows, num_rows, maxNonzeros);
     }
 // ROWMAJOR ELL:
     else if(RowMajor == ld)
@@ -79,25 +109,15 @@ void __spmv_ell_omp_simple( const IndexType num_rows,
 {
     const IndexType thread_num = Le_get_thread_num();
 
-// COLMAJOR ELL:
+// COLMAJOR ELL: 按行块并行, 块内跨行 SIMD
     if(ColMajor == ld)
     {
-        // #pragma omp parallel for num_threads(thread_num) schedule(SCHEDULE_STRATEGY)
+        const IndexType num_blocks = (num_rows + ELL_ROW_BLOCK - 1) / ELL_ROW_BLOCK;
         #pragma omp parallel for num_threads(thread_num)
-        for (size_t rowId = 0; rowId < num_rows; ++rowId)
+        for (IndexType b = 0; b < num_blocks; ++b)
         {
-            ValueType sum = 0.0;
-            #pragma omp simd reduction(+:sum)
-            for (size_t item = 0; item < maxNonzeros; item++)
-            {
-                IndexType colID = colIndex[rowId + item * num_rows];
-                ValueType val = values[rowId + item * num_rows]; // 放外面可能是为了SIMD
-                if (colID >= 0)  // colID != -1
-                {
-                    sum += val * x[colID];
-                }
-            }
-            y[rowId] = alpha * sum + beta * y[rowId];
+            const IndexType rs = b * ELL_ROW_BLOCK;
+            __spmv_ell_colmajor_rows(alpha, colIndex, values, x, beta, y, rs, std::min(num_rows, rs + (IndexType) ELL_ROW_BLOCK), num_rows, maxNonzeros);
         }
     }
 // ROWMAJOR ELL:
@@ -163,16 +183,19 @@ void __spmv_ell_omp_lb_row( const IndexType num_rows,
                             const ValueType * x, 
                             const ValueType beta, ValueType * y,
                             const LeadingDimension ld,
-                            IndexType *partition)
+                            IndexType *partition,
+                            Le_arena &arena)
 {
     const IndexType thread_num = Le_get_thread_num();
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
     // IndexType partition[thread_num + 1];  // index 0 ~ thread_num
 
     if(RowMajor == ld)
     {
         if(partition == nullptr)
         {
-            partition = new_array<IndexType>(thread_num + 1);
+            partition = arena.alloc_array<IndexType>(thread_num + 1);
             balanced_partition_row_by_nnz_ell(colIndex, num_nnzs, 
                                           num_rows, maxNonzeros, 
                                           thread_num, partition);
@@ -187,23 +210,15 @@ void __spmv_ell_omp_lb_row( const IndexType num_rows,
     }
     else
     {
-        //  暂时使用 omp_simple 的 ColMajor实现方法
-        // #pragma omp parallel for num_threads(thread_num) schedule(SCHEDULE_STRATEGY)
-        #pragma omp parallel for num_threads(thread_num)
-        for (size_t rowId = 0; rowId < num_rows; ++rowId)
+        // ColMajor 每行都按 maxNonzeros 计算 (跨行 SIMD 不跳过填充), 工作量按行均匀,
+        // 每个线程分到连续且按 SIMD 宽度对齐的行段
+        const IndexType lanes = std::max(1, Le_get_alignment<ValueType>());
+        #pragma omp parallel num_threads(thread_num)
         {
-            ValueType sum = 0.0;
-            #pragma omp simd reduction(+:sum)
-            for (size_t item = 0; item < maxNonzeros; item++)
-            {
-                IndexType colID = colIndex[rowId + item * num_rows];
-                ValueType val = values[rowId + item * num_rows]; // 放外面可能是为了SIMD
-                if (colID >= 0)  // colID != -1
-                {
-                    sum += val * x[colID];
-                }
-            }
-            y[rowId] = alpha * sum + beta * y[rowId];
+            IndexType tid = Le_get_thread_id();
+            IndexType local_m_start = std::min(num_rows, (IndexType) ((long long) num_rows * tid / thread_num / lanes * lanes));
+            IndexType local_m_end   = (tid + 1 == thread_num) ? num_rows : std::min(num_rows, (IndexType) ((long long) num_rows * (tid + 1) / thread_num / lanes * lanes));
+            __spmv_ell_colmajor_rows(alpha, colIndex, values, x, beta, y, local_m_start, local_m_end, num_rows, maxNonzeros);
         }
     }
 }
@@ -236,9 +251,8 @@ void LeSpMV_ell(const ValueType alpha, const ELL_Matrix<IndexType, ValueType>& e
     }
     else if(2 == ell.kernel_flag)
     {
-        // call the load balanced by nnz of each row in omp
-        // Now just consider RowMajor
-        __spmv_ell_omp_lb_row(ell.num_rows, ell.max_row_width, ell.num_nnzs, alpha, ell.col_index, ell.values, x, beta, y, ell.ld, ell.partition);
+        // call the load balanced by nnz of each row in omp, RowMajor or ColMajor
+        __spmv_ell_omp_lb_row(ell.num_rows, ell.max_row_width, ell.num_nnzs, alpha, ell.col_index, ell.values, x, beta, y, ell.ld, ell.partition, Le_get_arena(ell.arena));
     }
     else{
         // DEFAULT: omp simple implementation
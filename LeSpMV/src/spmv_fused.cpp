@@ -0,0 +1,367 @@
+/**
+ * @file spmv_fused.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  SpMV fused with the vector reductions of Krylov solvers.
+ *         y = alpha * A * x + beta * w, dot(y, z) and dot(y, y) are
+ *         accumulated while y[row] is still in register, so y is not
+ *         read again by a separate dot / norm pass.
+ * @version 0.1
+ * @date 2024-03-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include"../include/LeSpMV.h"
+
+#include"../include/thread.h"
+
+/**
+ * @brief Rows lrs to lre of the fused CSR kernel, partial dot / norm2 are
+ *        added into dot and norm2.
+ */
+template <typename IndexType, typename ValueType>
+inline void __spmv_csr_fused_perthread( const ValueType alpha,
+                                        const IndexType *Ap,
+                                        const IndexType *Aj,
+                                        const ValueType *Ax,
+                                        const ValueType * x,
+                                        const ValueType beta,
+                                        const ValueType * w,
+                                        ValueType * y,
+                                        const ValueType * z,
+                                        const IndexType lrs,
+                                        const IndexType lre,
+                                        ValueType &dot,
+                                        ValueType &norm2)
+{
+    ValueType local_dot = 0, local_norm2 = 0;
+    for (IndexType row = lrs; row < lre; row++)
+    {
+        const IndexType pks = Ap[row];
+        const IndexType pke = Ap[row+1];
+
+        ValueType sum = 0;
+        #pragma omp simd reduction(+:sum)
+        for (IndexType jj = pks; jj < pke; ++jj) {
+            sum += Ax[jj] * x[Aj[jj]];
+        }
+
+        // w 可以与 y 相同, 先读后写
+        const ValueType yi = (beta == 0) ? alpha * sum : alpha * sum + beta * w[row];
+        y[row] = yi;
+
+        if (z != nullptr)
+            local_dot += yi * z[row];
+        local_norm2 += yi * yi;
+    }
+    dot   += local_dot;
+    norm2 += local_norm2;
+}
+
+template <typename IndexType, typename ValueType>
+void __spmv_csr_fused_omp_simple(const IndexType num_rows,
+                                 const ValueType alpha,
+                                 const IndexType *Ap,
+                                 const IndexType *Aj,
+                                 const ValueType *Ax,
+                                 const ValueType * x,
+                                 const ValueType beta,
+                                 const ValueType * w,
+                                 ValueType * y,
+                                 const ValueType * z,
+                                 ValueType &dot,
+                                 ValueType &norm2)
+{
+    const IndexType thread_num = Le_get_thread_num();
+    ValueType sum_dot = 0, sum_norm2 = 0;
+
+    #pragma omp parallel for num_threads(thread_num) reduction(+:sum_dot, sum_norm2)
+    for (IndexType row = 0; row < num_rows; ++row)
+    {
+        ValueType sum = 0;
+        const IndexType row_start = Ap[row];
+        const IndexType row_end   = Ap[row+1];
+
+        #pragma omp simd reduction(+:sum)
+        for (IndexType jj = row_start; jj < row_end; ++jj) {
+            sum += Ax[jj] * x[Aj[jj]];
+        }
+
+        const ValueType yi = (beta == 0) ? alpha * sum : alpha * sum + beta * w[row];
+        y[row] = yi;
+
+        if (z != nullptr)
+            sum_dot += yi * z[row];
+        sum_norm2 += yi * yi;
+    }
+    dot   = sum_dot;
+    norm2 = sum_norm2;
+}
+
+/**
+ * @brief Load balanced by nnz, the partial sums of threads are added in
+ *        thread order, so the result does not depend on the omp reduction order.
+ */
+template <typename IndexType, typename ValueType>
+void __spmv_csr_fused_omp_lb(const IndexType num_rows,
+                             const ValueType alpha,
+                             const IndexType *Ap,
+                             const IndexType *Aj,
+                             const ValueType *Ax,
+                             const ValueType * x,
+                             const ValueType beta,
+                             const ValueType * w,
+                             ValueType * y,
+                             const ValueType * z,
+                             ValueType &dot,
+                             ValueType &norm2,
+                             const IndexType* partition,
+                             Le_arena &arena)
+{
+    const IndexType thread_num = Le_get_thread_num();
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
+
+    if(partition == nullptr)
+    {
+        IndexType *local_partition = arena.alloc_array<IndexType>(thread_num + 1);
+        balanced_partition_row_by_nnz(Ap, num_rows, thread_num, local_partition);
+        partition = local_partition;
+    }
+
+    // 每个线程的部分和占一个 cache line, 避免伪共享
+    const size_t stride = Le_get_cache_line() / sizeof(ValueType);
+    ValueType *partial = arena.alloc_array<ValueType>(2 * stride * thread_num);
+
+    #pragma omp parallel num_threads(thread_num)
+    {
+        IndexType tid = Le_get_thread_id();
+        ValueType local_dot = 0, local_norm2 = 0;
+        __spmv_csr_fused_perthread(alpha, Ap, Aj, Ax, x, beta, w, y, z, partition[tid], partition[tid + 1], local_dot, local_norm2);
+        partial[2 * stride * tid]          = local_dot;
+        partial[2 * stride * tid + stride] = local_norm2;
+    }
+
+    dot = 0;
+    norm2 = 0;
+    for (IndexType tid = 0; tid < thread_num; ++tid)
+    {
+        dot   += partial[2 * stride * tid];
+        norm2 += partial[2 * stride * tid + stride];
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_csr_fused(const ValueType alpha, const CSR_Matrix<IndexType, ValueType>& csr, const ValueType * x, const ValueType beta, const ValueType * w, ValueType * y, const ValueType * z, ValueType * dot_yz, ValueType * norm2_y)
+{
+    CHECK_VALUES(csr);
+    if (w == nullptr)
+        w = y;
+
+    ValueType dot = 0, norm2 = 0;
+    if (0 == csr.kernel_flag)
+    {
+        __spmv_csr_fused_perthread(alpha, csr.row_offset, csr.col_index, csr.values, x, beta, w, y, z, (IndexType) 0, csr.num_rows, dot, norm2);
+    }
+    else if (2 == csr.kernel_flag)
+    {
+        __spmv_csr_fused_omp_lb(csr.num_rows, alpha, csr.row_offset, csr.col_index, csr.values, x, beta, w, y, z, dot, norm2, csr.partition, Le_get_arena(csr.arena));
+    }
+    else{
+        // 1 and DEFAULT: omp simple implementation
+        __spmv_csr_fused_omp_simple(csr.num_rows, alpha, csr.row_offset, csr.col_index, csr.values, x, beta, w, y, z, dot, norm2);
+    }
+
+    if (dot_yz != nullptr)
+        *dot_yz = dot;
+    if (norm2_y != nullptr)
+        *norm2_y = norm2;
+}
+
+/**
+ * @brief Chunks chunk_lrs to chunk_lre of the fused SELL-c-sigma kernel,
+ *        y, w and z are indexed by the original row Reorder[global_row].
+ */
+template <typename IndexType, typename ValueType>
+inline void __spmv_sell_cs_fused_perthread( const IndexType * Reorder,
+                                            const ValueType alpha,
+                                            const IndexType *chunk_ptr,
+                                            const IndexType *col_index,
+                                            const ValueType *values,
+                                            const ValueType * x,
+                                            const ValueType beta,
+                                            const ValueType * w,
+                                            ValueType * y,
+                                            const ValueType * z,
+                                            const IndexType chunk_lrs,
+                                            const IndexType chunk_lre,
+                                            const IndexType num_rows,
+                                            const IndexType *max_row_width,
+                                            const IndexType chunk_size,
+                                            ValueType &dot,
+                                            ValueType &norm2)
+{
+    ValueType local_dot = 0, local_norm2 = 0;
+    for (IndexType chunkID = chunk_lrs; chunkID < chunk_lre; chunkID++)
+    {
+        const size_t chunk_width = max_row_width[chunkID];
+        const size_t chunk_start_row = (size_t) chunkID * chunk_size;
+        const IndexType * chunk_col = col_index + chunk_ptr[chunkID];
+        const ValueType * chunk_val = values + chunk_ptr[chunkID];
+
+        for (size_t row = 0; row < (size_t) chunk_size; ++row)
+        {
+            size_t global_row = chunk_start_row + row;
+            if (global_row >= (size_t) num_rows) break; // 越界检查
+
+            const size_t sumPos = Reorder[global_row];
+            ValueType sum = 0;
+
+            #pragma omp simd reduction(+:sum)
+            for (size_t i = 0; i < chunk_width; ++i)
+            {
+                const size_t pos = i * chunk_size + row;   // chunk 内按列存储
+                const IndexType col = chunk_col[pos];
+                if (col >= 0) { // 检查是否为填充的空位
+                    sum += chunk_val[pos] * x[col];
+                }
+            }
+
+            const ValueType yi = (beta == 0) ? alpha * sum : alpha * sum + beta * w[sumPos];
+            y[sumPos] = yi;
+
+            if (z != nullptr)
+                local_dot += yi * z[sumPos];
+            local_norm2 += yi * yi;
+        }
+    }
+    dot   += local_dot;
+    norm2 += local_norm2;
+}
+
+template <typename IndexType, typename ValueType>
+void __spmv_sell_cs_fused_omp_simple(const IndexType * Reorder,
+                                     const IndexType num_rows,
+                                     const IndexType chunk_rowNum,
+                                     const IndexType total_chunk_num,
+                                     const ValueType alpha,
+                                     const IndexType *max_row_width,
+                                     const IndexType *chunk_ptr,
+                                     const IndexType *col_index,
+                                     const ValueType *values,
+                                     const ValueType * x,
+                                     const ValueType beta,
+                                     const ValueType * w,
+                                     ValueType * y,
+                                     const ValueType * z,
+                                     ValueType &dot,
+                                     ValueType &norm2)
+{
+    const IndexType thread_num = Le_get_thread_num();
+    ValueType sum_dot = 0, sum_norm2 = 0;
+
+    #pragma omp parallel for num_threads(thread_num) reduction(+:sum_dot, sum_norm2)
+    for (IndexType chunkID = 0; chunkID < total_chunk_num; ++chunkID)
+    {
+        __spmv_sell_cs_fused_perthread(Reorder, alpha, chunk_ptr, col_index, values, x, beta, w, y, z, chunkID, chunkID + 1, num_rows, max_row_width, chunk_rowNum, sum_dot, sum_norm2);
+    }
+    dot   = sum_dot;
+    norm2 = sum_norm2;
+}
+
+template <typename IndexType, typename ValueType>
+void __spmv_sell_cs_fused_omp_lb(const IndexType * Reorder,
+                                 const IndexType num_rows,
+                                 const IndexType chunk_rowNum,
+                                 const IndexType total_chunk_num,
+                                 const IndexType num_nnzs,
+                                 const ValueType alpha,
+                                 const IndexType *max_row_width,
+                                 const IndexType *chunk_ptr,
+                                 const IndexType *col_index,
+                                 const ValueType *values,
+                                 const ValueType * x,
+                                 const ValueType beta,
+                                 const ValueType * w,
+                                 ValueType * y,
+                                 const ValueType * z,
+                                 ValueType &dot,
+                                 ValueType &norm2,
+                                 const IndexType *partition,
+                                 Le_arena &arena)
+{
+    const IndexType thread_num = Le_get_thread_num();
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
+
+    if(partition == nullptr)
+    {
+        IndexType *local_partition = arena.alloc_array<IndexType>(thread_num + 1);
+        balanced_partition_row_by_nnz_sell(chunk_ptr, col_index, num_nnzs, total_chunk_num, thread_num, local_partition);
+        partition = local_partition;
+    }
+
+    const size_t stride = Le_get_cache_line() / sizeof(ValueType);
+    ValueType *partial = arena.alloc_array<ValueType>(2 * stride * thread_num);
+
+    #pragma omp parallel num_threads(thread_num)
+    {
+        IndexType tid = Le_get_thread_id();
+        ValueType local_dot = 0, local_norm2 = 0;
+        __spmv_sell_cs_fused_perthread(Reorder, alpha, chunk_ptr, col_index, values, x, beta, w, y, z, partition[tid], partition[tid + 1], num_rows, max_row_width, chunk_rowNum, local_dot, local_norm2);
+        partial[2 * stride * tid]          = local_dot;
+        partial[2 * stride * tid + stride] = local_norm2;
+    }
+
+    dot = 0;
+    norm2 = 0;
+    for (IndexType tid = 0; tid < thread_num; ++tid)
+    {
+        dot   += partial[2 * stride * tid];
+        norm2 += partial[2 * stride * tid + stride];
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_sell_c_sigma_fused(const ValueType alpha, const SELL_C_Sigma_Matrix<IndexType, ValueType>& sell_c_sigma, const ValueType * x, const ValueType beta, const ValueType * w, ValueType * y, const ValueType * z, ValueType * dot_yz, ValueType * norm2_y)
+{
+    CHECK_VALUES(sell_c_sigma);
+    if (w == nullptr)
+        w = y;
+
+    ValueType dot = 0, norm2 = 0;
+    if (0 == sell_c_sigma.kernel_flag)
+    {
+        __spmv_sell_cs_fused_perthread(sell_c_sigma.reorder, alpha, sell_c_sigma.chunk_ptr, sell_c_sigma.col_index, sell_c_sigma.values, x, beta, w, y, z, (IndexType) 0, sell_c_sigma.validchunkNum, sell_c_sigma.num_rows, sell_c_sigma.chunk_len, sell_c_sigma.chunkWidth_C, dot, norm2);
+    }
+    else if (2 == sell_c_sigma.kernel_flag)
+    {
+        __spmv_sell_cs_fused_omp_lb(sell_c_sigma.reorder, sell_c_sigma.num_rows, sell_c_sigma.chunkWidth_C, sell_c_sigma.validchunkNum, sell_c_sigma.num_nnzs, alpha, sell_c_sigma.chunk_len, sell_c_sigma.chunk_ptr, sell_c_sigma.col_index, sell_c_sigma.values, x, beta, w, y, z, dot, norm2, sell_c_sigma.partition, Le_get_arena(sell_c_sigma.arena));
+    }
+    else{
+        // 1 and DEFAULT: omp simple implementation
+        __spmv_sell_cs_fused_omp_simple(sell_c_sigma.reorder, sell_c_sigma.num_rows, sell_c_sigma.chunkWidth_C, sell_c_sigma.validchunkNum, alpha, sell_c_sigma.chunk_len, sell_c_sigma.chunk_ptr, sell_c_sigma.col_index, sell_c_sigma.values, x, beta, w, y, z, dot, norm2);
+    }
+
+    if (dot_yz != nullptr)
+        *dot_yz = dot;
+    if (norm2_y != nullptr)
+        *norm2_y = norm2;
+}
+
+template void LeSpMV_csr_fused<int, float>(const float, const CSR_Matrix<int, float>&, const float*, const float, const float*, float*, const float*, float*, float*);
+
+template void LeSpMV_csr_fused<int, double>(const double, const CSR_Matrix<int, double>&, const double*, const double, const double*, double*, const double*, double*, double*);
+
+template void LeSpMV_csr_fused<long long, float>(const float, const CSR_Matrix<long long, float>&, const float*, const float, const float*, float*, const float*, float*, float*);
+
+template void LeSpMV_csr_fused<long long, double>(const double, const CSR_Matrix<long long, double>&, const double*, const double, const double*, double*, const double*, double*, double*);
+
+template void LeSpMV_sell_c_sigma_fused<int, float>(const float, const SELL_C_Sigma_Matrix<int, float>&, const float*, const float, const float*, float*, const float*, float*, float*);
+
+template void LeSpMV_sell_c_sigma_fused<int, double>(const double, const SELL_C_Sigma_Matrix<int, double>&, const double*, const double, const double*, double*, const double*, double*, double*);
+
+template void LeSpMV_sell_c_sigma_fused<long long, float>(const float, const SELL_C_Sigma_Matrix<long long, float>&, const float*, const float, const float*, float*, const float*, float*, float*);
+
+template void LeSpMV_sell_c_sigma_fused<long long, double>(const double, const SELL_C_Sigma_Matrix<long long, double>&, const double*, const double, const double*, double*, const double*, double*, double*);
@@ -14,44 +14,70 @@
 
 #include"../include/thread.h"
 
+/**
+ * @brief One column-major chunk: for every column i the row_num_perC rows are
+ *        contiguous, the inner loop runs SIMD across the rows with masked
+ *        gathers of x (padding col = -1). sum has row_num_perC entries.
+ */
+template <typename IndexType, typename ValueType>
+static inline void __spmv_sell_chunk(   const ValueType alpha,
+                                        const IndexType *col_index,
+                                        const ValueType *values,
+                                        const IndexType chunk_width,
+                                        const IndexType row_num_perC,
+                                        const ValueType * x,
+                                        const ValueType beta,
+                                        ValueType * y,
+                                        const IndexType chunk_start_row,
+                                        const IndexType num_rows,
+                                        ValueType * sum)
+{
+    for (IndexType row = 0; row < row_num_perC; ++row)
+        sum[row] = 0;
+
+    for (IndexType i = 0; i < chunk_width; ++i)
+    {
+        const IndexType * ci = col_index + (size_t) i * row_num_perC;
+        const ValueType * va = values    + (size_t) i * row_num_perC;
+        #pragma omp simd
+        for (IndexType row = 0; row < row_num_perC; ++row)
+        {
+            const IndexType col = ci[row];
+            sum[row] += (col >= 0) ? va[row] * x[col] : ValueType(0); // 检查是否为填充的空位
+        }
+    }
+
+    const IndexType rows = std::min(row_num_perC, num_rows - chunk_start_row); // 越界检查
+    if (beta == 0)
+        for (IndexType row = 0; row < rows; ++row)
+            y[chunk_start_row + row] = alpha * sum[row];
+    else
+        for (IndexType row = 0; row < rows; ++row)
+            y[chunk_start_row + row] = alpha * sum[row] + beta * y[chunk_start_row + row];
+}
+
 template <typename IndexType, typename ValueType>
 void __spmv_sell_serial_simple( const IndexType num_rows,
                                 const IndexType row_num_perC,
                                 const IndexType total_chunk_num,
                                 const ValueType alpha,
                                 const IndexType *max_row_width,
-                                const IndexType * const *col_index,
-                                const ValueType * const *values,
+                                const IndexType *chunk_ptr,
+                                const IndexType *col_index,
+                                const ValueType *values,
                                 const ValueType * x, 
                                 const ValueType beta, 
-                                ValueType * y)
+                                ValueType * y,
+                                Le_arena &arena)
 {
-    for (size_t chunk = 0; chunk < total_chunk_num; ++chunk)
+    arena.reserve_threads(1);
+    Le_arena_scope scope(arena);
+    ValueType *sum = arena.alloc_array<ValueType>(row_num_perC);
+    for (IndexType chunk = 0; chunk < total_chunk_num; ++chunk)
     {
-        size_t chunk_width = max_row_width[chunk];
-        size_t chunk_start_row = chunk * row_num_perC;
-
-        for (size_t row = 0; row < row_num_perC; ++row)
-        {
-            size_t global_row = chunk_start_row + row;
-            if (global_row >= num_rows) break; // 越界检查
-            
-            ValueType sum = 0;
-            // #pragma omp simd reduction(+:sum)
-            for (size_t i = 0; i < chunk_width; ++i) 
-            {
-                size_t col_index_pos = row * chunk_width + i;
-                size_t col = col_index[chunk][col_index_pos];
-
-                if (col >= 0) { // 检查是否为填充的空位
-                    sum += values[chunk][col_index_pos] * x[col];
-                }
-            }
-
-            y[global_row] = alpha * sum + beta * y[global_row];
-        }
+        __spmv_sell_chunk(alpha, col_index + chunk_ptr[chunk], values + chunk_ptr[chunk], max_row_width[chunk], row_num_perC,
+                          x, beta, y, chunk * row_num_perC, num_rows, sum);
     }
-
 }
 
 
@@ -75,52 +101,36 @@ void __spmv_sell_omp_simple(const IndexType num_rows,
                             const IndexType total_chunk_num,
                             const ValueType alpha,
                             const IndexType *max_row_width,
-                            const IndexType * const *col_index,
-                            const ValueType * const *values,
+                            const IndexType *chunk_ptr,
+                            const IndexType *col_index,
+                            const ValueType *values,
                             const ValueType * x, 
                             const ValueType beta, 
-                            ValueType * y)
+                            ValueType * y,
+                            Le_arena &arena)
 {
     const IndexType thread_num = Le_get_thread_num();
-    // const IndexType chunk_size = std::max(1, total_chunk_num/ thread_num);
-
-    // const int colindex_align_bytes = ALIGNMENT_NUM * sizeof(IndexType);
-    // const int values_align_bytes   = ALIGNMENT_NUM * sizeof(ValueType);
+    arena.reserve_threads(thread_num);
 
-    //  Only spmv for row major SELL
-    // #pragma omp parallel for num_threads(thread_num) schedule(SCHEDULE_STRATEGY)
-    #pragma omp parallel for num_threads(thread_num)
-    for (size_t chunk = 0; chunk < total_chunk_num; ++chunk)
+    #pragma omp parallel num_threads(thread_num)
     {
-        size_t chunk_width = max_row_width[chunk];
-        size_t chunk_start_row = chunk * row_num_perC;
-
-        for (size_t row = 0; row < row_num_perC; ++row)
+        const IndexType tid = Le_get_thread_id();
+        Le_arena_scope scope(arena, tid);
+        ValueType *sum = arena.alloc_array<ValueType>(row_num_perC, tid);
+        #pragma omp for
+        for (IndexType chunk = 0; chunk < total_chunk_num; ++chunk)
         {
-            ValueType sum = 0;
-            size_t global_row = chunk_start_row + row;
-            if (global_row >= num_rows) break; // 越界检查
-
-            #pragma omp simd reduction(+:sum)
-            for (size_t i = 0; i < chunk_width; ++i) 
-            {
-                size_t col_index_pos = row * chunk_width + i;
-                size_t col = col_index[chunk][col_index_pos];
-
-                if (col >= 0) { // 检查是否为填充的空位
-                    sum += values[chunk][col_index_pos] * x[col];
-                }
-            }
-
-            y[global_row] = alpha * sum + beta * y[global_row];
+            __spmv_sell_chunk(alpha, col_index + chunk_ptr[chunk], values + chunk_ptr[chunk], max_row_width[chunk], row_num_perC,
+                              x, beta, y, chunk * row_num_perC, num_rows, sum);
         }
     }
 }
 
 template <typename IndexType, typename ValueType>
 inline void __spmv_sell_perthread(  const ValueType alpha, 
-                                    const IndexType * const *col_index,
-                                    const ValueType * const *values,
+                                    const IndexType *chunk_ptr,
+                                    const IndexType *col_index,
+                                    const ValueType *values,
                                     const ValueType * x, 
                                     const ValueType beta, 
                                     ValueType * y, 
@@ -128,44 +138,13 @@ inline void __spmv_sell_perthread(  const ValueType alpha,
                                     const IndexType chunk_lre, 
                                     const IndexType num_rows, 
                                     const IndexType *max_row_width, 
-                                    const IndexType chunk_size)
+                                    const IndexType chunk_size,
+                                    ValueType *sum)
 {
-    for (size_t chunkID = chunk_lrs; chunkID < chunk_lre; chunkID++)
+    for (IndexType chunkID = chunk_lrs; chunkID < chunk_lre; chunkID++)
     {
-        size_t chunk_width = max_row_width[chunkID];
-        size_t chunk_start_row = chunkID * chunk_size;
-
-        for (size_t row = 0; row < chunk_size; ++row)
-        {
-            ValueType sum = 0.0;
-            size_t global_row = chunk_start_row + row;
-            if (global_row >= num_rows) break; // 越界检查
-
-            if (beta)
-            {
-                y[global_row] = beta * y[global_row];
-            }
-
-            // #pragma omp simd reduction(+:sum)
-            for (size_t i = 0; i < chunk_width; ++i) 
-            {
-                size_t col_index_pos = row * chunk_width + i;
-                size_t col = col_index[chunkID][col_index_pos];
-
-                if (col >= 0) { // 检查是否为填充的空位
-                    sum += values[chunkID][col_index_pos] * x[col];
-                }
-            }
-            // Scale the sum by alpha and add to the y vector scaled by beta
-            if(alpha == 1)
-            {
-                y[global_row] += sum;
-            }
-            else {
-                // y[global_row] = alpha * sum + beta * y[global_row];
-                y[global_row] += alpha * sum;
-            }
-        }
+        __spmv_sell_chunk(alpha, col_index + chunk_ptr[chunkID], values + chunk_ptr[chunkID], max_row_width[chunkID], chunk_size,
+                          x, beta, y, chunkID * chunk_size, num_rows, sum);
     }
 }
 
@@ -176,26 +155,32 @@ void __spmv_sell_omp_lb_row(const IndexType num_rows,
                             const IndexType num_nnzs, 
                             const ValueType alpha, 
                             const IndexType *max_row_width,
-                            const IndexType * const *col_index,
-                            const ValueType * const *values,
+                            const IndexType *chunk_ptr,
+                            const IndexType *col_index,
+                            const ValueType *values,
                             const ValueType * x, 
                             const ValueType beta, 
                             ValueType * y,
-                            IndexType *partition)
+                            IndexType *partition,
+                            Le_arena &arena)
 {
     const IndexType thread_num = Le_get_thread_num();
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
     
     if(partition == nullptr)
     {
-        partition = new_array<IndexType>(thread_num + 1);
-        balanced_partition_row_by_nnz_sell(col_index, num_nnzs, row_num_perC, total_chunk_num, max_row_width, thread_num, partition);
+        partition = arena.alloc_array<IndexType>(thread_num + 1);
+        balanced_partition_row_by_nnz_sell(chunk_ptr, col_index, num_nnzs, total_chunk_num, thread_num, partition);
     }
     #pragma omp parallel num_threads(thread_num)
     {
         IndexType tid = Le_get_thread_id();
         IndexType local_chunk_start = partition[tid];
         IndexType local_chunk_end   = partition[tid + 1];
-        __spmv_sell_perthread(alpha, col_index, values, x, beta, y, local_chunk_start, local_chunk_end, num_rows, max_row_width, row_num_perC);
+        Le_arena_scope thread_scope(arena, tid);
+        ValueType *sum = arena.alloc_array<ValueType>(row_num_perC, tid);
+        __spmv_sell_perthread(alpha, chunk_ptr, col_index, values, x, beta, y, local_chunk_start, local_chunk_end, num_rows, max_row_width, row_num_perC, sum);
     }
 }
 
@@ -203,23 +188,23 @@ template <typename IndexType, typename ValueType>
 void LeSpMV_sell(const ValueType alpha, const S_ELL_Matrix<IndexType, ValueType>& sell, const ValueType * x, const ValueType beta, ValueType * y){
     if (0 == sell.kernel_flag)
     {
-        __spmv_sell_serial_simple(sell.num_rows, sell.sliceWidth, sell.chunk_num, alpha, sell.row_width, sell.col_index, sell.values, x, beta, y);
+        __spmv_sell_serial_simple(sell.num_rows, sell.sliceWidth, sell.chunk_num, alpha, sell.row_width, sell.chunk_ptr, sell.col_index, sell.values, x, beta, y, Le_get_arena(sell.arena));
 
     }
     else if(1 == sell.kernel_flag)
     {
-        __spmv_sell_omp_simple(sell.num_rows, sell.sliceWidth, sell.chunk_num, alpha, sell.row_width, sell.col_index, sell.values, x, beta, y);
+        __spmv_sell_omp_simple(sell.num_rows, sell.sliceWidth, sell.chunk_num, alpha, sell.row_width, sell.chunk_ptr, sell.col_index, sell.values, x, beta, y, Le_get_arena(sell.arena));
 
     }
     else if(2 == sell.kernel_flag)
     {
         // call the load balanced by nnz of chunks in omp
         // just consider RowMajor
-        __spmv_sell_omp_lb_row( sell.num_rows, sell.sliceWidth, sell.chunk_num, sell.num_nnzs, alpha, sell.row_width, sell.col_index, sell.values, x, beta, y, sell.partition);
+        __spmv_sell_omp_lb_row( sell.num_rows, sell.sliceWidth, sell.chunk_num, sell.num_nnzs, alpha, sell.row_width, sell.chunk_ptr, sell.col_index, sell.values, x, beta, y, sell.partition, Le_get_arena(sell.arena));
     }
     else{
         //DEFAULT: omp simple implementation
-        __spmv_sell_omp_simple(sell.num_rows, sell.sliceWidth, sell.chunk_num, alpha, sell.row_width, sell.col_index, sell.values, x, beta, y);
+        __spmv_sell_omp_simple(sell.num_rows, sell.sliceWidth, sell.chunk_num, alpha, sell.row_width, sell.chunk_ptr, sell.col_index, sell.values, x, beta, y, Le_get_arena(sell.arena));
     }
 }
 
@@ -21,8 +21,9 @@ void __spmv_sell_cR_serial_simple( const IndexType *Reorder,
                                    const IndexType total_chunk_num,
                                    const ValueType alpha,
                                    const IndexType *max_row_width,
-                                   const IndexType *const *col_index,
-                                   const ValueType *const *values,
+                                   const IndexType *chunk_ptr,
+                                   const IndexType *col_index,
+                                   const ValueType *values,
                                    const ValueType *x, 
                                    const ValueType beta, 
                                    ValueType * y)
@@ -43,10 +44,10 @@ void __spmv_sell_cR_serial_simple( const IndexType *Reorder,
             for (size_t i = 0; i < chunk_width; i++)
             {
                 size_t col_index_pos = row * chunk_width + i;
-                size_t col = col_index[chunkID][col_index_pos];
+                size_t col = col_index[chunk_ptr[chunkID] + col_index_pos];
 
                 if (col >= 0) { // 检查是否为填充的空位
-                    sum += values[chunkID][col_index_pos] * x[col];
+                    sum += values[chunk_ptr[chunkID] + col_index_pos] * x[col];
                 }
             }
 
@@ -62,8 +63,9 @@ void __spmv_sell_cR_omp_simple( const IndexType * Reorder,
                                 const IndexType total_chunk_num,
                                 const ValueType alpha,
                                 const IndexType *max_row_width,
-                                const IndexType * const *col_index,
-                                const ValueType * const *values,
+                                const IndexType *chunk_ptr,
+                                const IndexType *col_index,
+                                const ValueType *values,
                                 const ValueType * x, 
                                 const ValueType beta, 
                                 ValueType * y)
@@ -88,10 +90,10 @@ void __spmv_sell_cR_omp_simple( const IndexType * Reorder,
             for (size_t i = 0; i < chunk_width; i++)
             {
                 size_t col_index_pos = row * chunk_width + i;
-                size_t col = col_index[chunkID][col_index_pos];
+                size_t col = col_index[chunk_ptr[chunkID] + col_index_pos];
 
                 if (col >= 0) { // 检查是否为填充的空位
-                    sum += values[chunkID][col_index_pos] * x[col];
+                    sum += values[chunk_ptr[chunkID] + col_index_pos] * x[col];
                 }
             }
 
@@ -103,8 +105,9 @@ void __spmv_sell_cR_omp_simple( const IndexType * Reorder,
 template <typename IndexType, typename ValueType>
 inline void __spmv_sell_cR_perthread(const IndexType * Reorder,
                                     const ValueType alpha, 
-                                    const IndexType * const *col_index,
-                                    const ValueType * const *values,
+                                    const IndexType *chunk_ptr,
+                                    const IndexType *col_index,
+                                    const ValueType *values,
                                     const ValueType * x, 
                                     const ValueType beta, 
                                     ValueType * y, 
@@ -130,15 +133,19 @@ inline void __spmv_sell_cR_perthread(const IndexType * Reorder,
             {
                 y[sumPos] = beta * y[sumPos];
             }
+            else
+            {
+                y[sumPos] = 0;
+            }
 
             #pragma omp simd reduction(+:sum)
             for (size_t i = 0; i < chunk_width; ++i) 
             {
                 size_t col_index_pos = row * chunk_width + i;
-                size_t col = col_index[chunkID][col_index_pos];
+                size_t col = col_index[chunk_ptr[chunkID] + col_index_pos];
 
                 if (col >= 0) { // 检查是否为填充的空位
-                    sum += values[chunkID][col_index_pos] * x[col];
+                    sum += values[chunk_ptr[chunkID] + col_index_pos] * x[col];
                 }
             }
             // Scale the sum by alpha and add to the y vector scaled by beta
@@ -162,19 +169,23 @@ void __spmv_sell_cR_omp_lb_row( const IndexType * Reorder,
                                 const IndexType num_nnzs, 
                                 const ValueType alpha, 
                                 const IndexType *max_row_width,
-                                const IndexType * const *col_index,
-                                const ValueType * const *values,
+                                const IndexType *chunk_ptr,
+                                const IndexType *col_index,
+                                const ValueType *values,
                                 const ValueType * x, 
                                 const ValueType beta, 
                                 ValueType * y,
-                                IndexType *partition)
+                                IndexType *partition,
+                                Le_arena &arena)
 {
     const IndexType thread_num = Le_get_thread_num();
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
     
     if(partition == nullptr)
     {
-        partition = new_array<IndexType>(thread_num + 1);
-        balanced_partition_row_by_nnz_sell(col_index, num_nnzs, row_num_perC, total_chunk_num, max_row_width, thread_num, partition);
+        partition = arena.alloc_array<IndexType>(thread_num + 1);
+        balanced_partition_row_by_nnz_sell(chunk_ptr, col_index, num_nnzs, total_chunk_num, thread_num, partition);
         
     }
     #pragma omp parallel num_threads(thread_num)
@@ -182,7 +193,7 @@ void __spmv_sell_cR_omp_lb_row( const IndexType * Reorder,
         IndexType tid = Le_get_thread_id();
         IndexType local_chunk_start = partition[tid];
         IndexType local_chunk_end   = partition[tid + 1];
-        __spmv_sell_cR_perthread(Reorder, alpha, col_index, values, x, beta, y, local_chunk_start, local_chunk_end, num_rows, max_row_width, row_num_perC);
+        __spmv_sell_cR_perthread(Reorder, alpha, chunk_ptr, col_index, values, x, beta, y, local_chunk_start, local_chunk_end, num_rows, max_row_width, row_num_perC);
     }
 }
 
@@ -191,22 +202,22 @@ void LeSpMV_sell_c_R(const ValueType alpha, const SELL_C_R_Matrix<IndexType, Val
 {
     if (0 == sell_c_R.kernel_flag)
     {
-        __spmv_sell_cR_serial_simple(sell_c_R.reorder, sell_c_R.num_rows, sell_c_R.chunkWidth_C, sell_c_R.validchunkNum, alpha, sell_c_R.chunk_len, sell_c_R.col_index, sell_c_R.values, x, beta, y);
+        __spmv_sell_cR_serial_simple(sell_c_R.reorder, sell_c_R.num_rows, sell_c_R.chunkWidth_C, sell_c_R.validchunkNum, alpha, sell_c_R.chunk_len, sell_c_R.chunk_ptr, sell_c_R.col_index, sell_c_R.values, x, beta, y);
     }
     else if (1 == sell_c_R.kernel_flag)
     {
-        __spmv_sell_cR_omp_simple(sell_c_R.reorder, sell_c_R.num_rows, sell_c_R.chunkWidth_C, sell_c_R.validchunkNum, alpha, sell_c_R.chunk_len, sell_c_R.col_index, sell_c_R.values, x, beta, y);
+        __spmv_sell_cR_omp_simple(sell_c_R.reorder, sell_c_R.num_rows, sell_c_R.chunkWidth_C, sell_c_R.validchunkNum, alpha, sell_c_R.chunk_len, sell_c_R.chunk_ptr, sell_c_R.col_index, sell_c_R.values, x, beta, y);
     }
     else if (2 == sell_c_R.kernel_flag)
     {
         // call the load balanced by nnz of chunks in omp
         // just consider RowMajor
-        __spmv_sell_cR_omp_lb_row( sell_c_R.reorder, sell_c_R.num_rows, sell_c_R.chunkWidth_C, sell_c_R.validchunkNum, sell_c_R.num_nnzs, alpha, sell_c_R.chunk_len, sell_c_R.col_index, sell_c_R.values, x, beta, y, sell_c_R.partition);
+        __spmv_sell_cR_omp_lb_row( sell_c_R.reorder, sell_c_R.num_rows, sell_c_R.chunkWidth_C, sell_c_R.validchunkNum, sell_c_R.num_nnzs, alpha, sell_c_R.chunk_len, sell_c_R.chunk_ptr, sell_c_R.col_index, sell_c_R.values, x, beta, y, sell_c_R.partition, Le_get_arena(sell_c_R.arena));
 
     }
     else{
         //DEFAULT: omp simple implementation
-        __spmv_sell_cR_omp_simple(sell_c_R.reorder, sell_c_R.num_rows, sell_c_R.chunkWidth_C, sell_c_R.validchunkNum, alpha, sell_c_R.chunk_len, sell_c_R.col_index, sell_c_R.values, x, beta, y);
+        __spmv_sell_cR_omp_simple(sell_c_R.reorder, sell_c_R.num_rows, sell_c_R.chunkWidth_C, sell_c_R.validchunkNum, alpha, sell_c_R.chunk_len, sell_c_R.chunk_ptr, sell_c_R.col_index, sell_c_R.values, x, beta, y);
     }
 }
 
@@ -2,7 +2,8 @@
  * @file spmv_sell_c_sigma.cpp
  * @author your name (you@domain.com)
  * @brief Simple implementation of SpMV in Sliced SELL-c-sigma format.
- *         Using OpenMP automatic parallism and vectorization.
+ *         Chunks are column-major, the C rows of a chunk are processed lane-wise
+ *         by AVX-512 / AVX2 masked gathers, other targets use omp simd.
  * @version 0.1
  * @date 2024-01-22
  * 
@@ -13,57 +14,461 @@
 #include"../include/LeSpMV.h"
 
 #include"../include/thread.h"
+#include<algorithm>
+#include<cstring>
+#include<type_traits>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include<immintrin.h>
+#endif
 
+// 通用路径一次处理的最大行数
+#define SELL_CS_ROW_GROUP 16
+
+// pattern-only 矩阵 (Pattern_Values) 只累加 x, 不读 values
+template <typename ValueArray>
+struct __sell_cs_is_pattern : std::false_type {};
+
+template <typename ValueType>
+struct __sell_cs_is_pattern<Pattern_Values<ValueType>> : std::true_type {};
+
+// 量化数值 (Quantized_Values) 带逐行 / 逐 chunk 的缩放因子
+template <typename ValueArray>
+struct __sell_cs_is_quantized : std::false_type {};
+
+template <typename ValueType, typename Code>
+struct __sell_cs_is_quantized<Quantized_Values<ValueType, Code>> : std::true_type {};
+
+/**
+ * @brief y[reorder[r]] = alpha * sum[r] + beta * y[reorder[r]], r < n
+ */
+template <typename IndexType, typename ValueType>
+inline void __sell_cs_store_rows(const ValueType *sum, const IndexType n, const IndexType *reorder, const ValueType alpha, const ValueType beta, ValueType *y)
+{
+    if (beta == 0)
+        for (IndexType r = 0; r < n; ++r)
+            y[reorder[r]] = alpha * sum[r];
+    else
+        for (IndexType r = 0; r < n; ++r)
+            y[reorder[r]] = alpha * sum[r] + beta * y[reorder[r]];
+}
+
+#if defined(__AVX2__)
+/**
+ * @brief lane 组的数值加载: 稠密 values 直接加载, 值编号压缩 (SELL-VI) 先把
+ *        lanes 个 uint8_t / uint16_t 编号零扩展为 32 位, 再从值表 gather.
+ */
+static inline __m256 __sell_cs_load8f(const float *va) { return _mm256_loadu_ps(va); }
+static inline __m256 __sell_cs_load8f(const Indexed_Values<float, uint8_t> va)
+{
+    return _mm256_i32gather_ps(va.table, _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) va.index)), 4);
+}
+static inline __m256 __sell_cs_load8f(const Indexed_Values<float, uint16_t> va)
+{
+    return _mm256_i32gather_ps(va.table, _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) va.index)), 4);
+}
+
+static inline __m256d __sell_cs_load4d(const double *va) { return _mm256_loadu_pd(va); }
+static inline __m256d __sell_cs_load4d(const Indexed_Values<double, uint8_t> va)
+{
+    int code4;
+    memcpy(&code4, va.index, sizeof(code4));
+    return _mm256_i32gather_pd(va.table, _mm_cvtepu8_epi32(_mm_cvtsi32_si128(code4)), 8);
+}
+static inline __m256d __sell_cs_load4d(const Indexed_Values<double, uint16_t> va)
+{
+    return _mm256_i32gather_pd(va.table, _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *) va.index)), 8);
+}
+
+/**
+ * @brief 量化数值在寄存器中解码: int8 符号扩展后转浮点, BF16 左移 16 位即为 float,
+ *        FP16 用 F16C 的 vcvtph2ps (没有 F16C 时逐个解码)
+ */
+static inline __m256 __sell_cs_load8f(const Quantized_Values<float, int8_t> va)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *) va.codes)));
+}
+static inline __m256 __sell_cs_load8f(const Quantized_Values<float, Le_bfloat16> va)
+{
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) va.codes)), 16));
+}
+static inline __m256 __sell_cs_load8f(const Quantized_Values<float, Le_half> va)
+{
+#if defined(__F16C__)
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *) va.codes));
+#else
+    float buf[8];
+    for (int l = 0; l < 8; ++l)
+        buf[l] = le_dequantize(va.codes[l]);
+    return _mm256_loadu_ps(buf);
+#endif
+}
+
+static inline __m256d __sell_cs_load4d(const Quantized_Values<double, int8_t> va)
+{
+    int code4;
+    memcpy(&code4, va.codes, sizeof(code4));
+    return _mm256_cvtepi32_pd(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(code4)));
+}
+static inline __m256d __sell_cs_load4d(const Quantized_Values<double, Le_bfloat16> va)
+{
+    return _mm256_cvtps_pd(_mm_castsi128_ps(_mm_slli_epi32(_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *) va.codes)), 16)));
+}
+static inline __m256d __sell_cs_load4d(const Quantized_Values<double, Le_half> va)
+{
+#if defined(__F16C__)
+    return _mm256_cvtps_pd(_mm_cvtph_ps(_mm_loadl_epi64((const __m128i *) va.codes)));
+#else
+    double buf[4];
+    for (int l = 0; l < 4; ++l)
+        buf[l] = le_dequantize(va.codes[l]);
+    return _mm256_loadu_pd(buf);
+#endif
+}
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+static inline __m512d __sell_cs_load8d(const double *va) { return _mm512_loadu_pd(va); }
+static inline __m512d __sell_cs_load8d(const Indexed_Values<double, uint8_t> va)
+{
+    return _mm512_i32gather_pd(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) va.index)), va.table, 8);
+}
+static inline __m512d __sell_cs_load8d(const Indexed_Values<double, uint16_t> va)
+{
+    return _mm512_i32gather_pd(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) va.index)), va.table, 8);
+}
+
+static inline __m512 __sell_cs_load16f(const float *va) { return _mm512_loadu_ps(va); }
+static inline __m512 __sell_cs_load16f(const Indexed_Values<float, uint8_t> va)
+{
+    return _mm512_i32gather_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *) va.index)), va.table, 4);
+}
+static inline __m512 __sell_cs_load16f(const Indexed_Values<float, uint16_t> va)
+{
+    return _mm512_i32gather_ps(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *) va.index)), va.table, 4);
+}
+
+static inline __m512d __sell_cs_load8d(const Quantized_Values<double, int8_t> va)
+{
+    return _mm512_cvtepi32_pd(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *) va.codes)));
+}
+static inline __m512d __sell_cs_load8d(const Quantized_Values<double, Le_bfloat16> va)
+{
+    return _mm512_cvtps_pd(_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) va.codes)), 16)));
+}
+static inline __m512d __sell_cs_load8d(const Quantized_Values<double, Le_half> va)
+{
+    // vcvtph2ps 的 512 位形式只需 AVX-512F, 取低 8 个
+    const __m512 f = _mm512_cvtph_ps(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) va.codes)));
+    return _mm512_cvtps_pd(_mm512_castps512_ps256(f));
+}
+
+static inline __m512 __sell_cs_load16f(const Quantized_Values<float, int8_t> va)
+{
+    return _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i *) va.codes)));
+}
+static inline __m512 __sell_cs_load16f(const Quantized_Values<float, Le_bfloat16> va)
+{
+    return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *) va.codes)), 16));
+}
+static inline __m512 __sell_cs_load16f(const Quantized_Values<float, Le_half> va)
+{
+    return _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i *) va.codes));
+}
+#endif
+
+/**
+ * @brief 手写向量化的 lane 组: 一个向量寄存器处理 chunk 内相邻的 lanes 行,
+ *        第 j 列 lanes 个列号连续加载, 以 col >= 0 为 mask 做 gather,
+ *        结果经 reorder 写回 y (AVX-512 为 mask scatter).
+ *        lanes = 0 表示当前编译目标没有对应实现, 使用 omp simd 的通用路径.
+ */
 template <typename IndexType, typename ValueType>
+struct __sell_cs_simd
+{
+    static const int lanes = 0;
+    template <typename ValueArray>
+    static void rows(const IndexType *, const ValueArray, const IndexType, const IndexType, const IndexType *, const IndexType, const ValueType *, const ValueType, const ValueType *, const ValueType, ValueType *) {}
+};
+
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+
+template <>
+struct __sell_cs_simd<int, double>
+{
+    static const int lanes = 8;
+    template <typename ValueArray>
+    static inline void rows(const int *ci, const ValueArray va, const int width, const int C, const int *reorder, const int valid, const double *rs,
+                            const double alpha, const double *x, const double beta, double *y)
+    {
+        __m512d sum = _mm512_setzero_pd();
+        for (int j = 0; j < width; ++j)
+        {
+            const __m256i  col = _mm256_loadu_si256((const __m256i *) (ci + (size_t) j * C));
+            const __mmask8 m   = _mm256_cmpge_epi32_mask(col, _mm256_setzero_si256());
+            const __m512d  xv  = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), m, col, x, 8);
+            if constexpr (__sell_cs_is_pattern<ValueArray>::value)
+                sum = _mm512_add_pd(sum, xv);
+            else
+                sum = _mm512_fmadd_pd(__sell_cs_load8d(va + (size_t) j * C), xv, sum);
+        }
+        if (rs != nullptr)    // 量化数值的逐行缩放因子
+            sum = _mm512_mul_pd(_mm512_loadu_pd(rs), sum);
+        const __mmask8 rm  = valid >= 8 ? (__mmask8) 0xFF : (__mmask8) ((1u << valid) - 1);
+        const __m256i  dst = _mm256_maskz_loadu_epi32(rm, reorder);
+        __m512d out = _mm512_mul_pd(_mm512_set1_pd(alpha), sum);
+        if (beta != 0)
+            out = _mm512_fmadd_pd(_mm512_set1_pd(beta), _mm512_mask_i32gather_pd(_mm512_setzero_pd(), rm, dst, y, 8), out);
+        _mm512_mask_i32scatter_pd(y, rm, dst, out, 8);
+    }
+};
+
+template <>
+struct __sell_cs_simd<int, float>
+{
+    static const int lanes = 16;
+    template <typename ValueArray>
+    static inline void rows(const int *ci, const ValueArray va, const int width, const int C, const int *reorder, const int valid, const float *rs,
+                            const float alpha, const float *x, const float beta, float *y)
+    {
+        __m512 sum = _mm512_setzero_ps();
+        for (int j = 0; j < width; ++j)
+        {
+            const __m512i   col = _mm512_loadu_si512((const void *) (ci + (size_t) j * C));
+            const __mmask16 m   = _mm512_cmpge_epi32_mask(col, _mm512_setzero_si512());
+            const __m512    xv  = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), m, col, x, 4);
+            if constexpr (__sell_cs_is_pattern<ValueArray>::value)
+                sum = _mm512_add_ps(sum, xv);
+            else
+                sum = _mm512_fmadd_ps(__sell_cs_load16f(va + (size_t) j * C), xv, sum);
+        }
+        if (rs != nullptr)    // 量化数值的逐行缩放因子
+            sum = _mm512_mul_ps(_mm512_loadu_ps(rs), sum);
+        const __mmask16 rm  = valid >= 16 ? (__mmask16) 0xFFFF : (__mmask16) ((1u << valid) - 1);
+        const __m512i   dst = _mm512_maskz_loadu_epi32(rm, reorder);
+        __m512 out = _mm512_mul_ps(_mm512_set1_ps(alpha), sum);
+        if (beta != 0)
+            out = _mm512_fmadd_ps(_mm512_set1_ps(beta), _mm512_mask_i32gather_ps(_mm512_setzero_ps(), rm, dst, y, 4), out);
+        _mm512_mask_i32scatter_ps(y, rm, dst, out, 4);
+    }
+};
+
+template <>
+struct __sell_cs_simd<long long, double>
+{
+    static const int lanes = 8;
+    template <typename ValueArray>
+    static inline void rows(const long long *ci, const ValueArray va, const long long width, const long long C, const long long *reorder, const long long valid, const double *rs,
+                            const double alpha, const double *x, const double beta, double *y)
+    {
+        __m512d sum = _mm512_setzero_pd();
+        for (long long j = 0; j < width; ++j)
+        {
+            const __m512i  col = _mm512_loadu_si512((const void *) (ci + j * C));
+            const __mmask8 m   = _mm512_cmpge_epi64_mask(col, _mm512_setzero_si512());
+            const __m512d  xv  = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), m, col, x, 8);
+            if constexpr (__sell_cs_is_pattern<ValueArray>::value)
+                sum = _mm512_add_pd(sum, xv);
+            else
+                sum = _mm512_fmadd_pd(__sell_cs_load8d(va + j * C), xv, sum);
+        }
+        if (rs != nullptr)    // 量化数值的逐行缩放因子
+            sum = _mm512_mul_pd(_mm512_loadu_pd(rs), sum);
+        const __mmask8 rm  = valid >= 8 ? (__mmask8) 0xFF : (__mmask8) ((1u << valid) - 1);
+        const __m512i  dst = _mm512_maskz_loadu_epi64(rm, reorder);
+        __m512d out = _mm512_mul_pd(_mm512_set1_pd(alpha), sum);
+        if (beta != 0)
+            out = _mm512_fmadd_pd(_mm512_set1_pd(beta), _mm512_mask_i64gather_pd(_mm512_setzero_pd(), rm, dst, y, 8), out);
+        _mm512_mask_i64scatter_pd(y, rm, dst, out, 8);
+    }
+};
+
+template <>
+struct __sell_cs_simd<long long, float>
+{
+    static const int lanes = 8;
+    template <typename ValueArray>
+    static inline void rows(const long long *ci, const ValueArray va, const long long width, const long long C, const long long *reorder, const long long valid, const float *rs,
+                            const float alpha, const float *x, const float beta, float *y)
+    {
+        __m256 sum = _mm256_setzero_ps();
+        for (long long j = 0; j < width; ++j)
+        {
+            const __m512i  col = _mm512_loadu_si512((const void *) (ci + j * C));
+            const __mmask8 m   = _mm512_cmpge_epi64_mask(col, _mm512_setzero_si512());
+            const __m256   xv  = _mm512_mask_i64gather_ps(_mm256_setzero_ps(), m, col, x, 4);
+            if constexpr (__sell_cs_is_pattern<ValueArray>::value)
+                sum = _mm256_add_ps(sum, xv);
+            else
+                sum = _mm256_fmadd_ps(__sell_cs_load8f(va + j * C), xv, sum);
+        }
+        if (rs != nullptr)    // 量化数值的逐行缩放因子
+            sum = _mm256_mul_ps(_mm256_loadu_ps(rs), sum);
+        const __mmask8 rm  = valid >= 8 ? (__mmask8) 0xFF : (__mmask8) ((1u << valid) - 1);
+        const __m512i  dst = _mm512_maskz_loadu_epi64(rm, reorder);
+        __m256 out = _mm256_mul_ps(_mm256_set1_ps(alpha), sum);
+        if (beta != 0)
+            out = _mm256_fmadd_ps(_mm256_set1_ps(beta), _mm512_mask_i64gather_ps(_mm256_setzero_ps(), rm, dst, y, 4), out);
+        _mm512_mask_i64scatter_ps(y, rm, dst, out, 4);
+    }
+};
+
+#elif defined(__AVX2__)
+
+// AVX2 没有 scatter, 结果经 reorder 标量写回
+template <>
+struct __sell_cs_simd<int, double>
+{
+    static const int lanes = 4;
+    template <typename ValueArray>
+    static inline void rows(const int *ci, const ValueArray va, const int width, const int C, const int *reorder, const int valid, const double *rs,
+                            const double alpha, const double *x, const double beta, double *y)
+    {
+        __m256d sum = _mm256_setzero_pd();
+        for (int j = 0; j < width; ++j)
+        {
+            const __m128i col = _mm_loadu_si128((const __m128i *) (ci + (size_t) j * C));
+            const __m256d m   = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmpgt_epi32(col, _mm_set1_epi32(-1))));
+            const __m256d xv  = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, col, m, 8);
+            if constexpr (__sell_cs_is_pattern<ValueArray>::value)
+                sum = _mm256_add_pd(sum, xv);
+            else
+                sum = _mm256_add_pd(sum, _mm256_mul_pd(__sell_cs_load4d(va + (size_t) j * C), xv));
+        }
+        if (rs != nullptr)    // 量化数值的逐行缩放因子
+            sum = _mm256_mul_pd(_mm256_loadu_pd(rs), sum);
+        double buf[4];
+        _mm256_storeu_pd(buf, sum);
+        __sell_cs_store_rows(buf, std::min(valid, 4), reorder, alpha, beta, y);
+    }
+};
+
+template <>
+struct __sell_cs_simd<int, float>
+{
+    static const int lanes = 8;
+    template <typename ValueArray>
+    static inline void rows(const int *ci, const ValueArray va, const int width, const int C, const int *reorder, const int valid, const float *rs,
+                            const float alpha, const float *x, const float beta, float *y)
+    {
+        __m256 sum = _mm256_setzero_ps();
+        for (int j = 0; j < width; ++j)
+        {
+            const __m256i col = _mm256_loadu_si256((const __m256i *) (ci + (size_t) j * C));
+            const __m256  m   = _mm256_castsi256_ps(_mm256_cmpgt_epi32(col, _mm256_set1_epi32(-1)));
+            const __m256  xv  = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), x, col, m, 4);
+            if constexpr (__sell_cs_is_pattern<ValueArray>::value)
+                sum = _mm256_add_ps(sum, xv);
+            else
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(__sell_cs_load8f(va + (size_t) j * C), xv));
+        }
+        if (rs != nullptr)    // 量化数值的逐行缩放因子
+            sum = _mm256_mul_ps(_mm256_loadu_ps(rs), sum);
+        float buf[8];
+        _mm256_storeu_ps(buf, sum);
+        __sell_cs_store_rows(buf, std::min(valid, 8), reorder, alpha, beta, y);
+    }
+};
+
+#endif
+
+/**
+ * @brief 一个 chunk 的 C 行 (chunk 内按列存储). C 是 lanes 的整数倍时
+ *        按 lane 组调用手写向量化实现, 否则 omp simd 跨行累加.
+ *        valid_rows < C 只出现在最后一个 chunk, 多余的行全是填充位.
+ */
+template <typename IndexType, typename ValueType, typename ValueArray>
+inline void __spmv_sell_cs_chunk(const IndexType *ci,
+                                 const ValueArray va,
+                                 const IndexType chunk_width,
+                                 const IndexType C,
+                                 const IndexType *reorder,
+                                 const IndexType valid_rows,
+                                 const IndexType row_begin,
+                                 const ValueType alpha,
+                                 const ValueType *x,
+                                 const ValueType beta,
+                                 ValueType *y)
+{
+    // 量化数值: 整个 chunk 共用一个缩放因子时并入 alpha, 否则逐行乘
+    ValueType chunk_alpha = alpha;
+    bool per_row_scale = false;
+    if constexpr (__sell_cs_is_quantized<ValueArray>::value)
+    {
+        if (va.scale_rows % C == 0)
+            chunk_alpha = alpha * value_row_scale(va, (size_t) row_begin);
+        else
+            per_row_scale = true;
+    }
+
+    typedef __sell_cs_simd<IndexType, ValueType> simd;
+    IndexType g = 0;
+    if (simd::lanes > 0 && C % simd::lanes == 0)
+    {
+        ValueType rs[SELL_CS_ROW_GROUP];
+        for (; g < valid_rows; g += simd::lanes)
+        {
+            if (per_row_scale)
+                for (IndexType r = 0; r < simd::lanes; ++r)
+                    rs[r] = g + r < valid_rows ? value_row_scale(va, (size_t) (row_begin + g + r)) : ValueType(0);
+            simd::rows(ci + g, va + g, chunk_width, C, reorder + g, valid_rows - g, per_row_scale ? rs : nullptr, chunk_alpha, x, beta, y);
+        }
+        return;
+    }
+
+    for (; g < valid_rows; g += SELL_CS_ROW_GROUP)
+    {
+        const IndexType n = std::min((IndexType) SELL_CS_ROW_GROUP, valid_rows - g);
+        ValueType sum[SELL_CS_ROW_GROUP] = {0};
+        for (IndexType j = 0; j < chunk_width; ++j)
+        {
+            const IndexType *cj = ci + (size_t) j * C + g;
+            const ValueArray vj = va + (size_t) j * C + g;
+            #pragma omp simd
+            for (IndexType r = 0; r < n; ++r)
+            {
+                const IndexType col = cj[r];
+                sum[r] += (col >= 0) ? vj[r] * x[col] : ValueType(0);   // 填充位 col = -1
+            }
+        }
+        if (per_row_scale)
+            for (IndexType r = 0; r < n; ++r)
+                sum[r] *= value_row_scale(va, (size_t) (row_begin + g + r));
+        __sell_cs_store_rows(sum, n, reorder + g, chunk_alpha, beta, y);
+    }
+}
+
+template <typename IndexType, typename ValueType, typename ValueArray>
 void __spmv_sell_cs_serial_simple( const IndexType * Reorder,
                                    const IndexType num_rows,
                                    const IndexType chunk_rowNum,
                                    const IndexType total_chunk_num,
                                    const ValueType alpha,
                                    const IndexType *max_row_width,
-                                   const IndexType * const *col_index,
-                                   const ValueType * const *values,
+                                   const IndexType *chunk_ptr,
+                                   const IndexType *col_index,
+                                   const ValueArray values,
                                    const ValueType * x, 
                                    const ValueType beta, 
                                    ValueType * y)
 {
-    for ( size_t chunkID = 0; chunkID < total_chunk_num; ++chunkID)
+    for (IndexType chunkID = 0; chunkID < total_chunk_num; ++chunkID)
     {
-        size_t chunk_width = max_row_width[chunkID];
-        size_t chunk_start_row = chunkID * chunk_rowNum;
-
-        for (size_t row = 0; row < chunk_rowNum; row++)
-        {
-            size_t global_row = chunk_start_row + row;
-            if ( global_row >= num_rows) break; // 越界检查
-            
-            size_t sumPos = Reorder[global_row];
-            ValueType sum    = 0;
-
-            for (size_t i = 0; i < chunk_width; i++)
-            {
-                size_t col_index_pos = row * chunk_width + i;
-                size_t col = col_index[chunkID][col_index_pos];
-
-                if (col >= 0) { // 检查是否为填充的空位
-                    sum += values[chunkID][col_index_pos] * x[col];
-                }
-            }
-
-            y[sumPos] = alpha * sum + beta * y[sumPos];
-        }   
+        const IndexType chunk_start_row = chunkID * chunk_rowNum;
+        const IndexType valid_rows = std::min(chunk_rowNum, num_rows - chunk_start_row);
+        __spmv_sell_cs_chunk(col_index + chunk_ptr[chunkID], values + chunk_ptr[chunkID], max_row_width[chunkID], chunk_rowNum, Reorder + chunk_start_row, valid_rows, chunk_start_row, alpha, x, beta, y);
     }
 }
 
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 void __spmv_sell_cs_omp_simple( const IndexType * Reorder,
                                 const IndexType num_rows,
                                 const IndexType chunk_rowNum,
                                 const IndexType total_chunk_num,
                                 const ValueType alpha,
                                 const IndexType *max_row_width,
-                                const IndexType * const *col_index,
-                                const ValueType * const *values,
+                                const IndexType *chunk_ptr,
+                                const IndexType *col_index,
+                                const ValueArray values,
                                 const ValueType * x, 
                                 const ValueType beta, 
                                 ValueType * y)
@@ -71,40 +476,20 @@ void __spmv_sell_cs_omp_simple( const IndexType * Reorder,
     const IndexType thread_num = Le_get_thread_num();
 
     #pragma omp parallel for num_threads(thread_num)
-    for ( size_t chunkID = 0; chunkID < total_chunk_num; ++chunkID)
+    for (IndexType chunkID = 0; chunkID < total_chunk_num; ++chunkID)
     {
-        size_t chunk_width = max_row_width[chunkID];
-        size_t chunk_start_row = chunkID * chunk_rowNum;
-
-        for (size_t row = 0; row < chunk_rowNum; row++)
-        {
-            size_t global_row = chunk_start_row + row;
-            if ( global_row >= num_rows) break; // 越界检查
-            
-            size_t sumPos = Reorder[global_row];
-            ValueType sum    = 0;
-
-            #pragma omp simd reduction(+:sum)
-            for (size_t i = 0; i < chunk_width; i++)
-            {
-                size_t col_index_pos = row * chunk_width + i;
-                size_t col = col_index[chunkID][col_index_pos];
-
-                if (col >= 0) { // 检查是否为填充的空位
-                    sum += values[chunkID][col_index_pos] * x[col];
-                }
-            }
-
-            y[sumPos] = alpha * sum + beta * y[sumPos];
-        }   
+        const IndexType chunk_start_row = chunkID * chunk_rowNum;
+        const IndexType valid_rows = std::min(chunk_rowNum, num_rows - chunk_start_row);
+        __spmv_sell_cs_chunk(col_index + chunk_ptr[chunkID], values + chunk_ptr[chunkID], max_row_width[chunkID], chunk_rowNum, Reorder + chunk_start_row, valid_rows, chunk_start_row, alpha, x, beta, y);
     }
 }
 
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 inline void __spmv_sell_cs_perthread(const IndexType * Reorder,
                                     const ValueType alpha, 
-                                    const IndexType * const *col_index,
-                                    const ValueType * const *values,
+                                    const IndexType *chunk_ptr,
+                                    const IndexType *col_index,
+                                    const ValueArray values,
                                     const ValueType * x, 
                                     const ValueType beta, 
                                     ValueType * y, 
@@ -114,47 +499,15 @@ inline void __spmv_sell_cs_perthread(const IndexType * Reorder,
                                     const IndexType *max_row_width, 
                                     const IndexType chunk_size)
 {
-    for (size_t chunkID = chunk_lrs; chunkID < chunk_lre; chunkID++)
+    for (IndexType chunkID = chunk_lrs; chunkID < chunk_lre; chunkID++)
     {
-        size_t chunk_width = max_row_width[chunkID];
-        size_t chunk_start_row = chunkID * chunk_size;
-
-        for (size_t row = 0; row < chunk_size; ++row)
-        {
-            size_t global_row = chunk_start_row + row;
-            if (global_row >= num_rows) break; // 越界检查
-
-            size_t sumPos = Reorder[global_row];
-            ValueType sum = 0.0;
-            if (beta)
-            {
-                y[sumPos] = beta * y[sumPos];
-            }
-
-            #pragma omp simd reduction(+:sum)
-            for (size_t i = 0; i < chunk_width; ++i) 
-            {
-                size_t col_index_pos = row * chunk_width + i;
-                size_t col = col_index[chunkID][col_index_pos];
-
-                if (col >= 0) { // 检查是否为填充的空位
-                    sum += values[chunkID][col_index_pos] * x[col];
-                }
-            }
-            // Scale the sum by alpha and add to the y vector scaled by beta
-            if(alpha == 1)
-            {
-                y[sumPos] += sum;
-            }
-            else {
-                // y[sumPos] = alpha * sum + beta * y[sumPos];
-                y[sumPos] += alpha * sum;
-            }
-        }
+        const IndexType chunk_start_row = chunkID * chunk_size;
+        const IndexType valid_rows = std::min(chunk_size, num_rows - chunk_start_row);
+        __spmv_sell_cs_chunk(col_index + chunk_ptr[chunkID], values + chunk_ptr[chunkID], max_row_width[chunkID], chunk_size, Reorder + chunk_start_row, valid_rows, chunk_start_row, alpha, x, beta, y);
     }
 }
 
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename ValueArray>
 void __spmv_sell_cs_omp_lb_row( const IndexType * Reorder,
                                 const IndexType num_rows,
                                 const IndexType row_num_perC,
@@ -162,19 +515,23 @@ void __spmv_sell_cs_omp_lb_row( const IndexType * Reorder,
                                 const IndexType num_nnzs, 
                                 const ValueType alpha, 
                                 const IndexType *max_row_width,
-                                const IndexType * const *col_index,
-                                const ValueType * const *values,
+                                const IndexType *chunk_ptr,
+                                const IndexType *col_index,
+                                const ValueArray values,
                                 const ValueType * x, 
                                 const ValueType beta, 
                                 ValueType * y,
-                                IndexType *partition)
+                                IndexType *partition,
+                                Le_arena &arena)
 {
     const IndexType thread_num = Le_get_thread_num();
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
     
     if(partition == nullptr)
     {
-        partition = new_array<IndexType>(thread_num + 1);
-        balanced_partition_row_by_nnz_sell(col_index, num_nnzs, row_num_perC, total_chunk_num, max_row_width, thread_num, partition);
+        partition = arena.alloc_array<IndexType>(thread_num + 1);
+        balanced_partition_row_by_nnz_sell(chunk_ptr, col_index, num_nnzs, total_chunk_num, thread_num, partition);
         
     }
     #pragma omp parallel num_threads(thread_num)
@@ -182,31 +539,61 @@ void __spmv_sell_cs_omp_lb_row( const IndexType * Reorder,
         IndexType tid = Le_get_thread_id();
         IndexType local_chunk_start = partition[tid];
         IndexType local_chunk_end   = partition[tid + 1];
-        __spmv_sell_cs_perthread(Reorder, alpha, col_index, values, x, beta, y, local_chunk_start, local_chunk_end, num_rows, max_row_width, row_num_perC);
+        __spmv_sell_cs_perthread(Reorder, alpha, chunk_ptr, col_index, values, x, beta, y, local_chunk_start, local_chunk_end, num_rows, max_row_width, row_num_perC);
     }
 }
 
-template <typename IndexType, typename ValueType>
-void LeSpMV_sell_c_sigma(const ValueType alpha, const SELL_C_Sigma_Matrix<IndexType, ValueType>& sell_c_sigma, const ValueType *x, const ValueType beta, ValueType *y)
+template <typename IndexType, typename ValueType, typename ValueArray>
+void __spmv_sell_cs(const ValueType alpha, const SELL_C_Sigma_Matrix<IndexType, ValueType>& sell_c_sigma, const ValueArray values, const ValueType *x, const ValueType beta, ValueType *y)
 {
     if (0 == sell_c_sigma.kernel_flag)
     {
-        __spmv_sell_cs_serial_simple(sell_c_sigma.reorder, sell_c_sigma.num_rows, sell_c_sigma.chunkWidth_C, sell_c_sigma.validchunkNum, alpha, sell_c_sigma.chunk_len, sell_c_sigma.col_index, sell_c_sigma.values, x, beta, y);
+        __spmv_sell_cs_serial_simple(sell_c_sigma.reorder, sell_c_sigma.num_rows, sell_c_sigma.chunkWidth_C, sell_c_sigma.validchunkNum, alpha, sell_c_sigma.chunk_len, sell_c_sigma.chunk_ptr, sell_c_sigma.col_index, values, x, beta, y);
     }
     else if (1 == sell_c_sigma.kernel_flag)
     {
-        __spmv_sell_cs_omp_simple(sell_c_sigma.reorder, sell_c_sigma.num_rows, sell_c_sigma.chunkWidth_C, sell_c_sigma.validchunkNum, alpha, sell_c_sigma.chunk_len, sell_c_sigma.col_index, sell_c_sigma.values, x, beta, y);
+        __spmv_sell_cs_omp_simple(sell_c_sigma.reorder, sell_c_sigma.num_rows, sell_c_sigma.chunkWidth_C, sell_c_sigma.validchunkNum, alpha, sell_c_sigma.chunk_len, sell_c_sigma.chunk_ptr, sell_c_sigma.col_index, values, x, beta, y);
     }
     else if (2 == sell_c_sigma.kernel_flag)
     {
         // call the load balanced by nnz of chunks in omp
         // just consider RowMajor
-        __spmv_sell_cs_omp_lb_row( sell_c_sigma.reorder, sell_c_sigma.num_rows, sell_c_sigma.chunkWidth_C, sell_c_sigma.validchunkNum, sell_c_sigma.num_nnzs, alpha, sell_c_sigma.chunk_len, sell_c_sigma.col_index, sell_c_sigma.values, x, beta, y, sell_c_sigma.partition);
+        __spmv_sell_cs_omp_lb_row( sell_c_sigma.reorder, sell_c_sigma.num_rows, sell_c_sigma.chunkWidth_C, sell_c_sigma.validchunkNum, sell_c_sigma.num_nnzs, alpha, sell_c_sigma.chunk_len, sell_c_sigma.chunk_ptr, sell_c_sigma.col_index, values, x, beta, y, sell_c_sigma.partition, Le_get_arena(sell_c_sigma.arena));
 
     }
     else{
         //DEFAULT: omp simple implementation
-        __spmv_sell_cs_omp_simple(sell_c_sigma.reorder, sell_c_sigma.num_rows, sell_c_sigma.chunkWidth_C, sell_c_sigma.validchunkNum, alpha, sell_c_sigma.chunk_len, sell_c_sigma.col_index, sell_c_sigma.values, x, beta, y);
+        __spmv_sell_cs_omp_simple(sell_c_sigma.reorder, sell_c_sigma.num_rows, sell_c_sigma.chunkWidth_C, sell_c_sigma.validchunkNum, alpha, sell_c_sigma.chunk_len, sell_c_sigma.chunk_ptr, sell_c_sigma.col_index, values, x, beta, y);
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_sell_c_sigma(const ValueType alpha, const SELL_C_Sigma_Matrix<IndexType, ValueType>& sell_c_sigma, const ValueType *x, const ValueType beta, ValueType *y)
+{
+    // pattern-only: chunk 只读列号, alpha 在写回 y 时乘一次; SELL-VI: 按编号查值表;
+    // 量化数值: lane 组在寄存器中解码, 缩放因子在写回 y 时乘
+    switch (sell_c_sigma.value_storage)
+    {
+        case PatternValues:
+            __spmv_sell_cs(alpha, sell_c_sigma, Pattern_Values<ValueType>(), x, beta, y);
+            break;
+        case IndexedValues8:
+            __spmv_sell_cs(alpha, sell_c_sigma, Indexed_Values<ValueType, uint8_t>{sell_c_sigma.value_table, (const uint8_t *) sell_c_sigma.packed_values}, x, beta, y);
+            break;
+        case IndexedValues16:
+            __spmv_sell_cs(alpha, sell_c_sigma, Indexed_Values<ValueType, uint16_t>{sell_c_sigma.value_table, (const uint16_t *) sell_c_sigma.packed_values}, x, beta, y);
+            break;
+        case HalfValues:
+            __spmv_sell_cs(alpha, sell_c_sigma, Quantized_Values<ValueType, Le_half>{(const Le_half *) sell_c_sigma.packed_values, sell_c_sigma.value_scale, (size_t) sell_c_sigma.scale_rows}, x, beta, y);
+            break;
+        case BFloat16Values:
+            __spmv_sell_cs(alpha, sell_c_sigma, Quantized_Values<ValueType, Le_bfloat16>{(const Le_bfloat16 *) sell_c_sigma.packed_values, sell_c_sigma.value_scale, (size_t) sell_c_sigma.scale_rows}, x, beta, y);
+            break;
+        case Int8Values:
+            __spmv_sell_cs(alpha, sell_c_sigma, Quantized_Values<ValueType, int8_t>{(const int8_t *) sell_c_sigma.packed_values, sell_c_sigma.value_scale, (size_t) sell_c_sigma.scale_rows}, x, beta, y);
+            break;
+        default:
+            __spmv_sell_cs(alpha, sell_c_sigma, (const ValueType *) sell_c_sigma.values, x, beta, y);
     }
 }
 
@@ -0,0 +1,469 @@
+/**
+ * @file spmv_transpose.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Transpose SpMV y = alpha * A^T * x + beta * y for CSR, SELL-C-sigma, BSR,
+ *         CSR5 and CSB, scattering from the row-wise storage without building A^T.
+ * @version 0.1
+ * @date 2024-03-29
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include"../include/LeSpMV.h"
+
+#include"../include/thread.h"
+
+template <typename IndexType>
+TransposeStrategy transpose_strategy(const IndexType num_nnzs, const IndexType num_cols)
+{
+    if ((double) num_nnzs >= TRANSPOSE_PRIVATE_NNZ_PER_COL * (double) num_cols)
+        return TRANSPOSE_PRIVATE;
+    return TRANSPOSE_COLOR;
+}
+template TransposeStrategy transpose_strategy<int>(const int num_nnzs, const int num_cols);
+template TransposeStrategy transpose_strategy<long long>(const long long num_nnzs, const long long num_cols);
+
+template <typename IndexType, typename ValueType>
+static void __transpose_scale_y(const ValueType beta, ValueType *y, const IndexType cs, const IndexType ce)
+{
+    if (beta == 0)
+        std::fill(y + cs, y + ce, ValueType(0));
+    else if (beta != 1)
+        for (IndexType col = cs; col < ce; ++col)
+            y[col] *= beta;
+}
+
+/**
+ * @brief Split units [0, num_units) into nblocks ranges of about equal weight,
+ *        unit_ptr is the weight prefix (e.g. row_offset).
+ */
+template <typename IndexType>
+static void __transpose_split(const IndexType num_units, const IndexType *unit_ptr, const IndexType nblocks, IndexType *bounds)
+{
+    const double total = (double) (unit_ptr[num_units] - unit_ptr[0]);
+    bounds[0] = 0;
+    for (IndexType b = 1; b < nblocks; ++b)
+    {
+        const IndexType target = unit_ptr[0] + (IndexType) (total * b / nblocks);
+        const IndexType u = (IndexType) (std::lower_bound(unit_ptr, unit_ptr + num_units + 1, target) - unit_ptr);
+        bounds[b] = std::max(bounds[b - 1], std::min(u, num_units));
+    }
+    bounds[nblocks] = num_units;
+}
+
+/**
+ * @brief Parallel conflict-free scatter of a row-wise format.
+ *        window(us, ue, lo, hi)  : column window [lo, hi) of units us to ue, lo = hi if empty
+ *        scatter(us, ue, buf, lo): buf[col - lo] += alpha * A(row, col) * x[row] for units us to ue
+ *        Block bounds, colors and private buffers come from arena.
+ */
+template <typename IndexType, typename ValueType, typename WindowFn, typename ScatterFn>
+static void __spmv_transpose_scatter(const IndexType num_cols,
+                                     const IndexType num_units,
+                                     const IndexType *unit_ptr,
+                                     const ValueType beta, ValueType *y,
+                                     const WindowFn &window,
+                                     const ScatterFn &scatter,
+                                     Le_arena &arena)
+{
+    const IndexType thread_num = Le_get_thread_num();
+    const IndexType nnzs = unit_ptr[num_units] - unit_ptr[0];
+    arena.reserve_threads(thread_num);
+    Le_arena_scope scope(arena);
+
+    if (transpose_strategy(nnzs, num_cols) == TRANSPOSE_COLOR)
+    {
+        const IndexType nblocks = thread_num * TRANSPOSE_COLOR_BLOCKS;
+        IndexType *bounds = arena.alloc_array<IndexType>(nblocks + 1);
+        IndexType *lo     = arena.alloc_array<IndexType>(nblocks);
+        IndexType *hi     = arena.alloc_array<IndexType>(nblocks);
+        __transpose_split(num_units, unit_ptr, nblocks, bounds);
+
+        #pragma omp parallel for num_threads(thread_num) schedule(dynamic, 1)
+        for (IndexType b = 0; b < nblocks; ++b)
+            window(bounds[b], bounds[b + 1], lo[b], hi[b]);
+
+        // 区间图着色: 按窗口起点排序, first-fit 给出最少颜色数
+        IndexType *order = arena.alloc_array<IndexType>(nblocks);
+        IndexType num_order = 0;
+        for (IndexType b = 0; b < nblocks; ++b)
+            if (lo[b] < hi[b])
+                order[num_order++] = b;
+        std::sort(order, order + num_order, [&](const IndexType a, const IndexType c){ return lo[a] < lo[c]; });
+
+        IndexType *color_of  = arena.alloc_array<IndexType>(nblocks);
+        IndexType *color_end = arena.alloc_array<IndexType>(nblocks);
+        IndexType num_colors = 0;
+        for (IndexType i = 0; i < num_order; ++i)
+        {
+            const IndexType b = order[i];
+            IndexType c = 0;
+            while (c < num_colors && color_end[c] > lo[b])
+                ++c;
+            if (c == num_colors)
+                num_colors++;
+            color_end[c] = hi[b];
+            color_of[b] = c;
+        }
+
+        // 平均每种颜色至少要有 thread_num / 2 个 block, 否则改用私有缓冲
+        if (num_colors * thread_num <= 2 * num_order)
+        {
+            // 按颜色计数排序: color_ptr[c] ~ color_ptr[c + 1] 为颜色 c 的 block
+            IndexType *color_ptr    = arena.alloc_array<IndexType>(num_colors + 1);
+            IndexType *color_blocks = arena.alloc_array<IndexType>(num_order);
+            std::fill(color_ptr, color_ptr + num_colors + 1, (IndexType) 0);
+            for (IndexType i = 0; i < num_order; ++i)
+                color_ptr[color_of[order[i]] + 1]++;
+            for (IndexType c = 0; c < num_colors; ++c)
+                color_ptr[c + 1] += color_ptr[c];
+            for (IndexType i = 0; i < num_order; ++i)
+                color_blocks[color_ptr[color_of[order[i]]]++] = order[i];
+            for (IndexType c = num_colors; c > 0; --c)
+                color_ptr[c] = color_ptr[c - 1];
+            color_ptr[0] = 0;
+
+            #pragma omp parallel num_threads(thread_num)
+            {
+                #pragma omp for
+                for (IndexType col = 0; col < num_cols; ++col)
+                    y[col] = (beta == 0) ? 0 : beta * y[col];
+
+                for (IndexType c = 0; c < num_colors; ++c)
+                {
+                    #pragma omp for schedule(dynamic, 1)
+                    for (IndexType i = color_ptr[c]; i < color_ptr[c + 1]; ++i)
+                    {
+                        const IndexType b = color_blocks[i];
+                        scatter(bounds[b], bounds[b + 1], y, (IndexType) 0);
+                    }
+                }
+            }
+            return;
+        }
+    }
+
+    // TRANSPOSE_PRIVATE
+    IndexType *bounds = arena.alloc_array<IndexType>(thread_num + 1);
+    IndexType *lo     = arena.alloc_array<IndexType>(thread_num);
+    IndexType *hi     = arena.alloc_array<IndexType>(thread_num);
+    ValueType **bufs  = arena.alloc_array<ValueType *>(thread_num);
+    std::fill(bufs, bufs + thread_num, nullptr);
+    __transpose_split(num_units, unit_ptr, thread_num, bounds);
+
+    #pragma omp parallel num_threads(thread_num)
+    {
+        const IndexType tid = Le_get_thread_id();
+        Le_arena_scope thread_scope(arena, tid);
+        window(bounds[tid], bounds[tid + 1], lo[tid], hi[tid]);
+        if (hi[tid] > lo[tid])
+        {
+            bufs[tid] = arena.alloc_array<ValueType>(hi[tid] - lo[tid], tid);
+            std::fill(bufs[tid], bufs[tid] + (hi[tid] - lo[tid]), ValueType(0));
+            scatter(bounds[tid], bounds[tid + 1], bufs[tid], lo[tid]);
+        }
+        #pragma omp barrier
+
+        // 按列划分归约, 每个 y[col] 只由一个线程写
+        const IndexType cs = (IndexType) ((double) num_cols * tid / thread_num);
+        const IndexType ce = (IndexType) ((double) num_cols * (tid + 1) / thread_num);
+        __transpose_scale_y(beta, y, cs, ce);
+        for (IndexType t = 0; t < thread_num; ++t)
+        {
+            if (bufs[t] == nullptr)
+                continue;
+            const IndexType s = std::max(cs, lo[t]);
+            const IndexType e = std::min(ce, hi[t]);
+            const ValueType *buf = bufs[t] - lo[t];
+            #pragma omp simd
+            for (IndexType col = s; col < e; ++col)
+                y[col] += buf[col];
+        }
+        // 其他线程读完本线程的缓冲后才结束 thread_scope
+        #pragma omp barrier
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CSR
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_csr_transpose(const ValueType alpha, const CSR_Matrix<IndexType, ValueType>& csr, const ValueType * x, const ValueType beta, ValueType * y)
+{
+    CHECK_VALUES(csr);
+    const IndexType *Ap = csr.row_offset;
+    const IndexType *Aj = csr.col_index;
+    const ValueType *Ax = csr.values;
+
+    auto window = [&](const IndexType rs, const IndexType re, IndexType &lo, IndexType &hi){
+        lo = csr.num_cols;
+        hi = 0;
+        for (IndexType jj = Ap[rs]; jj < Ap[re]; ++jj)
+        {
+            lo = std::min(lo, Aj[jj]);
+            hi = std::max(hi, Aj[jj] + 1);
+        }
+        if (lo >= hi)
+            lo = hi = 0;
+    };
+    auto scatter = [&](const IndexType rs, const IndexType re, ValueType *buf, const IndexType lo){
+        ValueType *out = buf - lo;
+        for (IndexType row = rs; row < re; ++row)
+        {
+            const ValueType xr = alpha * x[row];
+            for (IndexType jj = Ap[row]; jj < Ap[row + 1]; ++jj)
+                out[Aj[jj]] += Ax[jj] * xr;
+        }
+    };
+
+    if (0 == csr.kernel_flag)
+    {
+        __transpose_scale_y(beta, y, (IndexType) 0, csr.num_cols);
+        scatter((IndexType) 0, csr.num_rows, y, (IndexType) 0);
+    }
+    else
+        __spmv_transpose_scatter(csr.num_cols, csr.num_rows, Ap, beta, y, window, scatter, Le_get_arena(csr.arena));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SELL-C-sigma: units are chunks, rows map to the original ordering by reorder
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_sell_c_sigma_transpose(const ValueType alpha, const SELL_C_Sigma_Matrix<IndexType, ValueType>& sell_c_sigma, const ValueType * x, const ValueType beta, ValueType * y)
+{
+    CHECK_VALUES(sell_c_sigma);
+    const IndexType C = sell_c_sigma.chunkWidth_C;
+    const IndexType num_chunks = sell_c_sigma.validchunkNum;
+    const IndexType num_rows = sell_c_sigma.num_rows;
+
+    auto window = [&](const IndexType cs, const IndexType ce, IndexType &lo, IndexType &hi){
+        lo = sell_c_sigma.num_cols;
+        hi = 0;
+        // chunk cs ~ ce-1 在 col_index 中连续存放
+        const IndexType *cols = sell_c_sigma.col_index;
+        for (IndexType i = sell_c_sigma.chunk_ptr[cs]; i < sell_c_sigma.chunk_ptr[ce]; ++i)
+            if (cols[i] >= 0)
+            {
+                lo = std::min(lo, cols[i]);
+                hi = std::max(hi, cols[i] + 1);
+            }
+        if (lo >= hi)
+            lo = hi = 0;
+    };
+    auto scatter = [&](const IndexType cs, const IndexType ce, ValueType *buf, const IndexType lo){
+        ValueType *out = buf - lo;
+        for (IndexType chunk = cs; chunk < ce; ++chunk)
+        {
+            const IndexType width = sell_c_sigma.chunk_len[chunk];
+            const IndexType *cols = sell_c_sigma.chunk_col(chunk);
+            const ValueType *vals = sell_c_sigma.chunk_val(chunk);
+            for (IndexType r = 0; r < C; ++r)
+            {
+                const IndexType global_row = chunk * C + r;
+                if (global_row >= num_rows)
+                    break;
+                const ValueType xr = alpha * x[sell_c_sigma.reorder[global_row]];
+                for (IndexType j = 0; j < width; ++j)
+                {
+                    const IndexType i = j * C + r;  // chunk 内按列存储
+                    if (cols[i] < 0)
+                        break;  // 行内的填充位于末尾
+                    out[cols[i]] += vals[i] * xr;
+                }
+            }
+        }
+    };
+
+    if (0 == sell_c_sigma.kernel_flag)
+    {
+        __transpose_scale_y(beta, y, (IndexType) 0, sell_c_sigma.num_cols);
+        scatter((IndexType) 0, num_chunks, y, (IndexType) 0);
+        return;
+    }
+
+    // chunk 的权重为存储的元素数
+    __spmv_transpose_scatter(sell_c_sigma.num_cols, num_chunks, (const IndexType *) sell_c_sigma.chunk_ptr, beta, y, window, scatter, Le_get_arena(sell_c_sigma.arena));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// BSR: units are block rows
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_bsr_transpose(const ValueType alpha, const BSR_Matrix<IndexType, ValueType>& bsr, const ValueType * x, const ValueType beta, ValueType * y)
+{
+    const IndexType bdr = bsr.blockDim_r;
+    const IndexType bdc = bsr.blockDim_c;
+
+    auto window = [&](const IndexType bs, const IndexType be, IndexType &lo, IndexType &hi){
+        lo = bsr.num_cols;
+        hi = 0;
+        for (IndexType j = bsr.row_ptr[bs]; j < bsr.row_ptr[be]; ++j)
+        {
+            lo = std::min(lo, bsr.block_colindex[j] * bdc);
+            hi = std::max(hi, std::min(bsr.num_cols, (bsr.block_colindex[j] + 1) * bdc));
+        }
+        if (lo >= hi)
+            lo = hi = 0;
+    };
+    auto scatter = [&](const IndexType bs, const IndexType be, ValueType *buf, const IndexType lo){
+        ValueType *out = buf - lo;
+        for (IndexType br = bs; br < be; ++br)
+        {
+            const IndexType rows = std::min(bdr, bsr.num_rows - br * bdr);
+            for (IndexType j = bsr.row_ptr[br]; j < bsr.row_ptr[br + 1]; ++j)
+            {
+                const IndexType col_start = bsr.block_colindex[j] * bdc;
+                const IndexType cols = std::min(bdc, bsr.num_cols - col_start);
+                const ValueType *block = bsr.block_data + (size_t) j * bdr * bdc;
+                for (IndexType r = 0; r < rows; ++r)
+                {
+                    const ValueType xr = alpha * x[br * bdr + r];
+                    #pragma omp simd
+                    for (IndexType c = 0; c < cols; ++c)
+                        out[col_start + c] += block[r * bdc + c] * xr;
+                }
+            }
+        }
+    };
+
+    if (0 == bsr.kernel_flag)
+    {
+        __transpose_scale_y(beta, y, (IndexType) 0, bsr.num_cols);
+        scatter((IndexType) 0, bsr.mb, y, (IndexType) 0);
+    }
+    else
+        __spmv_transpose_scatter(bsr.num_cols, bsr.mb, bsr.row_ptr, beta, y, window, scatter, Le_get_arena(bsr.arena));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CSR5: units are tiles, the last unit is the tail in CSR order
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename IndexType, typename UIndexType, typename ValueType>
+void LeSpMV_csr5_transpose(const ValueType alpha, const CSR5_Matrix<IndexType, UIndexType, ValueType>& csr5, const ValueType * x, const ValueType beta, ValueType * y)
+{
+    CHECK_VALUES(csr5);
+    if (csr5.num_nnzs == 0 || csr5._p == 0)
+    {
+        __transpose_scale_y(beta, y, (IndexType) 0, csr5.num_cols);
+        return;
+    }
+
+    const IndexType tile_nnz  = csr5.omega * csr5.sigma;
+    const IndexType num_tiles = csr5._p;      // tiles 0 ~ _p-2 是转置存储的完整 tile, _p-1 为 tail
+
+    // tile 内第 i 个 (原 CSR 顺序) 元素的存储位置; fast track tile (整块在一行内) 未转置
+    auto position = [&](const IndexType tile, const IndexType i){
+        const IndexType base = tile * tile_nnz;
+        if (tile == num_tiles - 1 || csr5.tile_ptr[tile] == csr5.tile_ptr[tile + 1])
+            return base + i;
+        return base + (i % csr5.sigma) * csr5.omega + i / csr5.sigma;
+    };
+    auto tile_end = [&](const IndexType tile){
+        return (tile == num_tiles - 1) ? csr5.num_nnzs : (tile + 1) * tile_nnz;
+    };
+
+    auto window = [&](const IndexType ts, const IndexType te, IndexType &lo, IndexType &hi){
+        lo = csr5.num_cols;
+        hi = 0;
+        const IndexType ks = ts * tile_nnz;
+        const IndexType ke = (te == 0) ? 0 : tile_end(te - 1);
+        for (IndexType k = ks; k < ke; ++k)
+        {
+            lo = std::min(lo, csr5.col_index[k]);
+            hi = std::max(hi, csr5.col_index[k] + 1);
+        }
+        if (lo >= hi)
+            lo = hi = 0;
+    };
+    auto scatter = [&](const IndexType ts, const IndexType te, ValueType *buf, const IndexType lo){
+        if (ts >= te)
+            return;
+        ValueType *out = buf - lo;
+        const IndexType *Ap = csr5.row_offset;
+        IndexType row = (IndexType) (std::upper_bound(Ap, Ap + csr5.num_rows + 1, ts * tile_nnz) - Ap) - 1;
+        for (IndexType tile = ts; tile < te; ++tile)
+        {
+            const IndexType base = tile * tile_nnz;
+            const IndexType len  = tile_end(tile) - base;
+            for (IndexType i = 0; i < len; ++i)
+            {
+                while (Ap[row + 1] <= base + i)
+                    row++;
+                const IndexType k = position(tile, i);
+                out[csr5.col_index[k]] += csr5.values[k] * alpha * x[row];
+            }
+        }
+    };
+
+    if (0 == csr5.kernel_flag)
+    {
+        __transpose_scale_y(beta, y, (IndexType) 0, csr5.num_cols);
+        scatter((IndexType) 0, num_tiles, y, (IndexType) 0);
+        return;
+    }
+
+    Le_arena &arena = Le_get_arena(csr5.arena);
+    arena.reserve_threads(Le_get_thread_num());
+    Le_arena_scope scope(arena);
+    IndexType *tile_ptr = arena.alloc_array<IndexType>(num_tiles + 1);
+    for (IndexType tile = 0; tile < num_tiles; ++tile)
+        tile_ptr[tile] = tile * tile_nnz;
+    tile_ptr[num_tiles] = csr5.num_nnzs;
+    __spmv_transpose_scatter(csr5.num_cols, num_tiles, tile_ptr, beta, y, window, scatter, arena);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CSB: block columns own disjoint y segments
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename IndexType, typename ValueType>
+void LeSpMV_csb_transpose(const ValueType alpha, const CSB_Matrix<IndexType, ValueType>& csb, const ValueType * x, const ValueType beta, ValueType * y)
+{
+    const IndexType thread_num = Le_get_thread_num();
+    const int num_threads = (0 == csb.kernel_flag) ? 1 : (int) thread_num;
+
+    #pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1)
+    for (IndexType bc = 0; bc < csb.nbc; ++bc)
+    {
+        const IndexType cs = bc << csb.log_beta;
+        const IndexType ce = std::min(csb.num_cols, cs + csb.beta);
+        __transpose_scale_y(beta, y, cs, ce);
+
+        ValueType *y_seg = y + cs;
+        for (IndexType br = 0; br < csb.nbr; ++br)
+        {
+            const IndexType b = br * csb.nbc + bc;
+            const ValueType *x_seg = x + (br << csb.log_beta);
+            for (IndexType k = csb.blk_ptr[b]; k < csb.blk_ptr[b + 1]; ++k)
+                y_seg[csb.cloc[k]] += alpha * csb.values[k] * x_seg[csb.rloc[k]];
+        }
+    }
+}
+
+template void LeSpMV_csr_transpose<int, float>(const float, const CSR_Matrix<int, float>&, const float* , const float, float*);
+template void LeSpMV_csr_transpose<int, double>(const double, const CSR_Matrix<int, double>&, const double* , const double, double*);
+template void LeSpMV_csr_transpose<long long, float>(const float, const CSR_Matrix<long long, float>&, const float* , const float, float*);
+template void LeSpMV_csr_transpose<long long, double>(const double, const CSR_Matrix<long long, double>&, const double* , const double, double*);
+
+template void LeSpMV_sell_c_sigma_transpose<int, float>(const float, const SELL_C_Sigma_Matrix<int, float>&, const float* , const float, float*);
+template void LeSpMV_sell_c_sigma_transpose<int, double>(const double, const SELL_C_Sigma_Matrix<int, double>&, const double* , const double, double*);
+template void LeSpMV_sell_c_sigma_transpose<long long, float>(const float, const SELL_C_Sigma_Matrix<long long, float>&, const float* , const float, float*);
+template void LeSpMV_sell_c_sigma_transpose<long long, double>(const double, const SELL_C_Sigma_Matrix<long long, double>&, const double* , const double, double*);
+
+template void LeSpMV_bsr_transpose<int, float>(const float, const BSR_Matrix<int, float>&, const float* , const float, float*);
+template void LeSpMV_bsr_transpose<int, double>(const double, const BSR_Matrix<int, double>&, const double* , const double, double*);
+template void LeSpMV_bsr_transpose<long long, float>(const float, const BSR_Matrix<long long, float>&, const float* , const float, float*);
+template void LeSpMV_bsr_transpose<long long, double>(const double, const BSR_Matrix<long long, double>&, const double* , const double, double*);
+
+template void LeSpMV_csr5_transpose<int, uint32_t, float>(const float, const CSR5_Matrix<int, uint32_t, float>&, const float* , const float, float*);
+template void LeSpMV_csr5_transpose<int, uint32_t, double>(const double, const CSR5_Matrix<int, uint32_t, double>&, const double* , const double, double*);
+
+template void LeSpMV_csb_transpose<int, float>(const float, const CSB_Matrix<int, float>&, const float* , const float, float*);
+template void LeSpMV_csb_transpose<int, double>(const double, const CSB_Matrix<int, double>&, const double* , const double, double*);
+template void LeSpMV_csb_transpose<long long, float>(const float, const CSB_Matrix<long long, float>&, const float* , const float, float*);
+template void LeSpMV_csb_transpose<long long, double>(const double, const CSB_Matrix<long long, double>&, const double* , const double, double*);
@@ -22,6 +22,9 @@ void usage(int argc, char** argv)
     std::cout << "\t" << " --Index     = 0 (int) or 1 (long long) (default 1).\n";
     std::cout << "\t" << " --precision = 64(or 32), for counting features (default 64).\n";
     std::cout << "\t" << " --threads   = t_num, define the number of omp threads.\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx\n";
+    std::cout << "\t" << "               e.g. stencil27:64,64,64 | rmat:16,16 | gini:100000,100000,16,0.6 (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
     std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n"; 
 }
 
@@ -36,7 +39,9 @@ void test_features(int argc, char** argv)
         }
     }
 
-    if(mm_filename == NULL)
+    char * gen_spec = get_argval(argc, argv, "gen");
+
+    if(mm_filename == NULL && gen_spec == NULL)
     {
         printf("You need to input a matrix file! see '--help' for more details\n");
         return;
@@ -50,14 +55,38 @@ void test_features(int argc, char** argv)
     }
 
     MTX<IndexType, ValueType> mtx(matID);
-    mtx.MtxLoad(mm_filename);
-    mtx.CalculateFeatures();
-    mtx.FeaturesPrint();
 
-    // if (mtx.getRowNum() >= mtx.getTileSize() && mtx.getColNum() >= mtx.getTileSize()){
-        mtx.CalculateTilesExtraFeatures(mm_filename);
+    if(gen_spec != NULL)
+    {
+        // 直接在内存中生成矩阵，不经过 mtx 文件
+        unsigned long long seed = 1;
+        char * seed_str = get_argval(argc, argv, "seed");
+        if(seed_str != NULL)
+            seed = strtoull(seed_str, NULL, 10);
+
+        CSR_Matrix<IndexType, ValueType> csr = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr.num_rows == 0)
+            return;
+
+        mtx.MtxLoad(csr, gen_spec);
+        mtx.CalculateFeatures();
+        mtx.FeaturesPrint();
+
+        mtx.CalculateTilesExtraFeatures(csr);
         mtx.ExtraFeaturesPrint();
-    // }
+        delete_csr_matrix(csr);
+    }
+    else
+    {
+        mtx.MtxLoad(mm_filename);
+        mtx.CalculateFeatures();
+        mtx.FeaturesPrint();
+
+        // if (mtx.getRowNum() >= mtx.getTileSize() && mtx.getColNum() >= mtx.getTileSize()){
+            mtx.CalculateTilesExtraFeatures(mm_filename);
+            mtx.ExtraFeaturesPrint();
+        // }
+    }
     
     mtx.FeaturesWrite(MAT_FEATURES);
 }
@@ -81,7 +110,7 @@ int main(int argc, char** argv) {
         Index = atoi(Index_str);
 
     // 包括超线程
-    Le_set_thread_num(CPU_SOCKET * CPU_CORES_PER_SOC * CPU_HYPER_THREAD);
+    Le_set_thread_num(Le_get_hardware_thread_num());
     char * threads_str = get_argval(argc, argv, "threads");
     if(threads_str != NULL)
         Le_set_thread_num(atoi(threads_str));
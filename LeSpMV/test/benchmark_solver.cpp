@@ -0,0 +1,384 @@
+/**
+ * @file benchmark_solver.cpp for the time to solution of Krylov solvers in each format.
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Solve A x = b (b = A * 1) by CG, BiCGSTAB or GMRES with every format
+ *         as the SpMV back end. Reports conversion time, solve time,
+ *         iterations and iterations per second.
+ * @version 0.1
+ * @date 2024-03-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include<iostream>
+#include<cstdio>
+#include<cstring>
+#include<vector>
+#include<string>
+#include<sstream>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --matID     = m_num, giving the matrix ID number in dataset (default 0).\n";
+    std::cout << "\t" << " --Index     = 0 (int:default) or 1 (long long)\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --method    = kernel_flag of the SpMV, 0 serial, 1 omp simple (default), 2 load balanced\n";
+    std::cout << "\t" << " --solver    = cg (default), bicgstab or gmres\n";
+    std::cout << "\t" << " --precond   = jacobi (default) or none\n";
+    std::cout << "\t" << " --formats   = comma list of csr,coo,ell,sell,sell_c_sigma,sell_c_R,dia,bsr\n";
+    std::cout << "\t" << "               (default all but dia)\n";
+    std::cout << "\t" << " --tol       = relative residual tolerance (default SOLVER_TOL)\n";
+    std::cout << "\t" << " --maxiter   = iteration limit (default SOLVER_MAX_ITER)\n";
+    std::cout << "\t" << " --restart   = GMRES restart length (default GMRES_RESTART)\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+static std::vector<std::string> split_list(const char * str)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+struct Solver_Config
+{
+    std::string solver;
+    double tol;
+    int max_iter;
+    int restart;
+};
+
+template <typename SparseMatrix, typename SpMV>
+Solver_Result run_solver(const Solver_Config &cfg, const SparseMatrix &A, SpMV spmv,
+                         const typename SparseMatrix::value_type * b,
+                         const typename SparseMatrix::value_type * inv_diag)
+{
+    typedef typename SparseMatrix::value_type ValueType;
+    ValueType * x = new_array<ValueType>(A.num_cols);
+    std::fill(x, x + A.num_cols, ValueType(0));
+
+    Solver_Result res;
+    if (cfg.solver == "bicgstab")
+        res = LeSolve_bicgstab(A, spmv, b, x, inv_diag, cfg.tol, cfg.max_iter);
+    else if (cfg.solver == "gmres")
+        res = LeSolve_gmres(A, spmv, b, x, inv_diag, cfg.tol, cfg.max_iter, cfg.restart);
+    else
+        res = LeSolve_cg(A, spmv, b, x, inv_diag, cfg.tol, cfg.max_iter);
+
+    delete_array(x);
+    return res;
+}
+
+/**
+ * @brief Convert csr_ref to format and solve, return the solver result,
+ *        convert_ms is the conversion time.
+ */
+template <typename IndexType, typename ValueType>
+Solver_Result solve_in_format(const CSR_Matrix<IndexType, ValueType> &csr_ref, const std::string &format, int methods,
+                              const Solver_Config &cfg, const ValueType * b, const ValueType * inv_diag, double &convert_ms)
+{
+    const IndexType thread_num = Le_get_thread_num();
+    Solver_Result res = {0, 0, 0, 0, 0};
+    convert_ms = 0;
+
+    if (format == "csr")
+    {
+        CSR_Matrix<IndexType, ValueType> csr = csr_ref;
+        csr.kernel_flag = methods;
+        csr.partition = nullptr;
+        timer t;
+        if (2 == methods)
+        {
+            csr.partition = new_array<IndexType>(thread_num + 1);
+            balanced_partition_row_by_nnz(csr.row_offset, csr.num_rows, thread_num, csr.partition);
+        }
+        convert_ms = t.milliseconds_elapsed();
+        res = run_solver(cfg, csr, LeSpMV_csr<IndexType, ValueType>, b, inv_diag);
+        if (csr.partition != nullptr)
+            delete_array(csr.partition);
+    }
+    else if (format == "coo")
+    {
+        timer t;
+        COO_Matrix<IndexType, ValueType> coo = csr_to_coo(csr_ref);
+        convert_ms = t.milliseconds_elapsed();
+        coo.kernel_flag = methods;
+        res = run_solver(cfg, coo, LeSpMV_coo<IndexType, ValueType>, b, inv_diag);
+        delete_coo_matrix(coo);
+    }
+    else if (format == "ell")
+    {
+        timer t;
+        ELL_Matrix<IndexType, ValueType> ell = csr_to_ell(csr_ref, RowMajor);
+        convert_ms = t.milliseconds_elapsed();
+        ell.kernel_flag = methods;
+        res = run_solver(cfg, ell, LeSpMV_ell<IndexType, ValueType>, b, inv_diag);
+        delete_ell_matrix(ell);
+    }
+    else if (format == "sell")
+    {
+        timer t;
+        S_ELL_Matrix<IndexType, ValueType> sell = csr_to_sell(csr_ref, nullptr);
+        if (2 == methods)
+        {
+            sell.partition = new_array<IndexType>(thread_num + 1);
+            balanced_partition_row_by_nnz_sell(sell.chunk_ptr, sell.col_index, sell.num_nnzs, sell.chunk_num, thread_num, sell.partition);
+        }
+        convert_ms = t.milliseconds_elapsed();
+        sell.kernel_flag = methods;
+        res = run_solver(cfg, sell, LeSpMV_sell<IndexType, ValueType>, b, inv_diag);
+        if (sell.partition != nullptr)
+            delete_array(sell.partition);
+        delete_s_ell_matrix(sell);
+    }
+    else if (format == "sell_c_sigma")
+    {
+        timer t;
+        SELL_C_Sigma_Matrix<IndexType, ValueType> sell_c_sigma = csr_to_sell_c_sigma(csr_ref, nullptr);
+        if (2 == methods)
+        {
+            sell_c_sigma.partition = new_array<IndexType>(thread_num + 1);
+            balanced_partition_row_by_nnz_sell(sell_c_sigma.chunk_ptr, sell_c_sigma.col_index, sell_c_sigma.num_nnzs, sell_c_sigma.validchunkNum, thread_num, sell_c_sigma.partition);
+        }
+        convert_ms = t.milliseconds_elapsed();
+        sell_c_sigma.kernel_flag = methods;
+        res = run_solver(cfg, sell_c_sigma, LeSpMV_sell_c_sigma<IndexType, ValueType>, b, inv_diag);
+        if (sell_c_sigma.partition != nullptr)
+            delete_array(sell_c_sigma.partition);
+        delete_s_ell_c_sigma_matrix(sell_c_sigma);
+    }
+    else if (format == "sell_c_R")
+    {
+        timer t;
+        SELL_C_R_Matrix<IndexType, ValueType> sell_c_R = csr_to_sell_c_R(csr_ref, nullptr);
+        if (2 == methods)
+        {
+            sell_c_R.partition = new_array<IndexType>(thread_num + 1);
+            balanced_partition_row_by_nnz_sell(sell_c_R.chunk_ptr, sell_c_R.col_index, sell_c_R.num_nnzs, sell_c_R.validchunkNum, thread_num, sell_c_R.partition);
+        }
+        convert_ms = t.milliseconds_elapsed();
+        sell_c_R.kernel_flag = methods;
+        res = run_solver(cfg, sell_c_R, LeSpMV_sell_c_R<IndexType, ValueType>, b, inv_diag);
+        if (sell_c_R.partition != nullptr)
+            delete_array(sell_c_R.partition);
+        delete_s_ell_c_R_matrix(sell_c_R);
+    }
+    else if (format == "dia")
+    {
+        timer t;
+        DIA_Matrix<IndexType, ValueType> dia = csr_to_dia(csr_ref, (IndexType) MAX_DIAG_NUM, nullptr);
+        convert_ms = t.milliseconds_elapsed();
+        dia.kernel_flag = methods;
+        res = run_solver(cfg, dia, LeSpMV_dia<IndexType, ValueType>, b, inv_diag);
+        delete_dia_matrix(dia);
+    }
+    else if (format == "bsr")
+    {
+        timer t;
+        BSR_Matrix<IndexType, ValueType> bsr = csr_to_bsr(csr_ref);
+        if (2 == methods)
+        {
+            bsr.partition = new_array<IndexType>(thread_num + 1);
+            balanced_partition_row_by_nnz(bsr.row_ptr, bsr.mb, thread_num, bsr.partition);
+        }
+        convert_ms = t.milliseconds_elapsed();
+        bsr.kernel_flag = methods;
+        res = run_solver(cfg, bsr, LeSpMV_bsr<IndexType, ValueType>, b, inv_diag);
+        if (bsr.partition != nullptr)
+            delete_array(bsr.partition);
+        delete_bsr_matrix(bsr);
+    }
+    else
+    {
+        printf("Unknown format %s, skipped\n", format.c_str());
+        convert_ms = -1;
+    }
+    return res;
+}
+
+template <typename IndexType, typename ValueType>
+void run_solver_benchmark(int argc, char **argv, const Solver_Config &cfg)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+
+    char * gen_spec = get_argval(argc, argv, "gen");
+
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return;
+    }
+
+    std::string matrixName = (gen_spec != NULL) ? std::string(gen_spec) : extractFileNameWithoutExtension(mm_filename);
+
+    int matID = 0;
+    char * matID_str = get_argval(argc, argv, "matID");
+    if(matID_str != NULL)
+        matID = atoi(matID_str);
+
+    int methods = 1;
+    char * methods_str = get_argval(argc, argv, "method");
+    if(methods_str != NULL)
+        methods = atoi(methods_str);
+
+    bool use_jacobi = true;
+    char * precond_str = get_argval(argc, argv, "precond");
+    if(precond_str != NULL)
+        use_jacobi = (strcmp(precond_str, "none") != 0);
+
+    std::vector<std::string> formats = {"csr", "coo", "ell", "sell", "sell_c_sigma", "sell_c_R", "bsr"};
+    char * formats_str = get_argval(argc, argv, "formats");
+    if(formats_str != NULL)
+        formats = split_list(formats_str);
+
+    CSR_Matrix<IndexType, ValueType> csr_ref;
+    if(gen_spec != NULL)
+    {
+        unsigned long long seed = 1;
+        char * seed_str = get_argval(argc, argv, "seed");
+        if(seed_str != NULL)
+            seed = strtoull(seed_str, NULL, 10);
+        csr_ref = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr_ref.num_rows == 0)
+            return;
+    }
+    else
+        csr_ref = read_csr_matrix<IndexType, ValueType> (mm_filename);
+
+    if(csr_ref.num_rows != csr_ref.num_cols)
+    {
+        printf("The solver needs a square matrix!\n");
+        delete_csr_matrix(csr_ref);
+        return;
+    }
+
+    if constexpr(std::is_same<IndexType, int>::value) {
+        printf("Using %d-by-%d matrix with %d nonzero values\n", csr_ref.num_rows, csr_ref.num_cols, csr_ref.num_nnzs);
+    } else if constexpr(std::is_same<IndexType, long long>::value) {
+        printf("Using %lld-by-%lld matrix with %lld nonzero values\n", csr_ref.num_rows, csr_ref.num_cols, csr_ref.num_nnzs);
+    }
+    fflush(stdout);
+
+    // b = A * 1, 解为全 1 向量
+    ValueType * ones = new_array<ValueType>(csr_ref.num_cols);
+    ValueType * b    = new_array<ValueType>(csr_ref.num_rows);
+    std::fill(ones, ones + csr_ref.num_cols, ValueType(1));
+    csr_ref.kernel_flag = 1;
+    LeSpMV_csr(ValueType(1), csr_ref, ones, ValueType(0), b);
+
+    ValueType * inv_diag = use_jacobi ? jacobi_inv_diag(csr_ref) : nullptr;
+
+    FILE *save_perf = fopen(MAT_SOLVER, "a");
+    if ( save_perf == nullptr)
+        std::cout << "Unable to open perf-saved file: "<< MAT_SOLVER << std::endl;
+
+    printf("\n=== %s (%s preconditioner, method %d, %d threads) ===\n", cfg.solver.c_str(), use_jacobi ? "jacobi" : "no", methods, Le_get_thread_num());
+    printf("%14s %10s %10s %8s %12s %12s %5s\n", "format", "conv ms", "solve ms", "iters", "iters/s", "rel.res", "conv");
+
+    for (const std::string &format : formats){
+        double convert_ms = 0;
+        Solver_Result res = solve_in_format(csr_ref, format, methods, cfg, b, inv_diag, convert_ms);
+        if (convert_ms < 0)
+            continue;
+
+        printf("%14s %10.4f %10.4f %8d %12.2f %12.4e %5d\n", format.c_str(), convert_ms, res.time, res.iterations, res.iters_per_sec, res.residual, res.converged);
+        fflush(stdout);
+        // 输出格式： 【Mat Format Solver Method Threads ConvertTime SolveTime Iterations Iters/s Residual Converged】
+        if (save_perf != nullptr)
+            fprintf(save_perf, "%d %s %s %s %d %d %8.4f %8.4f %d %5.2f %e %d \n", matID, matrixName.c_str(), format.c_str(), cfg.solver.c_str(), methods, Le_get_thread_num(), convert_ms, res.time, res.iterations, res.iters_per_sec, res.residual, res.converged);
+    }
+
+    if (save_perf != nullptr)
+        fclose(save_perf);
+    if (inv_diag != nullptr)
+        delete_array(inv_diag);
+    delete_array(ones);
+    delete_array(b);
+    delete_csr_matrix(csr_ref);
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    int Index = 0;
+    char * Index_str = get_argval(argc, argv, "Index");
+    if(Index_str != NULL)
+        Index = atoi(Index_str);
+
+    int threads = Le_get_hardware_thread_num();
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        threads = atoi(threads_str);
+    Le_set_thread_num(threads);
+
+    Solver_Config cfg = {"cg", SOLVER_TOL, SOLVER_MAX_ITER, GMRES_RESTART};
+    char * solver_str = get_argval(argc, argv, "solver");
+    if(solver_str != NULL)
+        cfg.solver = solver_str;
+    if(cfg.solver != "cg" && cfg.solver != "bicgstab" && cfg.solver != "gmres")
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+
+    char * tol_str = get_argval(argc, argv, "tol");
+    if(tol_str != NULL)
+        cfg.tol = atof(tol_str);
+
+    char * maxiter_str = get_argval(argc, argv, "maxiter");
+    if(maxiter_str != NULL)
+        cfg.max_iter = atoi(maxiter_str);
+
+    char * restart_str = get_argval(argc, argv, "restart");
+    if(restart_str != NULL)
+        cfg.restart = atoi(restart_str);
+
+    printf("\nUsing %d-bit floating point precision, %d-bit Index, threads = %d\n\n", precision, (Index+1)*32, threads);
+
+    if (Index == 0 && precision ==  32){
+        run_solver_benchmark<int, float>(argc, argv, cfg);
+    }
+    else if (Index == 0 && precision == 64){
+        run_solver_benchmark<int, double>(argc, argv, cfg);
+    }
+    else if (Index == 1 && precision ==  32){
+        run_solver_benchmark<long long, float>(argc, argv, cfg);
+    }
+    else if (Index == 1 && precision == 64){
+        run_solver_benchmark<long long, double>(argc, argv, cfg);
+    }
+    else{
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
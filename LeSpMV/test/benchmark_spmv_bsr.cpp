@@ -124,7 +124,7 @@ int main(int argc, char** argv)
         precision = atoi(precision_str);
 
     // 包括超线程
-    Le_set_thread_num(CPU_SOCKET * CPU_CORES_PER_SOC * CPU_HYPER_THREAD);
+    Le_set_thread_num(Le_get_hardware_thread_num());
 
     char * threads_str = get_argval(argc, argv, "threads");
     if(threads_str != NULL)
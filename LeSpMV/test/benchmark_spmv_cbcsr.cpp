@@ -0,0 +1,136 @@
+/**
+ * @file benchmark_spmv_cbcsr.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Column-blocked CSR against CSR: correctness and performance of each kernel,
+ *         and whether the tile features suggest column blocking for the matrix.
+ * @version 0.1
+ * @date 2024-03-25
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include<iostream>
+#include<cstdio>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --panel     = columns per panel (default: CBCSR_CACHE_FRACTION of one LLC instance)\n";
+    std::cout << "\t" << " --features  = 1: compute the MTX features and report SuggestColumnBlocking()\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+template <typename IndexType, typename ValueType>
+void run_cbcsr_kernels(int argc, char **argv)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+    char * gen_spec = get_argval(argc, argv, "gen");
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return;
+    }
+
+    unsigned long long seed = 1;
+    char * seed_str = get_argval(argc, argv, "seed");
+    if(seed_str != NULL)
+        seed = strtoull(seed_str, NULL, 10);
+
+    CSR_Matrix<IndexType, ValueType> csr;
+    if(gen_spec != NULL)
+    {
+        csr = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr.num_rows == 0)
+            return;
+    }
+    else
+        csr = read_csr_matrix<IndexType, ValueType>(mm_filename);
+    csr.partition = nullptr;
+
+    printf("Using %lld-by-%lld matrix with %lld nonzero values\n",
+           (long long) csr.num_rows, (long long) csr.num_cols, (long long) csr.num_nnzs);
+
+    char * features_str = get_argval(argc, argv, "features");
+    if(features_str != NULL && atoi(features_str) != 0)
+    {
+        MTX<IndexType, ValueType> mtx;
+        mtx.MtxLoad(csr, gen_spec != NULL ? std::string(gen_spec) : extractFileNameWithoutExtension(mm_filename));
+        mtx.CalculateFeatures();
+        printf("\tx = %.2f MB, column blocking suggested: %s\n",
+               (double) csr.num_cols * sizeof(ValueType) / (1 << 20), mtx.SuggestColumnBlocking() ? "yes" : "no");
+    }
+
+    IndexType panel_width = 0;
+    char * panel_str = get_argval(argc, argv, "panel");
+    if(panel_str != NULL)
+        panel_width = (IndexType) atoll(panel_str);
+
+    const char * names[] = {"serial_simple", "omp_simple", "omp_lb"};
+    for (int methods = 0; methods < 3; ++methods)
+    {
+        csr.kernel_flag = methods;
+        CBCSR_Matrix<IndexType, ValueType> cbcsr = csr_to_cbcsr(csr, panel_width);
+        if (methods == 2)
+        {
+            const IndexType thread_num = Le_get_thread_num();
+            cbcsr.partition = new_array<IndexType>(cbcsr.num_panels * (thread_num + 1));
+            balanced_partition_cbcsr(cbcsr.panel_ptr, cbcsr.row_offset, cbcsr.num_panels, thread_num, cbcsr.partition);
+        }
+        std::cout << "\n=====  " << names[methods] << ": " << cbcsr.num_panels << " panels of " << cbcsr.panel_width
+                  << " columns, " << cbcsr.num_panel_rows << " panel rows  =====" << std::endl;
+
+        test_spmv_kernel(csr, LeSpMV_csr<IndexType, ValueType>,
+                         cbcsr, LeSpMV_cbcsr<IndexType, ValueType>,
+                         (std::string("cbcsr_") + names[methods]).c_str());
+
+        benchmark_spmv_on_host(csr, LeSpMV_csr<IndexType, ValueType>, std::string("csr_") + names[methods]);
+        benchmark_spmv_on_host(cbcsr, LeSpMV_cbcsr<IndexType, ValueType>, std::string("cbcsr_") + names[methods]);
+
+        delete_host_matrix(cbcsr);
+    }
+
+    delete_csr_matrix(csr);
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    Le_set_thread_num(Le_get_hardware_thread_num());
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        Le_set_thread_num(atoi(threads_str));
+
+    if (precision == 32)
+        run_cbcsr_kernels<int, float>(argc, argv);
+    else if (precision == 64)
+        run_cbcsr_kernels<int, double>(argc, argv);
+    else
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
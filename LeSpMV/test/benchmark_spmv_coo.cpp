@@ -90,10 +90,12 @@ void run_coo_kernels(int argc, char **argv)
     double msec_per_iteration;
     double sec_per_iteration;
 
-    // 0: 串行， 1：omp simple， 3：alphaspasre COO
-    // Our : {St,StCont, Dyn, guided} x {omp}
+    // 0: 串行， 1：omp simple， 2：load balanced， 3：alphaspasre COO
+    // Our : {St,StCont, Dyn, guided} x {omp}, load balanced 不受调度策略影响
     for (int sche_mode = 0 ; sche_mode < 4; ++sche_mode){
-    for(int methods = 1; methods < 2; ++methods){
+    for(int methods = 1; methods < 3; ++methods){
+        if (methods == 2 && sche_mode > 0)
+            continue;
         msec_per_iteration = test_coo_matrix_kernels(csr_ref, methods, sche_mode);
         fflush(stdout);
         sec_per_iteration = msec_per_iteration / 1000.0;
@@ -120,7 +122,7 @@ int main(int argc, char** argv)
         precision = atoi(precision_str);
     
     // 包括超线程
-    Le_set_thread_num(CPU_SOCKET * CPU_CORES_PER_SOC * CPU_HYPER_THREAD);
+    Le_set_thread_num(Le_get_hardware_thread_num());
 
     char * threads_str = get_argval(argc, argv, "threads");
     if(threads_str != NULL)
@@ -0,0 +1,126 @@
+/**
+ * @file benchmark_spmv_csb.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Compressed Sparse Blocks against CSR: index bytes, correctness and
+ *         performance of each kernel.
+ * @version 0.1
+ * @date 2024-03-27
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include<iostream>
+#include<cstdio>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --beta      = block dim, power of 2 <= 65536 (default from sqrt(max(rows, cols)))\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+template <typename IndexType, typename ValueType>
+void run_csb_kernels(int argc, char **argv)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+    char * gen_spec = get_argval(argc, argv, "gen");
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return;
+    }
+
+    unsigned long long seed = 1;
+    char * seed_str = get_argval(argc, argv, "seed");
+    if(seed_str != NULL)
+        seed = strtoull(seed_str, NULL, 10);
+
+    CSR_Matrix<IndexType, ValueType> csr;
+    if(gen_spec != NULL)
+    {
+        csr = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr.num_rows == 0)
+            return;
+    }
+    else
+        csr = read_csr_matrix<IndexType, ValueType>(mm_filename);
+    csr.partition = nullptr;
+
+    printf("Using %lld-by-%lld matrix with %lld nonzero values\n",
+           (long long) csr.num_rows, (long long) csr.num_cols, (long long) csr.num_nnzs);
+
+    IndexType beta = 0;
+    char * beta_str = get_argval(argc, argv, "beta");
+    if(beta_str != NULL)
+        beta = (IndexType) atoll(beta_str);
+
+    const char * names[] = {"serial_simple", "omp_simple", "omp_lb"};
+    for (int methods = 0; methods < 3; ++methods)
+    {
+        csr.kernel_flag = methods;
+        CSB_Matrix<IndexType, ValueType> csb = csr_to_csb(csr, beta);
+        if (methods == 0)
+        {
+            // CSR: row_offset + col_index, CSB: blk_ptr + rloc + cloc
+            const double csr_index = (double) sizeof(IndexType) * (csr.num_rows + 1 + csr.num_nnzs);
+            const double csb_index = (double) sizeof(IndexType) * ((double) csb.nbr * csb.nbc + 1) + 2.0 * sizeof(uint16_t) * csb.num_nnzs;
+            printf("\tbeta = %lld, %lld x %lld blocks, index bytes CSB / CSR = %.4f\n",
+                   (long long) csb.beta, (long long) csb.nbr, (long long) csb.nbc, csb_index / csr_index);
+        }
+        std::cout << "\n=====  " << names[methods] << "  =====" << std::endl;
+
+        test_spmv_kernel(csr, LeSpMV_csr<IndexType, ValueType>,
+                         csb, LeSpMV_csb<IndexType, ValueType>,
+                         (std::string("csb_") + names[methods]).c_str());
+
+        benchmark_spmv_on_host(csr, LeSpMV_csr<IndexType, ValueType>, std::string("csr_") + names[methods]);
+        benchmark_spmv_on_host(csb, LeSpMV_csb<IndexType, ValueType>, std::string("csb_") + names[methods]);
+
+        delete_host_matrix(csb);
+    }
+
+    delete_csr_matrix(csr);
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    Le_set_thread_num(Le_get_hardware_thread_num());
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        Le_set_thread_num(atoi(threads_str));
+
+    if (precision == 32)
+        run_csb_kernels<int, float>(argc, argv);
+    else if (precision == 64)
+        run_csb_kernels<int, double>(argc, argv);
+    else
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file benchmark_spmv_dia_csr.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Hybrid DIA + CSR against CSR and DIA: split of the nonzeros, conversion
+ *         time, correctness and performance of each kernel.
+ * @version 0.1
+ * @date 2024-03-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include<iostream>
+#include<cstdio>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --fill      = fill ratio a diagonal needs to be stored as DIA (default NTRATIO)\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+template <typename IndexType, typename ValueType>
+void run_dia_csr_kernels(int argc, char **argv)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+    char * gen_spec = get_argval(argc, argv, "gen");
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return;
+    }
+
+    unsigned long long seed = 1;
+    char * seed_str = get_argval(argc, argv, "seed");
+    if(seed_str != NULL)
+        seed = strtoull(seed_str, NULL, 10);
+
+    CSR_Matrix<IndexType, ValueType> csr;
+    if(gen_spec != NULL)
+    {
+        csr = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr.num_rows == 0)
+            return;
+    }
+    else
+        csr = read_csr_matrix<IndexType, ValueType>(mm_filename);
+    csr.partition = nullptr;
+
+    printf("Using %lld-by-%lld matrix with %lld nonzero values\n",
+           (long long) csr.num_rows, (long long) csr.num_cols, (long long) csr.num_nnzs);
+
+    double fill = NTRATIO;
+    char * fill_str = get_argval(argc, argv, "fill");
+    if(fill_str != NULL)
+        fill = atof(fill_str);
+
+    // 全部对角线数目, 超过 MAX_DIAG_NUM 时 csr_to_dia 会拒绝该矩阵
+    IndexType * counts = new_array<IndexType>((size_t) csr.num_rows + csr.num_cols);
+    count_csr_diagonals(csr, counts);
+    IndexType all_diags = 0;
+    for (size_t n = 0; n < (size_t) csr.num_rows + csr.num_cols; ++n)
+        all_diags += (counts[n] != 0);
+    delete_array(counts);
+
+    timer t;
+    DIA_CSR_Matrix<IndexType, ValueType> hyb = csr_to_dia_csr(csr, fill);
+    double convert_ms = t.milliseconds_elapsed();
+    printf("\tfill %.2f: %lld of %lld diagonals in DIA holding %.2f%% of the nonzeros, conversion %8.4f ms\n",
+           fill, (long long) hyb.complete_ndiags, (long long) all_diags,
+           100.0 * hyb.dia_nnzs / std::max((IndexType) 1, hyb.num_nnzs), convert_ms);
+
+    DIA_Matrix<IndexType, ValueType> dia;
+    const bool fits_dia = (all_diags <= MAX_DIAG_NUM);
+    if (fits_dia)
+    {
+        timer t_dia;
+        dia = csr_to_dia(csr, (IndexType) MAX_DIAG_NUM, nullptr);
+        printf("\tcsr_to_dia %lld diagonals, conversion %8.4f ms\n", (long long) dia.complete_ndiags, t_dia.milliseconds_elapsed());
+    }
+
+    const char * names[] = {"serial_simple", "omp_simple"};
+    for (int methods = 0; methods < 2; ++methods)
+    {
+        csr.kernel_flag = methods;
+        hyb.kernel_flag = methods;
+        std::cout << "\n=====  " << names[methods] << "  =====" << std::endl;
+
+        test_spmv_kernel(csr, LeSpMV_csr<IndexType, ValueType>,
+                         hyb, LeSpMV_dia_csr<IndexType, ValueType>,
+                         (std::string("dia_csr_") + names[methods]).c_str());
+
+        benchmark_spmv_on_host(csr, LeSpMV_csr<IndexType, ValueType>, std::string("csr_") + names[methods]);
+        benchmark_spmv_on_host(hyb, LeSpMV_dia_csr<IndexType, ValueType>, std::string("dia_csr_") + names[methods]);
+
+        if (fits_dia)
+        {
+            dia.kernel_flag = methods;
+            benchmark_spmv_on_host(dia, LeSpMV_dia<IndexType, ValueType>, std::string("dia_") + names[methods]);
+        }
+    }
+
+    if (fits_dia)
+        delete_host_matrix(dia);
+    delete_host_matrix(hyb);
+    delete_csr_matrix(csr);
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    Le_set_thread_num(Le_get_hardware_thread_num());
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        Le_set_thread_num(atoi(threads_str));
+
+    if (precision == 32)
+        run_dia_csr_kernels<int, float>(argc, argv);
+    else if (precision == 64)
+        run_dia_csr_kernels<int, double>(argc, argv);
+    else
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
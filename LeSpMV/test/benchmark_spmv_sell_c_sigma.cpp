@@ -107,7 +107,7 @@ void run_sell_c_sigma_kernels(int argc, char **argv)
         sec_per_iteration = msec_per_iteration / 1000.0;
         double GFLOPs = (sec_per_iteration == 0) ? 0 : (2.0 * (double) csr.num_nnzs / sec_per_iteration) / 1e9;
         // 输出格式： 【Mat Format Method Schedule c sigma Time Performance】
-        fprintf(save_perf, "%d %s S-ELL-sigma %d %d %d %d %8.4f %5.4f \n", matID, matrixName.c_str(), methods, sche_mode, CHUNK_SIZE, SELL_SIGMA, msec_per_iteration, GFLOPs);
+        fprintf(save_perf, "%d %s S-ELL-sigma %d %d %d %d %8.4f %5.4f \n", matID, matrixName.c_str(), methods, sche_mode, Le_get_alignment<ValueType>(), SELL_SIGMA, msec_per_iteration, GFLOPs);
     }
     }
     fclose(save_perf);
@@ -127,7 +127,7 @@ int main(int argc, char** argv)
         precision = atoi(precision_str);
 
     // 包括超线程
-    Le_set_thread_num(CPU_SOCKET * CPU_CORES_PER_SOC * CPU_HYPER_THREAD);
+    Le_set_thread_num(Le_get_hardware_thread_num());
 
     char * threads_str = get_argval(argc, argv, "threads");
     if(threads_str != NULL)
@@ -0,0 +1,268 @@
+/**
+ * @file benchmark_thread_scaling.cpp for sweeping the thread number of each format.
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Strong scaling of one matrix: every format is run with 1 thread,
+ *         cores of one socket, all physical cores and all hardware threads.
+ *         Reports speedup, parallel efficiency (both relative to the smallest
+ *         thread number of the sweep) and the knee where the bandwidth saturates.
+ * @version 0.1
+ * @date 2024-03-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include<iostream>
+#include<cstdio>
+#include<cstring>
+#include<vector>
+#include<string>
+#include<sstream>
+#include<algorithm>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --matID     = m_num, giving the matrix ID number in dataset (default 0).\n";
+    std::cout << "\t" << " --Index     = 0 (int:default) or 1 (long long)\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --sche      = chosing the schedule strategy (default 0)\n";
+    std::cout << "\t" << "               0: static | 1: static, CHUNK_SIZE | 2: dynamic | 3: guided\n";
+    std::cout << "\t" << " --formats   = comma list of csr,coo,ell,sell,sell_c_sigma,sell_c_R,dia,bsr (default all)\n";
+    std::cout << "\t" << " --sweep     = comma list of thread numbers\n";
+    std::cout << "\t" << "               (default 1, cores per socket, physical cores, hardware threads)\n";
+    std::cout << "\t" << " --bind      = none, compact(default) or scatter\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+static std::vector<std::string> split_list(const char * str)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+template <typename IndexType, typename ValueType>
+double run_format_kernel(const CSR_Matrix<IndexType, ValueType> &csr_ref, const std::string &format, int methods, int sche_mode)
+{
+    if (format == "csr")
+        return test_csr_matrix_kernels(csr_ref, methods, sche_mode);
+    else if (format == "coo")
+        return test_coo_matrix_kernels(csr_ref, methods, sche_mode);
+    else if (format == "ell")
+        return test_ell_matrix_kernels(csr_ref, methods, RowMajor, sche_mode);
+    else if (format == "sell")
+        return test_s_ell_matrix_kernels(csr_ref, methods, sche_mode);
+    else if (format == "sell_c_sigma")
+        return test_sell_c_sigma_matrix_kernels(csr_ref, methods, sche_mode);
+    else if (format == "sell_c_R")
+        return test_sell_c_R_matrix_kernels(csr_ref, methods, sche_mode);
+    else if (format == "dia")
+        return test_dia_matrix_kernels(csr_ref, methods, sche_mode);
+    else if (format == "bsr")
+        return test_bsr_matrix_kernels(csr_ref, methods, sche_mode);
+
+    printf("Unknown format %s, skipped\n", format.c_str());
+    return 0;
+}
+
+template <typename IndexType, typename ValueType>
+void run_thread_scaling(int argc, char **argv, const std::vector<int> &sweep, BindPolicy bind_mode)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+
+    char * gen_spec = get_argval(argc, argv, "gen");
+
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return;
+    }
+
+    std::string matrixName = (gen_spec != NULL) ? std::string(gen_spec) : extractFileNameWithoutExtension(mm_filename);
+
+    int matID = 0;
+    char * matID_str = get_argval(argc, argv, "matID");
+    if(matID_str != NULL)
+        matID = atoi(matID_str);
+
+    int sche_mode = 0;
+    char * schedule_str = get_argval(argc, argv, "sche");
+    if(schedule_str != NULL)
+        sche_mode = atoi(schedule_str);
+
+    std::vector<std::string> formats = {"csr", "coo", "ell", "sell", "sell_c_sigma", "sell_c_R", "dia", "bsr"};
+    char * formats_str = get_argval(argc, argv, "formats");
+    if(formats_str != NULL)
+        formats = split_list(formats_str);
+
+    CSR_Matrix<IndexType, ValueType> csr_ref;
+    if(gen_spec != NULL)
+    {
+        unsigned long long seed = 1;
+        char * seed_str = get_argval(argc, argv, "seed");
+        if(seed_str != NULL)
+            seed = strtoull(seed_str, NULL, 10);
+        csr_ref = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr_ref.num_rows == 0)
+            return;
+    }
+    else
+        csr_ref = read_csr_matrix<IndexType, ValueType> (mm_filename);
+
+    if constexpr(std::is_same<IndexType, int>::value) {
+        printf("Using %d-by-%d matrix with %d nonzero values\n", csr_ref.num_rows, csr_ref.num_cols, csr_ref.num_nnzs);
+    } else if constexpr(std::is_same<IndexType, long long>::value) {
+        printf("Using %lld-by-%lld matrix with %lld nonzero values\n", csr_ref.num_rows, csr_ref.num_cols, csr_ref.num_nnzs);
+    }
+    fflush(stdout);
+
+    // 不同格式的额外开销不同, 统一用 CSR 的访存量作为有效带宽, 同一格式内带宽正比于 1/time
+    const double bytes = (double) bytes_per_spmv(csr_ref);
+    const double flops = 2.0 * (double) csr_ref.num_nnzs;
+
+    FILE *save_perf = fopen(MAT_SCALING, "a");
+    if ( save_perf == nullptr)
+    {
+        std::cout << "Unable to open perf-saved file: "<< MAT_SCALING << std::endl;
+        delete_csr_matrix(csr_ref);
+        return ;
+    }
+
+    const size_t num_points = sweep.size();
+    for (const std::string &format : formats){
+    for (int methods = 1; methods <= 2; ++methods){
+        std::vector<double> msec(num_points, 0.0);
+        for (size_t p = 0; p < num_points; ++p){
+            Le_set_thread_num(sweep[p]);
+            Le_bind_threads(bind_mode);
+            msec[p] = run_format_kernel(csr_ref, format, methods, sche_mode);
+            fflush(stdout);
+        }
+
+        double peak_gbytes = 0;
+        for (size_t p = 0; p < num_points; ++p)
+            if (msec[p] > 0)
+                peak_gbytes = std::max(peak_gbytes, bytes / (msec[p] / 1000.0) / 1e9);
+
+        printf("\n=== Thread scaling of %s (method %d, sche %d) ===\n", format.c_str(), methods, sche_mode);
+        printf("speedup and efficiency relative to %d thread(s)\n", sweep[0]);
+        printf("%8s %10s %10s %10s %8s %8s\n", "threads", "ms", "GFLOP/s", "GB/s", "speedup", "eff");
+
+        int knee = 0;
+        for (size_t p = 0; p < num_points; ++p){
+            double sec = msec[p] / 1000.0;
+            double GFLOPs  = (sec == 0) ? 0 : flops / sec / 1e9;
+            double GBYTEs  = (sec == 0) ? 0 : bytes / sec / 1e9;
+            double speedup = (msec[p] == 0) ? 0 : msec[0] / msec[p];
+            // 基准是 sweep 的最小线程数, 不一定是 1
+            double eff     = speedup * sweep[0] / (double) sweep[p];
+            if (knee == 0 && GBYTEs >= KNEE_RATIO * peak_gbytes && peak_gbytes > 0)
+                knee = sweep[p];
+
+            printf("%8d %10.4f %10.4f %10.4f %8.3f %8.3f\n", sweep[p], msec[p], GFLOPs, GBYTEs, speedup, eff);
+            // 输出格式： 【Mat Format Method Schedule Threads Time Performance Bandwidth Speedup Efficiency】
+            fprintf(save_perf, "%d %s %s %d %d %d %8.4f %5.4f %5.4f %5.3f %5.3f \n", matID, matrixName.c_str(), format.c_str(), methods, sche_mode, sweep[p], msec[p], GFLOPs, GBYTEs, speedup, eff);
+        }
+        printf("bandwidth knee: %d threads (>= %.0f%% of peak %.4f GB/s)\n\n", knee, KNEE_RATIO * 100, peak_gbytes);
+    }
+    }
+
+    fclose(save_perf);
+    delete_csr_matrix(csr_ref);
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 32;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    int Index = 0;
+    char * Index_str = get_argval(argc, argv, "Index");
+    if(Index_str != NULL)
+        Index = atoi(Index_str);
+
+    // 1, 单个 socket 的核数, 所有物理核, 包括超线程
+    const Le_Platform &plat = Le_get_platform();
+    std::vector<int> sweep = {1, plat.cpu_cores_per_soc, Le_get_physical_core_num(), Le_get_hardware_thread_num()};
+
+    char * sweep_str = get_argval(argc, argv, "sweep");
+    if(sweep_str != NULL)
+    {
+        sweep.clear();
+        for (const std::string &item : split_list(sweep_str))
+            if (atoi(item.c_str()) > 0)
+                sweep.push_back(atoi(item.c_str()));
+    }
+    std::sort(sweep.begin(), sweep.end());
+    sweep.erase(std::unique(sweep.begin(), sweep.end()), sweep.end());
+    if (sweep.empty())
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+
+    BindPolicy bind_mode = BIND_COMPACT;
+    char * bind_str = get_argval(argc, argv, "bind");
+    if(bind_str != NULL)
+    {
+        if (strcmp(bind_str, "none") == 0)
+            bind_mode = BIND_NONE;
+        else if (strcmp(bind_str, "scatter") == 0)
+            bind_mode = BIND_SCATTER;
+        else if (strcmp(bind_str, "compact") == 0)
+            bind_mode = BIND_COMPACT;
+        else
+        {
+            usage(argc, argv);
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("\nUsing %d-bit floating point precision, %d-bit Index, sweep =", precision, (Index+1)*32);
+    for (int t : sweep)
+        printf(" %d", t);
+    printf("\n\n");
+
+    if (Index == 0 && precision ==  32){
+        run_thread_scaling<int, float>(argc, argv, sweep, bind_mode);
+    }
+    else if (Index == 0 && precision == 64){
+        run_thread_scaling<int, double>(argc, argv, sweep, bind_mode);
+    }
+    else if (Index == 1 && precision ==  32){
+        run_thread_scaling<long long, float>(argc, argv, sweep, bind_mode);
+    }
+    else if (Index == 1 && precision == 64){
+        run_thread_scaling<long long, double>(argc, argv, sweep, bind_mode);
+    }
+    else{
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
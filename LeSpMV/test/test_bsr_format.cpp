@@ -37,7 +37,7 @@ void test_martixfile(int argc, char** argv)
 
     BSR_Matrix<IndexType, ValueType> bsr;
     
-    bsr = csr_to_bsr<IndexType, ValueType>(csr, BSR_BlockDimRow, SIMD_WIDTH/8/sizeof(ValueType));
+    bsr = csr_to_bsr<IndexType, ValueType>(csr, BSR_BlockDimRow, Le_get_alignment<ValueType>());
 
     std::cout << " block Row = " << bsr.blockDim_r << std::endl;
     std::cout << " block Col = " << bsr.blockDim_c << std::endl;
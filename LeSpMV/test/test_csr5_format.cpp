@@ -44,7 +44,7 @@ void test_martixfile(int argc, char** argv)
     CSR5_Matrix <IndexType, UIndexType, ValueType> csr5;
     FILE* save_features = fopen(MAT_FEATURES,"w");
     
-    csr5 = csr_to_csr5<IndexType, UIndexType, ValueType>(csr, save_features);
+    csr5 = csr_to_csr5<IndexType, UIndexType, ValueType>(csr, save_features, CSR5_ADOPT_CSR);
     
     fclose(save_features);
 
@@ -0,0 +1,271 @@
+/**
+ * @file test_csr_view.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Le_csr_view over external CSR arrays (zero-copy, 1-based int64, int32 -> int64)
+ *         and Le_matrix ownership: SpMV and the conversions of a view must match the
+ *         reference CSR, moves and release() must hand the arrays over exactly once.
+ * @version 0.1
+ * @date 2024-04-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include<iostream>
+#include<cstdio>
+#include<cmath>
+#include<string>
+#include<atomic>
+#include<type_traits>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+// 统计未释放数组的分配器, 检查所有权是否只交出一次
+static std::atomic<long> live_arrays(0);
+
+static void * counting_allocate(size_t bytes, MemClass cls, void *)
+{
+    ++live_arrays;
+    return Le_alloc_pages(bytes, cls);
+}
+
+static void counting_deallocate(void *p, void *)
+{
+    --live_arrays;
+    Le_free_pages(p);
+}
+
+static const Le_allocator counting_allocator = { counting_allocate, counting_deallocate, NULL };
+
+static int failures = 0;
+
+static void check(const bool ok, const std::string &name)
+{
+    printf("\t%-44s : %s\n", name.c_str(), ok ? "ok" : "  <-- FAILED");
+    if (!ok)
+        failures++;
+}
+
+/**
+ * @brief mat 的 kernel_flag 0 ~ max_kernel_flag 与参照 y_ref 比较
+ */
+template <typename SparseMatrix, typename SpMV, typename ValueType>
+void check_spmv(const SparseMatrix &mat, SpMV spmv, const int max_kernel_flag, const std::vector<ValueType> &x,
+                const std::vector<ValueType> &y_ref, const std::string &name)
+{
+    std::vector<ValueType> y(y_ref.size());
+    for (int kernel_flag = 0; kernel_flag <= max_kernel_flag; ++kernel_flag)
+    {
+        SparseMatrix a = mat;
+        a.kernel_flag = kernel_flag;
+        std::fill(y.begin(), y.end(), ValueType(0));
+        spmv((ValueType) 1, a, x.data(), (ValueType) 0, y.data());
+        const double error = (double) maximum_relative_error(y_ref.data(), y.data(), y.size());
+        const bool ok = error < 5 * std::sqrt(std::numeric_limits<ValueType>::epsilon());
+        printf("\t%-30s kernel %d : max relative error %e %s\n", name.c_str(), kernel_flag, error, ok ? "" : "  <-- FAILED");
+        if (!ok)
+            failures++;
+    }
+}
+
+/**
+ * @brief view 的 CSR, SELL-C-sigma 和 CSR5 (只有 int / double) 与参照比较
+ */
+template <typename IndexType, typename ValueType>
+void check_view(const Le_csr_view<IndexType, ValueType> &view, const std::vector<ValueType> &x,
+                const std::vector<ValueType> &y_ref, const std::string &name)
+{
+    check_spmv(view.get(), LeSpMV_csr<IndexType, ValueType>, 2, x, y_ref, name + " csr");
+
+    SELL_C_Sigma_Matrix<IndexType, ValueType> sell = csr_to_sell_c_sigma(view.get(), nullptr);
+    check_spmv(sell, LeSpMV_sell_c_sigma<IndexType, ValueType>, 2, x, y_ref, name + " sell_c_sigma");
+    delete_host_matrix(sell);
+
+    if constexpr (std::is_same<IndexType, int>::value && std::is_same<ValueType, double>::value)
+    {
+        CSR5_Matrix<IndexType, uint32_t, ValueType> csr5 = csr_to_csr5<IndexType, uint32_t, ValueType>(view.get(), nullptr, CSR5_SHARE_ROW_OFFSET);
+        check(csr5.row_offset == view->row_offset, name + " csr5 shares row_offset");
+        check_spmv(csr5, LeSpMV_csr5<IndexType, uint32_t, ValueType>, 0, x, y_ref, name + " csr5");
+        delete_host_matrix(csr5);
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void test_csr_view(int argc, char **argv)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+    char * gen_spec = get_argval(argc, argv, "gen");
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return;
+    }
+
+    unsigned long long seed = 1;
+    char * seed_str = get_argval(argc, argv, "seed");
+    if(seed_str != NULL)
+        seed = strtoull(seed_str, NULL, 10);
+
+    CSR_Matrix<IndexType, ValueType> csr;
+    if(gen_spec != NULL)
+    {
+        csr = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr.num_rows == 0)
+            return;
+    }
+    else
+        csr = read_csr_matrix<IndexType, ValueType>(mm_filename);
+    csr.partition = nullptr;
+    csr.kernel_flag = 1;
+
+    const IndexType num_rows = csr.num_rows, num_cols = csr.num_cols, num_nnzs = csr.num_nnzs;
+    printf("Using %lld-by-%lld matrix with %lld nonzero values\n",
+           (long long) num_rows, (long long) num_cols, (long long) num_nnzs);
+
+    std::vector<ValueType> x(num_cols), y_ref(num_rows, 0);
+    for (IndexType i = 0; i < num_cols; ++i)
+        x[i] = (ValueType) (i % 17) / 17 - (ValueType) 0.5;
+    LeSpMV_csr((ValueType) 1, csr, x.data(), (ValueType) 0, y_ref.data());
+
+    // 外部库的数组: 1-based int64 (MKL ILP64 / Fortran)
+    std::vector<long long> row_offset64(num_rows + 1), col_index64(num_nnzs);
+    for (IndexType i = 0; i <= num_rows; ++i)
+        row_offset64[i] = (long long) csr.row_offset[i] + 1;
+    for (IndexType jj = 0; jj < num_nnzs; ++jj)
+        col_index64[jj] = (long long) csr.col_index[jj] + 1;
+
+    std::cout << "\n=====  Zero-copy view of 0-based arrays  =====" << std::endl;
+    {
+        Le_csr_view<IndexType, ValueType> view(num_rows, num_cols, csr.row_offset, csr.col_index, csr.values);
+        check(view.zero_copy(), "zero_copy()");
+        check(view->row_offset == csr.row_offset && view->col_index == csr.col_index && view->values == csr.values,
+              "arrays used in place");
+        check_view(view, x, y_ref, "zero-copy");
+    }
+
+    std::cout << "\n=====  1-based int64 arrays  =====" << std::endl;
+    {
+        const long live_before = live_arrays.load();
+        Le_csr_view<IndexType, ValueType> view = [&]
+        {
+            // 翻译后的数组来自 counting_allocator, 析构时不依赖当前的分配器
+            Le_allocator_scope scope(&counting_allocator);
+            return Le_csr_view<IndexType, ValueType>(num_rows, num_cols, row_offset64.data(), col_index64.data(), csr.values, 1);
+        }();
+        check(!view.zero_copy(), "indices translated");
+        check(view->values == csr.values, "values not copied");
+        check(live_arrays.load() == live_before + 2, "translated arrays from the view's allocator");
+        check_view(view, x, y_ref, "1-based int64");
+
+        // 移动构造: 翻译后的数组随之转移, 源对象不再释放它们
+        const IndexType *translated = view->row_offset;
+        Le_csr_view<IndexType, ValueType> moved(std::move(view));
+        check(moved->row_offset == translated && !moved.zero_copy() && view.zero_copy(), "move constructor hands over the arrays");
+
+        // 移动赋值: 目标原来的 (zero-copy) 视图被替换
+        Le_csr_view<IndexType, ValueType> assigned(num_rows, num_cols, csr.row_offset, csr.col_index, csr.values);
+        assigned = std::move(moved);
+        check(assigned->row_offset == translated && moved.zero_copy(), "move assignment hands over the arrays");
+        check_spmv(assigned.get(), LeSpMV_csr<IndexType, ValueType>, 1, x, y_ref, "moved view csr");
+
+        assigned.reset();
+        check(live_arrays.load() == live_before, "reset() frees with the view's allocator");
+    }
+
+    std::cout << "\n=====  int32 arrays in a 64-bit index view  =====" << std::endl;
+    {
+        Le_csr_view<long long, ValueType> view(num_rows, num_cols, csr.row_offset, csr.col_index, csr.values);
+        check(!view.zero_copy(), "indices widened");
+        check_view(view, x, y_ref, "int32 -> int64");
+    }
+
+    std::cout << "\n=====  Le_matrix ownership  =====" << std::endl;
+    {
+        typedef SELL_C_Sigma_Matrix<IndexType, ValueType> SELL;
+        Le_csr_view<IndexType, ValueType> view(num_rows, num_cols, row_offset64.data(), col_index64.data(), csr.values, 1);
+        const long live_before = live_arrays.load();
+
+        Le_matrix<SELL> sell = Le_make_matrix(&counting_allocator, [&]{ return csr_to_sell_c_sigma(view.get(), nullptr); });
+        const long live_sell = live_arrays.load() - live_before;
+        check(sell.owning() && sell.allocator() == &counting_allocator && live_sell > 0, "Le_make_matrix owns its result");
+        check(Le_get_allocator() != &counting_allocator, "allocator restored after Le_make_matrix");
+        check_spmv(*sell, LeSpMV_sell_c_sigma<IndexType, ValueType>, 2, x, y_ref, "Le_matrix sell_c_sigma");
+
+        const IndexType *col_index = sell->col_index;
+        Le_matrix<SELL> moved(std::move(sell));
+        check(moved.owning() && !sell.owning() && moved->col_index == col_index, "move constructor transfers ownership");
+
+        Le_matrix<SELL> assigned = Le_matrix<SELL>::view(*moved);
+        check(!assigned.owning(), "view() does not own");
+        assigned = std::move(moved);
+        check(assigned.owning() && !moved.owning() && live_arrays.load() == live_before + live_sell,
+              "move assignment transfers ownership");
+
+        SELL raw = assigned.release();
+        check(!assigned.owning() && raw.col_index == col_index, "release() gives up ownership");
+        assigned.reset();
+        check(live_arrays.load() == live_before + live_sell, "reset() after release() frees nothing");
+
+        // release() 之后由调用方用 allocator() 释放
+        {
+            Le_allocator_scope scope(&counting_allocator);
+            delete_host_matrix(raw);
+        }
+        check(live_arrays.load() == live_before, "released arrays freed by the caller");
+
+        {
+            Le_matrix<SELL> owned = Le_make_matrix(&counting_allocator, [&]{ return csr_to_sell_c_sigma(view.get(), nullptr); });
+        }
+        check(live_arrays.load() == live_before, "destructor frees with the recorded allocator");
+    }
+
+    delete_csr_matrix(csr);
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    int threads = Le_get_hardware_thread_num();
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        threads = atoi(threads_str);
+    Le_set_thread_num(threads);
+
+    if (precision == 32)
+        test_csr_view<int, float>(argc, argv);
+    else if (precision == 64)
+        test_csr_view<int, double>(argc, argv);
+    else
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
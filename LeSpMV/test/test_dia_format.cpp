@@ -33,7 +33,7 @@ void test_martixfile(int argc, char** argv)
 
     DIA_Matrix <int, float> dia_matrix;
     IndexType max_diags = MAX_DIAG_NUM;
-    IndexType alignment = (SIMD_WIDTH/8/sizeof(ValueType));
+    IndexType alignment = Le_get_alignment<ValueType>();
     dia_matrix = read_dia_matrix<int, float>(mm_filename, max_diags, alignment);
 
     printf("Using %d-by-%d matrix with %d nonzero values\n", dia_matrix.num_rows, dia_matrix.num_cols, dia_matrix.num_nnzs);
@@ -0,0 +1,299 @@
+/**
+ * @file test_dynamic_update.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Incremental structural updates (sparse_dynamic.h) on CSR and SELL-C-sigma:
+ *         random refinements (inserts, value changes, removals, row removal, growth) are
+ *         checked against a reference matrix after every step, and the cost of a refinement
+ *         is compared with a full rebuild of the base format.
+ * @version 0.1
+ * @date 2024-04-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include<iostream>
+#include<cstdio>
+#include<cmath>
+#include<map>
+#include<string>
+#include<thread>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "\t" << " --steps     = number of refinement steps (default 20).\n";
+    std::cout << "\t" << " --updates   = updates per step (default a quarter of the merge threshold,\n";
+    std::cout << "\t" << "               so that the default run starts background merges).\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+// 参考矩阵: 每行一个 map, 按更新逐条维护
+template <typename IndexType, typename ValueType>
+struct Reference
+{
+    std::vector<std::map<IndexType, ValueType>> rows;
+    IndexType num_cols;
+
+    void spmv(const ValueType alpha, const ValueType *x, const ValueType beta, ValueType *y) const
+    {
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            ValueType sum = 0;
+            for (const auto &e : rows[i])
+                sum += e.second * x[e.first];
+            y[i] = alpha * sum + beta * y[i];
+        }
+    }
+
+    CSR_Matrix<IndexType, ValueType> to_csr() const
+    {
+        CSR_Matrix<IndexType, ValueType> csr;
+        csr.num_rows = (IndexType) rows.size();
+        csr.num_cols = num_cols;
+        csr.partition = nullptr;
+        csr.tag = 0;
+        csr.kernel_flag = 1;
+        csr.row_offset = new_array<IndexType>(csr.num_rows + 1);
+        csr.row_offset[0] = 0;
+        for (IndexType i = 0; i < csr.num_rows; ++i)
+            csr.row_offset[i + 1] = csr.row_offset[i] + (IndexType) rows[i].size();
+        csr.num_nnzs = csr.row_offset[csr.num_rows];
+        csr.col_index = new_array<IndexType>(csr.num_nnzs);
+        csr.values    = new_array<ValueType>(csr.num_nnzs);
+        IndexType jj = 0;
+        for (IndexType i = 0; i < csr.num_rows; ++i)
+            for (const auto &e : rows[i])
+            {
+                csr.col_index[jj] = e.first;
+                csr.values[jj++]  = e.second;
+            }
+        return csr;
+    }
+};
+
+template <typename Matrix, typename IndexType, typename ValueType>
+bool check_dynamic(const CSR_Matrix<IndexType, ValueType> &csr, const int steps, const IndexType updates, const std::string &name, unsigned long long seed)
+{
+    Reference<IndexType, ValueType> ref;
+    ref.num_cols = csr.num_cols;
+    ref.rows.resize(csr.num_rows);
+    for (IndexType i = 0; i < csr.num_rows; ++i)
+        for (IndexType jj = csr.row_offset[i]; jj < csr.row_offset[i + 1]; ++jj)
+            ref.rows[i][csr.col_index[jj]] = csr.values[jj];
+
+    Le_dynamic_matrix<Matrix> dyn(csr);
+    dyn.set_kernel_flag(1);
+
+    srand((unsigned) seed);
+    double max_error = 0, update_ms = 0, spmv_ms = 0, rebuild_ms = 0;
+
+    for (int step = 0; step < steps; ++step)
+    {
+        timer t_update;
+        // 网格加密: 中途新增若干行列
+        if (step == steps / 2)
+        {
+            const IndexType grow = std::max((IndexType) 1, (IndexType) (ref.rows.size() / 100));
+            dyn.resize((IndexType) ref.rows.size() + grow, ref.num_cols + grow);
+            ref.rows.resize(ref.rows.size() + grow);
+            ref.num_cols += grow;
+        }
+        for (IndexType k = 0; k < updates; ++k)
+        {
+            const IndexType row = (IndexType) (rand() % ref.rows.size());
+            const IndexType col = (IndexType) (rand() % ref.num_cols);
+            const ValueType val = (ValueType) (rand() % 1000) / 500 - 1;
+            const int op = rand() % 100;
+            if (op < 60)
+            {
+                dyn.insert(row, col, val);
+                ref.rows[row][col] = val;
+            }
+            else if (op < 75 && !ref.rows[row].empty())
+            {
+                // 改已有元素的值
+                const IndexType c = ref.rows[row].begin()->first;
+                dyn.insert(row, c, val);
+                ref.rows[row][c] = val;
+            }
+            else if (op < 98)
+            {
+                const IndexType c = ref.rows[row].empty() ? col : ref.rows[row].rbegin()->first;
+                dyn.remove(row, c);
+                ref.rows[row].erase(c);
+            }
+            else
+            {
+                dyn.remove_row(row);
+                ref.rows[row].clear();
+            }
+        }
+        update_ms += t_update.milliseconds_elapsed();
+
+        const IndexType n = dyn.num_rows();
+        std::vector<ValueType> x(dyn.num_cols()), y(n), y_ref(n);
+        for (auto &v : x)
+            v = (ValueType) (rand() % 1000) / 500 - 1;
+        for (IndexType i = 0; i < n; ++i)
+            y[i] = y_ref[i] = (ValueType) (i % 7) / 7;
+
+        timer t_spmv;
+        dyn.spmv(0.8, x.data(), 0.7, y.data());
+        spmv_ms += t_spmv.milliseconds_elapsed();
+        ref.spmv(0.8, x.data(), 0.7, y_ref.data());
+        max_error = std::max(max_error, (double) maximum_relative_error(y_ref.data(), y.data(), (size_t) n));
+
+        // 对照: 每步重新组装 CSR 并转换基础格式
+        timer t_rebuild;
+        CSR_Matrix<IndexType, ValueType> full = ref.to_csr();
+        Matrix rebuilt = Le_dynamic_base<Matrix>::build(full);
+        rebuild_ms += t_rebuild.milliseconds_elapsed();
+        Le_dynamic_base<Matrix>::destroy(rebuilt);
+        delete_csr_matrix(full);
+    }
+
+    dyn.merge();
+    {
+        const IndexType n = dyn.num_rows();
+        std::vector<ValueType> x(dyn.num_cols(), 1), y(n, 0), y_ref(n, 0);
+        dyn.spmv(1, x.data(), 0, y.data());
+        ref.spmv(1, x.data(), 0, y_ref.data());
+        max_error = std::max(max_error, (double) maximum_relative_error(y_ref.data(), y.data(), (size_t) n));
+    }
+
+    const bool ok = max_error < 5 * std::sqrt(std::numeric_limits<ValueType>::epsilon()) && dyn.delta_nnzs() == 0;
+    printf("\t%-14s : max relative error %e, nnz %lld (delta %lld after merge) %s\n", name.c_str(), max_error,
+           (long long) dyn.num_nnzs(), (long long) dyn.delta_nnzs(), ok ? "" : "  <-- FAILED");
+    printf("\t%-14s : %d steps x %lld updates, update %8.4f ms + spmv %8.4f ms per step, full rebuild %8.4f ms per step\n",
+           name.c_str(), steps, (long long) updates, update_ms / steps, spmv_ms / steps, rebuild_ms / steps);
+    // 后台合并与重放必须被覆盖到, 否则上面的误差只检查了 delta
+    const bool merged = dyn.background_merges() > 0;
+    printf("\t%-14s : %zu background merges, %zu updates replayed after a merge %s\n", name.c_str(),
+           dyn.background_merges(), dyn.replayed_updates(), merged ? "" : "  <-- FAILED (no background merge, raise --updates)");
+    // 合并线程的转换只用 DELTA_MERGE_THREADS 个线程, 调用方仍是 --threads
+    const bool merge_threads_ok = dyn.merge_threads() == DELTA_MERGE_THREADS;
+    printf("\t%-14s : merge converted with %d threads (DELTA_MERGE_THREADS %d), caller uses %d %s\n", name.c_str(),
+           dyn.merge_threads(), DELTA_MERGE_THREADS, Le_get_thread_num(), merge_threads_ok ? "" : "  <-- FAILED");
+    return ok && merged && merge_threads_ok;
+}
+
+/**
+ * @brief Le_thread_num_scope 只改本线程: 该线程上 num_threads(Le_get_thread_num()) 的并行区
+ *        只有 DELTA_MERGE_THREADS 个线程, 主线程不受影响
+ */
+bool check_thread_num_scope()
+{
+    const int caller_threads = Le_get_thread_num();
+    int team = 0, seen_in_scope = 0;
+    std::thread worker([&]
+    {
+        Le_thread_num_scope threads(DELTA_MERGE_THREADS);
+        seen_in_scope = Le_get_thread_num();
+        #pragma omp parallel num_threads(Le_get_thread_num())
+        {
+            #pragma omp single
+            team = omp_get_num_threads();
+        }
+    });
+    worker.join();
+    const bool ok = seen_in_scope == DELTA_MERGE_THREADS && team == DELTA_MERGE_THREADS && Le_get_thread_num() == caller_threads;
+    printf("\tthread scope   : team of %d threads in the scope, caller keeps %d %s\n", team, Le_get_thread_num(), ok ? "" : "  <-- FAILED");
+    return ok;
+}
+
+template <typename IndexType, typename ValueType>
+bool test_dynamic_update(int argc, char **argv)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+    char * gen_spec = get_argval(argc, argv, "gen");
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return false;
+    }
+
+    unsigned long long seed = 1;
+    char * seed_str = get_argval(argc, argv, "seed");
+    if(seed_str != NULL)
+        seed = strtoull(seed_str, NULL, 10);
+
+    CSR_Matrix<IndexType, ValueType> csr;
+    if(gen_spec != NULL)
+    {
+        csr = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr.num_rows == 0)
+            return false;
+    }
+    else
+        csr = read_csr_matrix<IndexType, ValueType>(mm_filename);
+    csr.partition = nullptr;
+
+    int steps = 20;
+    char * steps_str = get_argval(argc, argv, "steps");
+    if(steps_str != NULL)
+        steps = atoi(steps_str);
+
+    // 每步为合并阈值的 1/4, 默认运行中 delta 会多次超过阈值
+    const double merge_threshold = std::max((double) DELTA_MERGE_MIN, DELTA_MERGE_RATIO * csr.num_nnzs);
+    IndexType updates = std::max((IndexType) 1, (IndexType) (merge_threshold / 4));
+    char * updates_str = get_argval(argc, argv, "updates");
+    if(updates_str != NULL)
+        updates = (IndexType) atoll(updates_str);
+
+    printf("Using %lld-by-%lld matrix with %lld nonzero values\n",
+           (long long) csr.num_rows, (long long) csr.num_cols, (long long) csr.num_nnzs);
+
+    std::cout << "\n=====  Base + delta  =====" << std::endl;
+    bool ok = check_thread_num_scope();
+    ok = check_dynamic<CSR_Matrix<IndexType, ValueType>>(csr, steps, updates, "csr", seed) && ok;
+    ok = check_dynamic<SELL_C_Sigma_Matrix<IndexType, ValueType>>(csr, steps, updates, "sell_c_sigma", seed) && ok;
+
+    delete_csr_matrix(csr);
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    int threads = Le_get_hardware_thread_num();
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        threads = atoi(threads_str);
+    Le_set_thread_num(threads);
+
+    bool ok = false;
+    if (precision == 32)
+        ok = test_dynamic_update<int, float>(argc, argv);
+    else if (precision == 64)
+        ok = test_dynamic_update<int, double>(argc, argv);
+    else
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -36,7 +36,7 @@ int main(int argc, char** argv)
     printf("Using %d-by-%d matrix with %d nonzero values\n", ell_matrix.num_rows, ell_matrix.num_cols, ell_matrix.num_nnzs); 
 
     // 不用超线程，只计算真实CORE
-    Le_set_thread_num(CPU_SOCKET * CPU_CORES_PER_SOC);
+    Le_set_thread_num(Le_get_physical_core_num());
 
     char * threads_str = get_argval(argc, argv, "threads");
     if(threads_str != NULL)
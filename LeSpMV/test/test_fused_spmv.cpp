@@ -0,0 +1,237 @@
+/**
+ * @file test_fused_spmv.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Fused SpMV + reductions of CSR and SELL-c-sigma (kernel_flag 0 ~ 2) against
+ *         the plain SpMV of the same format followed by separate reductions:
+ *         y, dot(y, z), dot(y, y), pAp, the residual r = b - A x, and the
+ *         aliased w == y call of the CG solver (sparse_solver.h).
+ * @version 0.1
+ * @date 2024-04-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include<iostream>
+#include<cstdio>
+#include<cmath>
+#include<string>
+#include<vector>
+#include<limits>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+static int failures = 0;
+
+template <typename ValueType>
+static bool close_enough(const double error)
+{
+    return error < 5 * std::sqrt(std::numeric_limits<ValueType>::epsilon());
+}
+
+template <typename ValueType>
+static void check_vector(const std::vector<ValueType> &ref, const std::vector<ValueType> &y, const std::string &name)
+{
+    const double error = (double) maximum_relative_error(ref.data(), y.data(), y.size());
+    const bool ok = close_enough<ValueType>(error);
+    printf("\t%-44s : max relative error %e %s\n", name.c_str(), error, ok ? "" : "  <-- FAILED");
+    if (!ok)
+        failures++;
+}
+
+template <typename ValueType>
+static void check_scalar(const double ref, const ValueType value, const std::string &name)
+{
+    const double error = std::fabs(ref - (double) value) / std::max(std::fabs(ref), 1.0);
+    const bool ok = close_enough<ValueType>(error);
+    printf("\t%-44s : relative error %e %s\n", name.c_str(), error, ok ? "" : "  <-- FAILED");
+    if (!ok)
+        failures++;
+}
+
+// 参照的归约用 double 累加
+template <typename ValueType>
+static double dot_ref(const std::vector<ValueType> &a, const std::vector<ValueType> &b)
+{
+    double sum = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+        sum += (double) a[i] * (double) b[i];
+    return sum;
+}
+
+/**
+ * @brief mat 的 kernel_flag 0 ~ 2: fused kernel 与 spmv + 单独归约比较
+ */
+template <typename SparseMatrix, typename SpMV, typename Fused, typename PAp, typename Residual, typename ValueType>
+void check_fused(const SparseMatrix &mat, SpMV spmv, Fused fused, PAp pAp_fused, Residual residual_fused,
+                 const std::vector<ValueType> &x, const std::vector<ValueType> &w,
+                 const std::vector<ValueType> &z, const std::string &name)
+{
+    const size_t num_rows = mat.num_rows;
+    const ValueType alpha = (ValueType) 1.5, beta = (ValueType) -0.5;
+
+    for (int kernel_flag = 0; kernel_flag <= 2; ++kernel_flag)
+    {
+        SparseMatrix a = mat;
+        a.kernel_flag = kernel_flag;
+        const std::string tag = name + " kernel " + std::to_string(kernel_flag);
+
+        // 参照: Ax = A x, y = alpha * Ax + beta * w
+        std::vector<ValueType> Ax(num_rows, 0), y_ref(num_rows);
+        spmv((ValueType) 1, a, x.data(), (ValueType) 0, Ax.data());
+        for (size_t i = 0; i < num_rows; ++i)
+            y_ref[i] = alpha * Ax[i] + beta * w[i];
+
+        // w 与 y 分开
+        {
+            std::vector<ValueType> y(num_rows, 0);
+            ValueType dot_yz = 0, norm2_y = 0;
+            fused(alpha, a, x.data(), beta, w.data(), y.data(), z.data(), &dot_yz, &norm2_y);
+            check_vector(y_ref, y, tag + " y");
+            check_scalar(dot_ref(y_ref, z), dot_yz, tag + " dot(y, z)");
+            check_scalar(dot_ref(y_ref, y_ref), norm2_y, tag + " dot(y, y)");
+        }
+
+        // w == y, 以及 w = nullptr (同 y)
+        for (int alias = 0; alias < 2; ++alias)
+        {
+            std::vector<ValueType> y(w);
+            ValueType norm2_y = 0;
+            fused(alpha, a, x.data(), beta, (alias == 0) ? (const ValueType *) y.data() : (const ValueType *) nullptr,
+                  y.data(), (const ValueType *) nullptr, (ValueType *) nullptr, &norm2_y);
+            const std::string how = (alias == 0) ? " w == y" : " w = nullptr";
+            check_vector(y_ref, y, tag + how);
+            check_scalar(dot_ref(y_ref, y_ref), norm2_y, tag + how + " dot(y, y)");
+        }
+
+        // CG 的 Ap = A p, w == y == Ap (sparse_solver.h), Ap 中原有的值必须被忽略
+        {
+            std::vector<ValueType> Ap(w);
+            const ValueType pAp = pAp_fused(a, x.data(), Ap.data());
+            check_vector(Ax, Ap, tag + " Ap");
+            check_scalar(dot_ref(x, Ax), pAp, tag + " pAp");
+        }
+
+        // r = b - A x, b 取 w
+        {
+            std::vector<ValueType> r(num_rows, 0), r_ref(num_rows);
+            for (size_t i = 0; i < num_rows; ++i)
+                r_ref[i] = w[i] - Ax[i];
+            const ValueType rr = residual_fused(a, x.data(), w.data(), r.data());
+            check_vector(r_ref, r, tag + " residual r");
+            check_scalar(dot_ref(r_ref, r_ref), rr, tag + " residual dot(r, r)");
+        }
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void test_fused_spmv(int argc, char **argv)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+    char * gen_spec = get_argval(argc, argv, "gen");
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return;
+    }
+
+    unsigned long long seed = 1;
+    char * seed_str = get_argval(argc, argv, "seed");
+    if(seed_str != NULL)
+        seed = strtoull(seed_str, NULL, 10);
+
+    CSR_Matrix<IndexType, ValueType> csr;
+    if(gen_spec != NULL)
+    {
+        csr = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr.num_rows == 0)
+            return;
+    }
+    else
+        csr = read_csr_matrix<IndexType, ValueType>(mm_filename);
+    csr.partition = nullptr;
+
+    const IndexType num_rows = csr.num_rows, num_cols = csr.num_cols;
+    printf("Using %lld-by-%lld matrix with %lld nonzero values\n",
+           (long long) num_rows, (long long) num_cols, (long long) csr.num_nnzs);
+
+    if (num_rows != num_cols)
+    {
+        // pAp = dot(p, A p) 需要方阵
+        printf("The fused kernels are tested on a square matrix\n");
+        failures++;
+        delete_csr_matrix(csr);
+        return;
+    }
+
+    std::vector<ValueType> x(num_cols), w(num_rows), z(num_rows);
+    for (IndexType i = 0; i < num_cols; ++i)
+        x[i] = (ValueType) (i % 17) / 17 - (ValueType) 0.5;
+    for (IndexType i = 0; i < num_rows; ++i)
+    {
+        w[i] = (ValueType) (i % 13) / 13 - (ValueType) 0.25;
+        z[i] = (ValueType) (i % 11) / 11 + (ValueType) 0.1;
+    }
+
+    std::cout << "\n=====  CSR fused  =====" << std::endl;
+    check_fused(csr, LeSpMV_csr<IndexType, ValueType>, LeSpMV_csr_fused<IndexType, ValueType>,
+                LeSpMV_csr_pAp<IndexType, ValueType>, LeSpMV_csr_residual<IndexType, ValueType>,
+                x, w, z, "csr");
+
+    std::cout << "\n=====  SELL-c-sigma fused  =====" << std::endl;
+    SELL_C_Sigma_Matrix<IndexType, ValueType> sell = csr_to_sell_c_sigma(csr, nullptr);
+    check_fused(sell, LeSpMV_sell_c_sigma<IndexType, ValueType>, LeSpMV_sell_c_sigma_fused<IndexType, ValueType>,
+                LeSpMV_sell_c_sigma_pAp<IndexType, ValueType>, LeSpMV_sell_c_sigma_residual<IndexType, ValueType>,
+                x, w, z, "sell_c_sigma");
+    delete_host_matrix(sell);
+
+    delete_csr_matrix(csr);
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    int threads = Le_get_hardware_thread_num();
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        threads = atoi(threads_str);
+    Le_set_thread_num(threads);
+
+    if (precision == 32)
+        test_fused_spmv<int, float>(argc, argv);
+    else if (precision == 64)
+        test_fused_spmv<int, double>(argc, argv);
+    else
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
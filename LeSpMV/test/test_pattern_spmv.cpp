@@ -0,0 +1,179 @@
+/**
+ * @file test_pattern_spmv.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Pattern-only (binary) matrices in CSR, SELL-C-sigma and CSR5: the kernels must
+ *         match the same formats with explicit values of 1, and the time / bandwidth of
+ *         both variants are compared.
+ * @version 0.1
+ * @date 2024-04-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include<iostream>
+#include<cstdio>
+#include<cmath>
+#include<string>
+#include<type_traits>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "Note: the values of my_matrix.mtx are ignored, every nonzero is taken as 1.\n";
+}
+
+template <typename SparseMatrix, typename SpMV, typename ValueType>
+double time_spmv(const SparseMatrix &mat, SpMV spmv, const ValueType *x, ValueType *y, const int num_iterations)
+{
+    spmv((ValueType) 0.7, mat, x, (ValueType) 0.3, y);
+    timer t;
+    for (int i = 0; i < num_iterations; ++i)
+        spmv((ValueType) 0.7, mat, x, (ValueType) 0.3, y);
+    return t.milliseconds_elapsed() / num_iterations;
+}
+
+/**
+ * @brief ones: 数值全为 1 的矩阵, pattern: 同一结构的 pattern-only 矩阵, 检查 kernel_flag 0 ~ max_kernel_flag
+ */
+template <typename SparseMatrix, typename SpMV, typename IndexType, typename ValueType>
+void check_pattern(const SparseMatrix &ones, const SparseMatrix &pattern, SpMV spmv, const int max_kernel_flag, const std::string &name)
+{
+    const IndexType num_rows = pattern.num_rows;
+    std::vector<ValueType> x(pattern.num_cols), y_ref(num_rows), y(num_rows);
+    for (IndexType i = 0; i < pattern.num_cols; ++i)
+        x[i] = (ValueType) (i % 17) / 17 - (ValueType) 0.5;
+
+    const int num_iterations = 50;
+    for (int kernel_flag = 0; kernel_flag <= max_kernel_flag; ++kernel_flag)
+    {
+        SparseMatrix a = ones, b = pattern;
+        a.kernel_flag = b.kernel_flag = kernel_flag;
+
+        for (IndexType i = 0; i < num_rows; ++i)
+            y_ref[i] = y[i] = (ValueType) (i % 5) / 5;
+        spmv((ValueType) 0.7, a, x.data(), (ValueType) 0.3, y_ref.data());
+        spmv((ValueType) 0.7, b, x.data(), (ValueType) 0.3, y.data());
+        const double error = maximum_relative_error(y_ref.data(), y.data(), (size_t) num_rows);
+
+        const double ones_ms    = time_spmv(a, spmv, x.data(), y_ref.data(), num_iterations);
+        const double pattern_ms = time_spmv(b, spmv, x.data(), y.data(), num_iterations);
+        const double ones_gbs    = bytes_per_spmv(a) / ones_ms / 1e6;
+        const double pattern_gbs = bytes_per_spmv(b) / pattern_ms / 1e6;
+
+        const bool ok = error < 5 * std::sqrt(std::numeric_limits<ValueType>::epsilon());
+        printf("\t%-14s kernel %d : max relative error %e %s\n", name.c_str(), kernel_flag, error, ok ? "" : "  <-- FAILED");
+        printf("\t%-14s kernel %d : values 1 %8.4f ms (%6.2f GB/s), pattern %8.4f ms (%6.2f GB/s) ( %.2fx )\n",
+               name.c_str(), kernel_flag, ones_ms, ones_gbs, pattern_ms, pattern_gbs, pattern_ms > 0 ? ones_ms / pattern_ms : 0.0);
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void test_pattern_spmv(int argc, char **argv)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+    char * gen_spec = get_argval(argc, argv, "gen");
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return;
+    }
+
+    unsigned long long seed = 1;
+    char * seed_str = get_argval(argc, argv, "seed");
+    if(seed_str != NULL)
+        seed = strtoull(seed_str, NULL, 10);
+
+    CSR_Matrix<IndexType, ValueType> csr;
+    if(gen_spec != NULL)
+    {
+        csr = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr.num_rows == 0)
+            return;
+    }
+    else
+        csr = read_csr_matrix<IndexType, ValueType>(mm_filename);
+    csr.partition = nullptr;
+
+    printf("Using %lld-by-%lld matrix with %lld nonzero values\n",
+           (long long) csr.num_rows, (long long) csr.num_cols, (long long) csr.num_nnzs);
+
+    // 参照: 同一结构, 数值全为 1
+    std::fill(csr.values, csr.values + csr.num_nnzs, ValueType(1));
+    CSR_Matrix<IndexType, ValueType> csr_pattern = csr;
+    csr_pattern.row_offset = copy_array(csr.row_offset, csr.num_rows + 1);
+    csr_pattern.col_index  = copy_array(csr.col_index, csr.num_nnzs);
+    csr_pattern.values     = copy_array(csr.values, csr.num_nnzs);
+    drop_csr_values(csr_pattern);
+
+    std::cout << "\n=====  Pattern-only SpMV  =====" << std::endl;
+    check_pattern<CSR_Matrix<IndexType, ValueType>, decltype(&LeSpMV_csr<IndexType, ValueType>), IndexType, ValueType>
+        (csr, csr_pattern, LeSpMV_csr<IndexType, ValueType>, 2, "csr");
+
+    typedef SELL_C_Sigma_Matrix<IndexType, ValueType> SELL;
+    SELL sell = csr_to_sell_c_sigma(csr, nullptr);
+    SELL sell_pattern = csr_to_sell_c_sigma(csr_pattern, nullptr);
+    check_pattern<SELL, decltype(&LeSpMV_sell_c_sigma<IndexType, ValueType>), IndexType, ValueType>
+        (sell, sell_pattern, LeSpMV_sell_c_sigma<IndexType, ValueType>, 2, "sell_c_sigma");
+    delete_host_matrix(sell);
+    delete_host_matrix(sell_pattern);
+
+    // CSR5 的 AVX-512 kernel 只实现了双精度, 不区分 kernel_flag
+    if constexpr (std::is_same<ValueType, double>::value)
+    {
+        typedef CSR5_Matrix<IndexType, uint32_t, ValueType> CSR5;
+        CSR5 csr5 = csr_to_csr5<IndexType, uint32_t, ValueType>(csr, nullptr, CSR5_SHARE_ROW_OFFSET);
+        CSR5 csr5_pattern = csr_to_csr5<IndexType, uint32_t, ValueType>(csr_pattern, nullptr, CSR5_SHARE_ROW_OFFSET);
+        check_pattern<CSR5, decltype(&LeSpMV_csr5<IndexType, uint32_t, ValueType>), IndexType, ValueType>
+            (csr5, csr5_pattern, LeSpMV_csr5<IndexType, uint32_t, ValueType>, 0, "csr5");
+        delete_host_matrix(csr5);
+        delete_host_matrix(csr5_pattern);
+    }
+
+    delete_csr_matrix(csr_pattern);
+    delete_csr_matrix(csr);
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    int threads = Le_get_hardware_thread_num();
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        threads = atoi(threads_str);
+    Le_set_thread_num(threads);
+
+    if (precision == 32)
+        test_pattern_spmv<int, float>(argc, argv);
+    else if (precision == 64)
+        test_pattern_spmv<int, double>(argc, argv);
+    else
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,245 @@
+/**
+ * @file test_quantized_spmv.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Lossy FP16 / BF16 / int8 value storage with per-row and per-chunk scales in CSR and
+ *         SELL-C-sigma: accuracy report against the double precision reference SpMV
+ *         (maximum_relative_error), value footprint, time and bandwidth of every mode.
+ * @version 0.1
+ * @date 2024-04-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include<iostream>
+#include<cstdio>
+#include<cmath>
+#include<string>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --precision = 32(or 64), accumulation type of the quantized kernels\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+static const char * storage_name(const ValueStorage storage)
+{
+    switch (storage)
+    {
+        case HalfValues:     return "fp16";
+        case BFloat16Values: return "bf16";
+        case Int8Values:     return "int8";
+        default:             return "dense";
+    }
+}
+
+// 数值 + 缩放因子的字节数
+template <typename SparseMatrix>
+double value_megabytes(const SparseMatrix &mat, const size_t elem_nums)
+{
+    typedef typename std::remove_pointer<decltype(mat.values)>::type ValueType;
+    if (mat.value_storage == DenseValues)
+        return (double) sizeof(ValueType) * elem_nums / 1e6;
+    const size_t groups = (mat.num_rows + mat.scale_rows - 1) / mat.scale_rows;
+    return ((double) packed_value_bytes(mat.value_storage) * elem_nums + (double) sizeof(ValueType) * groups) / 1e6;
+}
+
+/**
+ * @brief mat 的 SpMV 与双精度参照 y_ref 比较, 并计时
+ */
+template <typename SparseMatrix, typename SpMV, typename IndexType, typename ValueType>
+void report(const SparseMatrix &mat, SpMV spmv, const size_t elem_nums, const std::vector<double> &y_ref,
+            const std::vector<ValueType> &x, const double reference_mb, const std::string &name, const std::string &scale)
+{
+    const IndexType num_rows = mat.num_rows;
+    std::vector<ValueType> y(num_rows, 0);
+    spmv((ValueType) 1, mat, x.data(), (ValueType) 0, y.data());
+    std::vector<double> y_double(y.begin(), y.end());
+    const double error = maximum_relative_error(y_ref.data(), y_double.data(), (size_t) num_rows);
+    // 逐行相对误差在接近抵消的行上会放大, 另给出 ||y - y_ref||_inf / ||y_ref||_inf
+    double diff_max = 0, ref_max = 0;
+    for (IndexType i = 0; i < num_rows; ++i)
+    {
+        diff_max = std::max(diff_max, std::fabs(y_double[i] - y_ref[i]));
+        ref_max  = std::max(ref_max, std::fabs(y_ref[i]));
+    }
+    const double norm_error = ref_max > 0 ? diff_max / ref_max : diff_max;
+
+    const int num_iterations = 50;
+    timer t;
+    for (int i = 0; i < num_iterations; ++i)
+        spmv((ValueType) 1, mat, x.data(), (ValueType) 0, y.data());
+    const double ms = t.milliseconds_elapsed() / num_iterations;
+    const double gbs = bytes_per_spmv(mat) / ms / 1e6;
+
+    const double mb = value_megabytes(mat, elem_nums);
+    printf("\t%-12s %-5s %-11s : max relative error %e, norm-wise %e, values %9.3f MB ( %.2fx smaller ), %8.4f ms (%6.2f GB/s)\n",
+           name.c_str(), storage_name(mat.value_storage), scale.c_str(), error, norm_error, mb, mb > 0 ? reference_mb / mb : 0.0, ms, gbs);
+}
+
+template <typename IndexType, typename ValueType>
+void test_quantized_spmv(int argc, char **argv)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+    char * gen_spec = get_argval(argc, argv, "gen");
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return;
+    }
+
+    unsigned long long seed = 1;
+    char * seed_str = get_argval(argc, argv, "seed");
+    if(seed_str != NULL)
+        seed = strtoull(seed_str, NULL, 10);
+
+    // 参照: 双精度 CSR
+    CSR_Matrix<IndexType, double> ref;
+    if(gen_spec != NULL)
+    {
+        ref = generate_csr_matrix<IndexType, double>(gen_spec, seed);
+        if(ref.num_rows == 0)
+            return;
+    }
+    else
+        ref = read_csr_matrix<IndexType, double>(mm_filename);
+    ref.partition = nullptr;
+    ref.kernel_flag = 1;
+
+    printf("Using %lld-by-%lld matrix with %lld nonzero values, %s accumulation\n",
+           (long long) ref.num_rows, (long long) ref.num_cols, (long long) ref.num_nnzs, sizeof(ValueType) == 4 ? "float" : "double");
+
+    std::vector<double> x_ref(ref.num_cols), y_ref(ref.num_rows, 0);
+    srand((unsigned) seed);
+    for (auto &v : x_ref)
+        v = (double) rand() / RAND_MAX - 0.5;
+    LeSpMV_csr((double) 1, ref, x_ref.data(), (double) 0, y_ref.data());
+    std::vector<ValueType> x(x_ref.begin(), x_ref.end());
+    const double reference_mb = (double) sizeof(double) * ref.num_nnzs / 1e6;
+
+    // 同一矩阵的 ValueType 版本
+    CSR_Matrix<IndexType, ValueType> csr;
+    csr.num_rows = ref.num_rows;
+    csr.num_cols = ref.num_cols;
+    csr.num_nnzs = ref.num_nnzs;
+    csr.tag = 0;
+    csr.partition = nullptr;
+    csr.kernel_flag = 1;
+    csr.row_offset = copy_array(ref.row_offset, ref.num_rows + 1);
+    csr.col_index  = copy_array(ref.col_index, ref.num_nnzs);
+    csr.values     = new_array<ValueType>(ref.num_nnzs);
+    for (IndexType jj = 0; jj < ref.num_nnzs; ++jj)
+        csr.values[jj] = (ValueType) ref.values[jj];
+
+    typedef CSR_Matrix<IndexType, ValueType> CSR;
+    typedef SELL_C_Sigma_Matrix<IndexType, ValueType> SELL;
+    const ValueStorage modes[] = {DenseValues, HalfValues, BFloat16Values, Int8Values};
+
+    std::cout << "\n=====  Quantized CSR, error against the double reference  =====" << std::endl;
+    const IndexType C = Le_get_alignment<ValueType>();
+    for (const ValueStorage mode : modes)
+        for (const IndexType scale_rows : {(IndexType) 1, C})
+        {
+            if (mode == DenseValues && scale_rows != 1)
+                continue;
+            CSR q = csr;
+            q.row_offset = copy_array(csr.row_offset, csr.num_rows + 1);
+            q.col_index  = copy_array(csr.col_index, csr.num_nnzs);
+            q.values     = copy_array(csr.values, csr.num_nnzs);
+            if (mode != DenseValues)
+                quantize_csr_values(q, mode, scale_rows);
+            report<CSR, decltype(&LeSpMV_csr<IndexType, ValueType>), IndexType, ValueType>
+                (q, LeSpMV_csr<IndexType, ValueType>, (size_t) csr.num_nnzs, y_ref, x, reference_mb,
+                 "csr", mode == DenseValues ? "" : (scale_rows == 1 ? "per-row" : "per-" + std::to_string((long long) C) + "-rows"));
+            delete_csr_matrix(q);
+        }
+
+    std::cout << "\n=====  Quantized SELL-C-sigma, error against the double reference  =====" << std::endl;
+    for (const ValueStorage mode : modes)
+        for (const bool per_chunk : {false, true})
+        {
+            if (mode == DenseValues && per_chunk)
+                continue;
+            SELL sell = csr_to_sell_c_sigma(csr, nullptr);
+            sell.kernel_flag = 1;
+            const size_t elem_nums = sell.chunk_ptr[sell.validchunkNum];
+            if (mode != DenseValues)
+                quantize_sell_c_sigma_values(sell, mode, per_chunk ? sell.chunkWidth_C : (IndexType) 1);
+            report<SELL, decltype(&LeSpMV_sell_c_sigma<IndexType, ValueType>), IndexType, ValueType>
+                (sell, LeSpMV_sell_c_sigma<IndexType, ValueType>, elem_nums, y_ref, x, reference_mb,
+                 "sell_c_sigma", mode == DenseValues ? "" : (per_chunk ? "per-chunk" : "per-row"));
+            delete_host_matrix(sell);
+        }
+
+    // 逐行量化的 CSR 直接转换为 SELL-C-sigma, 结果必须与 CSR 相同
+    std::cout << "\n=====  Quantized CSR -> SELL-C-sigma  =====" << std::endl;
+    for (const ValueStorage mode : {HalfValues, BFloat16Values, Int8Values})
+    {
+        CSR q = csr;
+        q.row_offset = copy_array(csr.row_offset, csr.num_rows + 1);
+        q.col_index  = copy_array(csr.col_index, csr.num_nnzs);
+        q.values     = copy_array(csr.values, csr.num_nnzs);
+        quantize_csr_values(q, mode);
+        SELL sell = csr_to_sell_c_sigma(q, nullptr);
+
+        std::vector<ValueType> y_csr(csr.num_rows, 0), y_sell(csr.num_rows, 0);
+        LeSpMV_csr((ValueType) 1, q, x.data(), (ValueType) 0, y_csr.data());
+        for (int kernel_flag = 0; kernel_flag <= 2; ++kernel_flag)
+        {
+            sell.kernel_flag = kernel_flag;
+            LeSpMV_sell_c_sigma((ValueType) 1, sell, x.data(), (ValueType) 0, y_sell.data());
+            const double error = maximum_relative_error(y_csr.data(), y_sell.data(), (size_t) csr.num_rows);
+            const bool ok = error < 5 * std::sqrt(std::numeric_limits<ValueType>::epsilon());
+            printf("\t%-5s kernel %d : max relative error to quantized csr %e %s\n", storage_name(mode), kernel_flag, error, ok ? "" : "  <-- FAILED");
+        }
+        delete_host_matrix(sell);
+        delete_csr_matrix(q);
+    }
+
+    delete_csr_matrix(csr);
+    delete_csr_matrix(ref);
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    int threads = Le_get_hardware_thread_num();
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        threads = atoi(threads_str);
+    Le_set_thread_num(threads);
+
+    if (precision == 32)
+        test_quantized_spmv<int, float>(argc, argv);
+    else if (precision == 64)
+        test_quantized_spmv<int, double>(argc, argv);
+    else
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file test_reorder.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Bandwidth, x locality and SpMV performance of CSR after RCM / degree / best-of RCM
+ *         reordering and multilevel graph partition.
+ * @version 0.1
+ * @date 2024-03-20
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include<iostream>
+#include<cstdio>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --method    = kernel_flag of the CSR SpMV (default 1, 2 uses the partition of the graph partition reorder)\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "\t" << " --shuffle   = 1: randomly permute the matrix first, to hide the natural ordering\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+template <typename IndexType, typename ValueType>
+void test_reorder(int argc, char **argv)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+    char * gen_spec = get_argval(argc, argv, "gen");
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return;
+    }
+
+    unsigned long long seed = 1;
+    char * seed_str = get_argval(argc, argv, "seed");
+    if(seed_str != NULL)
+        seed = strtoull(seed_str, NULL, 10);
+
+    CSR_Matrix<IndexType, ValueType> csr_ref;
+    if(gen_spec != NULL)
+    {
+        csr_ref = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr_ref.num_rows == 0)
+            return;
+    }
+    else
+        csr_ref = read_csr_matrix<IndexType, ValueType>(mm_filename);
+
+    int methods = 1;
+    char * methods_str = get_argval(argc, argv, "method");
+    if(methods_str != NULL)
+        methods = atoi(methods_str);
+    csr_ref.kernel_flag = methods;
+    csr_ref.partition = nullptr;
+
+    char * shuffle_str = get_argval(argc, argv, "shuffle");
+    if(shuffle_str != NULL && atoi(shuffle_str) != 0 && csr_ref.num_rows == csr_ref.num_cols)
+    {
+        IndexType * shuffle = new_array<IndexType>(csr_ref.num_rows);
+        for (IndexType i = 0; i < csr_ref.num_rows; ++i)
+            shuffle[i] = i;
+        srand((unsigned) seed);
+        for (IndexType i = csr_ref.num_rows - 1; i > 0; --i)
+            std::swap(shuffle[i], shuffle[rand() % (i + 1)]);
+        CSR_Matrix<IndexType, ValueType> shuffled = permute_csr(csr_ref, shuffle);
+        delete_csr_matrix(csr_ref);
+        csr_ref = shuffled;
+        delete_array(shuffle);
+    }
+
+    printf("Using %lld-by-%lld matrix with %lld nonzero values, bandwidth %lld\n",
+           (long long) csr_ref.num_rows, (long long) csr_ref.num_cols, (long long) csr_ref.num_nnzs, (long long) csr_bandwidth(csr_ref));
+
+    // 原始矩阵按 nnz 均分的线程划分下, 列落在本线程行范围内的比例
+    const IndexType thread_num = Le_get_thread_num();
+    IndexType * nnz_part = new_array<IndexType>(thread_num + 1);
+    balanced_partition_row_by_nnz(csr_ref.row_offset, csr_ref.num_rows, thread_num, nnz_part);
+    printf("\tx locality of %d threads: %.4f\n", (int) thread_num, csr_partition_locality(csr_ref, thread_num, (const IndexType *) nnz_part));
+    delete_array(nnz_part);
+
+    benchmark_spmv_on_host(csr_ref, LeSpMV_csr<IndexType, ValueType>, "csr_original");
+
+    const ReorderMethod reorders[] = {REORDER_RCM, REORDER_DEGREE, REORDER_BANDWIDTH, REORDER_PARTITION};
+    const char * names[] = {"rcm", "degree", "bandwidth", "partition"};
+
+    for (int r = 0; r < 4; ++r)
+    {
+        std::cout << "\n=====  Reorder: " << names[r] << "  =====" << std::endl;
+        timer t;
+        Permuted_CSR_Matrix<IndexType, ValueType> pcsr = csr_to_permuted_csr(csr_ref, reorders[r]);
+        double reorder_ms = t.milliseconds_elapsed();
+
+        printf("\treorder time %8.4f ms, bandwidth %lld\n", reorder_ms, (long long) csr_bandwidth((const CSR_Matrix<IndexType, ValueType> &) pcsr));
+        if (pcsr.partition != nullptr)
+            printf("\tx locality of %d parts: %.4f\n", (int) thread_num, csr_partition_locality((const CSR_Matrix<IndexType, ValueType> &) pcsr, thread_num, (const IndexType *) pcsr.partition));
+
+        std::string name = std::string("csr_") + names[r];
+        test_spmv_kernel(csr_ref, LeSpMV_csr<IndexType, ValueType>,
+                         pcsr, LeSpMV_permuted_csr<IndexType, ValueType>,
+                         (name + "_permuted").c_str());
+
+        // 仅重排后的 kernel, 以及包含 x / y 置换的完整 SpMV
+        CSR_Matrix<IndexType, ValueType> &inner = pcsr;
+        benchmark_spmv_on_host(inner, LeSpMV_csr<IndexType, ValueType>, name);
+        benchmark_spmv_on_host(pcsr, LeSpMV_permuted_csr<IndexType, ValueType>, name + "_permuted");
+
+        delete_permuted_csr_matrix(pcsr);
+    }
+
+    delete_csr_matrix(csr_ref);
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    int threads = Le_get_hardware_thread_num();
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        threads = atoi(threads_str);
+    Le_set_thread_num(threads);
+
+    if (precision == 32)
+        test_reorder<int, float>(argc, argv);
+    else if (precision == 64)
+        test_reorder<int, double>(argc, argv);
+    else
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
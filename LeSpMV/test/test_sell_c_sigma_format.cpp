@@ -33,8 +33,8 @@ void test_martixfile(int argc, char** argv)
     SELL_C_Sigma_Matrix <int, float> s_ell_c_sigma;
     
     IndexType slicewidth = SELL_SIGMA;
-    IndexType chunkwidth = CHUNK_SIZE;
-    IndexType alignment  = SIMD_WIDTH/8/sizeof(ValueType);
+    IndexType chunkwidth = Le_get_alignment<ValueType>();   // C = SIMD lanes
+    IndexType alignment  = Le_get_alignment<ValueType>();
     
     s_ell_c_sigma = read_sell_c_sigma_matrix<IndexType, ValueType> (mm_filename, slicewidth, chunkwidth, alignment);
 
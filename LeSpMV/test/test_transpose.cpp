@@ -0,0 +1,208 @@
+/**
+ * @file test_transpose.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Correctness and performance of y = alpha * A^T * x + beta * y on CSR, SELL-C-sigma,
+ *         BSR, CSR5 and CSB, compared with the CSR SpMV of an explicitly built A^T.
+ * @version 0.1
+ * @date 2024-03-20
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include<iostream>
+#include<cstdio>
+#include<string>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+// 参考结果: 显式构造 A^T 的 CSR (按列计数排序)
+template <typename IndexType, typename ValueType>
+CSR_Matrix<IndexType, ValueType> explicit_transpose(const CSR_Matrix<IndexType, ValueType> &csr)
+{
+    CSR_Matrix<IndexType, ValueType> csrt;
+    csrt.num_rows = csr.num_cols;
+    csrt.num_cols = csr.num_rows;
+    csrt.num_nnzs = csr.num_nnzs;
+    csrt.kernel_flag = 1;
+    csrt.partition = nullptr;
+
+    csrt.row_offset = new_array<IndexType>(csrt.num_rows + 1);
+    csrt.col_index  = new_array<IndexType>(csrt.num_nnzs);
+    csrt.values     = new_array<ValueType>(csrt.num_nnzs);
+
+    for (IndexType i = 0; i <= csrt.num_rows; ++i)
+        csrt.row_offset[i] = 0;
+    for (IndexType jj = 0; jj < csr.num_nnzs; ++jj)
+        csrt.row_offset[csr.col_index[jj] + 1]++;
+    for (IndexType i = 0; i < csrt.num_rows; ++i)
+        csrt.row_offset[i + 1] += csrt.row_offset[i];
+
+    IndexType * fill = copy_array(csrt.row_offset, csrt.num_rows);
+    for (IndexType row = 0; row < csr.num_rows; ++row)
+        for (IndexType jj = csr.row_offset[row]; jj < csr.row_offset[row + 1]; ++jj)
+        {
+            IndexType dst = fill[csr.col_index[jj]]++;
+            csrt.col_index[dst] = row;
+            csrt.values[dst]    = csr.values[jj];
+        }
+    delete_array(fill);
+    return csrt;
+}
+
+/**
+ * @brief test_spmv_kernel 要求两个矩阵维度相同, 转置 SpMV 的 x / y 长度互换, 这里单独比较与计时
+ */
+template <typename SparseMatrix, typename TransposeSpMV, typename IndexType, typename ValueType>
+void check_transpose_kernel(const CSR_Matrix<IndexType, ValueType> &csrt, SparseMatrix &mat, TransposeSpMV spmv_t, const std::string &name)
+{
+    const ValueType alpha = 0.8, beta = 0.7;
+    ValueType * x     = new_array<ValueType>(mat.num_rows);
+    ValueType * y_ref = new_array<ValueType>(mat.num_cols);
+    ValueType * y     = new_array<ValueType>(mat.num_cols);
+
+    for (IndexType i = 0; i < mat.num_rows; ++i)
+        x[i] = (ValueType) (rand() % 1000) / 500 - 1;
+
+    for (int flag = 0; flag < 3; ++flag)
+    {
+        mat.kernel_flag = flag;
+        for (IndexType i = 0; i < mat.num_cols; ++i)
+            y_ref[i] = y[i] = (ValueType) (i % 7) / 7;
+
+        LeSpMV_csr(alpha, csrt, x, beta, y_ref);
+        spmv_t(alpha, mat, x, beta, y);
+
+        double error = maximum_relative_error(y_ref, y, (size_t) mat.num_cols);
+        printf("\t%-20s kernel_flag %d : max relative error %e %s\n", name.c_str(), flag, error, error < 5 * std::sqrt(std::numeric_limits<ValueType>::epsilon()) ? "" : "  <-- FAILED");
+    }
+
+    // 计时并行 kernel
+    mat.kernel_flag = 1;
+    const int num_iterations = 50;
+    spmv_t(alpha, mat, x, beta, y);
+    timer t;
+    for (int i = 0; i < num_iterations; ++i)
+        spmv_t(alpha, mat, x, beta, y);
+    double msec = t.milliseconds_elapsed() / num_iterations;
+    double gflops = 2.0 * mat.num_nnzs / msec / 1e6;
+    printf("\t%-20s : %8.4f ms ( %5.2f GFLOP/s )\n", name.c_str(), msec, gflops);
+
+    delete_array(x);
+    delete_array(y_ref);
+    delete_array(y);
+}
+
+template <typename IndexType, typename ValueType>
+void test_transpose(int argc, char **argv)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+    char * gen_spec = get_argval(argc, argv, "gen");
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return;
+    }
+
+    unsigned long long seed = 1;
+    char * seed_str = get_argval(argc, argv, "seed");
+    if(seed_str != NULL)
+        seed = strtoull(seed_str, NULL, 10);
+
+    CSR_Matrix<IndexType, ValueType> csr_ref;
+    if(gen_spec != NULL)
+    {
+        csr_ref = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr_ref.num_rows == 0)
+            return;
+    }
+    else
+        csr_ref = read_csr_matrix<IndexType, ValueType>(mm_filename);
+    csr_ref.partition = nullptr;
+    srand((unsigned) seed);
+
+    printf("Using %lld-by-%lld matrix with %lld nonzero values, transpose strategy %s\n",
+           (long long) csr_ref.num_rows, (long long) csr_ref.num_cols, (long long) csr_ref.num_nnzs,
+           transpose_strategy(csr_ref.num_nnzs, csr_ref.num_cols) == TRANSPOSE_PRIVATE ? "private" : "color");
+
+    CSR_Matrix<IndexType, ValueType> csrt = explicit_transpose(csr_ref);
+    {
+        // 显式转置 + 普通 CSR SpMV 的性能作为对照
+        std::cout << "\n=====  CSR of explicit A^T  =====" << std::endl;
+        timer t;
+        CSR_Matrix<IndexType, ValueType> tmp = explicit_transpose(csr_ref);
+        printf("\tbuild A^T %8.4f ms\n", t.milliseconds_elapsed());
+        delete_csr_matrix(tmp);
+        benchmark_spmv_on_host(csrt, LeSpMV_csr<IndexType, ValueType>, "csr_explicit_transpose");
+    }
+
+    std::cout << "\n=====  Transpose kernels  =====" << std::endl;
+    check_transpose_kernel(csrt, csr_ref, LeSpMV_csr_transpose<IndexType, ValueType>, "csr");
+
+    SELL_C_Sigma_Matrix<IndexType, ValueType> sell_c_sigma = csr_to_sell_c_sigma(csr_ref, nullptr);
+    check_transpose_kernel(csrt, sell_c_sigma, LeSpMV_sell_c_sigma_transpose<IndexType, ValueType>, "sell_c_sigma");
+    delete_host_matrix(sell_c_sigma);
+
+    BSR_Matrix<IndexType, ValueType> bsr = csr_to_bsr(csr_ref);
+    check_transpose_kernel(csrt, bsr, LeSpMV_bsr_transpose<IndexType, ValueType>, "bsr");
+    delete_host_matrix(bsr);
+
+    CSR5_Matrix<IndexType, uint32_t, ValueType> csr5 = csr_to_csr5<IndexType, uint32_t, ValueType>(csr_ref, nullptr, CSR5_SHARE_ROW_OFFSET);
+    check_transpose_kernel(csrt, csr5, LeSpMV_csr5_transpose<IndexType, uint32_t, ValueType>, "csr5");
+    delete_host_matrix(csr5);
+
+    CSB_Matrix<IndexType, ValueType> csb = csr_to_csb(csr_ref);
+    check_transpose_kernel(csrt, csb, LeSpMV_csb_transpose<IndexType, ValueType>, "csb");
+    delete_host_matrix(csb);
+
+    delete_csr_matrix(csrt);
+    delete_csr_matrix(csr_ref);
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    int threads = Le_get_hardware_thread_num();
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        threads = atoi(threads_str);
+    Le_set_thread_num(threads);
+
+    if (precision == 32)
+        test_transpose<int, float>(argc, argv);
+    else if (precision == 64)
+        test_transpose<int, double>(argc, argv);
+    else
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
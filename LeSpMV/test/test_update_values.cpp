@@ -0,0 +1,166 @@
+/**
+ * @file test_update_values.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Value-only update of SELL-C-sigma, BSR and CSR5 with a fixed sparsity pattern:
+ *         the updated arrays must equal a fresh conversion of the new values,
+ *         and the update is timed against that reconversion.
+ * @version 0.1
+ * @date 2024-04-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include<iostream>
+#include<cstdio>
+#include<cmath>
+#include<string>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+template <typename ValueType>
+double max_difference(const ValueType *a, const ValueType *b, const size_t N)
+{
+    double diff = 0;
+    for (size_t i = 0; i < N; ++i)
+        diff = std::max(diff, (double) std::fabs(a[i] - b[i]));
+    return diff;
+}
+
+/**
+ * @brief convert(csr) 重新转换, values_of(mat) 返回 {values, 长度}
+ */
+template <typename SparseMatrix, typename Convert, typename ValuesOf, typename IndexType, typename ValueType>
+void check_update(const CSR_Matrix<IndexType, ValueType> &csr, const ValueType *new_vals, Convert convert, ValuesOf values_of, const std::string &name)
+{
+    SparseMatrix mat = convert(csr);
+
+    CSR_Matrix<IndexType, ValueType> csr_new = csr;
+    csr_new.values = const_cast<ValueType *>(new_vals);
+
+    timer t_convert;
+    SparseMatrix ref = convert(csr_new);
+    double convert_ms = t_convert.milliseconds_elapsed();
+
+    update_values(mat, new_vals);
+
+    const int num_iterations = 20;
+    timer t_update;
+    for (int i = 0; i < num_iterations; ++i)
+        update_values(mat, new_vals);
+    double update_ms = t_update.milliseconds_elapsed() / num_iterations;
+
+    std::pair<const ValueType *, size_t> v = values_of(mat), v_ref = values_of(ref);
+    double diff = v.second == v_ref.second ? max_difference(v.first, v_ref.first, v.second) : 1.0;
+    printf("\t%-14s : max difference to reconversion %e %s\n", name.c_str(), diff, diff == 0 ? "" : "  <-- FAILED");
+    printf("\t%-14s : reconvert %9.4f ms, update_values %8.4f ms ( %.1fx )\n", name.c_str(), convert_ms, update_ms, update_ms > 0 ? convert_ms / update_ms : 0.0);
+
+    delete_host_matrix(mat);
+    delete_host_matrix(ref);
+}
+
+template <typename IndexType, typename ValueType>
+void test_update_values(int argc, char **argv)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+    char * gen_spec = get_argval(argc, argv, "gen");
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return;
+    }
+
+    unsigned long long seed = 1;
+    char * seed_str = get_argval(argc, argv, "seed");
+    if(seed_str != NULL)
+        seed = strtoull(seed_str, NULL, 10);
+
+    CSR_Matrix<IndexType, ValueType> csr;
+    if(gen_spec != NULL)
+    {
+        csr = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr.num_rows == 0)
+            return;
+    }
+    else
+        csr = read_csr_matrix<IndexType, ValueType>(mm_filename);
+    csr.partition = nullptr;
+
+    printf("Using %lld-by-%lld matrix with %lld nonzero values\n",
+           (long long) csr.num_rows, (long long) csr.num_cols, (long long) csr.num_nnzs);
+
+    // 新的一步: 结构不变, 数值改变
+    ValueType * new_vals = new_array<ValueType>(csr.num_nnzs);
+    for (IndexType jj = 0; jj < csr.num_nnzs; ++jj)
+        new_vals[jj] = csr.values[jj] * (ValueType) 1.5 + (ValueType) (jj % 13) / 13;
+
+    std::cout << "\n=====  Value-only update  =====" << std::endl;
+    typedef SELL_C_Sigma_Matrix<IndexType, ValueType> SELL;
+    check_update<SELL>(csr, new_vals,
+        [](const CSR_Matrix<IndexType, ValueType> &m) { return csr_to_sell_c_sigma(m, nullptr); },
+        [](const SELL &m) { return std::make_pair((const ValueType *) m.values, (size_t) m.chunk_ptr[m.validchunkNum]); },
+        "sell_c_sigma");
+
+    typedef BSR_Matrix<IndexType, ValueType> BSR;
+    check_update<BSR>(csr, new_vals,
+        [](const CSR_Matrix<IndexType, ValueType> &m) { return csr_to_bsr(m); },
+        [](const BSR &m) { return std::make_pair((const ValueType *) m.block_data, (size_t) m.nnzb * m.blockNNZ); },
+        "bsr");
+
+    typedef CSR5_Matrix<IndexType, uint32_t, ValueType> CSR5;
+    check_update<CSR5>(csr, new_vals,
+        [](const CSR_Matrix<IndexType, ValueType> &m) { return csr_to_csr5<IndexType, uint32_t, ValueType>(m, nullptr, CSR5_SHARE_ROW_OFFSET); },
+        [](const CSR5 &m) { return std::make_pair((const ValueType *) m.values, (size_t) m.num_nnzs); },
+        "csr5");
+
+    delete_array(new_vals);
+    delete_csr_matrix(csr);
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    int threads = Le_get_hardware_thread_num();
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        threads = atoi(threads_str);
+    Le_set_thread_num(threads);
+
+    if (precision == 32)
+        test_update_values<int, float>(argc, argv);
+    else if (precision == 64)
+        test_update_values<int, double>(argc, argv);
+    else
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
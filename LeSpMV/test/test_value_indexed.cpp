@@ -0,0 +1,232 @@
+/**
+ * @file test_value_indexed.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Value-indexed compression (CSR-VI / SELL-VI): matrices with few distinct values store
+ *         a value table and 8- or 16-bit codes. The kernels must match the dense formats,
+ *         the footprint and the time / bandwidth of both variants are compared.
+ * @version 0.1
+ * @date 2024-04-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include<iostream>
+#include<cstdio>
+#include<cmath>
+#include<string>
+#include"../include/LeSpMV.h"
+#include"../include/cmdline.h"
+
+void usage(int argc, char** argv)
+{
+    std::cout << "Usage:\n";
+    std::cout << "\t" << argv[0] << " with following parameters:\n";
+    std::cout << "\t" << " my_matrix.mtx\n";
+    std::cout << "\t" << " --precision = 32(or 64)\n";
+    std::cout << "\t" << " --threads   = define the num of omp threads\n";
+    std::cout << "\t" << " --gen       = spec, generate the matrix in memory instead of my_matrix.mtx (see sparse_generator.h)\n";
+    std::cout << "\t" << " --seed      = generator seed (default 1).\n";
+    std::cout << "\t" << " --levels    = round the values to this many distinct levels before compression (default: keep the values).\n";
+    std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n";
+}
+
+static const char * storage_name(const ValueStorage storage)
+{
+    switch (storage)
+    {
+        case IndexedValues8:  return "8-bit codes";
+        case IndexedValues16: return "16-bit codes";
+        case PatternValues:   return "pattern";
+        default:              return "dense";
+    }
+}
+
+template <typename SparseMatrix, typename SpMV, typename ValueType>
+double time_spmv(const SparseMatrix &mat, SpMV spmv, const ValueType *x, ValueType *y, const int num_iterations)
+{
+    spmv((ValueType) 0.7, mat, x, (ValueType) 0.3, y);
+    timer t;
+    for (int i = 0; i < num_iterations; ++i)
+        spmv((ValueType) 0.7, mat, x, (ValueType) 0.3, y);
+    return t.milliseconds_elapsed() / num_iterations;
+}
+
+/**
+ * @brief dense: 稠密数值的矩阵, indexed: 同一矩阵的值编号压缩版本, 检查 kernel_flag 0 ~ max_kernel_flag
+ */
+template <typename SparseMatrix, typename SpMV, typename IndexType, typename ValueType>
+void check_indexed(const SparseMatrix &dense, const SparseMatrix &indexed, SpMV spmv, const int max_kernel_flag, const std::string &name)
+{
+    const IndexType num_rows = indexed.num_rows;
+    std::vector<ValueType> x(indexed.num_cols), y_ref(num_rows), y(num_rows);
+    for (IndexType i = 0; i < indexed.num_cols; ++i)
+        x[i] = (ValueType) (i % 17) / 17 - (ValueType) 0.5;
+
+    const int num_iterations = 50;
+    for (int kernel_flag = 0; kernel_flag <= max_kernel_flag; ++kernel_flag)
+    {
+        SparseMatrix a = dense, b = indexed;
+        a.kernel_flag = b.kernel_flag = kernel_flag;
+
+        for (IndexType i = 0; i < num_rows; ++i)
+            y_ref[i] = y[i] = (ValueType) (i % 5) / 5;
+        spmv((ValueType) 0.7, a, x.data(), (ValueType) 0.3, y_ref.data());
+        spmv((ValueType) 0.7, b, x.data(), (ValueType) 0.3, y.data());
+        const double error = maximum_relative_error(y_ref.data(), y.data(), (size_t) num_rows);
+
+        const double dense_ms   = time_spmv(a, spmv, x.data(), y_ref.data(), num_iterations);
+        const double indexed_ms = time_spmv(b, spmv, x.data(), y.data(), num_iterations);
+        const double dense_gbs   = bytes_per_spmv(a) / dense_ms / 1e6;
+        const double indexed_gbs = bytes_per_spmv(b) / indexed_ms / 1e6;
+
+        const bool ok = error < 5 * std::sqrt(std::numeric_limits<ValueType>::epsilon());
+        printf("\t%-14s kernel %d : max relative error %e %s\n", name.c_str(), kernel_flag, error, ok ? "" : "  <-- FAILED");
+        printf("\t%-14s kernel %d : dense %8.4f ms (%6.2f GB/s), indexed %8.4f ms (%6.2f GB/s) ( %.2fx )\n",
+               name.c_str(), kernel_flag, dense_ms, dense_gbs, indexed_ms, indexed_gbs, indexed_ms > 0 ? dense_ms / indexed_ms : 0.0);
+    }
+}
+
+/**
+ * @brief 几乎各不相同的数值: 值表不省空间, compress_csr_values 必须返回 false 且矩阵保持稠密
+ */
+template <typename IndexType, typename ValueType>
+bool check_unique_stays_dense(const CSR_Matrix<IndexType, ValueType> &csr)
+{
+    CSR_Matrix<IndexType, ValueType> unique = csr;
+    unique.row_offset = copy_array(csr.row_offset, csr.num_rows + 1);
+    unique.col_index  = copy_array(csr.col_index, csr.num_nnzs);
+    unique.values     = new_array<ValueType>(csr.num_nnzs);
+    for (IndexType jj = 0; jj < csr.num_nnzs; ++jj)
+        unique.values[jj] = (ValueType) 1 + (ValueType) (jj % 4096) / 4096 + (ValueType) (jj / 4096);
+
+    const bool compressed = compress_csr_values(unique);
+    const bool ok = !compressed && unique.value_storage == DenseValues && unique.values != nullptr;
+    printf("Mostly unique values (%lld nonzeros, table capacity %zu): %s %s\n", (long long) csr.num_nnzs,
+           value_table_capacity<ValueType>(), compressed ? "compressed" : "stays dense", ok ? "" : "  <-- FAILED");
+    delete_csr_matrix(unique);
+    return ok;
+}
+
+template <typename IndexType, typename ValueType>
+bool test_value_indexed(int argc, char **argv)
+{
+    char * mm_filename = NULL;
+    for(int i = 1; i < argc; i++){
+        if(argv[i][0] != '-'){
+            mm_filename = argv[i];
+            break;
+        }
+    }
+    char * gen_spec = get_argval(argc, argv, "gen");
+    if(mm_filename == NULL && gen_spec == NULL)
+    {
+        printf("You need to input a matrix file!\n");
+        return false;
+    }
+
+    unsigned long long seed = 1;
+    char * seed_str = get_argval(argc, argv, "seed");
+    if(seed_str != NULL)
+        seed = strtoull(seed_str, NULL, 10);
+
+    CSR_Matrix<IndexType, ValueType> csr;
+    if(gen_spec != NULL)
+    {
+        csr = generate_csr_matrix<IndexType, ValueType>(gen_spec, seed);
+        if(csr.num_rows == 0)
+            return false;
+    }
+    else
+        csr = read_csr_matrix<IndexType, ValueType>(mm_filename);
+    csr.partition = nullptr;
+
+    printf("Using %lld-by-%lld matrix with %lld nonzero values\n",
+           (long long) csr.num_rows, (long long) csr.num_cols, (long long) csr.num_nnzs);
+
+    const bool unique_ok = check_unique_stays_dense(csr);
+
+    // 可选: 把数值量化到 levels 个等级, 模拟少量不同值的矩阵
+    char * levels_str = get_argval(argc, argv, "levels");
+    if(levels_str != NULL && atoi(levels_str) > 0)
+    {
+        const int levels = atoi(levels_str);
+        ValueType vmax = 0;
+        for (IndexType jj = 0; jj < csr.num_nnzs; ++jj)
+            vmax = std::max(vmax, (ValueType) std::fabs(csr.values[jj]));
+        const ValueType step = vmax > 0 ? 2 * vmax / levels : ValueType(1);
+        for (IndexType jj = 0; jj < csr.num_nnzs; ++jj)
+            csr.values[jj] = std::round(csr.values[jj] / step) * step;
+    }
+
+    CSR_Matrix<IndexType, ValueType> csr_indexed = csr;
+    csr_indexed.row_offset = copy_array(csr.row_offset, csr.num_rows + 1);
+    csr_indexed.col_index  = copy_array(csr.col_index, csr.num_nnzs);
+    csr_indexed.values     = copy_array(csr.values, csr.num_nnzs);
+
+    timer t_compress;
+    const bool compressed = compress_csr_values(csr_indexed);
+    const double compress_ms = t_compress.milliseconds_elapsed();
+    if (!compressed)
+    {
+        printf("More than %zu distinct values or no saving, the matrix stays dense (%.4f ms). Try --levels.\n",
+               value_table_capacity<ValueType>(), compress_ms);
+        delete_csr_matrix(csr_indexed);
+        delete_csr_matrix(csr);
+        return unique_ok;
+    }
+
+    const double dense_mb   = (double) sizeof(ValueType) * csr.num_nnzs / 1e6;
+    const double indexed_mb = ((double) packed_value_bytes(csr_indexed.value_storage) * csr.num_nnzs
+                             + (double) sizeof(ValueType) * csr_indexed.value_table_size) / 1e6;
+    printf("Value table of %lld entries, %s, compressed in %.4f ms\n",
+           (long long) csr_indexed.value_table_size, storage_name(csr_indexed.value_storage), compress_ms);
+    printf("Value storage %.3f MB -> %.3f MB ( %.2fx smaller )\n", dense_mb, indexed_mb, indexed_mb > 0 ? dense_mb / indexed_mb : 0.0);
+
+    std::cout << "\n=====  Value-indexed SpMV  =====" << std::endl;
+    check_indexed<CSR_Matrix<IndexType, ValueType>, decltype(&LeSpMV_csr<IndexType, ValueType>), IndexType, ValueType>
+        (csr, csr_indexed, LeSpMV_csr<IndexType, ValueType>, 2, "csr");
+
+    typedef SELL_C_Sigma_Matrix<IndexType, ValueType> SELL;
+    SELL sell = csr_to_sell_c_sigma(csr, nullptr);
+    SELL sell_indexed = csr_to_sell_c_sigma(csr_indexed, nullptr);
+    check_indexed<SELL, decltype(&LeSpMV_sell_c_sigma<IndexType, ValueType>), IndexType, ValueType>
+        (sell, sell_indexed, LeSpMV_sell_c_sigma<IndexType, ValueType>, 2, "sell_c_sigma");
+    delete_host_matrix(sell);
+    delete_host_matrix(sell_indexed);
+
+    delete_csr_matrix(csr_indexed);
+    delete_csr_matrix(csr);
+    return unique_ok;
+}
+
+int main(int argc, char** argv)
+{
+    if (get_arg(argc, argv, "help") != NULL){
+        usage(argc, argv);
+        return EXIT_SUCCESS;
+    }
+
+    int precision = 64;
+    char * precision_str = get_argval(argc, argv, "precision");
+    if(precision_str != NULL)
+        precision = atoi(precision_str);
+
+    int threads = Le_get_hardware_thread_num();
+    char * threads_str = get_argval(argc, argv, "threads");
+    if(threads_str != NULL)
+        threads = atoi(threads_str);
+    Le_set_thread_num(threads);
+
+    bool ok = false;
+    if (precision == 32)
+        ok = test_value_indexed<int, float>(argc, argv);
+    else if (precision == 64)
+        ok = test_value_indexed<int, double>(argc, argv);
+    else
+    {
+        usage(argc, argv);
+        return EXIT_FAILURE;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file arena.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Per-thread bump arenas for conversion scratch and SpMV temporaries.
+ *         A block that overflows is retired (linked through its header) and
+ *         replaced by a larger one; retired blocks are freed once the outermost
+ *         scope of the sub-arena ends, so the next call fits in one block.
+ * @version 0.1
+ * @date 2024-04-03
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include"../include/arena.h"
+#include"../include/general_config.h"
+#include"../include/plat_runtime.h"
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<algorithm>
+
+// 每个 block 头部一条 cache line, 存放 retired 链表的 next 指针
+static const size_t ARENA_HEADER = 64;
+
+struct alignas(64) Le_arena::Sub
+{
+    char   *block   = nullptr;  // current block, data starts at block + ARENA_HEADER
+    size_t  cap     = 0;        // data bytes of the current block
+    size_t  top     = 0;
+    char   *retired = nullptr;  // overflowed blocks still referenced by open scopes
+    int     depth   = 0;        // open scopes
+};
+
+static inline size_t round_line(const size_t bytes)
+{
+    return (bytes + ARENA_HEADER - 1) / ARENA_HEADER * ARENA_HEADER;
+}
+
+Le_arena::Le_arena(size_t bytes_per_thread, const Le_allocator *alloc)
+    : subs(nullptr), num_subs(0), first_block(round_line(bytes_per_thread)),
+      alloc(alloc != nullptr ? alloc : Le_get_allocator())
+{
+}
+
+Le_arena::~Le_arena()
+{
+    release();
+    delete [] subs;
+}
+
+void Le_arena::reserve_threads(int num_threads)
+{
+    if (num_threads <= num_subs)
+        return;
+    Sub *grown = new Sub[num_threads];
+    Le_count_heap_call();
+    for (int t = 0; t < num_subs; ++t)
+        grown[t] = subs[t];
+    if (subs != nullptr)
+    {
+        delete [] subs;
+        Le_count_heap_call();
+    }
+    subs = grown;
+    num_subs = num_threads;
+}
+
+void Le_arena::free_retired(Sub &s)
+{
+    while (s.retired != nullptr)
+    {
+        char *next = *(char **) s.retired;
+        alloc->deallocate(s.retired, alloc->ctx);
+        Le_count_heap_call();
+        s.retired = next;
+    }
+}
+
+void Le_arena::grow(Sub &s, size_t need)
+{
+    const size_t cap = std::max(std::max(s.top + need, 2 * s.cap), std::max(first_block, (size_t) ARENA_MIN_BLOCK));
+    char *b = (char *) alloc->allocate(cap + ARENA_HEADER, MEM_CLASS_VECTOR, alloc->ctx);
+    Le_count_heap_call();
+    if (b == nullptr)
+    {
+        fprintf(stderr, "Error: arena failed to allocate %zu bytes\n", cap + ARENA_HEADER);
+        exit(EXIT_FAILURE);
+    }
+    if (s.block != nullptr)
+    {
+        if (s.top == 0)
+        {
+            alloc->deallocate(s.block, alloc->ctx);
+            Le_count_heap_call();
+        }
+        else
+        {
+            *(char **) s.block = s.retired;
+            s.retired = s.block;
+        }
+    }
+    s.block = b;
+    s.cap = cap;
+    s.top = 0;
+}
+
+void * Le_arena::allocate(size_t bytes, int tid)
+{
+    if (tid < 0 || tid >= num_subs)
+    {
+        fprintf(stderr, "Error: arena has %d sub-arenas, thread %d needs reserve_threads()\n", num_subs, tid);
+        exit(EXIT_FAILURE);
+    }
+    Sub &s = subs[tid];
+    const size_t need = round_line(std::max(bytes, (size_t) 1));
+    if (s.block == nullptr || s.top + need > s.cap)
+        grow(s, need);
+    void *p = s.block + ARENA_HEADER + s.top;
+    s.top += need;
+    return p;
+}
+
+size_t Le_arena::capacity() const
+{
+    size_t bytes = 0;
+    for (int t = 0; t < num_subs; ++t)
+        bytes += subs[t].cap;
+    return bytes;
+}
+
+void Le_arena::release()
+{
+    for (int t = 0; t < num_subs; ++t)
+    {
+        Sub &s = subs[t];
+        free_retired(s);
+        if (s.block != nullptr)
+        {
+            alloc->deallocate(s.block, alloc->ctx);
+            Le_count_heap_call();
+        }
+        s = Sub();
+    }
+}
+
+Le_arena_scope::Le_arena_scope(Le_arena &arena, int tid)
+    : arena(arena), tid(tid)
+{
+    Le_arena::Sub &s = arena.subs[tid];
+    ++s.depth;
+    block = s.block;
+    top   = s.top;
+}
+
+Le_arena_scope::~Le_arena_scope()
+{
+    Le_arena::Sub &s = arena.subs[tid];
+    // 作用域内换过 block 时, 新 block 上全是本作用域的分配
+    s.top = (s.block == block) ? top : 0;
+    if (--s.depth == 0)
+    {
+        arena.free_retired(s);
+        s.top = 0;
+    }
+}
+
+Le_arena & Le_thread_arena()
+{
+    // 与调用时生效的 allocator 无关, 固定使用默认 allocator
+    static thread_local Le_arena arena(0, Le_default_allocator());
+    return arena;
+}
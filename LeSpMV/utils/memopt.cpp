@@ -0,0 +1,229 @@
+/**
+ * @file memopt.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Page policies of new_array(): base pages, transparent huge pages
+ *         (madvise) or explicit 2 MiB / 1 GiB pages of hugetlbfs (mmap).
+ *         hugetlbfs mappings are recorded so that delete_array() can unmap them.
+ *         The allocator hooks of new_array() / delete_array() default to these pages.
+ * @version 0.1
+ * @date 2024-03-30
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include"../include/memopt.h"
+#include"../include/general_config.h"
+
+#include<stdlib.h>
+#include<string.h>
+#include<atomic>
+#include<mutex>
+#include<unordered_map>
+
+#ifdef __linux__
+#include<sys/mman.h>
+#endif
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+static const size_t PAGE_2M = 2ULL << 20;
+static const size_t PAGE_1G = 1ULL << 30;
+
+static MemPagePolicy policy_from_env(const char *name)
+{
+    MemPagePolicy policy = MEM_PAGE_DEFAULT;
+    const char *val = getenv(name);
+    if (val != NULL && val[0] != '\0' && !Le_parse_page_policy(val, policy))
+        fprintf(stderr, "Warning: unknown %s=%s, use default pages\n", name, val);
+    return policy;
+}
+
+static MemPagePolicy * page_policies()
+{
+    static MemPagePolicy policies[MEM_CLASS_NUM] = {
+        policy_from_env("LESPMV_PAGE_MATRIX"),
+        policy_from_env("LESPMV_PAGE_VECTOR")
+    };
+    return policies;
+}
+
+// hugetlbfs mappings: address -> mapped bytes
+static std::mutex mapped_lock;
+static std::unordered_map<void *, size_t> mapped;
+static std::atomic<long> mapped_count(0);
+
+void Le_set_page_policy(MemClass cls, MemPagePolicy policy)
+{
+    page_policies()[cls] = policy;
+}
+
+MemPagePolicy Le_get_page_policy(MemClass cls)
+{
+    return page_policies()[cls];
+}
+
+bool Le_parse_page_policy(const char *name, MemPagePolicy &policy)
+{
+    if (strcmp(name, "default") == 0 || strcmp(name, "4k") == 0)
+        policy = MEM_PAGE_DEFAULT;
+    else if (strcmp(name, "thp") == 0)
+        policy = MEM_PAGE_THP;
+    else if (strcmp(name, "2m") == 0)
+        policy = MEM_PAGE_HUGETLB_2M;
+    else if (strcmp(name, "1g") == 0)
+        policy = MEM_PAGE_HUGETLB_1G;
+    else
+        return false;
+    return true;
+}
+
+const char * Le_page_policy_name(MemPagePolicy policy)
+{
+    switch (policy)
+    {
+        case MEM_PAGE_THP:        return "thp";
+        case MEM_PAGE_HUGETLB_2M: return "2m";
+        case MEM_PAGE_HUGETLB_1G: return "1g";
+        default:                  return "default";
+    }
+}
+
+static inline size_t round_up(const size_t bytes, const size_t page)
+{
+    return (bytes + page - 1) / page * page;
+}
+
+#ifdef __linux__
+static void * alloc_hugetlb(const size_t bytes, const size_t page, const int log2_page)
+{
+    const size_t len = round_up(bytes, page);
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (log2_page << MAP_HUGE_SHIFT), -1, 0);
+    if (p == MAP_FAILED)
+    {
+        // 没有预留 hugetlbfs 页时只提示一次
+        static std::atomic<bool> warned(false);
+        if (!warned.exchange(true))
+            fprintf(stderr, "Warning: no %s hugetlbfs pages for %zu bytes, fall back\n", page == PAGE_1G ? "1 GiB" : "2 MiB", len);
+        return NULL;
+    }
+    {
+        std::lock_guard<std::mutex> guard(mapped_lock);
+        mapped[p] = len;
+    }
+    ++mapped_count;
+    return p;
+}
+
+static void * alloc_thp(const size_t bytes)
+{
+    const size_t len = round_up(bytes, PAGE_2M);
+    void *p = NULL;
+    if (posix_memalign(&p, PAGE_2M, len) != 0)
+        return NULL;
+    madvise(p, len, MADV_HUGEPAGE);
+    return p;
+}
+#endif
+
+void * Le_alloc_pages(const size_t bytes, MemClass cls)
+{
+    MemPagePolicy policy = Le_get_page_policy(cls);
+#ifdef __linux__
+    if (policy != MEM_PAGE_DEFAULT && bytes >= MEM_HUGE_PAGE_MIN_BYTES)
+    {
+        void *p = NULL;
+        if (policy == MEM_PAGE_HUGETLB_1G && bytes >= MEM_HUGE_1G_MIN_BYTES)
+            p = alloc_hugetlb(bytes, PAGE_1G, 30);
+        if (p == NULL && policy >= MEM_PAGE_HUGETLB_2M)
+            p = alloc_hugetlb(bytes, PAGE_2M, 21);
+        if (p == NULL)
+            p = alloc_thp(bytes);
+        if (p != NULL)
+            return p;
+    }
+#endif
+    return memalign(Le_get_cache_line(), (uint64_t) bytes);
+}
+
+void Le_free_pages(void *p)
+{
+    if (p == NULL)
+        return;
+#ifdef __linux__
+    if (mapped_count.load(std::memory_order_relaxed) > 0)
+    {
+        size_t len = 0;
+        {
+            std::lock_guard<std::mutex> guard(mapped_lock);
+            auto it = mapped.find(p);
+            if (it != mapped.end())
+            {
+                len = it->second;
+                mapped.erase(it);
+            }
+        }
+        if (len > 0)
+        {
+            --mapped_count;
+            munmap(p, len);
+            return;
+        }
+    }
+#endif
+    free(p);
+}
+
+static void * default_allocate(size_t bytes, MemClass cls, void *)
+{
+    return Le_alloc_pages(bytes, cls);
+}
+
+static void default_deallocate(void *p, void *)
+{
+    Le_free_pages(p);
+}
+
+static const Le_allocator default_allocator = { default_allocate, default_deallocate, NULL };
+static std::atomic<const Le_allocator *> current_allocator(&default_allocator);
+
+const Le_allocator * Le_default_allocator()
+{
+    return &default_allocator;
+}
+
+// Le_allocator_scope 只改本线程, 不影响后台合并线程等并发的分配
+static thread_local const Le_allocator *thread_allocator = NULL;
+
+const Le_allocator * Le_get_allocator()
+{
+    if (thread_allocator != NULL)
+        return thread_allocator;
+    return current_allocator.load(std::memory_order_acquire);
+}
+
+const Le_allocator * Le_set_allocator(const Le_allocator *alloc)
+{
+    return current_allocator.exchange(alloc != NULL ? alloc : &default_allocator, std::memory_order_acq_rel);
+}
+
+const Le_allocator * Le_set_thread_allocator(const Le_allocator *alloc)
+{
+    const Le_allocator *prev = thread_allocator;
+    thread_allocator = alloc;
+    return prev;
+}
+
+static std::atomic<long long> heap_calls(0);
+
+void Le_count_heap_call()
+{
+    heap_calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+long long Le_heap_calls()
+{
+    return heap_calls.load(std::memory_order_relaxed);
+}
@@ -1,5 +1,6 @@
 #include"../include/sparse_partition.h"
 #include<vector>
+#include<algorithm>
 #include"../include/memopt.h"
 
 /**          acc_sum_arr=[3, 5, 8, 12, 15]   rows-1 = 4
@@ -166,7 +167,7 @@ template void balanced_partition_row_by_nnz_ell_n2(const int*, const int, int, c
 template void balanced_partition_row_by_nnz_ell_n2(const long long*, const long long, long long, const long long, long long, long long*);
 
 template <typename IndexType>
-void balanced_partition_row_by_nnz_sell(const IndexType * const *col_index, const IndexType num_nnzs, IndexType chunk_size, IndexType chunk_num, const IndexType *row_width, IndexType num_threads, IndexType *partition)
+void balanced_partition_row_by_nnz_sell(const IndexType *chunk_ptr, const IndexType *col_index, const IndexType num_nnzs, IndexType chunk_num, IndexType num_threads, IndexType *partition)
 {
     // 初始化每个线程的分区指针
     partition[0] = 0;
@@ -175,19 +176,14 @@ void balanced_partition_row_by_nnz_sell(const IndexType * const *col_index, cons
     }
 
     // 计算每 CHUNK 的非零元素数并累积总和
+    // chunk 内按列优先存储, 填充 -1 不一定在行尾连续出现, 逐个统计
     std::vector<IndexType> nnz_cumulative(chunk_num + 1, 0);
     for (IndexType chunkID = 0; chunkID < chunk_num; ++chunkID) {
         IndexType nnz_this_chunk = 0;
-        IndexType max_width = row_width[chunkID];
-        for (IndexType rowID = 0; rowID < chunk_size; rowID++)
-        {
-            for (IndexType j = 0; j < max_width; ++j) {
-                if (col_index[chunkID][j + rowID * max_width] >= 0)
-                    ++nnz_this_chunk;
-                else
-                    break;
-            }
-        } 
+        for (IndexType j = chunk_ptr[chunkID]; j < chunk_ptr[chunkID + 1]; ++j) {
+            if (col_index[j] >= 0)
+                ++nnz_this_chunk;
+        }
         nnz_cumulative[chunkID + 1] = nnz_cumulative[chunkID] + nnz_this_chunk;
     }
 
@@ -200,5 +196,28 @@ void balanced_partition_row_by_nnz_sell(const IndexType * const *col_index, cons
     }
 }
 
-template void balanced_partition_row_by_nnz_sell(const int * const *, const int , int , int , const int *, int , int *);
-template void balanced_partition_row_by_nnz_sell(const long long * const *, const long long , long long , long long , const long long *, long long , long long *);
\ No newline at end of file
+template void balanced_partition_row_by_nnz_sell(const int *, const int *, const int , int , int , int *);
+template void balanced_partition_row_by_nnz_sell(const long long *, const long long *, const long long , long long , long long , long long *);
+
+template <typename IndexType>
+void balanced_partition_cbcsr(const IndexType *panel_ptr, const IndexType *row_offset, IndexType num_panels, IndexType num_threads, IndexType *partition)
+{
+    #pragma omp parallel for num_threads(num_threads)
+    for (IndexType p = 0; p < num_panels; ++p)
+    {
+        IndexType *part = partition + p * (num_threads + 1);
+        const IndexType ks = panel_ptr[p];
+        const IndexType ke = panel_ptr[p + 1];
+        const IndexType nnz_start = row_offset[ks];
+        const IndexType ave = std::max((IndexType) 1, (row_offset[ke] - nnz_start) / num_threads);
+
+        // 在本 panel 的 row_offset 上二分, 第 t 个线程从累计 nnz 达到 t * ave 的行开始
+        part[0] = ks;
+        for (IndexType t = 1; t < num_threads; ++t)
+            part[t] = std::min(ke, (IndexType) (std::lower_bound(row_offset + ks, row_offset + ke, nnz_start + ave * t) - row_offset));
+        part[num_threads] = ke;
+    }
+}
+
+template void balanced_partition_cbcsr(const int *, const int *, int, int, int *);
+template void balanced_partition_cbcsr(const long long *, const long long *, long long, long long, long long *);
@@ -0,0 +1,96 @@
+/**
+ * @file perf_counter.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  dTLB load miss counter of the OpenMP threads (Linux perf_event_open).
+ * @version 0.1
+ * @date 2024-03-30
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include"../include/perf_counter.h"
+#include"../include/thread.h"
+
+#include<string.h>
+#include<unistd.h>
+
+#ifdef __linux__
+#include<sys/ioctl.h>
+#include<sys/syscall.h>
+#include<linux/perf_event.h>
+
+static int open_dtlb_event()
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_HW_CACHE;
+    attr.config         = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    // pid = 0, cpu = -1: the calling thread on any cpu
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#else
+static int open_dtlb_event() { return -1; }
+#endif
+
+Le_dtlb_counter::Le_dtlb_counter()
+{
+    // 先试探一次事件是否可用
+    int fd = open_dtlb_event();
+    ok = (fd >= 0);
+    if (ok)
+        close(fd);
+}
+
+Le_dtlb_counter::~Le_dtlb_counter()
+{
+    for (size_t i = 0; i < fds.size(); ++i)
+        if (fds[i] >= 0)
+            close(fds[i]);
+}
+
+void Le_dtlb_counter::start()
+{
+    if (!ok)
+        return;
+    const int thread_num = Le_get_thread_num();
+    fds.assign(thread_num, -1);
+
+    #pragma omp parallel num_threads(thread_num)
+    {
+        const int tid = Le_get_thread_id();
+        const int fd  = open_dtlb_event();
+        fds[tid] = fd;
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+}
+
+long long Le_dtlb_counter::stop()
+{
+    if (!ok || fds.empty())
+        return -1;
+    long long total = 0;
+    for (size_t i = 0; i < fds.size(); ++i)
+    {
+        if (fds[i] < 0)
+            continue;
+        long long count = 0;
+#ifdef __linux__
+        ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+#endif
+        if (read(fds[i], &count, sizeof(count)) == (ssize_t) sizeof(count))
+            total += count;
+        close(fds[i]);
+    }
+    fds.clear();
+    return total;
+}
@@ -0,0 +1,439 @@
+/**
+ * @file plat_runtime.cpp
+ * @author Shengle Lin (lsl036@hnu.edu.cn)
+ * @brief  Runtime detection of the parameters in plat_config.h.
+ *         Topology and caches from /sys/devices/system, SIMD width from
+ *         cpuid (x86) or hwcap (ARM), and the tick rate of rdtsc() is
+ *         calibrated against CLOCK_MONOTONIC.
+ * @version 0.1
+ * @date 2024-03-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include"../include/plat_runtime.h"
+#include<cstdint>
+#include"../include/rdtsc.h"
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<dirent.h>
+#include<unistd.h>
+#include<time.h>
+#include<set>
+#include<map>
+#include<vector>
+#include<tuple>
+#include<utility>
+#include<algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include<cpuid.h>
+#elif defined(__aarch64__)
+#include<sys/auxv.h>
+#include<sys/prctl.h>
+#endif
+
+// read the first integer of a sysfs file, return false if missing
+static bool read_sys_long(const char *path, long &val)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        return false;
+    bool ok = (fscanf(fp, "%ld", &val) == 1);
+    fclose(fp);
+    return ok;
+}
+
+static bool read_sys_string(const char *path, char *buf, int len)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        return false;
+    bool ok = (fgets(buf, len, fp) != NULL);
+    fclose(fp);
+    if (ok)
+        buf[strcspn(buf, "\n")] = '\0';
+    return ok;
+}
+
+// cache size string like "32K", "1024K", "36M" in Bytes
+static size_t parse_cache_size(const char *str)
+{
+    char *end = NULL;
+    size_t size = strtoul(str, &end, 10);
+    if (end != NULL)
+    {
+        if (*end == 'K') size *= 1024;
+        else if (*end == 'M') size *= 1024 * 1024;
+        else if (*end == 'G') size *= 1024 * 1024 * 1024;
+    }
+    return size;
+}
+
+// number of cpus in a cpu list like "0-3,56-59"
+static int count_cpu_list(const char *str)
+{
+    int count = 0;
+    const char *p = str;
+    while (*p)
+    {
+        char *end = NULL;
+        long first = strtol(p, &end, 10);
+        if (end == p)
+            break;
+        long last = first;
+        if (*end == '-')
+        {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+        }
+        count += (int)(last - first + 1);
+        p = (*end == ',') ? end + 1 : end;
+        if (*p == '\0' || *p == '\n')
+            break;
+    }
+    return count;
+}
+
+static void detect_topology(Le_Platform &plat)
+{
+    long num_conf = sysconf(_SC_NPROCESSORS_CONF);
+    std::set<long> packages;
+    std::set<std::pair<long, long>> cores;
+    int logical = 0;
+    char path[256];
+
+    for (long cpu = 0; cpu < num_conf; cpu++)
+    {
+        long package_id, core_id;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/topology/physical_package_id", cpu);
+        if (!read_sys_long(path, package_id))
+            continue;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/topology/core_id", cpu);
+        if (!read_sys_long(path, core_id))
+            continue;
+        packages.insert(package_id);
+        cores.insert(std::make_pair(package_id, core_id));
+        logical++;
+    }
+
+    if (logical == 0)
+        return;
+
+    plat.cpu_socket        = packages.size();
+    plat.cpu_cores_per_soc = cores.size() / packages.size();
+    plat.cpu_hyper_thread  = logical / cores.size();
+    if (plat.cpu_cores_per_soc < 1) plat.cpu_cores_per_soc = 1;
+    if (plat.cpu_hyper_thread < 1)  plat.cpu_hyper_thread = 1;
+}
+
+static void detect_numa(Le_Platform &plat)
+{
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (dir == NULL)
+        return;
+
+    int nodes = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9')
+            nodes++;
+    }
+    closedir(dir);
+
+    if (nodes > 0)
+        plat.numa_regions = nodes;
+}
+
+static void detect_caches(Le_Platform &plat)
+{
+    const int logical = plat.cpu_socket * plat.cpu_cores_per_soc * plat.cpu_hyper_thread;
+    char path[256], buf[256];
+
+    for (int index = 0; ; index++)
+    {
+        long level, line;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+        if (!read_sys_long(path, level))
+            break;
+
+        char type[32];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+        if (!read_sys_string(path, type, sizeof(type)))
+            continue;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+        if (!read_sys_string(path, buf, sizeof(buf)))
+            continue;
+        size_t instance = parse_cache_size(buf);
+
+        // how many cpus share one instance, lscpu reports size * instances
+        int shared = 1;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/shared_cpu_list", index);
+        if (read_sys_string(path, buf, sizeof(buf)))
+            shared = count_cpu_list(buf);
+        if (shared < 1)
+            shared = 1;
+        size_t total = instance * ((logical + shared - 1) / shared);
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/coherency_line_size", index);
+        if (level == 1 && read_sys_long(path, line) && line > 0)
+            plat.cache_line = line;
+
+        if (level == 1 && strcmp(type, "Data") == 0)
+        {
+            plat.l1dcache_size     = total;
+            plat.l1dcache_instance = instance;
+        }
+        else if (level == 1 && strcmp(type, "Instruction") == 0)
+        {
+            plat.l1icache_size = total;
+        }
+        else if (level == 2)
+        {
+            plat.l2cache_size     = total;
+            plat.l2cache_instance = instance;
+        }
+        else if (level == 3)
+        {
+            plat.l3cache_size     = total;
+            plat.l3cache_instance = instance;
+        }
+    }
+}
+
+static void detect_frequency(Le_Platform &plat)
+{
+    long khz;
+    if (read_sys_long("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq", khz) && khz > 0)
+        plat.cpu_max_frequency = khz * 1e3;
+    if (read_sys_long("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", khz) && khz > 0)
+    {
+        plat.cpu_frequency = khz * 1e3;
+        return;
+    }
+
+    // no cpufreq driver (e.g. VMs), try /proc/cpuinfo
+    FILE *fp = fopen("/proc/cpuinfo", "r");
+    if (fp == NULL)
+        return;
+    char line[512];
+    double mhz;
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        if (strncmp(line, "cpu MHz", 7) == 0 && sscanf(strchr(line, ':') + 1, "%lf", &mhz) == 1)
+        {
+            plat.cpu_frequency = mhz * 1e6;
+            break;
+        }
+    }
+    fclose(fp);
+}
+
+static void detect_memory(Le_Platform &plat)
+{
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page_size > 0)
+        plat.main_mem_size = ((size_t) pages * page_size) >> 30;
+}
+
+static void detect_simd(Le_Platform &plat)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return;
+
+    int width = (edx & (1u << 25)) ? 128 : plat.simd_width;  // SSE
+
+    // AVX / AVX-512 need the OS to save the ymm / zmm state (OSXSAVE + XCR0)
+    if (ecx & (1u << 27))
+    {
+        unsigned int xcr0_lo, xcr0_hi;
+        __asm__ __volatile__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+
+        if ((ecx & (1u << 28)) && (xcr0_lo & 0x6) == 0x6)
+            width = 256;
+
+        unsigned int eax7, ebx7, ecx7, edx7;
+        if (__get_cpuid_count(7, 0, &eax7, &ebx7, &ecx7, &edx7)
+            && (ebx7 & (1u << 16)) && (xcr0_lo & 0xE6) == 0xE6)
+            width = 512;
+    }
+    plat.simd_width = width;
+#elif defined(__aarch64__)
+    int width = 128;    // NEON/ASIMD
+#if defined(HWCAP_SVE) && defined(PR_SVE_GET_VL)
+    if (getauxval(AT_HWCAP) & HWCAP_SVE)
+    {
+        int vl = prctl(PR_SVE_GET_VL);
+        if (vl > 0)
+            width = (vl & PR_SVE_VL_LEN_MASK) * 8;
+    }
+#endif
+    plat.simd_width = width;
+#endif
+}
+
+static double monotonic_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// ticks of rdtsc() per second, measured over ~10 ms
+static void calibrate_ticks(Le_Platform &plat)
+{
+    double t_start = monotonic_seconds();
+    unsigned long long c_start = rdtsc();
+    double t_end;
+    do {
+        t_end = monotonic_seconds();
+    } while (t_end - t_start < 0.01);
+    unsigned long long c_end = rdtsc();
+
+    double freq = (double)(c_end - c_start) / (t_end - t_start);
+    if (freq > 0)
+        plat.tick_frequency = freq;
+}
+
+static Le_Platform detect_platform()
+{
+    Le_Platform plat;
+
+    // fallback: values generated by detect_plat.sh at build time
+    plat.cpu_frequency      = CPU_FREQUENCY;
+    plat.cpu_max_frequency  = CPU_MAX_FREQUENCY;
+    plat.cpu_socket         = CPU_SOCKET;
+    plat.cpu_cores_per_soc  = CPU_CORES_PER_SOC;
+    plat.cpu_hyper_thread   = CPU_HYPER_THREAD;
+    plat.numa_regions       = NUMA_REGIONS;
+    plat.l3cache_size       = CPU_L3CACHE_SIZE;
+    plat.l2cache_size       = CPU_L2CACHE_SIZE;
+    plat.l1dcache_size      = CPU_L1DCACHE_SIZE;
+    plat.l1icache_size      = CPU_L1IACHE_SIZE;
+    plat.l3cache_instance   = CPU_L3CACHE_SIZE / CPU_SOCKET;
+    plat.l2cache_instance   = CPU_L2CACHE_SIZE / (CPU_SOCKET * CPU_CORES_PER_SOC);
+    plat.l1dcache_instance  = CPU_L1DCACHE_SIZE / (CPU_SOCKET * CPU_CORES_PER_SOC);
+    plat.cache_line         = CACHE_LINE;
+    plat.main_mem_size      = MAIN_MEM_SIZE;
+    plat.simd_width         = SIMD_WIDTH;
+
+    detect_topology(plat);
+    detect_numa(plat);
+    detect_caches(plat);
+    detect_frequency(plat);
+    detect_memory(plat);
+    detect_simd(plat);
+
+    // timer falls back to the max frequency as before
+    plat.tick_frequency = plat.cpu_max_frequency;
+    calibrate_ticks(plat);
+
+    plat.s_alignment = plat.simd_width / 32;
+    plat.d_alignment = plat.simd_width / 64;
+
+    return plat;
+}
+
+const Le_Platform & Le_get_platform()
+{
+    static const Le_Platform plat = detect_platform();
+    return plat;
+}
+
+// populate at startup, so that the calibration is not counted in the first timer
+static const Le_Platform & _plat_at_startup = Le_get_platform();
+
+void Le_print_platform()
+{
+    const Le_Platform &plat = Le_get_platform();
+    printf("=== Platform ===\n");
+    printf("CPU_FREQUENCY     = %.3f MHz\n", plat.cpu_frequency / 1e6);
+    printf("CPU_MAX_FREQUENCY = %.3f MHz\n", plat.cpu_max_frequency / 1e6);
+    printf("TICK_FREQUENCY    = %.3f MHz\n", plat.tick_frequency / 1e6);
+    printf("CPU_SOCKET        = %d\n", plat.cpu_socket);
+    printf("CPU_CORES_PER_SOC = %d\n", plat.cpu_cores_per_soc);
+    printf("CPU_HYPER_THREAD  = %d\n", plat.cpu_hyper_thread);
+    printf("NUMA_REGIONS      = %d\n", plat.numa_regions);
+    printf("CPU_L3CACHE_SIZE  = %zu (%zu per instance)\n", plat.l3cache_size, plat.l3cache_instance);
+    printf("CPU_L2CACHE_SIZE  = %zu (%zu per instance)\n", plat.l2cache_size, plat.l2cache_instance);
+    printf("CPU_L1DCACHE_SIZE = %zu (%zu per instance)\n", plat.l1dcache_size, plat.l1dcache_instance);
+    printf("CACHE_LINE        = %zu\n", plat.cache_line);
+    printf("MAIN_MEM_SIZE     = %zu GB\n", plat.main_mem_size);
+    printf("SIMD_WIDTH        = %d\n", plat.simd_width);
+}
+
+int Le_get_simd_width()
+{
+    return Le_get_platform().simd_width;
+}
+
+size_t Le_get_cache_line()
+{
+    return Le_get_platform().cache_line;
+}
+
+double Le_get_tick_frequency()
+{
+    return Le_get_platform().tick_frequency;
+}
+
+int Le_get_physical_core_num()
+{
+    const Le_Platform &plat = Le_get_platform();
+    return plat.cpu_socket * plat.cpu_cores_per_soc;
+}
+
+int Le_get_hardware_thread_num()
+{
+    const Le_Platform &plat = Le_get_platform();
+    return plat.cpu_socket * plat.cpu_cores_per_soc * plat.cpu_hyper_thread;
+}
+
+int Le_get_cpu_order(int compact, int *cpus)
+{
+    long num_conf = sysconf(_SC_NPROCESSORS_CONF);
+    char path[256];
+
+    // (package, core) -> its logical cpus
+    std::map<std::pair<long, long>, std::vector<int>> core_cpus;
+    for (long cpu = 0; cpu < num_conf; cpu++)
+    {
+        long package_id, core_id;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/topology/physical_package_id", cpu);
+        if (!read_sys_long(path, package_id))
+            continue;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/topology/core_id", cpu);
+        if (!read_sys_long(path, core_id))
+            continue;
+        core_cpus[std::make_pair(package_id, core_id)].push_back((int) cpu);
+    }
+
+    // (sibling rank, package, core rank in package, cpu)
+    std::vector<std::tuple<int, long, int, int>> order;
+    std::map<long, int> core_rank;
+    for (auto &entry : core_cpus)
+    {
+        long package_id = entry.first.first;
+        int rank = core_rank[package_id]++;
+        for (size_t ht = 0; ht < entry.second.size(); ht++)
+            order.push_back(std::make_tuple((int) ht, package_id, rank, entry.second[ht]));
+    }
+
+    if (compact)
+        std::sort(order.begin(), order.end());
+    else
+        std::sort(order.begin(), order.end(), [](const std::tuple<int, long, int, int> &a, const std::tuple<int, long, int, int> &b){
+            return std::make_tuple(std::get<0>(a), std::get<2>(a), std::get<1>(a)) < std::make_tuple(std::get<0>(b), std::get<2>(b), std::get<1>(b));
+        });
+
+    for (size_t i = 0; i < order.size(); i++)
+        cpus[i] = std::get<3>(order[i]);
+    return (int) order.size();
+}
@@ -158,6 +158,8 @@ COO_Matrix<IndexType,ValueType> read_coo_matrix(const char * mm_filename)
         coo.values    = new_V;
         coo.num_nnzs = true_nnz;
     }
+    // 分析阶段一次性按行排序 (文件通常按列排序), SpMV 的 carry kernel 需要
+    sort_coo_by_row(coo);
     coo.kernel_flag = KERNEL_FLAG;
     return coo;
 }
@@ -167,6 +169,21 @@ template COO_Matrix<int, double> read_coo_matrix<int, double>(const char * mm_fi
 template COO_Matrix<long long, float> read_coo_matrix<long long, float>(const char * mm_filename);
 template COO_Matrix<long long, double> read_coo_matrix<long long, double>(const char * mm_filename);
 
+/**
+ * @brief Whether the banner of a ".mtx" file declares a "pattern" matrix.
+ */
+static bool mm_file_is_pattern(const char * mm_filename)
+{
+    FILE *fid = fopen(mm_filename, "r");
+    if (fid == NULL)
+        return false;
+
+    MM_typecode matcode;
+    const bool pattern = (mm_read_banner(fid, &matcode) == 0) && mm_is_pattern(matcode);
+    fclose(fid);
+    return pattern;
+}
+
 /**
  * @brief Read sparse matrix in CSR format from ".mtx" format file.
  *        Convert from COO format.
@@ -174,10 +191,11 @@ template COO_Matrix<long long, double> read_coo_matrix<long long, double>(const
  * @tparam ValueType 
  * @param mm_filename The sparse matrix file, must in mtx format.
  * @param compact     Judge whether sum duplicates together in CSR or not
+ * @param pattern     Read "pattern" mtx files as pattern-only CSR (values == nullptr)
  * @return CSR_Matrix<IndexType, ValueType> 
  */
 template <class IndexType, class ValueType>
-CSR_Matrix<IndexType, ValueType> read_csr_matrix(const char * mm_filename, bool compact)
+CSR_Matrix<IndexType, ValueType> read_csr_matrix(const char * mm_filename, bool compact, bool pattern)
 {
     // 先按COO的标准读进来
     COO_Matrix<IndexType, ValueType> coo = read_coo_matrix<IndexType, ValueType>(mm_filename);
@@ -198,15 +216,19 @@ CSR_Matrix<IndexType, ValueType> read_csr_matrix(const char * mm_filename, bool
     // std::cout << "- Finish CSR convertion -" << std::endl;
     delete_host_matrix(coo);
 
+    // pattern 文件的数值全为 1, 不保留 values
+    if (pattern && mm_file_is_pattern(mm_filename))
+        drop_csr_values(csr);
+
     csr.kernel_flag = KERNEL_FLAG;
 
     return csr;
 }
 
-template CSR_Matrix<int, float> read_csr_matrix<int, float>(const char * mm_filename, bool);
-template CSR_Matrix<int, double> read_csr_matrix<int, double>(const char * mm_filename, bool);
-template CSR_Matrix<long long, float> read_csr_matrix<long long, float>(const char * mm_filename, bool);
-template CSR_Matrix<long long, double> read_csr_matrix<long long, double>(const char * mm_filename, bool);
+template CSR_Matrix<int, float> read_csr_matrix<int, float>(const char * mm_filename, bool, bool);
+template CSR_Matrix<int, double> read_csr_matrix<int, double>(const char * mm_filename, bool, bool);
+template CSR_Matrix<long long, float> read_csr_matrix<long long, float>(const char * mm_filename, bool, bool);
+template CSR_Matrix<long long, double> read_csr_matrix<long long, double>(const char * mm_filename, bool, bool);
 
 
 template <class IndexType, class ValueType>
@@ -249,10 +271,10 @@ CSR5_Matrix<IndexType, UIndexType, ValueType> read_csr5_matrix(const char * mm_f
 
     FILE* save_features = fopen(MAT_FEATURES,"w");
 
-    csr5 = csr_to_csr5<IndexType, UIndexType, ValueType>(csr, save_features);
+    // csr5 接管 csr 的数组, 不再额外复制一份 nnz 数组
+    csr5 = csr_to_csr5<IndexType, UIndexType, ValueType>(csr, save_features, CSR5_ADOPT_CSR);
 
     fclose(save_features);
-    delete_csr_matrix(csr);
 
     return csr5;
 }
@@ -19,7 +19,7 @@ double test_bsr_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &csr_ref, i
 
     BSR_Matrix<IndexType,ValueType> bsr;
 
-    IndexType alignment = (SIMD_WIDTH/8/sizeof(ValueType));
+    IndexType alignment = Le_get_alignment<ValueType>();
     IndexType bsr_rowdim = BSR_BlockDimRow;
     IndexType bsr_coldim = 1*alignment;
     bsr = csr_to_bsr(csr_ref, bsr_rowdim, bsr_coldim);
@@ -38,7 +38,7 @@ double test_coo_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &csr_ref, i
         msec_per_iteration = benchmark_spmv_on_host(coo_test,LeSpMV_coo<IndexType, ValueType>,"coo_serial_simple");
     }
     else if(1 == kernel_tag){
-        std::cout << "\n===  Compared coo omp with csr default  ===" << std::endl;
+        std::cout << "\n===  Compared coo omp default (load balanced) with csr default  ===" << std::endl;
 
         // 设置 omp 调度策略
         const IndexType thread_num = Le_get_thread_num();
@@ -52,21 +52,23 @@ double test_coo_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &csr_ref, i
         // test correctness
         test_spmv_kernel(csr_ref,  LeSpMV_csr<IndexType, ValueType>,
                          coo_test, LeSpMV_coo<IndexType, ValueType>,
-                         "coo_omp_simple");
+                         "coo_omp_default");
 
-        std::cout << "\n===  Performance of COO omp simple  ===" << std::endl;
+        std::cout << "\n===  Performance of COO omp default  ===" << std::endl;
         // count performance of Gflops and Gbytes
-        msec_per_iteration = benchmark_spmv_on_host(coo_test,LeSpMV_coo<IndexType, ValueType>,"coo_omp_simple");
+        msec_per_iteration = benchmark_spmv_on_host(coo_test,LeSpMV_coo<IndexType, ValueType>,"coo_omp_default");
     }
     else if(2 == kernel_tag){
-        std::cout << "\n===  Compared coo alpha implementation with csr default ===" << std::endl;
+        std::cout << "\n===  Compared coo load balanced with csr default ===" << std::endl;
+        // read_coo_matrix 已按行排序, 这里只做检查
+        sort_coo_by_row(coo_test);
 
         // test correctness
         test_spmv_kernel(csr_ref,  LeSpMV_csr<IndexType, ValueType>,
                          coo_test, LeSpMV_coo<IndexType, ValueType>,
                          "coo_omp_lb");
 
-        std::cout << "\n===  Performance of coo alpha implementation  ===" << std::endl;
+        std::cout << "\n===  Performance of coo load balanced  ===" << std::endl;
         // count performance of Gflops and Gbytes
         msec_per_iteration = benchmark_spmv_on_host( coo_test, LeSpMV_coo<IndexType, ValueType>,"coo_omp_lb");
     }
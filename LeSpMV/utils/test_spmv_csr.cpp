@@ -18,7 +18,9 @@ double test_csr_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &csr_ref, i
     std::cout << "=====  Testing CSR Kernels  =====" << std::endl;
 
     // csr_test 测试所有kernel， csr_ref 为 omp simple实现
-    CSR_Matrix<IndexType,ValueType> csr_test;
+    // csr_test_owner 释放 csr_test 的数组及 lb 分支分配的 partition
+    Le_matrix<CSR_Matrix<IndexType,ValueType>> csr_test_owner(CSR_Matrix<IndexType,ValueType>{});
+    CSR_Matrix<IndexType,ValueType> &csr_test = *csr_test_owner;
     csr_test.num_rows = csr_ref.num_rows;
     csr_test.num_cols = csr_ref.num_cols;
     csr_test.num_nnzs = csr_ref.num_nnzs;
@@ -82,7 +84,6 @@ double test_csr_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &csr_ref, i
     
     }
 
-    delete_csr_matrix(csr_test);
     return msec_per_iteration;
 }
 
@@ -23,7 +23,8 @@ double test_csr5_matrix_kernels(const CSR_Matrix<IndexType, ValueType> &csr_ref,
     
     FILE* save_features = fopen(MAT_FEATURES,"w");
     // printf("11111111\n");
-    csr5 = csr_to_csr5<IndexType, UIndexType, ValueType>(csr_ref, save_features);
+    // csr_ref 比 csr5 存活更久, 直接借用其 row_offset
+    csr5 = csr_to_csr5<IndexType, UIndexType, ValueType>(csr_ref, save_features, CSR5_SHARE_ROW_OFFSET);
     // printf("22222222\n");
     fclose(save_features);
 
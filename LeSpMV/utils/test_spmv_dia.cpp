@@ -21,7 +21,7 @@ double test_dia_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &csr_ref, i
     DIA_Matrix<IndexType,ValueType> dia;
 
     IndexType max_diags = MAX_DIAG_NUM;
-    IndexType alignment = (SIMD_WIDTH/8/sizeof(ValueType));
+    IndexType alignment = Le_get_alignment<ValueType>();
     FILE* save_features = fopen(MAT_FEATURES,"w");
 
     dia = csr_to_dia(csr_ref, max_diags, save_features, alignment);
@@ -49,7 +49,7 @@ double test_dia_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &csr_ref, i
         const IndexType thread_num = Le_get_thread_num();
         
         // IndexType chunk_size = OMP_ROWS_SIZE;
-        const IndexType chunk_size = std::max((IndexType)1, dia.complete_ndiags/thread_num); // 对角线数目 除以线程数
+        const IndexType chunk_size = std::max((IndexType)1, (dia.num_rows + DIA_ROW_BLOCK - 1) / DIA_ROW_BLOCK / thread_num); // 行块数目 除以线程数
 
         set_omp_schedule(schedule_mod, chunk_size);
 
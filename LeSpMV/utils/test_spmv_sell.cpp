@@ -20,7 +20,7 @@ double test_s_ell_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &csr_ref,
     S_ELL_Matrix<IndexType,ValueType> sell;
 
     FILE* save_features = fopen(MAT_FEATURES,"w");
-    IndexType alignment = (SIMD_WIDTH/8/sizeof(ValueType));
+    IndexType alignment = Le_get_alignment<ValueType>();
     IndexType chunk_width = CHUNK_SIZE;
 
     sell = csr_to_sell(csr_ref, save_features, chunk_width, alignment);
@@ -66,7 +66,7 @@ double test_s_ell_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &csr_ref,
         const IndexType thread_num = Le_get_thread_num();
         sell.partition = new_array<IndexType>(thread_num + 1);
 
-        balanced_partition_row_by_nnz_sell(sell.col_index, sell.num_nnzs, sell.sliceWidth, sell.chunk_num, sell.row_width, thread_num, sell.partition);
+        balanced_partition_row_by_nnz_sell(sell.chunk_ptr, sell.col_index, sell.num_nnzs, sell.chunk_num, thread_num, sell.partition);
 
         // test correctness
         test_spmv_kernel(csr_ref, LeSpMV_csr<IndexType, ValueType>,
@@ -22,7 +22,7 @@ double test_sell_c_R_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &csr_r
     FILE* save_features = fopen(MAT_FEATURES,"w");
 
     IndexType chunkwidth = CHUNK_SIZE;
-    IndexType alignment  = SIMD_WIDTH/8/sizeof(ValueType);
+    IndexType alignment  = Le_get_alignment<ValueType>();
 
     sell_c_R = csr_to_sell_c_R(csr_ref, save_features, chunkwidth, alignment);
 
@@ -69,7 +69,7 @@ double test_sell_c_R_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &csr_r
         const IndexType thread_num = Le_get_thread_num();
         sell_c_R.partition = new_array<IndexType>(thread_num + 1);
 
-        balanced_partition_row_by_nnz_sell(sell_c_R.col_index, sell_c_R.num_nnzs, sell_c_R.chunkWidth_C, sell_c_R.validchunkNum, sell_c_R.chunk_len, thread_num, sell_c_R.partition);
+        balanced_partition_row_by_nnz_sell(sell_c_R.chunk_ptr, sell_c_R.col_index, sell_c_R.num_nnzs, sell_c_R.validchunkNum, thread_num, sell_c_R.partition);
 
         // test correctness
         test_spmv_kernel(csr_ref, LeSpMV_csr<IndexType, ValueType>,
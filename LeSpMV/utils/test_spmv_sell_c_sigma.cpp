@@ -22,8 +22,8 @@ double test_sell_c_sigma_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &c
     FILE* save_features = fopen(MAT_FEATURES,"w");
 
     IndexType slicewidth = SELL_SIGMA;
-    IndexType chunkwidth = CHUNK_SIZE;
-    IndexType alignment  = SIMD_WIDTH/8/sizeof(ValueType);
+    IndexType chunkwidth = Le_get_alignment<ValueType>();   // C = SIMD lanes
+    IndexType alignment  = Le_get_alignment<ValueType>();
 
     sell_c_sigma = csr_to_sell_c_sigma(csr_ref, save_features, slicewidth, chunkwidth, alignment);
 
@@ -71,7 +71,7 @@ double test_sell_c_sigma_matrix_kernels(const CSR_Matrix<IndexType,ValueType> &c
         const IndexType thread_num = Le_get_thread_num();
         sell_c_sigma.partition = new_array<IndexType>(thread_num + 1);
 
-        balanced_partition_row_by_nnz_sell(sell_c_sigma.col_index, sell_c_sigma.num_nnzs, sell_c_sigma.chunkWidth_C, sell_c_sigma.validchunkNum, sell_c_sigma.chunk_len, thread_num, sell_c_sigma.partition);
+        balanced_partition_row_by_nnz_sell(sell_c_sigma.chunk_ptr, sell_c_sigma.col_index, sell_c_sigma.num_nnzs, sell_c_sigma.validchunkNum, thread_num, sell_c_sigma.partition);
 
         // test correctness
         test_spmv_kernel(csr_ref, LeSpMV_csr<IndexType, ValueType>,
@@ -1,9 +1,16 @@
 
 #include"../include/thread.h"
+#include"../include/plat_runtime.h"
 #include<stdio.h>
+#include<sched.h>
+#include<unistd.h>
+#include<vector>
 
 int _thread_num;
 
+// Le_thread_num_scope 只改本线程, 例如后台合并线程不占满所有核
+static thread_local int _thread_num_override = 0;
+
 int Le_get_core_num()
 {
 #ifdef _OPENMP
@@ -25,11 +32,20 @@ void Le_set_thread_num(const int thread_num)
 int Le_get_thread_num()
 {
 #ifdef _OPENMP
+    if (_thread_num_override > 0)
+        return _thread_num_override;
     return _thread_num == 0 ? Le_get_core_num() : _thread_num;
 #else
     return 1;
 #endif
 }
+
+int Le_set_thread_num_override(const int thread_num)
+{
+    const int prev = _thread_num_override;
+    _thread_num_override = thread_num > 0 ? thread_num : 0;
+    return prev;
+}
 int Le_get_thread_id()
 {
 #ifdef _OPENMP
@@ -69,4 +85,33 @@ void set_omp_schedule(int sche_mode, int chunk_size=0) {
             break;
     }
 #endif
-}
\ No newline at end of file
+}
+void Le_bind_threads(BindPolicy bind_mode)
+{
+#ifdef _OPENMP
+    const int thread_num = Le_get_thread_num();
+    const int num_conf = sysconf(_SC_NPROCESSORS_CONF);
+
+    std::vector<int> cpus(num_conf > 0 ? num_conf : 1);
+    int num_cpus = 0;
+    if (bind_mode != BIND_NONE)
+        num_cpus = Le_get_cpu_order(bind_mode == BIND_COMPACT, cpus.data());
+
+    #pragma omp parallel num_threads(thread_num)
+    {
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (num_cpus == 0)
+        {
+            // unbind: allow all cpus
+            for (int cpu = 0; cpu < num_conf; cpu++)
+                CPU_SET(cpu, &mask);
+        }
+        else
+        {
+            CPU_SET(cpus[Le_get_thread_id() % num_cpus], &mask);
+        }
+        sched_setaffinity(0, sizeof(cpu_set_t), &mask);
+    }
+#endif
+}